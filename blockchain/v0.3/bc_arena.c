@@ -0,0 +1,98 @@
+/* bc_arena_t transaction_t BC_ARENA_ALIGN */
+#include "blockchain.h"
+/* fprintf */
+#include <stdio.h>
+/* calloc free */
+#include <stdlib.h>
+/* llist_destroy */
+#include <llist.h>
+
+
+/**
+ * bcArenaInit - allocates the zeroed region of an arena
+ *
+ * @arena: pointer to the arena to initialize
+ * @cap: size of the region in bytes, as measured by blockSerialSz
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+int bcArenaInit(bc_arena_t *arena, size_t cap)
+{
+	if (!arena)
+	{
+		fprintf(stderr, "bcArenaInit: NULL parameter\n");
+		return (1);
+	}
+
+	arena->len = 0;
+	arena->cap = cap;
+	arena->buf = calloc(1, cap);
+	if (!arena->buf)
+	{
+		fprintf(stderr, "bcArenaInit: calloc failure\n");
+		return (1);
+	}
+
+	return (0);
+}
+
+
+/**
+ * bcArenaAlloc - hands out the next zeroed bytes of an arena
+ *
+ * @arena: pointer to the arena, or NULL to allocate on the heap instead
+ * @sz: amount of bytes needed
+ *
+ * Return: pointer to the bytes, to be released by bcArenaFree, or NULL if
+ *   the arena is exhausted or upon failure
+ */
+void *bcArenaAlloc(bc_arena_t *arena, size_t sz)
+{
+	void *ptr;
+
+	if (!arena)
+		return (calloc(1, sz));
+
+	sz = BC_ARENA_ALIGN(sz);
+	if (sz > arena->cap - arena->len)
+	{
+		fprintf(stderr, "bcArenaAlloc: arena exhausted\n");
+		return (NULL);
+	}
+	ptr = arena->buf + arena->len;
+	arena->len += sz;
+
+	return (ptr);
+}
+
+
+/**
+ * bcArenaFree - releases bytes handed out by bcArenaAlloc; those of an arena
+ *   are only released with its whole region
+ *
+ * @arena: pointer to the arena `ptr` was allocated from, or NULL if from the
+ *   heap
+ * @ptr: bytes to release
+ */
+void bcArenaFree(bc_arena_t const *arena, void *ptr)
+{
+	if (!arena)
+		free(ptr);
+}
+
+
+/**
+ * arenaTxDestroy - deletes the lists of a transaction decoded into the arena
+ *   of its block, leaving the transaction, its inputs and its outputs to be
+ *   released with the region, see block_destroy
+ *
+ * @tx: pointer to the transaction to delete
+ */
+void arenaTxDestroy(transaction_t *tx)
+{
+	if (!tx)
+		return;
+
+	llist_destroy(tx->inputs, 0, NULL);
+	llist_destroy(tx->outputs, 0, NULL);
+}
@@ -0,0 +1,357 @@
+/* bc_file_t bc_file_ftr_t bc_tx_loc_t block_t HBLK_MAG HBLK_VER */
+#include "blockchain.h"
+/* madvise MADV_RANDOM */
+#include <sys/mman.h>
+/* close */
+#include <unistd.h>
+/* fprintf */
+#include <stdio.h>
+/* memcpy memcmp memset */
+#include <string.h>
+/* _get_endianness _swap_endian */
+#include "provided/endianness.h"
+
+
+/**
+ * loadU64 - reads a serialized 64-bit field
+ *
+ * @bytes: first byte of the field, not necessarily aligned
+ * @bswap: nonzero if the file endianness differs from the local one
+ *
+ * Return: value of the field
+ */
+static uint64_t loadU64(uint8_t const *bytes, int bswap)
+{
+	uint64_t value;
+
+	memcpy(&value, bytes, sizeof(uint64_t));
+	if (bswap)
+	{
+#ifdef __GNUC__ /* compiled with gcc, can use gcc builtins for fast assembly */
+		value = __builtin_bswap64(value);
+#else /* use function to manually byte swap */
+		_swap_endian(&value, 8);
+#endif
+	}
+
+	return (value);
+}
+
+
+/**
+ * mapIndex - locates the block and transaction tables of a version 0.4 file
+ *   through its footer, see bcIndexWrite
+ *
+ * @file: pointer to file with its header read
+ *
+ * Return: 0 on success, or 1 if the footer is missing or invalid
+ */
+static int mapIndex(bc_file_t *file)
+{
+	bc_file_ftr_t footer;
+	size_t end;
+
+	if (file->reader.sz < sizeof(bc_file_hdr_t) + sizeof(bc_file_ftr_t))
+	{
+		fprintf(stderr, "mapIndex: file too small to contain footer\n");
+		return (1);
+	}
+	end = file->reader.sz - sizeof(bc_file_ftr_t);
+	memcpy(&footer, file->reader.buf + end, sizeof(bc_file_ftr_t));
+	if (memcmp(footer.hblk_magic, HBLK_MAG, HBLK_MAG_LEN) != 0)
+	{
+		fprintf(stderr, "mapIndex: invalid footer magic number\n");
+		return (1);
+	}
+	file->bswap = file->local_endianness != file->header.hblk_endian;
+	footer.blocks_off = loadU64((uint8_t *)&(footer.blocks_off),
+				    file->bswap);
+	footer.txs_off = loadU64((uint8_t *)&(footer.txs_off), file->bswap);
+	footer.tx_ct = loadU32((uint8_t *)&(footer.tx_ct), file->bswap);
+
+	/* tables lie between the header and the footer, in this order */
+	if (footer.blocks_off < sizeof(bc_file_hdr_t) ||
+	    footer.blocks_off > footer.txs_off || footer.txs_off > end ||
+	    (footer.txs_off - footer.blocks_off) / sizeof(uint64_t) <
+	    file->header.hblk_blocks ||
+	    (end - footer.txs_off) / sizeof(bc_tx_loc_t) < footer.tx_ct)
+	{
+		fprintf(stderr, "mapIndex: footer out of file bounds\n");
+		return (1);
+	}
+	file->block_offs = file->reader.buf + footer.blocks_off;
+	file->tx_locs = file->reader.buf + footer.txs_off;
+	file->tx_ct = footer.tx_ct;
+	/* lookups read a few pages each, anywhere in the file */
+	madvise((void *)file->reader.buf, file->reader.sz, MADV_RANDOM);
+
+	return (0);
+}
+
+
+/**
+ * buildIndex - builds the block and transaction tables of a version 0.3
+ *   file, which has none, by decoding each of its blocks once
+ *
+ * @file: pointer to file with its header read, positioned at its first block
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+static int buildIndex(bc_file_t *file)
+{
+	block_t *block;
+	uint64_t off;
+	uint32_t i;
+
+	for (i = 0; i < file->header.hblk_blocks; i++)
+	{
+		off = file->reader.pos;
+		block = readBlock(&(file->reader), file->local_endianness,
+				  file->header.hblk_endian);
+		if (!block)
+			return (1);
+		if (bcIndexBlock(&(file->built), block, off) != 0)
+		{
+			block_destroy(block);
+			return (1);
+		}
+		block_destroy(block);
+	}
+	bcIndexSort(&(file->built));
+	file->block_offs = (uint8_t const *)file->built.block_offs;
+	file->tx_locs = (uint8_t const *)file->built.tx_locs;
+	file->tx_ct = file->built.tx_ct;
+	file->bswap = 0;
+
+	return (0);
+}
+
+
+/**
+ * bcFileOpen - opens a serialized blockchain for random access to its
+ *   blocks, without deserializing it whole
+ *
+ * @file: pointer to the struct to initialize, released by bcFileClose
+ * @path: path to a regular file serialized by blockchain_serialize; the
+ *   tables of version 0.3 files are built here, in time linear to their size
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+int bcFileOpen(bc_file_t *file, char const *path)
+{
+	int fd, ret;
+
+	if (!file || !path)
+	{
+		fprintf(stderr, "bcFileOpen: NULL parameter(s)\n");
+		return (1);
+	}
+	memset(file, 0, sizeof(bc_file_t));
+
+	fd = pathToReadFD(path);
+	if (fd == -1)
+		return (1);
+	ret = bcReaderMap(&(file->reader), fd);
+	close(fd);
+	if (ret == 2)
+		fprintf(stderr, "bcFileOpen: not a regular file\n");
+	if (ret != 0)
+		return (1);
+
+	file->local_endianness = _get_endianness();
+	if (readBlkchnFileHdr(&(file->reader), file->local_endianness,
+			      &(file->header)) != 0 ||
+	    (memcmp(file->header.hblk_version, HBLK_VER, HBLK_VER_LEN) == 0 ?
+	     mapIndex(file) : buildIndex(file)) != 0)
+	{
+		fprintf(stderr, "bcFileOpen: failed to index '%s'\n", path);
+		bcFileClose(file);
+		return (1);
+	}
+
+	return (0);
+}
+
+
+/**
+ * bcFileClose - unmaps a blockchain file and frees any table built for it
+ *
+ * @file: pointer to the file to release
+ */
+void bcFileClose(bc_file_t *file)
+{
+	if (!file)
+		return;
+
+	bcReaderUnmap(&(file->reader));
+	bcIndexFree(&(file->built));
+	memset(file, 0, sizeof(bc_file_t));
+}
+
+
+/**
+ * blockAt - decodes the block serialized at a given offset of a file
+ *
+ * @file: pointer to open file
+ * @off: file offset of the block, as found in its tables
+ *
+ * Return: pointer to the deserialized block, or NULL upon failure
+ */
+static block_t *blockAt(bc_file_t const *file, uint64_t off)
+{
+	bc_reader_t reader = file->reader;
+
+	if (off < sizeof(bc_file_hdr_t) || off >= reader.sz)
+	{
+		fprintf(stderr, "blockAt: block offset out of file bounds\n");
+		return (NULL);
+	}
+	reader.pos = off;
+
+	return (readBlock(&reader, file->local_endianness,
+			  file->header.hblk_endian));
+}
+
+
+/**
+ * bcFileBlock - deserializes a single block of a blockchain file
+ *
+ * @file: pointer to open file
+ * @index: position of the block in the chain, 0 being the Genesis Block
+ *
+ * Return: pointer to the block, to be freed with block_destroy, or NULL if
+ *   out of range or upon failure
+ */
+block_t *bcFileBlock(bc_file_t const *file, uint32_t index)
+{
+	if (!file)
+	{
+		fprintf(stderr, "bcFileBlock: NULL parameter\n");
+		return (NULL);
+	}
+	if (index >= file->header.hblk_blocks)
+	{
+		fprintf(stderr, "bcFileBlock: index out of range\n");
+		return (NULL);
+	}
+
+	return (blockAt(file, loadU64(file->block_offs +
+				      index * sizeof(uint64_t), file->bswap)));
+}
+
+
+/**
+ * hashAt - finds the hash of the block serialized at a given offset of a
+ *   file, without decoding the block
+ *
+ * @file: pointer to open file
+ * @off: file offset of the block, as found in its tables
+ *
+ * Return: pointer to the hash in the mapped file, or NULL if the block runs
+ *   out of file bounds
+ */
+static uint8_t const *hashAt(bc_file_t const *file, uint64_t off)
+{
+	uint64_t at = off + sizeof(block_info_t);
+	uint32_t data_len;
+
+	if (off < sizeof(bc_file_hdr_t) || off >= file->reader.sz ||
+	    at + sizeof(uint32_t) > file->reader.sz)
+	{
+		fprintf(stderr, "hashAt: block offset out of file bounds\n");
+		return (NULL);
+	}
+	data_len = loadU32(file->reader.buf + at, file->local_endianness !=
+			   file->header.hblk_endian);
+	at += sizeof(uint32_t) + data_len;
+	if (data_len > BLOCKCHAIN_DATA_MAX ||
+	    at + SHA256_DIGEST_LENGTH > file->reader.sz)
+	{
+		fprintf(stderr, "hashAt: block hash out of file bounds\n");
+		return (NULL);
+	}
+
+	return (file->reader.buf + at);
+}
+
+
+/**
+ * bcFileBlockByHash - deserializes the block of a given hash in a blockchain
+ *   file; the block table is walked reading only the hash of each block, so
+ *   that only the block found is decoded
+ *
+ * @file: pointer to open file
+ * @hash: hash of the block to find
+ *
+ * Return: pointer to the block, to be freed with block_destroy, or NULL if
+ *   not found or upon failure
+ */
+block_t *bcFileBlockByHash(bc_file_t const *file,
+			   uint8_t const hash[SHA256_DIGEST_LENGTH])
+{
+	uint8_t const *at;
+	uint64_t off;
+	uint32_t i;
+
+	if (!file || !hash)
+	{
+		fprintf(stderr, "bcFileBlockByHash: NULL parameter(s)\n");
+		return (NULL);
+	}
+
+	for (i = 0; i < file->header.hblk_blocks; i++)
+	{
+		off = loadU64(file->block_offs + (size_t)i * sizeof(uint64_t),
+			      file->bswap);
+		at = hashAt(file, off);
+		if (!at)
+			return (NULL);
+		if (memcmp(at, hash, SHA256_DIGEST_LENGTH) == 0)
+			return (blockAt(file, off));
+	}
+
+	return (NULL);
+}
+
+
+/**
+ * bcFileTxBlock - deserializes the block of a blockchain file containing a
+ *   given transaction, found by binary search of the transaction table
+ *
+ * @file: pointer to open file
+ * @tx_id: ID of the transaction to find
+ *
+ * Return: pointer to the block, to be freed with block_destroy, or NULL if
+ *   no block contains the transaction or upon failure
+ */
+block_t *bcFileTxBlock(bc_file_t const *file,
+		       uint8_t const tx_id[SHA256_DIGEST_LENGTH])
+{
+	uint8_t const *tx_loc;
+	uint32_t lo = 0, hi, mid;
+	int cmp;
+
+	if (!file || !tx_id)
+	{
+		fprintf(stderr, "bcFileTxBlock: NULL parameter(s)\n");
+		return (NULL);
+	}
+
+	hi = file->tx_ct;
+	while (lo < hi)
+	{
+		mid = lo + (hi - lo) / 2;
+		tx_loc = file->tx_locs + (size_t)mid * sizeof(bc_tx_loc_t);
+		cmp = memcmp(tx_loc, tx_id, SHA256_DIGEST_LENGTH);
+		if (cmp == 0)
+			return (blockAt(file, loadU64(tx_loc +
+						      SHA256_DIGEST_LENGTH,
+						      file->bswap)));
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return (NULL);
+}
@@ -0,0 +1,216 @@
+/* bc_index_t bc_tx_loc_t bc_file_ftr_t bc_writer_t HBLK_MAG */
+#include "blockchain.h"
+/* fprintf */
+#include <stdio.h>
+/* realloc free qsort */
+#include <stdlib.h>
+/* memcpy memcmp memset */
+#include <string.h>
+/* llist_* */
+#include <llist.h>
+
+
+/**
+ * indexTx - used as `action` for llist_for_each to add the location of each
+ *   transaction of a block to an index
+ *
+ * @tx: pointer to transaction in block->transactions, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx` in block->transactions, as iterated through by
+ *   llist_for_each
+ * @index: index to amend, its last block offset being that of the block
+ *   containing `tx`
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int indexTx(transaction_t *tx, unsigned int idx, bc_index_t *index)
+{
+	bc_tx_loc_t *tx_locs;
+	uint32_t cap;
+
+	(void)idx;
+
+	if (!tx || !index)
+	{
+		fprintf(stderr, "indexTx: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	if (index->tx_ct == index->tx_cap)
+	{
+		cap = index->tx_cap ? index->tx_cap * 2 : 64;
+		tx_locs = realloc(index->tx_locs, cap * sizeof(bc_tx_loc_t));
+		if (!tx_locs)
+		{
+			fprintf(stderr, "indexTx: realloc failure\n");
+			return (-2);
+		}
+		index->tx_locs = tx_locs;
+		index->tx_cap = cap;
+	}
+	memcpy(index->tx_locs[index->tx_ct].tx_id, tx->id,
+	       SHA256_DIGEST_LENGTH);
+	index->tx_locs[index->tx_ct++].block_off =
+		index->block_offs[index->block_ct - 1];
+
+	return (0);
+}
+
+
+/**
+ * bcIndexBlock - adds a block and its transactions to an index
+ *
+ * @index: index to amend
+ * @block: block about to be serialized, or deserialized
+ * @off: file offset of the serialized block
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+int bcIndexBlock(bc_index_t *index, block_t const *block, uint64_t off)
+{
+	uint64_t *block_offs;
+	uint32_t cap;
+
+	if (!index || !block)
+	{
+		fprintf(stderr, "bcIndexBlock: NULL parameter(s)\n");
+		return (1);
+	}
+
+	if (index->block_ct == index->block_cap)
+	{
+		cap = index->block_cap ? index->block_cap * 2 : 64;
+		block_offs = realloc(index->block_offs,
+				     cap * sizeof(uint64_t));
+		if (!block_offs)
+		{
+			fprintf(stderr, "bcIndexBlock: realloc failure\n");
+			return (1);
+		}
+		index->block_offs = block_offs;
+		index->block_cap = cap;
+	}
+	index->block_offs[index->block_ct++] = off;
+
+	/* Genesis Block transactions are not serialized, see writeBlock */
+	if (block->info.index > 0 && block->transactions &&
+	    llist_for_each(block->transactions, (node_func_t)indexTx,
+			   index) < 0)
+	{
+		fprintf(stderr, "bcIndexBlock: llist_for_each failure\n");
+		return (1);
+	}
+
+	return (0);
+}
+
+
+/**
+ * cmpTxLoc - compares two transaction index entries by ID, for qsort and
+ *   bsearch
+ *
+ * @a: pointer to first entry
+ * @b: pointer to second entry
+ *
+ * Return: negative, 0 or positive as `a` sorts before, with or after `b`
+ */
+static int cmpTxLoc(void const *a, void const *b)
+{
+	return (memcmp(a, b, SHA256_DIGEST_LENGTH));
+}
+
+
+/**
+ * bcIndexSort - sorts the transactions of an index by ID, so that they can be
+ *   binary searched
+ *
+ * @index: index to sort
+ */
+void bcIndexSort(bc_index_t *index)
+{
+	if (!index)
+	{
+		fprintf(stderr, "bcIndexSort: NULL parameter\n");
+		return;
+	}
+
+	if (index->tx_ct > 1)
+		qsort(index->tx_locs, index->tx_ct, sizeof(bc_tx_loc_t),
+		      cmpTxLoc);
+}
+
+
+/**
+ * bcIndexWrite - writes the block and transaction tables of an index, and
+ *   the file footer locating them, after the unspent outputs of a
+ *   serialized blockchain
+ *
+ * @writer: pointer to buffered output of a file open for writing, past the
+ *   last unspent output
+ * @index: index built while writing the blocks, its transactions sorted by
+ *   this call
+ *
+ * Index format, since version 0.4:
+ *  Offset Size(b) Field        Purpose
+ *  0x00   8       block_offs   File offset of each block, in chain order;
+ *          * hblk_blocks         endianness dependent
+ *  ...    40      tx_locs      For each transaction, its ID (32 bytes) then
+ *          * tx_ct               the file offset of its block (8 bytes,
+ *                                endianness dependent); sorted by ID
+ *  ...    24      footer       blocks_off (8), txs_off (8) and tx_ct (4),
+ *                                endianness dependent, then "HBLK"; always
+ *                                the last 24 bytes of the file
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+int bcIndexWrite(bc_writer_t *writer, bc_index_t *index)
+{
+	bc_file_ftr_t footer;
+
+	if (!writer || !index)
+	{
+		fprintf(stderr, "bcIndexWrite: NULL parameter(s)\n");
+		return (1);
+	}
+
+	bcIndexSort(index);
+	memset(&footer, 0, sizeof(bc_file_ftr_t));
+	footer.blocks_off = writer->pos;
+	footer.txs_off = footer.blocks_off +
+		(uint64_t)index->block_ct * sizeof(uint64_t);
+	footer.tx_ct = index->tx_ct;
+	memcpy(footer.hblk_magic, HBLK_MAG, HBLK_MAG_LEN);
+	/*
+	 * sizeof(bc_tx_loc_t):40 tx_id:32 block_off:8
+	 * sizeof(bc_file_ftr_t):24 blocks_off:8 txs_off:8 tx_ct:4 magic:4
+	 * neither is padded, both can be written whole
+	 */
+	if (bcWriterPut(writer, index->block_offs,
+			index->block_ct * sizeof(uint64_t)) != 0 ||
+	    bcWriterPut(writer, index->tx_locs,
+			index->tx_ct * sizeof(bc_tx_loc_t)) != 0 ||
+	    bcWriterPut(writer, &footer, sizeof(bc_file_ftr_t)) != 0)
+	{
+		fprintf(stderr, "bcIndexWrite: bcWriterPut failure\n");
+		return (1);
+	}
+
+	return (0);
+}
+
+
+/**
+ * bcIndexFree - frees the tables of an index
+ *
+ * @index: index to release, left empty
+ */
+void bcIndexFree(bc_index_t *index)
+{
+	if (!index)
+		return;
+
+	free(index->block_offs);
+	free(index->tx_locs);
+	memset(index, 0, sizeof(bc_index_t));
+}
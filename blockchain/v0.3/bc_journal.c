@@ -0,0 +1,596 @@
+/* bc_journal_t bc_jnl_hdr_t bc_sync_t chainAdd HJNL_* BC_* */
+#include "blockchain.h"
+/* fdatasync ftruncate close unlink */
+#include <unistd.h>
+/* open O_* S_* */
+#include <fcntl.h>
+/* errno ENOENT */
+#include <errno.h>
+/* fprintf perror */
+#include <stdio.h>
+/* malloc free */
+#include <stdlib.h>
+/* strlen memcpy memcmp memset */
+#include <string.h>
+/* _get_endianness */
+#include "provided/endianness.h"
+/* llist_* */
+#include <llist.h>
+
+
+/**
+ * journalPath - names the journal of a blockchain file
+ *
+ * @path: path to the blockchain file
+ *
+ * Return: malloc'd path of the journal, or NULL upon failure
+ */
+static char *journalPath(char const *path)
+{
+	char *jpath;
+
+	jpath = malloc(strlen(path) + sizeof(HJNL_EXT));
+	if (!jpath)
+	{
+		fprintf(stderr, "journalPath: malloc failure\n");
+		return (NULL);
+	}
+	strcpy(jpath, path);
+	strcat(jpath, HJNL_EXT);
+
+	return (jpath);
+}
+
+
+/**
+ * journalSync - flushes the records of a journal to disk, if its sync policy
+ *   requires it at a given point
+ *
+ * @journal: pointer to journal
+ * @level: BC_SYNC_ALWAYS after a block, BC_SYNC_CHECKPOINT after a
+ *   checkpoint or header
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+static int journalSync(bc_journal_t *journal, bc_sync_t level)
+{
+	if (journal->sync < level)
+		return (0);
+	if (fdatasync(journal->fd) == -1)
+	{
+		perror("journalSync: fdatasync");
+		return (1);
+	}
+
+	return (0);
+}
+
+
+/**
+ * bcJournalCreate - starts a new, empty journal for a blockchain just saved
+ *   by blockchain_serialize, replacing any previous one
+ *
+ * @path: path to the blockchain file, the journal being named after it
+ * @blockchain: pointer to the blockchain saved to `path`
+ * @sync: when records are to be flushed to disk
+ *
+ * Journal format:
+ *  Offset Size(b) Field        Purpose
+ *  0x00   48      header       See bc_jnl_hdr_t; ties the journal to the last
+ *                                block of the blockchain file
+ *  0x30   ?       records      Each a type byte followed by its payload:
+ *                                'B' a block, serialized as by writeBlock
+ *                                'U' a checkpoint, the number of unspent
+ *                                outputs (4 bytes, endianness dependent) then
+ *                                each output as serialized by writeUnspent
+ *
+ * Return: pointer to the journal, to be released by bcJournalClose, or NULL
+ *   upon failure
+ */
+bc_journal_t *bcJournalCreate(char const *path,
+			      blockchain_t const *blockchain, bc_sync_t sync)
+{
+	bc_journal_t *journal;
+	bc_jnl_hdr_t header;
+	bc_writer_t writer;
+	block_t *tail;
+	char *jpath;
+
+	if (!path || !blockchain)
+	{
+		fprintf(stderr, "bcJournalCreate: NULL parameter(s)\n");
+		return (NULL);
+	}
+	tail = llist_get_tail(blockchain->chain);
+	journal = calloc(1, sizeof(bc_journal_t));
+	jpath = journalPath(path);
+	if (!tail || !journal || !jpath)
+	{
+		fprintf(stderr, "bcJournalCreate: %s\n", !tail ?
+			"empty blockchain" : "allocation failure");
+		free(journal);
+		free(jpath);
+		return (NULL);
+	}
+
+	memset(&header, 0, sizeof(bc_jnl_hdr_t));
+	memcpy(header.hjnl_magic, HJNL_MAG, HJNL_MAG_LEN);
+	memcpy(header.hblk_version, HBLK_VER, HBLK_VER_LEN);
+	header.hjnl_endian = _get_endianness();
+	header.base_blocks = (uint32_t)llist_size(blockchain->chain);
+	header.hjnl_sync = (uint8_t)sync;
+	memcpy(header.base_hash, tail->hash, SHA256_DIGEST_LENGTH);
+
+	journal->sync = sync;
+	journal->fd = open(jpath, O_CREAT | O_TRUNC | O_WRONLY | O_APPEND,
+			   S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP | S_IROTH);
+	if (journal->fd == -1)
+		perror("bcJournalCreate: open");
+	free(jpath);
+	bcWriterInit(&writer, journal->fd);
+	if (journal->fd == -1 ||
+	    bcWriterPut(&writer, &header, sizeof(bc_jnl_hdr_t)) != 0 ||
+	    bcWriterFlush(&writer) != 0 ||
+	    journalSync(journal, BC_SYNC_CHECKPOINT) != 0)
+	{
+		fprintf(stderr, "bcJournalCreate: failed to write header\n");
+		if (journal->fd != -1)
+			close(journal->fd);
+		free(journal);
+		return (NULL);
+	}
+	journal->size = writer.pos;
+
+	return (journal);
+}
+
+
+/**
+ * bcJournalAppend - appends a block newly added to a blockchain to its
+ *   journal, followed by a checkpoint of its unspent outputs every
+ *   BC_JOURNAL_CKPT_BLOCKS blocks
+ *
+ * @journal: pointer to journal
+ * @block: block added to the blockchain
+ * @unspent: unspent outputs of the blockchain, `block` included
+ *
+ * Return: 0 on success, 1 upon failure to append the block, the journal left
+ *   as it was, or 2 if the block was appended but not the checkpoint, which
+ *   is then retried with the next block
+ */
+int bcJournalAppend(bc_journal_t *journal, block_t *block, llist_t *unspent)
+{
+	bc_writer_t writer;
+	uint8_t type = HJNL_REC_BLOCK;
+
+	if (!journal || !block || !unspent)
+	{
+		fprintf(stderr, "bcJournalAppend: NULL parameter(s)\n");
+		return (1);
+	}
+
+	bcWriterInit(&writer, journal->fd);
+	if (bcWriterPut(&writer, &type, 1) != 0 ||
+	    writeBlock(block, block->info.index, &writer) != 0 ||
+	    bcWriterFlush(&writer) != 0 ||
+	    journalSync(journal, BC_SYNC_ALWAYS) != 0)
+	{
+		fprintf(stderr, "bcJournalAppend: failed to append block\n");
+		/* a partial record would hide those appended after it */
+		if (ftruncate(journal->fd, (off_t)journal->size) == -1)
+			perror("bcJournalAppend: ftruncate");
+		return (1);
+	}
+	journal->size += writer.pos;
+
+	if (++journal->since_ckpt < BC_JOURNAL_CKPT_BLOCKS)
+		return (0);
+
+	return (bcJournalCheckpoint(journal, unspent) ? 2 : 0);
+}
+
+
+/**
+ * bcJournalCheckpoint - appends all the unspent outputs of a blockchain to
+ *   its journal, so that replaying it only updates unspent outputs with the
+ *   blocks appended after
+ *
+ * @journal: pointer to journal
+ * @unspent: unspent outputs of the blockchain
+ *
+ * Return: 0 on success, or 1 upon failure, the journal left as it was
+ */
+int bcJournalCheckpoint(bc_journal_t *journal, llist_t *unspent)
+{
+	bc_writer_t writer;
+	uint8_t type = HJNL_REC_UNSPENT;
+	int unspent_ct;
+
+	if (!journal || !unspent)
+	{
+		fprintf(stderr, "bcJournalCheckpoint: NULL parameter(s)\n");
+		return (1);
+	}
+
+	unspent_ct = llist_size(unspent);
+	bcWriterInit(&writer, journal->fd);
+	if (unspent_ct == -1 ||
+	    bcWriterPut(&writer, &type, 1) != 0 ||
+	    bcWriterPut(&writer, &unspent_ct, sizeof(uint32_t)) != 0 ||
+	    llist_for_each(unspent, (node_func_t)writeUnspent, &writer) < 0 ||
+	    bcWriterFlush(&writer) != 0 ||
+	    journalSync(journal, BC_SYNC_CHECKPOINT) != 0)
+	{
+		fprintf(stderr, "bcJournalCheckpoint: failed to append\n");
+		if (ftruncate(journal->fd, (off_t)journal->size) == -1)
+			perror("bcJournalCheckpoint: ftruncate");
+		return (1);
+	}
+	journal->size += writer.pos;
+	journal->since_ckpt = 0;
+
+	return (0);
+}
+
+
+/**
+ * journalScan - measures the records of a journal without decoding them
+ *
+ * @reader: pointer to reader over the mapped journal, past its header
+ * @bswap: nonzero if the journal endianness differs from the local one
+ * @end: modified by reference to the offset of the end of the last complete
+ *   record; an incomplete one may follow, from an interrupted append
+ * @ckpt: modified by reference to the offset of the last checkpoint, or 0
+ *
+ * Return: 0 on success, or 1 if a record is invalid
+ */
+static int journalScan(bc_reader_t const *reader, int bswap, size_t *end,
+		       size_t *ckpt)
+{
+	uint8_t const *rec;
+	size_t pos = reader->pos, avail, need;
+	int ret;
+
+	*end = pos;
+	*ckpt = 0;
+	while (pos < reader->sz)
+	{
+		rec = reader->buf + pos;
+		avail = reader->sz - pos - 1;
+		if (*rec == HJNL_REC_BLOCK)
+			ret = blockSerialSz(rec + 1, avail, bswap, &need, NULL);
+		else if (*rec == HJNL_REC_UNSPENT)
+		{
+			need = sizeof(uint32_t);
+			if (avail >= need)
+				need += (size_t)loadU32(rec + 1, bswap) *
+					BC_UNSPENT_SERIAL_SZ;
+			ret = avail >= need;
+		}
+		else
+		{
+			fprintf(stderr, "journalScan: invalid record type\n");
+			return (1);
+		}
+		if (ret < 0)
+			return (1);
+		if (ret == 0)
+			break;
+		if (*rec == HJNL_REC_UNSPENT)
+			*ckpt = pos;
+		pos += 1 + need;
+		*end = pos;
+	}
+
+	return (0);
+}
+
+
+/**
+ * replaceUnspent - replaces the unspent outputs of a blockchain with those
+ *   of a journal checkpoint
+ *
+ * @reader: pointer to reader over the mapped journal, past the record type
+ * @blockchain: pointer to the blockchain to amend
+ * @local_endianness: 1 for little endian, 2 for big endian
+ * @hjnl_endian: endianness of the journal
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+static int replaceUnspent(bc_reader_t *reader, blockchain_t *blockchain,
+			  uint8_t local_endianness, uint8_t hjnl_endian)
+{
+	unspent_tx_out_t *unspent_tx_out;
+	llist_t *unspent;
+	utxo_index_t *index = NULL;
+	uint32_t unspent_ct, i;
+
+	unspent_ct = loadU32(reader->buf + reader->pos,
+			     local_endianness != hjnl_endian);
+	reader->pos += sizeof(uint32_t);
+	unspent = llist_create(MT_SUPPORT_FALSE);
+	if (unspent)
+		index = unspentIndexCreate(unspent);
+	if (!index)
+	{
+		fprintf(stderr, "replaceUnspent: failed to create list\n");
+		if (unspent)
+			llist_destroy(unspent, 0, NULL);
+		return (1);
+	}
+	for (i = 0; i < unspent_ct; i++)
+	{
+		unspent_tx_out = readUnspentTxOut(reader, local_endianness,
+						  hjnl_endian);
+		if (!unspent_tx_out ||
+		    unspentAdd(unspent, index, unspent_tx_out) != 0)
+		{
+			fprintf(stderr, "replaceUnspent: %s\n",
+				"failed to add unspent output");
+			free(unspent_tx_out);
+			unspentIndexDestroy(index);
+			llist_destroy(unspent, 1, NULL);
+			return (1);
+		}
+	}
+	unspentIndexDestroy(blockchain->unspent_index);
+	llist_destroy(blockchain->unspent, 1, NULL);
+	blockchain->unspent = unspent;
+	blockchain->unspent_index = index;
+
+	return (0);
+}
+
+
+/**
+ * replayBlock - appends a journaled block to a blockchain
+ *
+ * @reader: pointer to reader over the mapped journal, past the record type
+ * @blockchain: pointer to the blockchain to amend
+ * @header: journal header, with fields in local endianness
+ * @update: nonzero if the unspent outputs of the blockchain are to be
+ *   updated with the block, zero if a later checkpoint covers it
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+static int replayBlock(bc_reader_t *reader, blockchain_t *blockchain,
+		       bc_jnl_hdr_t const *header, int update)
+{
+	block_t *block, *prev;
+	llist_t *unspent;
+
+	block = readBlock(reader, _get_endianness(), header->hjnl_endian);
+	if (!block)
+		return (1);
+	prev = llist_get_tail(blockchain->chain);
+	if (!prev || block->info.index != prev->info.index + 1 ||
+	    memcmp(block->info.prev_hash, prev->hash,
+		   SHA256_DIGEST_LENGTH) != 0)
+	{
+		fprintf(stderr, "replayBlock: block %u does not extend chain\n",
+			block->info.index);
+		block_destroy(block);
+		return (1);
+	}
+	if (update)
+	{
+		/* amended in place, along with its index */
+		unspent = updateUnspent(block->transactions, block->hash,
+					blockchain->unspent,
+					blockchain->unspent_index);
+		if (!unspent)
+		{
+			fprintf(stderr,
+				"replayBlock: updateUnspent failure\n");
+			block_destroy(block);
+			return (1);
+		}
+	}
+	if (chainAdd(blockchain, block) != 0)
+	{
+		fprintf(stderr, "replayBlock: chainAdd failure\n");
+		block_destroy(block);
+		return (1);
+	}
+
+	return (0);
+}
+
+
+/**
+ * replayRecords - replays the complete records of a journal; blocks only
+ *   update unspent outputs after the last checkpoint, which replaces them
+ *
+ * @reader: pointer to reader over the mapped journal, past its header
+ * @blockchain: pointer to the blockchain to amend
+ * @header: journal header, with fields in local endianness
+ * @end: offset of the end of the last complete record, see journalScan
+ * @ckpt: offset of the last checkpoint, or 0, see journalScan
+ * @since_ckpt: modified by reference to the number of blocks replayed after
+ *   the last checkpoint
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+static int replayRecords(bc_reader_t *reader, blockchain_t *blockchain,
+			 bc_jnl_hdr_t const *header, size_t end,
+			 size_t ckpt, uint32_t *since_ckpt)
+{
+	uint8_t local_endianness = _get_endianness();
+	size_t rec;
+	uint32_t unspent_ct;
+
+	*since_ckpt = 0;
+	while (reader->pos < end)
+	{
+		rec = reader->pos++;
+		if (reader->buf[rec] == HJNL_REC_BLOCK)
+		{
+			if (replayBlock(reader, blockchain, header,
+					rec > ckpt) != 0)
+				return (1);
+			*since_ckpt += rec > ckpt;
+		}
+		else if (rec == ckpt)
+		{
+			if (replaceUnspent(reader, blockchain, local_endianness,
+					   header->hjnl_endian) != 0)
+				return (1);
+		}
+		else
+		{
+			/* superseded checkpoint, sized by journalScan */
+			unspent_ct = loadU32(reader->buf + reader->pos,
+					     local_endianness !=
+					     header->hjnl_endian);
+			reader->pos += sizeof(uint32_t) +
+				(size_t)unspent_ct * BC_UNSPENT_SERIAL_SZ;
+		}
+	}
+
+	return (0);
+}
+
+
+/**
+ * bcJournalReplay - appends the blocks of the journal of a blockchain file,
+ *   if any, to the blockchain just deserialized from it, and reopens the
+ *   journal for appending
+ *
+ * @path: path to the blockchain file, the journal being named after it
+ * @blockchain: pointer to the blockchain deserialized from `path`
+ * @journal: modified by reference to the reopened journal, or to NULL if
+ *   there is none, or if it is in another endianness (journaling then stops
+ *   until the blockchain is saved again)
+ *
+ * Return: 0 on success, or 1 if the journal is invalid or upon failure; an
+ *   incomplete last record, left by an interrupted append, is dropped
+ */
+int bcJournalReplay(char const *path, blockchain_t *blockchain,
+		    bc_journal_t **journal)
+{
+	bc_reader_t reader;
+	bc_jnl_hdr_t header;
+	block_t *tail;
+	size_t end, ckpt;
+	uint32_t since_ckpt;
+	char *jpath;
+	int fd, bswap;
+
+	if (!path || !blockchain || !journal)
+	{
+		fprintf(stderr, "bcJournalReplay: NULL parameter(s)\n");
+		return (1);
+	}
+	*journal = NULL;
+	jpath = journalPath(path);
+	if (!jpath)
+		return (1);
+	fd = open(jpath, O_RDWR | O_APPEND);
+	free(jpath);
+	if (fd == -1 && errno == ENOENT)
+		return (0);
+	if (fd == -1)
+	{
+		perror("bcJournalReplay: open");
+		return (1);
+	}
+	if (bcReaderMap(&reader, fd) != 0 ||
+	    bcReaderTake(&reader, &header, sizeof(bc_jnl_hdr_t)) != 0 ||
+	    memcmp(header.hjnl_magic, HJNL_MAG, HJNL_MAG_LEN) != 0 ||
+	    !hblkVerCompat(header.hblk_version) ||
+	    header.hjnl_sync > BC_SYNC_ALWAYS)
+	{
+		fprintf(stderr, "bcJournalReplay: invalid journal header\n");
+		bcReaderUnmap(&reader);
+		close(fd);
+		return (1);
+	}
+	bswap = _get_endianness() != header.hjnl_endian;
+	header.base_blocks = loadU32((uint8_t *)&(header.base_blocks), bswap);
+
+	tail = llist_get_tail(blockchain->chain);
+	if (!tail || (uint32_t)llist_size(blockchain->chain) !=
+	    header.base_blocks ||
+	    memcmp(tail->hash, header.base_hash, SHA256_DIGEST_LENGTH) != 0 ||
+	    journalScan(&reader, bswap, &end, &ckpt) != 0 ||
+	    replayRecords(&reader, blockchain, &header, end, ckpt,
+			  &since_ckpt) != 0)
+	{
+		fprintf(stderr, "bcJournalReplay: %s\n",
+			"journal does not extend blockchain");
+		bcReaderUnmap(&reader);
+		close(fd);
+		return (1);
+	}
+	if (end < reader.sz)
+	{
+		fprintf(stderr,
+			"bcJournalReplay: dropped incomplete last record\n");
+		if (!bswap && ftruncate(fd, (off_t)end) == -1)
+			perror("bcJournalReplay: ftruncate");
+	}
+	bcReaderUnmap(&reader);
+
+	*journal = bswap ? NULL : malloc(sizeof(bc_journal_t));
+	if (!*journal)
+	{
+		close(fd);
+		return (0);
+	}
+	(*journal)->fd = fd;
+	(*journal)->sync = (bc_sync_t)header.hjnl_sync;
+	(*journal)->size = end;
+	(*journal)->since_ckpt = since_ckpt;
+
+	return (0);
+}
+
+
+/**
+ * bcJournalRemove - deletes the journal of a blockchain file, if any; to be
+ *   called once the file is overwritten, as the journal no longer extends it
+ *
+ * @path: path to the blockchain file
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+int bcJournalRemove(char const *path)
+{
+	char *jpath;
+	int ret = 0;
+
+	if (!path)
+	{
+		fprintf(stderr, "bcJournalRemove: NULL parameter\n");
+		return (1);
+	}
+
+	jpath = journalPath(path);
+	if (!jpath)
+		return (1);
+	if (unlink(jpath) == -1 && errno != ENOENT)
+	{
+		perror("bcJournalRemove: unlink");
+		ret = 1;
+	}
+	free(jpath);
+
+	return (ret);
+}
+
+
+/**
+ * bcJournalClose - flushes a journal to disk unless its sync policy is
+ *   BC_SYNC_NEVER, then closes it
+ *
+ * @journal: pointer to journal to release, may be NULL
+ */
+void bcJournalClose(bc_journal_t *journal)
+{
+	if (!journal)
+		return;
+
+	journalSync(journal, BC_SYNC_CHECKPOINT);
+	close(journal->fd);
+	free(journal);
+}
@@ -0,0 +1,225 @@
+/* bl_pool_t bc_reader_t block_t BC_LOAD_BATCH BLOCK_MINE_THREADS_MAX */
+#include "blockchain.h"
+/* fprintf */
+#include <stdio.h>
+/* malloc calloc free */
+#include <stdlib.h>
+/* pthread_create pthread_join */
+#include <pthread.h>
+/* llist_* */
+#include <llist.h>
+
+
+/**
+ * scanBlocks - locates every block of a mapped file by measuring their
+ *   serialized sizes, without decoding any of them
+ *
+ * @reader: pointer to reader over the mapped file, positioned at its first
+ *   block; advanced past the last block on success
+ * @pool: pointer to pool to amend, pool->offs having room for one more
+ *   member than pool->block_ct
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+static int scanBlocks(bc_reader_t *reader, bl_pool_t *pool)
+{
+	size_t off = reader->pos, need;
+	uint32_t i;
+	int ret;
+
+	for (i = 0; i < pool->block_ct; i++)
+	{
+		pool->offs[i] = off;
+		ret = blockSerialSz(reader->buf + off, reader->sz - off,
+				    pool->local_endianness !=
+				    pool->hblk_endian, &need, NULL);
+		if (ret != 1)
+		{
+			if (ret == 0)
+				fprintf(stderr, "scanBlocks: %s\n",
+					"unexpected end of file");
+			return (1);
+		}
+		off += need;
+	}
+	pool->offs[i] = off;
+	reader->pos = off;
+
+	return (0);
+}
+
+
+/**
+ * loadWorker - start routine of a readBlocksMT worker thread, claims and
+ *   decodes batches of consecutive blocks until none is left
+ *
+ * @pool: pointer to pool shared by every worker
+ *
+ * Return: always NULL, results are reported in pool->blocks
+ */
+static void *loadWorker(bl_pool_t *pool)
+{
+	bc_reader_t reader = *(pool->reader);
+	size_t i, end;
+
+	for (;;)
+	{
+		i = __atomic_fetch_add(&(pool->next), BC_LOAD_BATCH,
+				       __ATOMIC_RELAXED);
+		if (i >= pool->block_ct ||
+		    __atomic_load_n(&(pool->failed), __ATOMIC_RELAXED))
+			break;
+		end = pool->block_ct - i < BC_LOAD_BATCH ?
+			pool->block_ct : i + BC_LOAD_BATCH;
+		for (; i < end; i++)
+		{
+			/* bounded by the next block, see scanBlocks */
+			reader.pos = pool->offs[i];
+			reader.sz = pool->offs[i + 1];
+			pool->blocks[i] = readBlock(&reader,
+						    pool->local_endianness,
+						    pool->hblk_endian);
+			if (!pool->blocks[i] || reader.pos != reader.sz)
+			{
+				fprintf(stderr, "loadWorker: %s %lu\n",
+					"failed to decode block", i);
+				__atomic_store_n(&(pool->failed), 1,
+						 __ATOMIC_RELAXED);
+				return (NULL);
+			}
+		}
+	}
+
+	return (NULL);
+}
+
+
+/**
+ * loadPool - decodes every block of a pool, spreading them between
+ *   `thread_ct` workers; the calling thread acts as the first worker
+ *
+ * @pool: pointer to pool of blocks to decode
+ * @thread_ct: amount of workers, at least 1
+ */
+static void loadPool(bl_pool_t *pool, unsigned int thread_ct)
+{
+	pthread_t *tids;
+	unsigned int spawned = 1;
+
+	pool->next = 0;
+	if (thread_ct > pool->block_ct / BC_LOAD_BATCH)
+		thread_ct = pool->block_ct / BC_LOAD_BATCH ?
+			pool->block_ct / BC_LOAD_BATCH : 1;
+	tids = thread_ct > 1 ? malloc(thread_ct * sizeof(pthread_t)) : NULL;
+	/* remaining blocks are decoded by the calling thread on any failure */
+	for (; tids && spawned < thread_ct; spawned++)
+		if (pthread_create(tids + spawned, NULL,
+				   (void *(*)(void *))loadWorker, pool) != 0)
+			break;
+	loadWorker(pool);
+	while (tids && --spawned > 0)
+		pthread_join(tids[spawned], NULL);
+	free(tids);
+}
+
+
+/**
+ * linkBlocks - appends the decoded blocks of a pool to a chain in order, and
+ *   frees any block left unlinked
+ *
+ * @pool: pointer to pool of decoded blocks
+ * @blockchain: pointer to blockchain to amend
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+static int linkBlocks(bl_pool_t *pool, blockchain_t *blockchain)
+{
+	uint32_t i = 0;
+	int ret;
+
+	if (!pool->failed)
+	{
+		for (; i < pool->block_ct; i++)
+		{
+			if (chainAdd(blockchain, pool->blocks[i]) != 0)
+			{
+				fprintf(stderr,
+					"linkBlocks: chainAdd failure\n");
+				break;
+			}
+		}
+	}
+	ret = i < pool->block_ct;
+	for (; i < pool->block_ct; i++)
+		if (pool->blocks[i])
+			block_destroy(pool->blocks[i]);
+
+	return (ret);
+}
+
+
+/**
+ * readBlocksMT - reads serialized blocks from a mapped storage file into a
+ *   blockchain data structure, as readBlocks does, decoding them with
+ *   several threads; blocks are first located by a serial scan, then
+ *   decoded in parallel, then linked in chain order
+ *
+ * @reader: pointer to reader over the mapped file, positioned at its first
+ *   block; advanced past the last block on success
+ * @blockchain: pointer to a blockchain without blocks (Genesis Block
+ *   removed) to contain the deserialized blocks
+ * @local_endianness: 1 for little endian, 2 for big endian
+ * @header: stores values read from file header
+ * @thread_ct: amount of threads to use, or 0 for one per online processor;
+ *   bound to BLOCK_MINE_THREADS_MAX
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+int readBlocksMT(bc_reader_t *reader, blockchain_t *blockchain,
+		 uint8_t local_endianness, bc_file_hdr_t *header,
+		 unsigned int thread_ct)
+{
+	bl_pool_t pool = {NULL, NULL, NULL, 0, 0, 0, 0, 0};
+	int ret;
+
+	if (!reader || !blockchain || !header)
+	{
+		fprintf(stderr, "readBlocksMT: NULL parameter(s)\n");
+		return (1);
+	}
+	if (!llist_is_empty(blockchain->chain))
+	{
+		fprintf(stderr, "readBlocksMT: target blockchain not empty\n");
+		return (1);
+	}
+	pool.reader = reader;
+	pool.block_ct = header->hblk_blocks;
+	pool.local_endianness = local_endianness;
+	pool.hblk_endian = header->hblk_endian;
+	pool.offs = malloc(((size_t)pool.block_ct + 1) * sizeof(size_t));
+	pool.blocks = calloc((size_t)pool.block_ct + 1, sizeof(block_t *));
+	if (!pool.offs || !pool.blocks)
+	{
+		fprintf(stderr, "readBlocksMT: allocation failure\n");
+		free(pool.offs);
+		free(pool.blocks);
+		return (1);
+	}
+	if (scanBlocks(reader, &pool) != 0)
+	{
+		free(pool.offs);
+		free(pool.blocks);
+		return (1);
+	}
+
+	if (thread_ct == 0)
+		thread_ct = minerThreadCt();
+	else if (thread_ct > BLOCK_MINE_THREADS_MAX)
+		thread_ct = BLOCK_MINE_THREADS_MAX;
+	loadPool(&pool, thread_ct);
+	ret = linkBlocks(&pool, blockchain);
+	free(pool.offs);
+	free(pool.blocks);
+
+	return (ret);
+}
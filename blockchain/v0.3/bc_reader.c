@@ -0,0 +1,105 @@
+/* bc_reader_t */
+#include "blockchain.h"
+/* fstat `struct stat` */
+#include <sys/types.h>
+#include <sys/stat.h>
+/* mmap munmap madvise PROT_* MAP_* MADV_* */
+#include <sys/mman.h>
+/* fprintf perror */
+#include <stdio.h>
+/* memcpy */
+#include <string.h>
+
+
+/**
+ * bcReaderMap - maps a whole file in memory to be deserialized
+ *
+ * @reader: pointer to the reader to initialize
+ * @fd: file descriptor already open for reading, can be closed once mapped
+ *
+ * Return: 0 on success, 1 upon failure, or 2 if `fd` is not a regular file,
+ *   to be read as a stream instead (see blockchainFromStream)
+ */
+int bcReaderMap(bc_reader_t *reader, int fd)
+{
+	struct stat st;
+	void *map;
+
+	if (!reader)
+	{
+		fprintf(stderr, "bcReaderMap: NULL parameter\n");
+		return (1);
+	}
+	reader->buf = NULL;
+	reader->sz = reader->pos = 0;
+
+	if (fstat(fd, &st) == -1)
+	{
+		perror("bcReaderMap: fstat");
+		return (1);
+	}
+	if (!S_ISREG(st.st_mode))
+		return (2);
+	/* mmap fails on an empty file, which has nothing to read anyway */
+	if (st.st_size <= 0)
+		return (0);
+
+	map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (map == MAP_FAILED)
+	{
+		perror("bcReaderMap: mmap");
+		return (1);
+	}
+	/* only a hint, the mapping is read front to back */
+	madvise(map, (size_t)st.st_size, MADV_SEQUENTIAL);
+	reader->buf = map;
+	reader->sz = (size_t)st.st_size;
+
+	return (0);
+}
+
+
+/**
+ * bcReaderUnmap - unmaps the file of a reader
+ *
+ * @reader: pointer to the reader to release
+ */
+void bcReaderUnmap(bc_reader_t *reader)
+{
+	if (!reader)
+		return;
+
+	if (reader->buf)
+		munmap((void *)reader->buf, reader->sz);
+	reader->buf = NULL;
+	reader->sz = reader->pos = 0;
+}
+
+
+/**
+ * bcReaderTake - copies the next bytes of a mapped file
+ *
+ * @reader: pointer to the reader to copy from
+ * @dest: buffer of at least `len` bytes
+ * @len: amount of bytes to copy
+ *
+ * Return: 0 on success, or 1 if less than `len` bytes are left to read
+ */
+int bcReaderTake(bc_reader_t *reader, void *dest, size_t len)
+{
+	if (!reader || (!dest && len))
+	{
+		fprintf(stderr, "bcReaderTake: NULL parameter(s)\n");
+		return (1);
+	}
+
+	if (len > reader->sz - reader->pos)
+	{
+		fprintf(stderr, "bcReaderTake: unexpected end of file\n");
+		return (1);
+	}
+	memcpy(dest, reader->buf + reader->pos, len);
+	reader->pos += len;
+
+	return (0);
+}
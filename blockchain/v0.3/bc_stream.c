@@ -0,0 +1,408 @@
+/* bc_stream_t bc_measure_t blockchain_t chainAdd BC_STREAM_* BC_*_SERIAL_SZ */
+#include "blockchain.h"
+/* read */
+#include <unistd.h>
+/* errno EINTR */
+#include <errno.h>
+/* fprintf perror */
+#include <stdio.h>
+/* malloc realloc free */
+#include <stdlib.h>
+/* memcpy memset */
+#include <string.h>
+/* _get_endianness _swap_endian */
+#include "provided/endianness.h"
+/* llist_* */
+#include <llist.h>
+
+
+/**
+ * loadU32 - reads a serialized 32-bit field
+ *
+ * @bytes: first byte of the field, not necessarily aligned
+ * @bswap: nonzero if the file endianness differs from the local one
+ *
+ * Return: value of the field
+ */
+uint32_t loadU32(uint8_t const *bytes, int bswap)
+{
+	uint32_t value;
+
+	memcpy(&value, bytes, sizeof(uint32_t));
+	if (bswap)
+	{
+#ifdef __GNUC__ /* compiled with gcc, can use gcc builtins for fast assembly */
+		value = __builtin_bswap32(value);
+#else /* use function to manually byte swap */
+		_swap_endian(&value, 4);
+#endif
+	}
+
+	return (value);
+}
+
+
+/**
+ * blockMeasure - measures a serialized block and its transactions as
+ *   blockSerialSz does, resuming after the transactions measured by previous
+ *   calls on the first bytes of the same block, so that a block fed a few
+ *   bytes at a time is still measured in a single pass
+ *
+ * @bytes: serialized block, or its first bytes
+ * @len: amount of bytes available
+ * @bswap: nonzero if the file endianness differs from the local one
+ * @at: pointer to the progress of the measure, zeroed before the first call
+ *   on a block; at->mem is the size of the arena the block decodes into once
+ *   complete, see bc_arena_t
+ * @need: modified by reference to the size of the block if complete,
+ *   otherwise to the amount of bytes needed to measure it further
+ *
+ * Return: 1 if the block is complete, 0 if not, or -1 if invalid
+ */
+int blockMeasure(uint8_t const *bytes, size_t len, int bswap,
+		 bc_measure_t *at, size_t *need)
+{
+	size_t sz = sizeof(block_info_t) + sizeof(uint32_t);
+	uint32_t data_len, nb_inputs, nb_outputs;
+
+	if (!at->sz)
+	{
+		*need = sz;
+		if (len < sz)
+			return (0);
+		data_len = loadU32(bytes + sizeof(block_info_t), bswap);
+		if (data_len > BLOCKCHAIN_DATA_MAX)
+		{
+			fprintf(stderr,
+				"blockMeasure: block data over max length\n");
+			return (-1);
+		}
+		sz += data_len + SHA256_DIGEST_LENGTH + sizeof(int32_t);
+		*need = sz;
+		if (len < sz)
+			return (0);
+		/* -1 for the Genesis Block, see writeBlock */
+		at->tx_ct = (int32_t)loadU32(bytes + sz - sizeof(int32_t),
+					     bswap);
+		at->tx_done = 0;
+		at->sz = sz;
+		at->mem = BC_ARENA_ALIGN(sizeof(block_t));
+	}
+	for (; at->tx_done < at->tx_ct; at->tx_done++)
+	{
+		*need = at->sz + BC_TX_HDR_SERIAL_SZ;
+		if (len < *need)
+			return (0);
+		nb_inputs = loadU32(bytes + at->sz + SHA256_DIGEST_LENGTH,
+				    bswap);
+		nb_outputs = loadU32(bytes + at->sz + SHA256_DIGEST_LENGTH +
+				     sizeof(uint32_t), bswap);
+		at->sz = *need + (size_t)nb_inputs * sizeof(tx_in_t) +
+			(size_t)nb_outputs * BC_TX_OUT_SERIAL_SZ;
+		at->mem += BC_ARENA_ALIGN(sizeof(transaction_t)) +
+			nb_inputs * BC_ARENA_ALIGN(sizeof(tx_in_t)) +
+			nb_outputs * BC_ARENA_ALIGN(sizeof(tx_out_t));
+	}
+	*need = at->sz;
+
+	return (len >= at->sz);
+}
+
+
+/**
+ * blockSerialSz - measures a serialized block and its transactions, see
+ *   writeBlock, without decoding it
+ *
+ * @bytes: serialized block, or its first bytes
+ * @len: amount of bytes available
+ * @bswap: nonzero if the file endianness differs from the local one
+ * @need: modified by reference to the size of the block if complete,
+ *   otherwise to the amount of bytes needed to measure it further
+ * @arena_sz: if not NULL, modified by reference to the size of the arena
+ *   the block decodes into if complete, see bc_arena_t
+ *
+ * Return: 1 if the block is complete, 0 if not, or -1 if invalid
+ */
+int blockSerialSz(uint8_t const *bytes, size_t len, int bswap, size_t *need,
+		  size_t *arena_sz)
+{
+	bc_measure_t at = {0, 0, 0, 0};
+	int ret;
+
+	ret = blockMeasure(bytes, len, bswap, &at, need);
+	if (ret == 1 && arena_sz)
+		*arena_sz = at.mem;
+
+	return (ret);
+}
+
+
+/**
+ * decodeRecord - decodes the next record of a stream if complete, appending
+ *   it to a blockchain
+ *
+ * @stream: pointer to decoder, stream->need is set to the size of the record
+ *   if complete, otherwise to the amount of bytes needed to measure it
+ *   further
+ * @bytes: serialized record, or its first bytes
+ * @len: amount of bytes available
+ * @blockchain: pointer to the blockchain to amend
+ *
+ * Return: 1 if decoded, taking stream->need bytes, 0 if not complete yet,
+ *   or -1 upon failure
+ */
+static int decodeRecord(bc_stream_t *stream, uint8_t const *bytes,
+			size_t len, blockchain_t *blockchain)
+{
+	bc_reader_t reader = {NULL, 0, 0};
+	block_t *block;
+	unspent_tx_out_t *unspent_tx_out;
+	int ret = 1;
+
+	if (stream->state == BC_STREAM_HEADER)
+		stream->need = sizeof(bc_file_hdr_t);
+	else if (stream->state == BC_STREAM_BLOCKS)
+		ret = blockMeasure(bytes, len, stream->local_endianness !=
+				   stream->header.hblk_endian,
+				   &(stream->measure), &(stream->need));
+	else
+		stream->need = BC_UNSPENT_SERIAL_SZ;
+	if (ret != 1 || len < stream->need)
+		return (ret < 0 ? -1 : 0);
+	reader.buf = bytes;
+	reader.sz = stream->need;
+
+	if (stream->state == BC_STREAM_HEADER)
+	{
+		if (readBlkchnFileHdr(&reader, stream->local_endianness,
+				      &(stream->header)) != 0)
+			return (-1);
+		stream->blocks_left = stream->header.hblk_blocks;
+		stream->unspent_left = stream->header.hblk_unspent;
+	}
+	else if (stream->state == BC_STREAM_BLOCKS)
+	{
+		block = readBlock(&reader, stream->local_endianness,
+				  stream->header.hblk_endian);
+		if (!block)
+			return (-1);
+		if (chainAdd(blockchain, block) != 0)
+		{
+			fprintf(stderr, "decodeRecord: chainAdd failure\n");
+			block_destroy(block);
+			return (-1);
+		}
+		memset(&(stream->measure), 0, sizeof(bc_measure_t));
+		stream->blocks_left--;
+	}
+	else
+	{
+		unspent_tx_out = readUnspentTxOut(&reader,
+						  stream->local_endianness,
+						  stream->header.hblk_endian);
+		if (!unspent_tx_out)
+			return (-1);
+		if (unspentAdd(blockchain->unspent, blockchain->unspent_index,
+			       unspent_tx_out) != 0)
+		{
+			fprintf(stderr, "decodeRecord: unspentAdd failure\n");
+			free(unspent_tx_out);
+			return (-1);
+		}
+		stream->unspent_left--;
+	}
+	stream->state = stream->blocks_left ? BC_STREAM_BLOCKS :
+		stream->unspent_left ? BC_STREAM_UNSPENT : BC_STREAM_DONE;
+
+	return (1);
+}
+
+
+/**
+ * bufferRecord - copies the bytes of a split record to the buffer of a
+ *   stream, up to the amount of bytes it is known to need
+ *
+ * @stream: pointer to decoder
+ * @bytes: pointer to the bytes fed, advanced past those copied
+ * @len: pointer to the amount of bytes fed, decremented by those copied
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+static int bufferRecord(bc_stream_t *stream, uint8_t const **bytes,
+			size_t *len)
+{
+	size_t take = stream->need - stream->len, cap;
+	uint8_t *buf;
+
+	if (take > *len)
+		take = *len;
+	if (stream->len + take > stream->cap)
+	{
+		cap = stream->cap * 2;
+		if (cap < stream->len + take)
+			cap = stream->len + take;
+		buf = realloc(stream->buf, cap);
+		if (!buf)
+		{
+			fprintf(stderr, "bufferRecord: realloc failure\n");
+			return (1);
+		}
+		stream->buf = buf;
+		stream->cap = cap;
+	}
+	memcpy(stream->buf + stream->len, *bytes, take);
+	stream->len += take;
+	*bytes += take;
+	*len -= take;
+
+	return (0);
+}
+
+
+/**
+ * bcStreamInit - prepares a decoder for a new serialized blockchain
+ *
+ * @stream: pointer to the decoder to initialize
+ */
+void bcStreamInit(bc_stream_t *stream)
+{
+	if (!stream)
+	{
+		fprintf(stderr, "bcStreamInit: NULL parameter\n");
+		return;
+	}
+
+	memset(stream, 0, sizeof(bc_stream_t));
+	stream->state = BC_STREAM_HEADER;
+	stream->local_endianness = _get_endianness();
+}
+
+
+/**
+ * bcStreamFeed - decodes the next bytes of a serialized blockchain, see
+ *   blockchain_serialize for serialization format
+ *
+ * @stream: pointer to decoder
+ * @bytes: next bytes of the serialized blockchain
+ * @len: amount of bytes, any
+ * @blockchain: pointer to the blockchain to which each decoded block and
+ *   unspent output is appended, with its Genesis Block removed
+ *
+ * Return: amount of blocks appended, 0 if `bytes` complete none, or -1 upon
+ *   failure; bytes past the last unspent output are ignored
+ */
+int bcStreamFeed(bc_stream_t *stream, void const *bytes, size_t len,
+		 blockchain_t *blockchain)
+{
+	uint8_t const *next = bytes;
+	bc_stream_state_t state;
+	int blocks = 0, ret;
+
+	if (!stream || (!bytes && len) || !blockchain)
+	{
+		fprintf(stderr, "bcStreamFeed: NULL parameter(s)\n");
+		return (-1);
+	}
+
+	while (len && stream->state != BC_STREAM_DONE)
+	{
+		state = stream->state;
+		/* split record: complete it in the buffer first */
+		if (stream->len)
+		{
+			if (bufferRecord(stream, &next, &len) != 0)
+				return (-1);
+			if (stream->len < stream->need)
+				break;
+			ret = decodeRecord(stream, stream->buf, stream->len,
+					   blockchain);
+			if (ret == 1)
+				stream->len = 0;
+		}
+		else
+		{
+			ret = decodeRecord(stream, next, len, blockchain);
+			if (ret == 1)
+			{
+				next += stream->need;
+				len -= stream->need;
+			}
+			else if (ret == 0 &&
+				 bufferRecord(stream, &next, &len) != 0)
+				return (-1);
+		}
+		if (ret < 0)
+			return (-1);
+		blocks += ret == 1 && state == BC_STREAM_BLOCKS;
+	}
+
+	return (blocks);
+}
+
+
+/**
+ * bcStreamFree - releases the buffer of a decoder
+ *
+ * @stream: pointer to the decoder to release
+ */
+void bcStreamFree(bc_stream_t *stream)
+{
+	if (!stream)
+		return;
+
+	free(stream->buf);
+	stream->buf = NULL;
+	stream->len = stream->cap = 0;
+}
+
+
+/**
+ * blockchainFromStream - deserializes a blockchain from a file descriptor
+ *   that cannot be mapped in memory, such as a pipe
+ *
+ * @fd: file descriptor already open for reading, read until the whole
+ *   blockchain is decoded
+ *
+ * Return: pointer to deserialized blockchain, or NULL on failure
+ */
+blockchain_t *blockchainFromStream(int fd)
+{
+	uint8_t chunk[BC_STREAM_CHUNK_SZ];
+	bc_stream_t stream;
+	blockchain_t *blockchain;
+	ssize_t got = 1;
+
+	blockchain = blockchain_create();
+	if (!blockchain)
+	{
+		fprintf(stderr,
+			"blockchainFromStream: blockchain_create failure\n");
+		return (NULL);
+	}
+	chainPopGenesis(blockchain);
+	bcStreamInit(&stream);
+
+	while (got && stream.state != BC_STREAM_DONE)
+	{
+		/* reads may return less than asked, up to 0 at end of file */
+		got = read(fd, chunk, BC_STREAM_CHUNK_SZ);
+		if (got == -1 && errno == EINTR)
+			continue;
+		if (got == -1)
+			perror("blockchainFromStream: read");
+		if (got == -1 ||
+		    bcStreamFeed(&stream, chunk, (size_t)got, blockchain) < 0)
+			break;
+	}
+	bcStreamFree(&stream);
+	if (stream.state != BC_STREAM_DONE)
+	{
+		if (got == 0)
+			fprintf(stderr, "blockchainFromStream: %s\n",
+				"unexpected end of file");
+		blockchain_destroy(blockchain);
+		return (NULL);
+	}
+
+	return (blockchain);
+}
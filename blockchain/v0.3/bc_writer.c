@@ -0,0 +1,108 @@
+/* bc_writer_t BC_WRITER_BUF_SZ */
+#include "blockchain.h"
+/* write */
+#include <unistd.h>
+/* errno EINTR */
+#include <errno.h>
+/* fprintf perror */
+#include <stdio.h>
+/* memcpy */
+#include <string.h>
+
+
+/**
+ * bcWriterInit - prepares a buffered file output
+ *
+ * @writer: pointer to the writer to initialize
+ * @fd: file descriptor open for writing
+ */
+void bcWriterInit(bc_writer_t *writer, int fd)
+{
+	if (!writer)
+	{
+		fprintf(stderr, "bcWriterInit: NULL parameter\n");
+		return;
+	}
+
+	writer->fd = fd;
+	writer->len = 0;
+	writer->pos = 0;
+	writer->index = NULL;
+}
+
+
+/**
+ * bcWriterFlush - writes all the bytes buffered by a writer to its file,
+ *   retrying partial and interrupted writes
+ *
+ * @writer: pointer to the writer to flush
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+int bcWriterFlush(bc_writer_t *writer)
+{
+	size_t done = 0;
+	ssize_t ret;
+
+	if (!writer)
+	{
+		fprintf(stderr, "bcWriterFlush: NULL parameter\n");
+		return (1);
+	}
+
+	while (done < writer->len)
+	{
+		ret = write(writer->fd, writer->buf + done, writer->len - done);
+		if (ret == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			perror("bcWriterFlush: write");
+			return (1);
+		}
+		done += (size_t)ret;
+	}
+	writer->len = 0;
+
+	return (0);
+}
+
+
+/**
+ * bcWriterPut - appends bytes to the output of a writer, flushing its buffer
+ *   each time it is full
+ *
+ * @writer: pointer to the writer to append to
+ * @src: bytes to append
+ * @len: amount of bytes to append
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+int bcWriterPut(bc_writer_t *writer, void const *src, size_t len)
+{
+	uint8_t const *bytes = src;
+	size_t chunk;
+
+	if (!writer || (!src && len))
+	{
+		fprintf(stderr, "bcWriterPut: NULL parameter(s)\n");
+		return (1);
+	}
+
+	while (len)
+	{
+		if (writer->len == BC_WRITER_BUF_SZ &&
+		    bcWriterFlush(writer) != 0)
+			return (1);
+		chunk = BC_WRITER_BUF_SZ - writer->len;
+		if (chunk > len)
+			chunk = len;
+		memcpy(writer->buf + writer->len, bytes, chunk);
+		writer->len += chunk;
+		writer->pos += chunk;
+		bytes += chunk;
+		len -= chunk;
+	}
+
+	return (0);
+}
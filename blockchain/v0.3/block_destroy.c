@@ -22,7 +22,12 @@ void block_destroy(block_t *block)
 		return;
 	}
 
-	llist_destroy(block->transactions, 1,
+	/* a block decoded into an arena is the start of its region */
+	if (block->arena_sz)
+		llist_destroy(block->transactions, 1,
+			      (node_dtor_t)arenaTxDestroy);
+	else
+		llist_destroy(block->transactions, 1,
 			      (node_dtor_t)transaction_destroy);
 
 	free(block);
@@ -2,6 +2,7 @@
 #include <stdio.h>
 #include "../../crypto/hblk_crypto.h"
 #include <string.h>
+#include <stdlib.h>
 
 
 /**
@@ -36,26 +37,22 @@ static int readTxId(transaction_t *tx, unsigned int idx, buf_info_t *buf_info)
 
 
 /**
- * block_hash - computes the hash of a block
- * @block: pointer to the block to be hashed
- * @hash_buf: pointer to buffer for storing hash value
- * Return: pointer
+ * blockPreimage - serializes the parts of a block covered by its hash: block
+ *   info, data, and the ID of every transaction
+ * @block: pointer to the block to serialize
+ * @sz: modified by reference to the size of the preimage in bytes
+ * Return: newly allocated preimage, or NULL on failure
  */
-uint8_t *block_hash(block_t const *block,
-		    uint8_t hash_buf[SHA256_DIGEST_LENGTH])
+uint8_t *blockPreimage(block_t const *block, size_t *sz)
 {
 	buf_info_t buf_info = {NULL, 0, 0};
 	int tx_ct;
 
-	if (!block || !hash_buf)
+	if (!block || !sz)
 	{
+		fprintf(stderr, "blockPreimage: NULL parameter(s)\n");
 		return (NULL);
 	}
-	if (block->info.index == 0 && !block->transactions)
-	{
-		memcpy(hash_buf, GEN_BLK_HSH, SHA256_DIGEST_LENGTH);
-		return (hash_buf);
-	}
 	buf_info.sz += sizeof(block_info_t);
 	buf_info.sz += block->data.len;
 	tx_ct = llist_size(block->transactions);
@@ -71,17 +68,150 @@ uint8_t *block_hash(block_t const *block,
 	if (llist_for_each(block->transactions,
 			   (node_func_t)readTxId, &buf_info) < 0)
 	{
-		fprintf(stderr, "block_hash: llist_for_each failure: %s\n",
+		fprintf(stderr, "blockPreimage: llist_for_each failure: %s\n",
 			strE_LLIST(llist_errno));
 		free(buf_info.buf);
 		return (NULL);
 	}
-	if (!sha256((const int8_t *)buf_info.buf, buf_info.sz, hash_buf))
+	*sz = buf_info.sz;
+	return (buf_info.buf);
+}
+
+
+/**
+ * hashTxId - copies the ID of each transaction in a block to a stack buffer,
+ *   feeding the buffer to SHA-256 whenever it is full
+ * @tx: pointer to transaction in block->transactions list, as iterated
+ *   through by llist_for_each
+ * @idx: index of `tx` in block->transactions list, as iterated through by
+ *   llist_for_each
+ * @bh_stream: pointer to struct containing the SHA-256 context being
+ *   updated and the buffer of pending transaction IDs
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int hashTxId(transaction_t *tx, unsigned int idx,
+		    bh_stream_t *bh_stream)
+{
+	buf_info_t *buf_info;
+
+	(void)idx;
+
+	if (!tx || !bh_stream)
 	{
-		fprintf(stderr, "block_hash: sha256 failure\n");
-		free(buf_info.buf);
+		fprintf(stderr, "hashTxId: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	buf_info = &(bh_stream->buf_info);
+	if (buf_info->idx + SHA256_DIGEST_LENGTH > buf_info->sz)
+	{
+		if (!SHA256_Update(&(bh_stream->sha_ctx),
+				   buf_info->buf, buf_info->idx))
+		{
+			fprintf(stderr, "hashTxId: SHA256_Update failure\n");
+			return (-2);
+		}
+		buf_info->idx = 0;
+	}
+	memcpy(buf_info->buf + buf_info->idx, &(tx->id), SHA256_DIGEST_LENGTH);
+	buf_info->idx += SHA256_DIGEST_LENGTH;
+
+	return (0);
+}
+
+
+/**
+ * block_hash - computes the hash of a block; the preimage is streamed to
+ *   SHA-256 through a stack buffer rather than serialized, so no memory is
+ *   allocated
+ * @block: pointer to the block to be hashed
+ * @hash_buf: pointer to buffer for storing hash value
+ * Return: pointer
+ */
+uint8_t *block_hash(block_t const *block,
+		    uint8_t hash_buf[SHA256_DIGEST_LENGTH])
+{
+	uint8_t id_buf[BLOCK_HASH_STREAM_IDS * SHA256_DIGEST_LENGTH];
+	bh_stream_t bh_stream;
+
+	if (!block || !hash_buf)
+	{
+		return (NULL);
+	}
+	if (block->info.index == 0 && !block->transactions)
+	{
+		memcpy(hash_buf, GEN_BLK_HSH, SHA256_DIGEST_LENGTH);
+		return (hash_buf);
+	}
+	bh_stream.buf_info.buf = id_buf;
+	bh_stream.buf_info.sz = sizeof(id_buf);
+	bh_stream.buf_info.idx = 0;
+	if (!SHA256_Init(&(bh_stream.sha_ctx)) ||
+	    !SHA256_Update(&(bh_stream.sha_ctx), block,
+			   sizeof(block_info_t) + block->data.len))
+	{
+		fprintf(stderr, "block_hash: SHA256_Update failure\n");
+		return (NULL);
+	}
+	if (llist_for_each(block->transactions,
+			   (node_func_t)hashTxId, &bh_stream) < 0)
+	{
+		fprintf(stderr, "block_hash: llist_for_each failure: %s\n",
+			strE_LLIST(llist_errno));
+		return (NULL);
+	}
+	if (!SHA256_Update(&(bh_stream.sha_ctx), id_buf,
+			   bh_stream.buf_info.idx) ||
+	    !SHA256_Final(hash_buf, &(bh_stream.sha_ctx)))
+	{
+		fprintf(stderr, "block_hash: SHA256_Final failure\n");
 		return (NULL);
 	}
-	free(buf_info.buf);
 	return (hash_buf);
 }
+
+
+/**
+ * blockHashIsValid - checks whether the hash stored in a block is the hash
+ *   of its contents; a block found valid is not hashed again until marked
+ *   dirty
+ * @block: pointer to the block to check
+ * Return: 1 if valid, 0 if not or on failure
+ */
+int blockHashIsValid(block_t const *block)
+{
+	uint8_t hash_buf[SHA256_DIGEST_LENGTH];
+
+	if (!block)
+	{
+		fprintf(stderr, "blockHashIsValid: NULL parameter\n");
+		return (0);
+	}
+	if (block->hash_ok)
+		return (1);
+
+	if (!block_hash(block, hash_buf))
+	{
+		fprintf(stderr, "blockHashIsValid: block_hash failure\n");
+		return (0);
+	}
+	if (memcmp(block->hash, hash_buf, SHA256_DIGEST_LENGTH) != 0)
+		return (0);
+	/* a cache of the check rather than part of the block value */
+	((block_t *)block)->hash_ok = 1;
+	return (1);
+}
+
+
+/**
+ * blockHashDirty - marks the hash of a block to be checked again by
+ *   blockHashIsValid, to be called after changing any field it covers: info,
+ *   data, the transaction list or hash
+ * @block: pointer to the changed block
+ */
+void blockHashDirty(block_t *block)
+{
+	if (block)
+		block->hash_ok = 0;
+}
@@ -0,0 +1,200 @@
+/* block_t block_hash_ctx_t blockPreimage */
+#include "blockchain.h"
+/* sha256_midstate sha256_resume sha256_mb_resume */
+#include "../../crypto/hblk_crypto.h"
+/* fprintf */
+#include <stdio.h>
+/* malloc free */
+#include <stdlib.h>
+/* offsetof */
+#include <stddef.h>
+/* memcpy */
+#include <string.h>
+
+
+/**
+ * blockHashCtxInit - sizes a block hashing context for a given block: builds
+ *   its preimage, and precomputes the SHA-256 state of the chunks preceding
+ *   its nonce
+ *
+ * @ctx: pointer to the caller-owned context to initialize
+ * @block: block to be hashed, possibly repeatedly with different nonces
+ *
+ * Note: with the current block_info_t layout the nonce is found in the first
+ *   64-byte chunk, so no chunk can be hashed in advance; the state is still
+ *   computed generically should the nonce move further into the preimage
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int blockHashCtxInit(block_hash_ctx_t *ctx, block_t const *block)
+{
+	if (!ctx || !block)
+	{
+		fprintf(stderr, "blockHashCtxInit: NULL parameter(s)\n");
+		return (1);
+	}
+
+	ctx->buf = blockPreimage(block, &(ctx->sz));
+	if (!ctx->buf)
+	{
+		fprintf(stderr, "blockHashCtxInit: blockPreimage failure\n");
+		return (1);
+	}
+
+	ctx->lane_buf = NULL;
+	ctx->lanes = 1;
+	ctx->nonce_idx = offsetof(block_info_t, nonce);
+	ctx->mid_len = sha256_midstate((const int8_t *)ctx->buf,
+				       ctx->nonce_idx, &(ctx->mid));
+
+	return (0);
+}
+
+
+/**
+ * blockHashCtxDup - initializes a block hashing context as a copy of another,
+ *   so that both can be used concurrently
+ *
+ * @dst: pointer to the caller-owned context to initialize
+ * @src: pointer to the initialized context to copy
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int blockHashCtxDup(block_hash_ctx_t *dst, block_hash_ctx_t const *src)
+{
+	size_t lane_sz;
+
+	if (!dst || !src || !src->buf)
+	{
+		fprintf(stderr, "blockHashCtxDup: NULL parameter(s)\n");
+		return (1);
+	}
+
+	memcpy(dst, src, sizeof(block_hash_ctx_t));
+	lane_sz = src->sz * (src->lanes - 1);
+	dst->buf = malloc(src->sz);
+	dst->lane_buf = lane_sz ? malloc(lane_sz) : NULL;
+	if (!dst->buf || (lane_sz && !dst->lane_buf))
+	{
+		fprintf(stderr, "blockHashCtxDup: malloc failure\n");
+		blockHashCtxFree(dst);
+		return (1);
+	}
+	memcpy(dst->buf, src->buf, src->sz);
+	if (lane_sz)
+		memcpy(dst->lane_buf, src->lane_buf, lane_sz);
+
+	return (0);
+}
+
+
+/**
+ * blockHashCtxLanes - sets the amount of nonces blockHashCtxNonces hashes at
+ *   once, allocating a copy of the preimage for every extra lane
+ *
+ * @ctx: pointer to the initialized context
+ * @lanes: amount of lanes, 1 to SHA256_MB_LANES_MAX, usually sha256_mb_lanes()
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int blockHashCtxLanes(block_hash_ctx_t *ctx, unsigned int lanes)
+{
+	uint8_t *lane_buf = NULL;
+	unsigned int i;
+
+	if (!ctx || !ctx->buf || !lanes || lanes > SHA256_MB_LANES_MAX)
+	{
+		fprintf(stderr, "blockHashCtxLanes: invalid parameter(s)\n");
+		return (1);
+	}
+
+	if (lanes > 1)
+	{
+		lane_buf = malloc(ctx->sz * (lanes - 1));
+		if (!lane_buf)
+		{
+			fprintf(stderr, "blockHashCtxLanes: malloc failure\n");
+			return (1);
+		}
+		for (i = 0; i < lanes - 1; i++)
+			memcpy(lane_buf + i * ctx->sz, ctx->buf, ctx->sz);
+	}
+	free(ctx->lane_buf);
+	ctx->lane_buf = lane_buf;
+	ctx->lanes = lanes;
+
+	return (0);
+}
+
+
+/**
+ * blockHashCtxNonce - computes the hash of the block a context was
+ *   initialized with, as if its nonce was `nonce`; performs no allocation
+ *
+ * @ctx: pointer to the initialized context, its preimage nonce is modified
+ * @nonce: nonce to hash the block with
+ * @hash_buf: pointer to buffer for storing hash value
+ *
+ * Return: pointer to hash_buf, or NULL on failure
+ */
+uint8_t *blockHashCtxNonce(block_hash_ctx_t *ctx, uint64_t nonce,
+			   uint8_t hash_buf[SHA256_DIGEST_LENGTH])
+{
+	memcpy(ctx->buf + ctx->nonce_idx, &nonce, sizeof(uint64_t));
+
+	return (sha256_resume(&(ctx->mid),
+			      (const int8_t *)ctx->buf + ctx->mid_len,
+			      ctx->sz - ctx->mid_len, hash_buf));
+}
+
+
+/**
+ * blockHashCtxNonces - computes the hashes of the block a context was
+ *   initialized with, as if its nonce was each of `nonce`, `nonce + step`,
+ *   ... up to ctx->lanes nonces, hashed together with sha256_mb_resume;
+ *   performs no allocation
+ *
+ * @ctx: pointer to the initialized context, its preimage nonces are modified
+ * @nonce: first nonce to hash the block with
+ * @step: difference between two consecutive nonces
+ * @hash_bufs: receives the hash for each nonce, in ascending order
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int blockHashCtxNonces(block_hash_ctx_t *ctx, uint64_t nonce, uint64_t step,
+		       uint8_t hash_bufs[][SHA256_DIGEST_LENGTH])
+{
+	int8_t const *msgs[SHA256_MB_LANES_MAX];
+	uint8_t *lane;
+	unsigned int i;
+
+	for (i = 0; i < ctx->lanes; i++, nonce += step)
+	{
+		lane = i ? ctx->lane_buf + (i - 1) * ctx->sz : ctx->buf;
+		memcpy(lane + ctx->nonce_idx, &nonce, sizeof(uint64_t));
+		msgs[i] = (int8_t const *)lane + ctx->mid_len;
+	}
+
+	return (sha256_mb_resume(&(ctx->mid), msgs, ctx->sz - ctx->mid_len,
+				 ctx->lanes, hash_bufs));
+}
+
+
+/**
+ * blockHashCtxFree - frees memory allocated by blockHashCtxInit,
+ *   blockHashCtxDup or blockHashCtxLanes
+ *
+ * @ctx: pointer to the context to clear
+ */
+void blockHashCtxFree(block_hash_ctx_t *ctx)
+{
+	if (!ctx)
+		return;
+
+	free(ctx->buf);
+	free(ctx->lane_buf);
+	ctx->buf = NULL;
+	ctx->lane_buf = NULL;
+	ctx->sz = 0;
+	ctx->lanes = 1;
+}
@@ -1,6 +1,7 @@
 #include "blockchain.h"
 #include <stdio.h>
 #include <string.h>
+#include <stddef.h>
 
 
 /**
@@ -43,25 +44,14 @@ int miniumumBlkTxs(const block_t *block)
  */
 int validateBlockHashes(block_t const *block, block_t const *prev_block)
 {
-	uint8_t prev_hash_buf[SHA256_DIGEST_LENGTH],
-		hash_buf[SHA256_DIGEST_LENGTH];
-
-	if (!block_hash(prev_block, prev_hash_buf) ||
-	    !block_hash(block, hash_buf))
-	{
-		fprintf(stderr, "block_is_valid: block_hash failure\n");
-		return (1);
-	}
-
-	if (memcmp(prev_block->hash, prev_hash_buf,
-		   SHA256_DIGEST_LENGTH) != 0)
+	/* each block is hashed once, as `block` then as `prev_block` */
+	if (!blockHashIsValid(prev_block))
 	{
 		fprintf(stderr, "block_is_valid: invalid hash of prev_block\n");
 		return (1);
 	}
 
-	if (memcmp(block->hash, hash_buf,
-		   SHA256_DIGEST_LENGTH) != 0)
+	if (!blockHashIsValid(block))
 	{
 		fprintf(stderr, "block_is_valid: invalid hash of block\n");
 		return (1);
@@ -74,7 +64,7 @@ int validateBlockHashes(block_t const *block, block_t const *prev_block)
 		return (1);
 	}
 
-	if (memcmp(block->info.prev_hash, prev_hash_buf,
+	if (memcmp(block->info.prev_hash, prev_block->hash,
 		   SHA256_DIGEST_LENGTH) != 0)
 	{
 		fprintf(stderr, "block_is_valid: %s\n",
@@ -107,7 +97,9 @@ int block_is_valid(block_t const *block, block_t const *prev_block,
 
 	if (block->info.index == 0)
 	{
-		if (memcmp(block, &genesis_model, sizeof(block_t)) == 0)
+		/* hash_ok is not part of the block value */
+		if (memcmp(block, &genesis_model,
+			   offsetof(block_t, hash_ok)) == 0)
 			return (0);
 
 		fprintf(stderr, "block_is_valid: %s\n",
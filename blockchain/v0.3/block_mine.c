@@ -1,43 +1,287 @@
-/* stdint.h block_t SHA256_DIGEST_LENGTH */
+/* stdint.h block_t SHA256_DIGEST_LENGTH bm_* block_hash_ctx_t */
 #include "blockchain.h"
-/* ULONG_MAX */
-#include <limits.h>
-/* memcpy */
-#include <string.h>
+/* fprintf */
+#include <stdio.h>
+/* calloc free */
+#include <stdlib.h>
+/* sysconf _SC_NPROCESSORS_ONLN */
+#include <unistd.h>
+/* pthread_create pthread_join */
+#include <pthread.h>
 
 
 /**
- * block_mine - mines a block in order to insert it in the blockchain
+ * mineHash - hashes the block being mined by a worker with its next nonces,
+ *   using every lane of its hashing context
+ *
+ * @worker: pointer to info struct of the worker
+ * @nonce: first nonce to try, the others following it by the worker stride
+ * @lanes: amount of nonces to try, either 1 or worker->ctx.lanes
+ *
+ * Return: index of the first nonce tried producing a hash that meets the
+ *   block difficulty, -1 if none does, or -2 on failure
+ */
+static int mineHash(bm_worker_t *worker, uint64_t nonce, unsigned int lanes)
+{
+	uint8_t hash_bufs[SHA256_MB_LANES_MAX][SHA256_DIGEST_LENGTH];
+	unsigned int i;
+
+	if (lanes == 1)
+	{
+		if (!blockHashCtxNonce(&(worker->ctx), nonce, hash_bufs[0]))
+			return (-2);
+	}
+	else if (blockHashCtxNonces(&(worker->ctx), nonce,
+				    worker->shared->stride, hash_bufs) != 0)
+		return (-2);
+
+	for (i = 0; i < lanes; i++)
+		if (hashMatchesTarget(hash_bufs[i], &(worker->shared->target)))
+			return ((int)i);
+	return (-1);
+}
+
+
+/**
+ * mineWorker - start routine of a block_mine_mt worker thread, tries every
+ *   nonce of its partition in ascending order until one produces a hash that
+ *   meets the block difficulty, or a lower matching nonce has been found by
+ *   another worker
+ *
+ * @worker: pointer to info struct of this worker
+ *
+ * Return: always NULL, results are reported in worker->shared
+ */
+static void *mineWorker(bm_worker_t *worker)
+{
+	bm_shared_t *shared = worker->shared;
+	uint64_t nonce, best;
+	unsigned int lanes = 1;
+	int found;
+
+	for (nonce = worker->first_nonce; ; nonce += lanes * shared->stride)
+	{
+		best = __atomic_load_n(&(shared->best_nonce), __ATOMIC_RELAXED);
+		if (nonce >= best ||
+		    __atomic_load_n(&(shared->failed), __ATOMIC_RELAXED))
+			break;
+
+		/* last nonces before UINT64_MAX are tried one at a time */
+		lanes = worker->ctx.lanes;
+		if ((UINT64_MAX - nonce) / shared->stride <= lanes)
+			lanes = 1;
+		found = mineHash(worker, nonce, lanes);
+		if (found == -2)
+		{
+			fprintf(stderr, "mineWorker: mineHash failure\n");
+			__atomic_store_n(&(shared->failed), 1,
+					 __ATOMIC_RELAXED);
+			break;
+		}
+		if (found >= 0)
+		{
+			nonce += (uint64_t)found * shared->stride;
+			/* lower the shared best nonce, unless beaten to it */
+			while (nonce < best &&
+			       !__atomic_compare_exchange_n(
+				       &(shared->best_nonce), &best, nonce, 0,
+				       __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+				;
+			break;
+		}
+		/* UINT64_MAX is never tried, as in a serial search */
+		if (UINT64_MAX - nonce <= shared->stride)
+			break;
+	}
+
+	return (NULL);
+}
+
+
+/**
+ * mineSearch - partitions the nonce space between `thread_ct` workers and
+ *   searches it for the lowest nonce producing a hash that meets the block
+ *   difficulty; the calling thread acts as the first worker
+ *
+ * @ctx: hashing context of the block to be mined, copied for each worker
+ * @target: difficulty of the block to be mined, see hashTarget
+ * @thread_ct: amount of workers, at least 1
+ * @nonce: modified by reference to the lowest matching nonce on success
+ *
+ * Return: 0 if a nonce was found, 1 if none was found,
+ *   or -1 on failure to allocate, spawn a thread or hash the block
+ */
+static int mineSearch(block_hash_ctx_t const *ctx,
+		      hash_target_t const *target,
+		      unsigned int thread_ct, uint64_t *nonce)
+{
+	bm_shared_t shared = { {{ 0 }}, 0, UINT64_MAX, 0 };
+	bm_worker_t *workers;
+	unsigned int i, spawned = 0;
+
+	workers = calloc(thread_ct, sizeof(bm_worker_t));
+	if (!workers)
+	{
+		fprintf(stderr, "mineSearch: calloc failure\n");
+		return (-1);
+	}
+	shared.target = *target;
+	shared.stride = thread_ct;
+	for (i = 0; i < thread_ct; i++)
+	{
+		workers[i].shared = &shared;
+		workers[i].first_nonce = i;
+		if (blockHashCtxDup(&(workers[i].ctx), ctx) != 0)
+			break;
+	}
+	if (i < thread_ct)
+		fprintf(stderr, "mineSearch: blockHashCtxDup failure\n");
+	else
+		spawned = 1;
+	for (; spawned && spawned < thread_ct; spawned++)
+	{
+		if (pthread_create(&(workers[spawned].tid), NULL,
+				   (void *(*)(void *))mineWorker,
+				   workers + spawned) != 0)
+		{
+			fprintf(stderr, "mineSearch: pthread_create failure\n");
+			__atomic_store_n(&(shared.failed), 1, __ATOMIC_RELAXED);
+			break;
+		}
+	}
+	if (spawned)
+		mineWorker(workers);
+	for (i = 1; i < spawned; i++)
+		pthread_join(workers[i].tid, NULL);
+	for (i = 0; i < thread_ct; i++)
+		blockHashCtxFree(&(workers[i].ctx));
+	free(workers);
+
+	if (!spawned || shared.failed)
+		return (-1);
+	*nonce = shared.best_nonce;
+	return (shared.best_nonce == UINT64_MAX);
+}
+
+
+/**
+ * minerThreadCt - determines the default amount of block mining threads
+ *
+ * Return: amount of online processors, bound to BLOCK_MINE_THREADS_MAX, or 1
+ *   if it cannot be determined
+ */
+unsigned int minerThreadCt(void)
+{
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+	if (cores < 1)
+		return (1);
+	if (cores > BLOCK_MINE_THREADS_MAX)
+		return (BLOCK_MINE_THREADS_MAX);
+	return ((unsigned int)cores);
+}
+
+
+/**
+ * block_mine_engine - mines a block in order to insert it in the
+ *   blockchain, searching the nonce space with several threads
  *
  * @block: block to be mined
+ * @thread_ct: amount of threads to use, or 0 for one per online processor;
+ *   bound to BLOCK_MINE_THREADS_MAX
+ * @engine: hashing engine used by each thread
+ *
+ * Note: the nonce chosen is always the lowest one producing a hash that meets
+ *   the block difficulty, so results do not depend on the thread count
  */
-void block_mine(block_t *block)
+void block_mine_engine(block_t *block, unsigned int thread_ct,
+		       bm_engine_t engine)
 {
-	uint64_t i, orig_nonce;
-	uint8_t hash_buf[SHA256_DIGEST_LENGTH];
+	block_hash_ctx_t ctx;
+	hash_target_t target;
+	uint64_t nonce;
+	int ret;
 
 	if (!block)
 	{
-		fprintf(stderr, "block_mine: NULL parameter\n");
+		fprintf(stderr, "block_mine_engine: NULL parameter\n");
+		return;
+	}
+	if (block->info.index == 0 && !block->transactions)
+	{
+		fprintf(stderr, "block_mine_engine: %s\n",
+			"Genesis Block hash is fixed, it cannot be mined");
 		return;
 	}
 
-	orig_nonce = block->info.nonce;
-	/* assumes 64-bit architecture */
-	for (i = 0; i < ULONG_MAX; i++)
+	if (thread_ct == 0)
+		thread_ct = minerThreadCt();
+	else if (thread_ct > BLOCK_MINE_THREADS_MAX)
+		thread_ct = BLOCK_MINE_THREADS_MAX;
+
+	if (hashTarget(block->info.difficulty, &target) != 0 ||
+	    blockHashCtxInit(&ctx, block) != 0)
+		return;
+	if (engine == BM_ENGINE_AUTO)
+		engine = sha256_mb_preferred() ?
+			BM_ENGINE_SHA256_MB : BM_ENGINE_OPENSSL;
+	/* falls back on OpenSSL if lanes cannot be allocated */
+	if (engine == BM_ENGINE_SHA256_MB && sha256_mb_lanes() > 1)
+		blockHashCtxLanes(&ctx, sha256_mb_lanes());
+	ret = mineSearch(&ctx, &target, thread_ct, &nonce);
+	/* retry serially if threads could not be spawned */
+	if (ret == -1 && thread_ct > 1)
+		ret = mineSearch(&ctx, &target, 1, &nonce);
+	blockHashCtxFree(&ctx);
+	if (ret != 0)
 	{
-		block->info.nonce = i;
+		if (ret == 1)
+			fprintf(stderr, "block_mine_engine: %s %s %u\n",
+				"no nonce found to produce hash that meets",
+				"difficulty of", block->info.difficulty);
+		return;
+	}
 
-		block_hash(block, hash_buf);
-		if (hash_matches_difficulty(hash_buf, block->info.difficulty))
-		{
-			memcpy(block->hash, hash_buf, SHA256_DIGEST_LENGTH);
-			return;
-		}
+	block->info.nonce = nonce;
+	blockHashDirty(block);
+	if (!block_hash(block, block->hash))
+		fprintf(stderr, "block_mine_engine: block_hash failure\n");
+}
+
+
+/**
+ * block_mine_mt - mines a block in order to insert it in the blockchain,
+ *   searching the nonce space with several threads and the fastest hashing
+ *   engine for the running CPU
+ *
+ * @block: block to be mined
+ * @thread_ct: amount of threads to use, or 0 for one per online processor;
+ *   bound to BLOCK_MINE_THREADS_MAX
+ */
+void block_mine_mt(block_t *block, unsigned int thread_ct)
+{
+	if (!block)
+	{
+		fprintf(stderr, "block_mine_mt: NULL parameter\n");
+		return;
+	}
+
+	block_mine_engine(block, thread_ct, BM_ENGINE_AUTO);
+}
+
+
+/**
+ * block_mine - mines a block in order to insert it in the blockchain
+ *
+ * @block: block to be mined
+ */
+void block_mine(block_t *block)
+{
+	if (!block)
+	{
+		fprintf(stderr, "block_mine: NULL parameter\n");
+		return;
 	}
 
-	fprintf(stderr, "block_mine: %s %u\n",
-		"no nonce found to produce hash that meets difficulty of",
-		block->info.difficulty);
-	block->info.nonce = orig_nonce;
+	block_mine_mt(block, BLOCK_MINE_THREADS_DFLT);
 }
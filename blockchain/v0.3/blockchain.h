@@ -7,6 +7,8 @@
 #include <llist.h>
 /* [u]intN_t */
 #include <stdint.h>
+/* pthread_t */
+#include <pthread.h>
 /* SHA256_DIGEST_LENGTH */
 #include "../../crypto/hblk_crypto.h"
 /* expected by v0.3 checker mains that only include this header */
@@ -19,11 +21,55 @@
 #define DIFFICULTY_ADJUSTMENT_INTERVAL 5
 /* max size (in bytes) of the data payload in a block */
 #define BLOCKCHAIN_DATA_MAX 1024
+/* threads used by block_mine; 0 for one per online processor */
+#define BLOCK_MINE_THREADS_DFLT 0
+/* upper limit on threads used by block_mine_mt */
+#define BLOCK_MINE_THREADS_MAX 64
+/* 64-bit words in a SHA-256 hash, as checked by hashMatchesTarget */
+#define HASH_TARGET_WORDS (SHA256_DIGEST_LENGTH / 8)
+/* transaction IDs buffered by block_hash between SHA-256 updates */
+#define BLOCK_HASH_STREAM_IDS 64
+/* bytes buffered by blockchain_serialize between two write(2) calls */
+#define BC_WRITER_BUF_SZ 65536
+/* bytes read at a time by blockchainFromStream */
+#define BC_STREAM_CHUNK_SZ 65536
+/* serialized sizes of the fixed size records, see blockchain_serialize */
+#define BC_TX_HDR_SERIAL_SZ (SHA256_DIGEST_LENGTH + 2 * sizeof(uint32_t))
+#define BC_TX_OUT_SERIAL_SZ \
+	(sizeof(uint32_t) + EC_PUB_LEN + SHA256_DIGEST_LENGTH)
+#define BC_UNSPENT_SERIAL_SZ \
+	(2 * SHA256_DIGEST_LENGTH + BC_TX_OUT_SERIAL_SZ)
+/* blocks journaled between two unspent output checkpoints */
+#define BC_JOURNAL_CKPT_BLOCKS 16
+/* threads used by blockchain_deserialize; 0 for one per online processor */
+#define BC_LOAD_THREADS_DFLT 0
+/* blocks a file needs for blockchain_deserialize_mt to spawn threads */
+#define BC_LOAD_MT_MIN_BLOCKS 4096
+/* consecutive blocks claimed at a time by a loading thread */
+#define BC_LOAD_BATCH 64
+/* threads used by the CLI `validate` command; 0 for one per processor */
+#define BC_VALIDATE_THREADS_DFLT 0
+/* consecutive blocks claimed at a time by a validating thread */
+#define BC_VALIDATE_BATCH 64
+/* initial block and hash slot counts of a chain index, power of 2 */
+#define CHAIN_INDEX_MIN_CAP 64
+/* size of an arena allocation, rounded up to keep the next one aligned */
+#define BC_ARENA_ALIGN(sz) (((sz) + 7) & ~(size_t)7)
 
 #define HBLK_MAG            "HBLK"
 #define HBLK_MAG_LEN        4
-#define HBLK_VER            "0.3"
+#define HBLK_VER            "0.4"
 #define HBLK_VER_LEN        3
+/* previous version, without block and transaction index, still read */
+#define HBLK_VER_0_3        "0.3"
+
+#define HJNL_MAG            "HJNL"
+#define HJNL_MAG_LEN        4
+/* appended to the path of a blockchain file to name its journal */
+#define HJNL_EXT            ".hjnl"
+/* journal record types, see bcJournalAppend and bcJournalCheckpoint */
+#define HJNL_REC_BLOCK      'B'
+#define HJNL_REC_UNSPENT    'U'
 
 #define GEN_BLK_TS          1537578000
 #define GEN_BLK_DT_BUF      "Holberton School"
@@ -45,8 +91,11 @@
 	}, \
 	NULL, /* transactions */ \
 	"\xc5\x2c\x26\xc8\xb5\x46\x16\x39\x63\x5d\x8e\xdf\x2a\x97\xd4\x8d" \
-	"\x0c\x8e\x00\x09\xc8\x17\xf2\xb1\xd3\xd7\xff\x2f\x04\x51\x58\x03" \
-}       /* hash */
+	"\x0c\x8e\x00\x09\xc8\x17\xf2\xb1\xd3\xd7\xff\x2f\x04\x51\x58\x03", \
+	/* hash */ \
+	0, /* arena_sz */ \
+	0 /* hash_ok */ \
+}
 /*
  * sizeof(block_t.info) + sizeof(block_t.data.len) +
  * GEN_BLK.data.len + sizeof(block_t.hash)
@@ -59,11 +108,17 @@
  *
  * @chain:   Linked list of Blocks
  * @unspent: Linked list of unspent transaction outputs
+ * @unspent_index: Index of @unspent, amended along with it; also found from
+ *   @unspent alone by the spec API, see unspentIndexOf
+ * @chain_index: Index of @chain, amended along with it by chainAdd, or NULL
+ *   for blocks to be found by walking @chain
  */
 typedef struct blockchain_s
 {
-	llist_t     *chain;
-	llist_t     *unspent;
+	llist_t              *chain;
+	llist_t              *unspent;
+	utxo_index_t         *unspent_index;
+	struct chain_index_s *chain_index;
 } blockchain_t;
 
 /**
@@ -114,6 +169,12 @@ typedef struct block_data_s
  * @data:         Block data
  * @transactions: List of transactions
  * @hash:         256-bit digest of the Block, to ensure authenticity
+ * @arena_sz:     Size of the region holding the Block, then its
+ *                transactions and their inputs and outputs, if decoded into
+ *                an arena by readBlock; 0 if each is allocated on its own
+ * @hash_ok:      1 once @hash is found to be the hash of the Block, so that
+ *                it is not hashed again, see blockHashIsValid; reset by
+ *                blockHashDirty whenever a hashed field changes
  */
 typedef struct block_s
 {
@@ -121,6 +182,8 @@ typedef struct block_s
 	block_data_t data; /* This must stay second */
 	llist_t     *transactions;
 	uint8_t      hash[SHA256_DIGEST_LENGTH];
+	size_t       arena_sz;
+	uint8_t      hash_ok;
 } block_t;
 
 /**
@@ -146,6 +209,63 @@ typedef struct bc_file_hdr_s
 	uint32_t hblk_unspent;
 } bc_file_hdr_t;
 
+/**
+ * struct bc_tx_loc_s - transaction index entry of a blockchain file
+ *
+ * @tx_id: transaction ID (hash)
+ * @block_off: file offset of the block containing the transaction,
+ *   endianness dependent
+ */
+typedef struct bc_tx_loc_s
+{
+	uint8_t  tx_id[SHA256_DIGEST_LENGTH];
+	uint64_t block_off;
+} bc_tx_loc_t;
+
+/**
+ * struct bc_file_ftr_s - blockchain file footer structure, from version 0.4
+ *
+ * @blocks_off: file offset of the block table, made of the file offset of
+ *   each block as 8 bytes, endianness dependent
+ * @txs_off: file offset of the transaction table, made of a bc_tx_loc_t for
+ *   each transaction of the blockchain, sorted by ID; endianness dependent
+ * @tx_ct: number of entries in the transaction table, endianness dependent
+ * @hblk_magic: "HBLK" (ASCII 48 42 4c 4b), identifies the last bytes of the
+ *   file as a footer
+ */
+typedef struct bc_file_ftr_s
+{
+	uint64_t blocks_off;
+	uint64_t txs_off;
+	uint32_t tx_ct;
+	int8_t   hblk_magic[4];
+} bc_file_ftr_t;
+
+/**
+ * struct bc_index_s - block and transaction index of a blockchain file
+ *
+ * Description: Built while serializing a blockchain, to be written after it
+ *   as the tables referenced by the file footer (see bcIndexWrite); also
+ *   built when opening a version 0.3 file, which has none.
+ *
+ * @block_offs: file offset of each block
+ * @block_ct: number of blocks indexed
+ * @block_cap: number of members allocated in @block_offs
+ * @tx_locs: location of each transaction, sorted by ID once bcIndexSort is
+ *   called
+ * @tx_ct: number of transactions indexed
+ * @tx_cap: number of members allocated in @tx_locs
+ */
+typedef struct bc_index_s
+{
+	uint64_t    *block_offs;
+	uint32_t     block_ct;
+	uint32_t     block_cap;
+	bc_tx_loc_t *tx_locs;
+	uint32_t     tx_ct;
+	uint32_t     tx_cap;
+} bc_index_t;
+
 /**
  * struct buf_info_s - buffer info
  *
@@ -164,6 +284,415 @@ typedef struct buf_info_s
 	uint32_t idx;
 } buf_info_t;
 
+/**
+ * struct bc_writer_s - buffered file output
+ *
+ * Description: Serialized fields are appended to @buf, which is written to
+ *   @fd only once full, so that saving a blockchain takes one write(2) per
+ *   BC_WRITER_BUF_SZ bytes rather than several per block, input and output.
+ *
+ * @fd: file descriptor open for writing
+ * @len: amount of bytes in @buf not yet written to @fd
+ * @pos: file offset of the next byte to be appended
+ * @index: index to which writeBlock adds each block written, or NULL
+ * @buf: output buffer
+ */
+typedef struct bc_writer_s
+{
+	int         fd;
+	size_t      len;
+	uint64_t    pos;
+	bc_index_t *index;
+	uint8_t     buf[BC_WRITER_BUF_SZ];
+} bc_writer_t;
+
+/**
+ * struct bc_reader_s - bounds checked input over a memory mapped file
+ *
+ * Description: Files are mapped whole by bcReaderMap, and deserialized
+ *   fields are copied straight from the mapping, so loading a blockchain
+ *   takes no read(2) at all. Every copy is checked against @sz, so that a
+ *   truncated file is reported rather than read past. Files that cannot be
+ *   mapped are decoded by a bc_stream_t, which reads each record through a
+ *   bc_reader_t over the bytes fed.
+ *
+ * @buf: mapped file contents or record bytes, or NULL
+ * @sz: size of @buf in bytes
+ * @pos: offset in @buf of the next byte to deserialize
+ */
+typedef struct bc_reader_s
+{
+	uint8_t const *buf;
+	size_t         sz;
+	size_t         pos;
+} bc_reader_t;
+
+/**
+ * struct bc_arena_s - bump allocator over the region of a single block
+ *
+ * Description: A block decoded by readBlock is allocated first in a region
+ *   sized by blockSerialSz, followed by each of its transactions, inputs and
+ *   outputs in file order, so that it is laid out contiguously and released
+ *   by a single free(3) in block_destroy. List nodes are allocated by
+ *   libllist and are not part of the region.
+ *
+ * @buf: region, zeroed when allocated
+ * @len: amount of bytes handed out so far
+ * @cap: size of @buf in bytes
+ */
+typedef struct bc_arena_s
+{
+	uint8_t *buf;
+	size_t   len;
+	size_t   cap;
+} bc_arena_t;
+
+/**
+ * enum bc_stream_state_e - records expected next by a bc_stream_t
+ *
+ * @BC_STREAM_HEADER: file header
+ * @BC_STREAM_BLOCKS: block, with its transactions
+ * @BC_STREAM_UNSPENT: unspent output
+ * @BC_STREAM_DONE: none, every record counted in the header was decoded
+ */
+typedef enum bc_stream_state_e
+{
+	BC_STREAM_HEADER,
+	BC_STREAM_BLOCKS,
+	BC_STREAM_UNSPENT,
+	BC_STREAM_DONE
+} bc_stream_state_t;
+
+/**
+ * struct bc_measure_s - progress of blockMeasure over a serialized block
+ *   not complete yet
+ *
+ * @sz: size of the block up to the first transaction not measured yet, or 0
+ *   if its header was not measured yet
+ * @mem: size of the arena the block decodes into, up to the same transaction
+ * @tx_ct: amount of transactions of the block, -1 for the Genesis Block
+ * @tx_done: amount of transactions measured
+ */
+typedef struct bc_measure_s
+{
+	size_t  sz;
+	size_t  mem;
+	int32_t tx_ct;
+	int32_t tx_done;
+} bc_measure_t;
+
+/**
+ * struct bc_stream_s - incremental blockchain file decoder
+ *
+ * Description: Decodes a serialized blockchain fed in chunks of any size,
+ *   such as reads from a pipe, appending each record to a blockchain as soon
+ *   as its last byte is fed. Records complete within a chunk are decoded
+ *   in place; only the bytes of a record split between chunks are copied to
+ *   @buf, and no more than @need of them.
+ *
+ * @state: records expected next
+ * @header: file header, once decoded
+ * @local_endianness: 1 for little endian, 2 for big endian
+ * @blocks_left: amount of blocks left to decode
+ * @unspent_left: amount of unspent outputs left to decode
+ * @buf: bytes fed of the next record, not complete yet
+ * @len: amount of bytes in @buf
+ * @cap: size of @buf in bytes
+ * @need: amount of bytes the next record is known to take so far
+ * @measure: progress of the measure of the next record, if a block, so that
+ *   its transactions already measured are not walked again as bytes arrive
+ */
+typedef struct bc_stream_s
+{
+	bc_stream_state_t state;
+	bc_file_hdr_t     header;
+	uint8_t           local_endianness;
+	uint32_t          blocks_left;
+	uint32_t          unspent_left;
+	uint8_t          *buf;
+	size_t            len;
+	size_t            cap;
+	size_t            need;
+	bc_measure_t      measure;
+} bc_stream_t;
+
+/**
+ * struct bl_pool_s - parallel block loading pool, shared by its workers
+ *
+ * Description: Blocks are located first by a serial scan of their sizes,
+ *   see blockSerialSz, which decodes none of their transactions. Workers
+ *   then claim BC_LOAD_BATCH consecutive blocks at a time and decode them
+ *   each into its slot of @blocks, so that they are linked in chain order
+ *   once all are decoded, whichever worker decoded them.
+ *
+ * @reader: reader over the mapped file, shared but never advanced
+ * @offs: file offset of each block, followed by that of the end of the last
+ * @blocks: array of @block_ct decoded blocks, or NULL for those not decoded
+ * @block_ct: amount of blocks to decode
+ * @next: index of the next block to be claimed; only accessed atomically
+ * @failed: set to 1 by any worker unable to decode a block, stops all
+ *   workers; only accessed atomically
+ * @local_endianness: 1 for little endian, 2 for big endian
+ * @hblk_endian: 1 for little endian, 2 for big endian
+ */
+typedef struct bl_pool_s
+{
+	bc_reader_t const *reader;
+	size_t            *offs;
+	block_t          **blocks;
+	uint32_t           block_ct;
+	size_t             next;
+	int                failed;
+	uint8_t            local_endianness;
+	uint8_t            hblk_endian;
+} bl_pool_t;
+
+/**
+ * struct bv_pool_s - parallel block validation pool, shared by its workers
+ *
+ * Description: Workers claim BC_VALIDATE_BATCH consecutive blocks at a time
+ *   and check all of each block that does not depend on unspent outputs,
+ *   reading but never writing the block before it. Blocks past the first
+ *   invalid one found are skipped, and a worker finding an invalid block
+ *   lowers @first_bad to its index if lower.
+ *
+ * @blocks: array of every block in the chain, in order
+ * @block_ct: amount of blocks to check
+ * @next: index of the next block to be claimed; only accessed atomically
+ * @first_bad: index of the first invalid block found, or @block_ct; only
+ *   accessed atomically while workers run
+ */
+typedef struct bv_pool_s
+{
+	block_t **blocks;
+	uint32_t  block_ct;
+	size_t    next;
+	uint32_t  first_bad;
+} bv_pool_t;
+
+/**
+ * struct chain_index_s - height and hash index of a list of blocks
+ *
+ * Description: Held by a blockchain as blockchain->chain_index, so that
+ *   blocks are found by height or by hash in constant time rather than by
+ *   walking blockchain->chain, which still owns the blocks. Blocks are only
+ *   ever appended to a chain, through chainAdd, which amends both.
+ *
+ * @blocks: block at each height, flat array of @block_cap
+ * @block_ct: number of blocks indexed
+ * @block_cap: number of members allocated in @blocks
+ * @slots: height + 1 of the block hashed to each linearly probed slot, or 0
+ *   if empty; flat array of @slot_cap
+ * @slot_cap: amount of slots, power of 2, kept over twice @block_ct
+ */
+typedef struct chain_index_s
+{
+	block_t **blocks;
+	uint32_t  block_ct;
+	uint32_t  block_cap;
+	uint32_t *slots;
+	uint32_t  slot_cap;
+} chain_index_t;
+
+/**
+ * struct bc_file_s - blockchain file opened for random access
+ *
+ * Description: Single blocks are decoded from the mapped file on demand,
+ *   found through the block and transaction tables of the file, or through
+ *   a bc_index_t built by bcFileOpen for version 0.3 files.
+ *
+ * @reader: reader over the whole mapped file
+ * @header: file header
+ * @local_endianness: 1 for little endian, 2 for big endian
+ * @block_offs: block table, header.hblk_blocks 8-byte file offsets
+ * @tx_locs: transaction table, @tx_ct bc_tx_loc_t sorted by ID
+ * @tx_ct: number of entries in @tx_locs
+ * @bswap: nonzero if the tables are not in local endianness
+ * @built: index built for a version 0.3 file, empty otherwise
+ */
+typedef struct bc_file_s
+{
+	bc_reader_t    reader;
+	bc_file_hdr_t  header;
+	uint8_t        local_endianness;
+	uint8_t const *block_offs;
+	uint8_t const *tx_locs;
+	uint32_t       tx_ct;
+	int            bswap;
+	bc_index_t     built;
+} bc_file_t;
+
+/**
+ * enum bc_sync_e - when the records of a journal are flushed to disk
+ *
+ * @BC_SYNC_NEVER: left to the kernel, a crash may lose the last records
+ * @BC_SYNC_CHECKPOINT: after each unspent output checkpoint
+ * @BC_SYNC_ALWAYS: after each record
+ */
+typedef enum bc_sync_e
+{
+	BC_SYNC_NEVER,
+	BC_SYNC_CHECKPOINT,
+	BC_SYNC_ALWAYS
+} bc_sync_t;
+
+/**
+ * struct bc_jnl_hdr_s - blockchain journal file header structure
+ *
+ * @hjnl_magic: "HJNL" (ASCII 48 4a 4e 4c), identifies the file as a journal
+ * @hblk_version: version at which the journaled blocks are serialized
+ * @hjnl_endian: 1 or 2 for little or big endianness of the multi-byte fields
+ *   of the header and records
+ * @base_blocks: number of blocks in the blockchain file the journal extends,
+ *   endianness dependent
+ * @hjnl_sync: bc_sync_t of the journal, kept when it is reopened
+ * @reserved: zeroed
+ * @base_hash: hash of the last block of the blockchain file
+ */
+typedef struct bc_jnl_hdr_s
+{
+	int8_t   hjnl_magic[4];
+	int8_t   hblk_version[3];
+	uint8_t  hjnl_endian;
+	uint32_t base_blocks;
+	uint8_t  hjnl_sync;
+	uint8_t  reserved[3];
+	uint8_t  base_hash[SHA256_DIGEST_LENGTH];
+} bc_jnl_hdr_t;
+
+/**
+ * struct bc_journal_s - blockchain journal open for appending
+ *
+ * Description: Extends a blockchain file with the blocks added since it was
+ *   saved, so that they are persisted without rewriting the whole chain;
+ *   see bcJournalCreate and bcJournalReplay.
+ *
+ * @fd: file descriptor of the journal, open for appending
+ * @sync: when records are flushed to disk
+ * @size: file offset of the end of the last complete record
+ * @since_ckpt: blocks appended since the last unspent output checkpoint
+ */
+typedef struct bc_journal_s
+{
+	int       fd;
+	bc_sync_t sync;
+	uint64_t  size;
+	uint32_t  since_ckpt;
+} bc_journal_t;
+
+/**
+ * struct bh_stream_s - block_hash streaming state
+ *
+ * @sha_ctx: SHA-256 context being updated with the block preimage
+ * @buf_info: stack buffer batching transaction IDs between SHA-256 updates
+ */
+typedef struct bh_stream_s
+{
+	SHA256_CTX sha_ctx;
+	buf_info_t buf_info;
+} bh_stream_t;
+
+/**
+ * struct block_hash_ctx_s - caller-owned block hashing context
+ *
+ * Description: Serialization of a block to be hashed repeatedly with
+ *   different nonces (see block_hash), sized and built once per block. The
+ *   SHA-256 state of the whole chunks preceding the nonce is also
+ *   precomputed, so each hash only covers the preimage from @mid_len onwards,
+ *   and no memory is allocated between blockHashCtxInit and blockHashCtxFree.
+ *
+ * @buf: block info, data and transaction IDs
+ * @sz: size of @buf in bytes
+ * @nonce_idx: offset of the nonce in @buf
+ * @mid: SHA-256 state after hashing the first @mid_len bytes of @buf
+ * @mid_len: amount of bytes of @buf hashed into @mid, multiple of 64
+ * @lane_buf: @lanes - 1 more copies of @buf, hashed along with it by
+ *   blockHashCtxNonces, or NULL
+ * @lanes: amount of nonces hashed at once by blockHashCtxNonces
+ */
+typedef struct block_hash_ctx_s
+{
+	uint8_t     *buf;
+	size_t       sz;
+	size_t       nonce_idx;
+	SHA256_CTX   mid;
+	size_t       mid_len;
+	uint8_t     *lane_buf;
+	unsigned int lanes;
+} block_hash_ctx_t;
+
+/**
+ * enum bm_engine_e - block mining hashing engines
+ *
+ * @BM_ENGINE_AUTO: BM_ENGINE_SHA256_MB if sha256_mb_preferred() on the
+ *   running CPU, BM_ENGINE_OPENSSL otherwise
+ * @BM_ENGINE_OPENSSL: one nonce per hash, with OpenSSL (blockHashCtxNonce)
+ * @BM_ENGINE_SHA256_MB: sha256_mb_lanes() nonces per hash, with the SIMD
+ *   multi-buffer kernel (blockHashCtxNonces)
+ */
+typedef enum bm_engine_e
+{
+	BM_ENGINE_AUTO,
+	BM_ENGINE_OPENSSL,
+	BM_ENGINE_SHA256_MB
+} bm_engine_t;
+
+/**
+ * struct hash_target_s - difficulty converted for word-level hash checks
+ *
+ * Description: Built once per difficulty by hashTarget, so that
+ *   hashMatchesTarget can check hashes a big-endian 64-bit word at a time,
+ *   rejecting most of them on the first word.
+ *
+ * @mask: for each 64-bit word of a hash, the bits that must be 0
+ */
+typedef struct hash_target_s
+{
+	uint64_t mask[HASH_TARGET_WORDS];
+} hash_target_t;
+
+/**
+ * struct bm_shared_s - block mining shared state
+ *
+ * Description: Shared by all the worker threads of block_mine_mt. Worker `k`
+ *   of `stride` workers tries the nonces k, k + stride, k + 2 * stride...
+ *   in ascending order, and stops once its next nonce is not lower than
+ *   @best_nonce. The lowest matching nonce is therefore always found, making
+ *   the result identical to a serial search regardless of the thread count.
+ *
+ * @target: difficulty of the block being mined, see hashTarget
+ * @stride: nonce increment between two attempts of the same worker, which is
+ *   also the amount of workers
+ * @best_nonce: lowest nonce found so far producing a hash that meets the
+ *   block difficulty, or UINT64_MAX if none found yet; only accessed
+ *   atomically
+ * @failed: set to 1 by any worker unable to hash, stops all workers; only
+ *   accessed atomically
+ */
+typedef struct bm_shared_s
+{
+	hash_target_t target;
+	uint64_t      stride;
+	uint64_t      best_nonce;
+	int           failed;
+} bm_shared_t;
+
+/**
+ * struct bm_worker_s - block mining worker thread info
+ *
+ * @shared: state shared between all workers
+ * @first_nonce: first nonce tried by this worker
+ * @ctx: private hashing context, with its nonce modified on every attempt
+ * @tid: thread id, unused for the worker run on the calling thread
+ */
+typedef struct bm_worker_s
+{
+	bm_shared_t     *shared;
+	uint64_t         first_nonce;
+	block_hash_ctx_t ctx;
+	pthread_t        tid;
+} bm_worker_t;
+
 
 /* blockchain_create.c */
 char *strE_LLIST(E_LLIST code);
@@ -180,39 +709,168 @@ void block_destroy(block_t *block);
 /* blockchain_destroy.c */
 void blockchain_destroy(blockchain_t *blockchain);
 
+/* chain_index.c */
+/*
+ * static uint64_t blockKey(uint8_t const *hash);
+ * static int matchBlockHash(block_t const *block, uint8_t const *hash);
+ * static int indexSlots(chain_index_t *index, uint32_t cap);
+ * static int indexBlock(block_t *block, unsigned int idx,
+ *                       chain_index_t *index);
+ */
+chain_index_t *chainIndexCreate(llist_t *chain);
+void chainIndexDestroy(chain_index_t *index);
+void chainPopGenesis(blockchain_t *blockchain);
+int chainAdd(blockchain_t *blockchain, block_t *block);
+block_t *chainBlockAt(blockchain_t const *blockchain, uint32_t height);
+block_t *chainBlockByHash(blockchain_t const *blockchain,
+			  uint8_t const hash[SHA256_DIGEST_LENGTH]);
+
 /* block_hash.c */
 /*
  * static int readTxId(transaction_t *tx, unsigned int idx,
  *		    buf_info_t *buf_info);
+ * static int hashTxId(transaction_t *tx, unsigned int idx,
+ *		    bh_stream_t *bh_stream);
  */
+uint8_t *blockPreimage(block_t const *block, size_t *sz);
 uint8_t *block_hash(block_t const *block,
 		    uint8_t hash_buf[SHA256_DIGEST_LENGTH]);
+int blockHashIsValid(block_t const *block);
+void blockHashDirty(block_t *block);
+
+/* bc_writer.c */
+void bcWriterInit(bc_writer_t *writer, int fd);
+int bcWriterFlush(bc_writer_t *writer);
+int bcWriterPut(bc_writer_t *writer, void const *src, size_t len);
 
 /* blockchain_serialize.c */
 int pathToWriteFD(char const *path);
-int writeBlkchnFileHdr(int fd, const blockchain_t *blockchain);
-int writeBlock(block_t *block, unsigned int idx, int *fd);
-int writeTransaction(transaction_t *tx, unsigned int idx, int *fd);
-int writeInput(tx_in_t *tx_in, unsigned int idx, int *fd);
-int writeOutput(tx_out_t *tx_out, unsigned int idx, int *fd);
-int writeUnspent(unspent_tx_out_t *unspent_tx_out, unsigned int idx, int *fd);
+int writeBlkchnFileHdr(bc_writer_t *writer, const blockchain_t *blockchain);
+int writeBlock(block_t *block, unsigned int idx, bc_writer_t *writer);
+int writeTransaction(transaction_t *tx, unsigned int idx,
+		     bc_writer_t *writer);
+int writeInput(tx_in_t *tx_in, unsigned int idx, bc_writer_t *writer);
+int writeOutput(tx_out_t *tx_out, unsigned int idx, bc_writer_t *writer);
+int writeTxFlat(tx_flat_t const *flat, bc_writer_t *writer);
+int writeUnspent(unspent_tx_out_t *unspent_tx_out, unsigned int idx,
+		 bc_writer_t *writer);
 int blockchain_serialize(blockchain_t const *blockchain, char const *path);
 
+/* bc_reader.c */
+int bcReaderMap(bc_reader_t *reader, int fd);
+void bcReaderUnmap(bc_reader_t *reader);
+int bcReaderTake(bc_reader_t *reader, void *dest, size_t len);
+
+/* bc_index.c */
+/*
+ * static int indexTx(transaction_t *tx, unsigned int idx,
+ *                    bc_index_t *index);
+ * static int cmpTxLoc(void const *a, void const *b);
+ */
+int bcIndexBlock(bc_index_t *index, block_t const *block, uint64_t off);
+void bcIndexSort(bc_index_t *index);
+int bcIndexWrite(bc_writer_t *writer, bc_index_t *index);
+void bcIndexFree(bc_index_t *index);
+
+/* bc_file.c */
+/*
+ * static uint64_t loadU64(uint8_t const *bytes, int bswap);
+ * static int mapIndex(bc_file_t *file);
+ * static int buildIndex(bc_file_t *file);
+ * static block_t *blockAt(bc_file_t const *file, uint64_t off);
+ * static uint8_t const *hashAt(bc_file_t const *file, uint64_t off);
+ */
+int bcFileOpen(bc_file_t *file, char const *path);
+void bcFileClose(bc_file_t *file);
+block_t *bcFileBlock(bc_file_t const *file, uint32_t index);
+block_t *bcFileBlockByHash(bc_file_t const *file,
+			   uint8_t const hash[SHA256_DIGEST_LENGTH]);
+block_t *bcFileTxBlock(bc_file_t const *file,
+		       uint8_t const tx_id[SHA256_DIGEST_LENGTH]);
+
+/* bc_stream.c */
+/*
+ * static int decodeRecord(bc_stream_t *stream, uint8_t const *bytes,
+ *                         size_t len, blockchain_t *blockchain);
+ * static int bufferRecord(bc_stream_t *stream, uint8_t const **bytes,
+ *                         size_t *len);
+ */
+uint32_t loadU32(uint8_t const *bytes, int bswap);
+int blockMeasure(uint8_t const *bytes, size_t len, int bswap,
+		 bc_measure_t *at, size_t *need);
+int blockSerialSz(uint8_t const *bytes, size_t len, int bswap, size_t *need,
+		  size_t *arena_sz);
+void bcStreamInit(bc_stream_t *stream);
+int bcStreamFeed(bc_stream_t *stream, void const *bytes, size_t len,
+		 blockchain_t *blockchain);
+void bcStreamFree(bc_stream_t *stream);
+blockchain_t *blockchainFromStream(int fd);
+
+/* bc_journal.c */
+/*
+ * static char *journalPath(char const *path);
+ * static int journalSync(bc_journal_t *journal, bc_sync_t level);
+ * static int journalScan(bc_reader_t const *reader, int bswap, size_t *end,
+ *                        size_t *ckpt);
+ * static int replaceUnspent(bc_reader_t *reader, blockchain_t *blockchain,
+ *                           uint8_t local_endianness, uint8_t hjnl_endian);
+ * static int replayBlock(bc_reader_t *reader, blockchain_t *blockchain,
+ *                        bc_jnl_hdr_t const *header, int update);
+ * static int replayRecords(bc_reader_t *reader, blockchain_t *blockchain,
+ *                          bc_jnl_hdr_t const *header, size_t end,
+ *                          size_t ckpt, uint32_t *since_ckpt);
+ */
+bc_journal_t *bcJournalCreate(char const *path,
+			      blockchain_t const *blockchain, bc_sync_t sync);
+int bcJournalReplay(char const *path, blockchain_t *blockchain,
+		    bc_journal_t **journal);
+int bcJournalAppend(bc_journal_t *journal, block_t *block, llist_t *unspent);
+int bcJournalCheckpoint(bc_journal_t *journal, llist_t *unspent);
+int bcJournalRemove(char const *path);
+void bcJournalClose(bc_journal_t *journal);
+
+/* bc_arena.c */
+int bcArenaInit(bc_arena_t *arena, size_t cap);
+void *bcArenaAlloc(bc_arena_t *arena, size_t sz);
+void bcArenaFree(bc_arena_t const *arena, void *ptr);
+void arenaTxDestroy(transaction_t *tx);
+
+/* bc_load.c */
+/*
+ * static int scanBlocks(bc_reader_t *reader, bl_pool_t *pool);
+ * static void *loadWorker(bl_pool_t *pool);
+ * static void loadPool(bl_pool_t *pool, unsigned int thread_ct);
+ * static int linkBlocks(bl_pool_t *pool, blockchain_t *blockchain);
+ */
+int readBlocksMT(bc_reader_t *reader, blockchain_t *blockchain,
+		 uint8_t local_endianness, bc_file_hdr_t *header,
+		 unsigned int thread_ct);
+
 /* blockchain_deserialize.c */
 int pathToReadFD(char const *path);
-int readBlkchnFileHdr(int fd, uint8_t local_endianness,
+int hblkVerCompat(int8_t const version[HBLK_VER_LEN]);
+int readBlkchnFileHdr(bc_reader_t *reader, uint8_t local_endianness,
 		      bc_file_hdr_t *header);
 void bswapBlock(block_t *block, int32_t *nb_transactions);
-int readBlocks(int fd, llist_t *chain,
+block_t *readBlock(bc_reader_t *reader, uint8_t local_endianness,
+		   uint8_t hblk_endian);
+int readBlocks(bc_reader_t *reader, blockchain_t *blockchain,
 	       uint8_t local_endianness, bc_file_hdr_t *header);
-int readTransactions(int fd, llist_t *transactions,
+int readTransactions(bc_reader_t *reader, llist_t *transactions,
 		     uint32_t nb_transactions, uint8_t local_endianness,
-		     uint8_t hblk_endian);
-int readInputs(int fd, llist_t *inputs, uint32_t nb_inputs);
-int readOutputs(int fd, llist_t *outputs, uint32_t nb_outputs,
-		uint8_t local_endianness, uint8_t hblk_endian);
-int readUnspent(int fd, llist_t *unspent,
+		     uint8_t hblk_endian, bc_arena_t *arena);
+int readInputs(bc_reader_t *reader, llist_t *inputs, uint32_t nb_inputs,
+	       bc_arena_t *arena);
+int readOutputs(bc_reader_t *reader, llist_t *outputs, uint32_t nb_outputs,
+		uint8_t local_endianness, uint8_t hblk_endian,
+		bc_arena_t *arena);
+unspent_tx_out_t *readUnspentTxOut(bc_reader_t *reader,
+				   uint8_t local_endianness,
+				   uint8_t hblk_endian);
+int readUnspent(bc_reader_t *reader, llist_t *unspent, utxo_index_t *index,
 		uint8_t local_endianness, bc_file_hdr_t *header);
+blockchain_t *blockchain_deserialize_mt(char const *path,
+				       unsigned int thread_ct);
 blockchain_t *blockchain_deserialize(char const *path);
 
 /* block_is_valid.c */
@@ -221,14 +879,65 @@ int validateBlockHashes(block_t const *block, block_t const *prev_block);
 int block_is_valid(block_t const *block, block_t const *prev_block,
 		   llist_t *all_unspent);
 
+/* blockchain_validate.c */
+/*
+ * static int collectBlock(block_t *block, unsigned int idx,
+ *                         block_t **blocks);
+ * static int checkTxId(transaction_t *tx, unsigned int idx, void *arg);
+ * static int checkBlock(block_t * const *blocks, uint32_t i);
+ * static void *validateWorker(bv_pool_t *pool);
+ * static void validatePool(bv_pool_t *pool, unsigned int thread_ct);
+ * static int collectTx(transaction_t *tx, unsigned int idx, llist_t *txs);
+ * static int replayBlockTxs(block_t *block, blockchain_t *rebuilt,
+ *                           unsigned int thread_ct);
+ * static int matchUnspent(unspent_tx_out_t *utxo, unsigned int idx,
+ *                         blockchain_t *rebuilt);
+ * static int replayUnspent(blockchain_t const *blockchain, bv_pool_t *pool,
+ *                          unsigned int thread_ct);
+ */
+int blockchain_validate(blockchain_t const *blockchain,
+			unsigned int thread_ct, uint32_t *bad_index);
+
 /* hash_matches_difficulty.c */
+/*
+ * static uint64_t loadHashWord(uint8_t const hash[SHA256_DIGEST_LENGTH],
+ *                              unsigned int i);
+ * static unsigned int leadingZeroes(uint64_t word);
+ */
+int hashTarget(uint32_t difficulty, hash_target_t *target);
+int hashMatchesTarget(uint8_t const hash[SHA256_DIGEST_LENGTH],
+		      hash_target_t const *target);
 int hash_matches_difficulty(uint8_t const hash[SHA256_DIGEST_LENGTH],
 			    uint32_t difficulty);
 
 /* block_mine.c */
+/*
+ * static int mineHash(bm_worker_t *worker, uint64_t nonce,
+ *                     unsigned int lanes);
+ * static void *mineWorker(bm_worker_t *worker);
+ * static int mineSearch(block_hash_ctx_t const *ctx,
+ *                       hash_target_t const *target,
+ *                       unsigned int thread_ct, uint64_t *nonce);
+ */
+unsigned int minerThreadCt(void);
+void block_mine_engine(block_t *block, unsigned int thread_ct,
+		       bm_engine_t engine);
+void block_mine_mt(block_t *block, unsigned int thread_ct);
 void block_mine(block_t *block);
 
+/* block_hash_ctx.c */
+int blockHashCtxInit(block_hash_ctx_t *ctx, block_t const *block);
+int blockHashCtxDup(block_hash_ctx_t *dst, block_hash_ctx_t const *src);
+uint8_t *blockHashCtxNonce(block_hash_ctx_t *ctx, uint64_t nonce,
+			   uint8_t hash_buf[SHA256_DIGEST_LENGTH]);
+int blockHashCtxLanes(block_hash_ctx_t *ctx, unsigned int lanes);
+int blockHashCtxNonces(block_hash_ctx_t *ctx, uint64_t nonce, uint64_t step,
+		       uint8_t hash_bufs[][SHA256_DIGEST_LENGTH]);
+void blockHashCtxFree(block_hash_ctx_t *ctx);
+
 /* blockchain_difficulty.c */
+void retargetDifficulty(const block_t *latest_blk,
+			const block_t *last_adj_blk, uint32_t *difficulty);
 uint8_t adjustDifficulty(const blockchain_t *blockchain,
 			 const block_t *latest_blk, uint32_t *difficulty);
 uint32_t blockchain_difficulty(blockchain_t const *blockchain);
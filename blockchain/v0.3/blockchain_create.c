@@ -113,6 +113,8 @@ blockchain_t *blockchain_create(void)
 		return (NULL);
 	}
 
+	blockchain->unspent_index = NULL;
+	blockchain->chain_index = NULL;
 	blockchain->unspent = llist_create(MT_SUPPORT_FALSE);
 	if (!(blockchain->unspent))
 	{
@@ -121,6 +123,14 @@ blockchain_t *blockchain_create(void)
 			strE_LLIST(llist_errno));
 		return (NULL);
 	}
+	blockchain->unspent_index = unspentIndexCreate(blockchain->unspent);
+	if (!(blockchain->unspent_index))
+	{
+		blockchain_destroy(blockchain);
+		fprintf(stderr, "blockchain_create: %s\n",
+			"unspentIndexCreate failure");
+		return (NULL);
+	}
 
 	genesis = newGenesisBlk();
 	if (llist_add_node(blockchain->chain, (llist_node_t)genesis,
@@ -131,6 +141,22 @@ blockchain_t *blockchain_create(void)
 			strE_LLIST(llist_errno));
 		return (NULL);
 	}
+	blockchain->chain_index = chainIndexCreate(blockchain->chain);
+	if (!(blockchain->chain_index))
+	{
+		blockchain_destroy(blockchain);
+		fprintf(stderr, "blockchain_create: %s\n",
+			"chainIndexCreate failure");
+		return (NULL);
+	}
+	/* the spec API is handed blockchain->unspent without its index */
+	if (unspentIndexBind(blockchain) != 0)
+	{
+		blockchain_destroy(blockchain);
+		fprintf(stderr, "blockchain_create: %s\n",
+			"unspentIndexBind failure");
+		return (NULL);
+	}
 
 	return (blockchain);
 }
@@ -1,12 +1,13 @@
-/* block_t blockchain_t strE_LLIST bc_file_hdr_t HBLK_MAG* HBLK_VER* */
+/* block_t blockchain_t strE_LLIST chainAdd bc_file_hdr_t HBLK_MAG* HBLK_VER* */
 #include "blockchain.h"
-/* lstat `struct stat` */
+/* stat `struct stat` S_ISREG */
 #include <sys/types.h>
 #include <sys/stat.h>
+/* close */
 #include <unistd.h>
 /* errno */
 #include <errno.h>
-/* fprintf perror read */
+/* fprintf perror */
 #include <stdio.h>
 /* open O_* close */
 #include <fcntl.h>
@@ -20,7 +21,8 @@
 
 /**
  * pathToReadFD - validates a path and opens a file descriptor in
- *   read-only mode at that path
+ *   read-only mode at that path; only regular files are checked for size,
+ *   as that of a pipe is not known before reading it
  *
  * @path: contains the potential path to a file to open
  *
@@ -31,15 +33,16 @@ int pathToReadFD(char const *path)
 	struct stat st;
 	int fd;
 
-	if (lstat(path, &st) == -1)
+	if (stat(path, &st) == -1)
 	{
-		fprintf(stderr, "pathToReadFD: lstat '%s': %s\n", path,
+		fprintf(stderr, "pathToReadFD: stat '%s': %s\n", path,
 			strerror(errno));
 		return (-1);
 	}
 
 	/* st.st_size is type off_t, or long int */
-	if ((size_t)(st.st_size) < sizeof(bc_file_hdr_t) + GEN_BLK_SERIAL_SZ)
+	if (S_ISREG(st.st_mode) &&
+	    (size_t)(st.st_size) < sizeof(bc_file_hdr_t) + GEN_BLK_SERIAL_SZ)
 	{
 		fprintf(stderr, "pathToReadFD: %s\n",
 			"file too small to contain header and Genesis Block");
@@ -57,22 +60,44 @@ int pathToReadFD(char const *path)
 }
 
 
+/**
+ * hblkVerCompat - checks whether a serialization version number can be read;
+ *   the blocks and unspent outputs of version 0.3 files are laid out as in
+ *   the current version, which only appends an index after them
+ *
+ * @version: version number read from a file header, not NUL-terminated
+ *
+ * Return: 1 if compatible, 0 if not
+ */
+int hblkVerCompat(int8_t const version[HBLK_VER_LEN])
+{
+	if (!version)
+	{
+		fprintf(stderr, "hblkVerCompat: NULL parameter\n");
+		return (0);
+	}
+
+	return (memcmp(version, HBLK_VER, HBLK_VER_LEN) == 0 ||
+		memcmp(version, HBLK_VER_0_3, HBLK_VER_LEN) == 0);
+}
+
+
 /**
  * readBlkchnFileHdr - reads and validates a serialized file header from a
  *   file storing a blockchain
  *
- * @fd: file descriptor already open for reading
+ * @reader: pointer to reader over the mapped file
  * @local_endianness: 1 for little endian, 2 for big endian
  * @header: stores values read from file header
  *
  * Return: 0 on success, or 1 upon failure
  */
-int readBlkchnFileHdr(int fd, uint8_t local_endianness,
+int readBlkchnFileHdr(bc_reader_t *reader, uint8_t local_endianness,
 		      bc_file_hdr_t *header)
 {
-	if (!header)
+	if (!reader || !header)
 	{
-		fprintf(stderr, "readBlkchnFileHdr: NULL parameter\n");
+		fprintf(stderr, "readBlkchnFileHdr: NULL parameter(s)\n");
 		return (1);
 	}
 	if (local_endianness != 1 && local_endianness != 2)
@@ -81,9 +106,9 @@ int readBlkchnFileHdr(int fd, uint8_t local_endianness,
 			"readBlkchnFileHdr: invalid local_endianness\n");
 		return (1);
 	}
-	if (read(fd, header, sizeof(bc_file_hdr_t)) == -1)
+	if (bcReaderTake(reader, header, sizeof(bc_file_hdr_t)) != 0)
 	{
-		perror("readBlkchnFileHdr: read");
+		fprintf(stderr, "readBlkchnFileHdr: bcReaderTake failure\n");
 		return (1);
 	}
 	if (memcmp(&(header->hblk_magic), HBLK_MAG, HBLK_MAG_LEN) != 0)
@@ -92,7 +117,7 @@ int readBlkchnFileHdr(int fd, uint8_t local_endianness,
 			"readBlkchnFileHdr: invalid magic number\n");
 		return (1);
 	}
-	if (memcmp(&(header->hblk_version), HBLK_VER, HBLK_VER_LEN) != 0)
+	if (!hblkVerCompat(header->hblk_version))
 	{
 		fprintf(stderr, "readBlkchnFileHdr: %s\n",
 			"serialized with incompatible version number");
@@ -153,81 +178,184 @@ void bswapBlock(block_t *block, int32_t *nb_transactions)
 }
 
 
+/**
+ * readBlockFields - reads the serialized fields of a block preceding its
+ *   transactions, see writeBlock
+ *
+ * @reader: pointer to reader over the mapped file
+ * @block: pointer to the block to fill
+ * @nb_transactions: modified by reference to the amount of transactions
+ *   following the block
+ * @bswap: nonzero if the file endianness differs from the local one
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+static int readBlockFields(bc_reader_t *reader, block_t *block,
+			   int32_t *nb_transactions, int bswap)
+{
+	uint32_t data_len;
+
+	if (bcReaderTake(reader, &(block->info), sizeof(block_info_t)) != 0 ||
+	    bcReaderTake(reader, &data_len, sizeof(uint32_t)) != 0)
+	{
+		fprintf(stderr, "readBlocks: bcReaderTake failure\n");
+		return (1);
+	}
+	block->data.len = data_len;
+	if (bswap)
+	{
+#ifdef __GNUC__ /* compiled with gcc, can use gcc builtins for fast assembly */
+		data_len = __builtin_bswap32(data_len);
+#else /* use function to manually byte swap */
+		_swap_endian(&data_len, 4);
+#endif
+	}
+	/* data.buffer is fixed size, the length must be checked before use */
+	if (data_len > BLOCKCHAIN_DATA_MAX)
+	{
+		fprintf(stderr, "readBlocks: block data over max length\n");
+		return (1);
+	}
+	if (bcReaderTake(reader, &(block->data.buffer), data_len) != 0 ||
+	    bcReaderTake(reader, &(block->hash), SHA256_DIGEST_LENGTH) != 0 ||
+	    bcReaderTake(reader, nb_transactions, sizeof(int32_t)) != 0)
+	{
+		fprintf(stderr, "readBlocks: bcReaderTake failure\n");
+		return (1);
+	}
+	if (bswap)
+		bswapBlock(block, nb_transactions);
+
+	return (0);
+}
+
+
+/**
+ * releaseTx - deletes a transaction being deserialized
+ *
+ * @tx: pointer to the transaction to delete
+ * @arena: pointer to the arena `tx` was allocated from, or NULL if from the
+ *   heap
+ */
+static void releaseTx(transaction_t *tx, bc_arena_t const *arena)
+{
+	if (arena)
+		arenaTxDestroy(tx);
+	else
+		transaction_destroy(tx);
+}
+
+
+/**
+ * readBlock - reads a serialized block and its transactions; a block with
+ *   transactions is decoded into a single arena, see bc_arena_t
+ *
+ * @reader: pointer to reader over the serialized block
+ * @local_endianness: 1 for little endian, 2 for big endian
+ * @hblk_endian: 1 for little endian, 2 for big endian
+ *
+ * Return: pointer to the deserialized block, or NULL upon failure
+ */
+block_t *readBlock(bc_reader_t *reader, uint8_t local_endianness,
+		   uint8_t hblk_endian)
+{
+	int32_t nb_transactions;
+	bc_arena_t arena = {NULL, 0, 0}, *tx_arena = NULL;
+	size_t need;
+	block_t *block;
+
+	if (!reader)
+	{
+		fprintf(stderr, "readBlock: NULL parameter\n");
+		return (NULL);
+	}
+
+	/* truncated blocks are left to fail below, as read */
+	if (reader->pos <= reader->sz &&
+	    blockSerialSz(reader->buf + reader->pos, reader->sz - reader->pos,
+			  local_endianness != hblk_endian, &need,
+			  &(arena.cap)) == 1 &&
+	    arena.cap > BC_ARENA_ALIGN(sizeof(block_t)))
+	{
+		if (bcArenaInit(&arena, arena.cap) != 0)
+			return (NULL);
+		tx_arena = &arena;
+	}
+	/* first in its arena, freeing the block releases the whole region */
+	block = bcArenaAlloc(tx_arena, sizeof(block_t));
+	if (!block)
+	{
+		fprintf(stderr, "readBlocks: calloc failure\n");
+		return (NULL);
+	}
+	block->arena_sz = tx_arena ? arena.cap : 0;
+	if (readBlockFields(reader, block, &nb_transactions,
+			    local_endianness != hblk_endian))
+	{
+		free(block);
+		return (NULL);
+	}
+
+	if (nb_transactions == -1) /* genesis block */
+		return (block);
+	block->transactions = llist_create(MT_SUPPORT_FALSE);
+	if (!block->transactions)
+	{
+		fprintf(stderr, "readBlocks: llist_create failure\n");
+		free(block);
+		return (NULL);
+	}
+	if (readTransactions(reader, block->transactions, nb_transactions,
+			     local_endianness, hblk_endian, tx_arena) != 0)
+	{
+		fprintf(stderr, "readBlocks: readTransactions failure\n");
+		block_destroy(block);
+		return (NULL);
+	}
+
+	return (block);
+}
+
+
 /**
  * readBlocks - reads serialized blocks from a storage file into a blockchain
  *   data structure
  *
- * @fd: file descriptor already open for reading
- * @chain: pointer to an empty list of blocks (Genesis Block removed)
- *   to contain the deserialized blocks
+ * @reader: pointer to reader over the mapped file
+ * @blockchain: pointer to a blockchain without blocks (Genesis Block
+ *   removed) to contain the deserialized blocks
  * @local_endianness: 1 for little endian, 2 for big endian
  * @header: stores values read from file header
  *
  * Return: 0 on success, or 1 upon failure
  */
-int readBlocks(int fd, llist_t *chain, uint8_t local_endianness,
-	       bc_file_hdr_t *header)
+int readBlocks(bc_reader_t *reader, blockchain_t *blockchain,
+	       uint8_t local_endianness, bc_file_hdr_t *header)
 {
 	uint32_t i;
-	int32_t nb_transactions;
 	block_t *block;
 
-	if (!chain || !header)
+	if (!reader || !blockchain || !header)
 	{
-		fprintf(stderr, "readBlocks: NULL parameter\n");
+		fprintf(stderr, "readBlocks: NULL parameter(s)\n");
 		return (1);
 	}
-	if (!llist_is_empty(chain))
+	if (!llist_is_empty(blockchain->chain))
 	{
 		fprintf(stderr, "readBlocks: target blockchain not empty\n");
 		return (1);
 	}
 	for (i = 0; i < header->hblk_blocks; i++)
 	{
-		block = calloc(1, sizeof(block_t));
+		block = readBlock(reader, local_endianness,
+				  header->hblk_endian);
 		if (!block)
-		{
-			fprintf(stderr, "readBlocks: calloc failure\n");
-			return (1);
-		}
-		if (read(fd, &(block->info), sizeof(block_info_t)) == -1 ||
-		    read(fd, &(block->data.len), sizeof(uint32_t)) == -1 ||
-		    read(fd, &(block->data.buffer), block->data.len) == -1 ||
-		    read(fd, &(block->hash), SHA256_DIGEST_LENGTH) == -1 ||
-		    read(fd, &nb_transactions, sizeof(int32_t)) == -1)
-		{
-			perror("readBlocks: read");
 			return (1);
-		}
-		if (local_endianness != header->hblk_endian)
-			bswapBlock(block, &nb_transactions);
-
-		if (nb_transactions == -1) /* genesis block */
-			block->transactions = NULL;
-		else
-		{
-			block->transactions = llist_create(MT_SUPPORT_FALSE);
-			if (!block->transactions)
-			{
-				fprintf(stderr,
-					"readBlocks: llist_create failure\n");
-				return (1);
-			}
-			if (readTransactions(fd, block->transactions,
-					     nb_transactions, local_endianness,
-					     header->hblk_endian) != 0)
-			{
-				fprintf(stderr,
-					"readBlocks: readTransactions failure\n");
-				return (1);
-			}
-		}
 
-		if (llist_add_node(chain, (llist_node_t)block,
-				   ADD_NODE_REAR) != 0)
+		if (chainAdd(blockchain, block) != 0)
 		{
-			fprintf(stderr, "readBlocks: llist_add_node: %s\n",
-				strE_LLIST(llist_errno));
+			fprintf(stderr, "readBlocks: chainAdd failure\n");
+			block_destroy(block);
 			return (1);
 		}
 	}
@@ -239,25 +367,27 @@ int readBlocks(int fd, llist_t *chain, uint8_t local_endianness,
  * readTransactions - reads serialized transactions from a storage file into a
  *   blockchain data structure
  *
- * @fd: file descriptor already open for reading
+ * @reader: pointer to reader over the mapped file
  * @transactions: pointer to an empty transactions list to contain the
  *   deserialized transactions
  * @nb_transactions: amount of transactions to expect to read for this block
  * @local_endianness: 1 for little endian, 2 for big endian
  * @hblk_endian: 1 for little endian, 2 for big endian
+ * @arena: pointer to the arena of the block being read, or NULL to allocate
+ *   each transaction, input and output on the heap
  *
  * Return: 0 on success, or 1 upon failure
  */
-int readTransactions(int fd, llist_t *transactions,
+int readTransactions(bc_reader_t *reader, llist_t *transactions,
 		     uint32_t nb_transactions, uint8_t local_endianness,
-		     uint8_t hblk_endian)
+		     uint8_t hblk_endian, bc_arena_t *arena)
 {
 	uint32_t i, nb_inputs, nb_outputs;
 	transaction_t *tx;
 
-	if (!transactions)
+	if (!reader || !transactions)
 	{
-		fprintf(stderr, "readTransactions: NULL parameter\n");
+		fprintf(stderr, "readTransactions: NULL parameter(s)\n");
 		return (1);
 	}
 	if (!llist_is_empty(transactions))
@@ -268,17 +398,20 @@ int readTransactions(int fd, llist_t *transactions,
 	}
 	for (i = 0; i < nb_transactions; i++)
 	{
-		tx = calloc(1, sizeof(transaction_t));
+		tx = bcArenaAlloc(arena, sizeof(transaction_t));
 		if (!tx)
 		{
 			fprintf(stderr, "readTransactions: calloc failure\n");
 			return (1);
 		}
-		if (read(fd, &(tx->id), SHA256_DIGEST_LENGTH) == -1 ||
-		    read(fd, &nb_inputs, sizeof(uint32_t)) == -1 ||
-		    read(fd, &nb_outputs, sizeof(uint32_t)) == -1)
+		if (bcReaderTake(reader, &(tx->id),
+				 SHA256_DIGEST_LENGTH) != 0 ||
+		    bcReaderTake(reader, &nb_inputs, sizeof(uint32_t)) != 0 ||
+		    bcReaderTake(reader, &nb_outputs, sizeof(uint32_t)) != 0)
 		{
-			perror("readTransactions: read");
+			fprintf(stderr,
+				"readTransactions: bcReaderTake failure\n");
+			bcArenaFree(arena, tx);
 			return (1);
 		}
 		if (local_endianness != hblk_endian)
@@ -298,19 +431,22 @@ int readTransactions(int fd, llist_t *transactions,
 		{
 			fprintf(stderr,
 				"readTransactions: llist_create failure\n");
+			releaseTx(tx, arena);
 			return (1);
 		}
-		if (readInputs(fd, tx->inputs, nb_inputs) != 0)
+		if (readInputs(reader, tx->inputs, nb_inputs, arena) != 0)
 		{
 			fprintf(stderr,
 				"readTransactions: readInputs failure\n");
+			releaseTx(tx, arena);
 			return (1);
 		}
-		if (readOutputs(fd, tx->outputs, nb_outputs,
-				local_endianness, hblk_endian) != 0)
+		if (readOutputs(reader, tx->outputs, nb_outputs,
+				local_endianness, hblk_endian, arena) != 0)
 		{
 			fprintf(stderr,
 				"readTransactions: readOutputs failure\n");
+			releaseTx(tx, arena);
 			return (1);
 		}
 
@@ -320,6 +456,7 @@ int readTransactions(int fd, llist_t *transactions,
 			fprintf(stderr,
 				"readTransactions: llist_add_node: %s\n",
 				strE_LLIST(llist_errno));
+			releaseTx(tx, arena);
 			return (1);
 		}
 	}
@@ -331,21 +468,24 @@ int readTransactions(int fd, llist_t *transactions,
  * readInputs - reads serialized transaction inputs from a storage file into a
  *   blockchain data structure
  *
- * @fd: file descriptor already open for reading
+ * @reader: pointer to reader over the mapped file
  * @inputs: pointer to an empty list of transaction inputs to contain the
  *   deserialized inputs
  * @nb_inputs: number of inputs to expect to read
+ * @arena: pointer to the arena of the block being read, or NULL to allocate
+ *   each input on the heap
  *
  * Return: 0 on success, or 1 upon failure
  */
-int readInputs(int fd, llist_t *inputs, uint32_t nb_inputs)
+int readInputs(bc_reader_t *reader, llist_t *inputs, uint32_t nb_inputs,
+	       bc_arena_t *arena)
 {
 	uint32_t i;
 	tx_in_t *tx_in;
 
-	if (!inputs)
+	if (!reader || !inputs)
 	{
-		fprintf(stderr, "readInputs: NULL parameter\n");
+		fprintf(stderr, "readInputs: NULL parameter(s)\n");
 		return (1);
 	}
 	if (!llist_is_empty(inputs))
@@ -356,16 +496,17 @@ int readInputs(int fd, llist_t *inputs, uint32_t nb_inputs)
 	}
 	for (i = 0; i < nb_inputs; i++)
 	{
-		tx_in = calloc(1, sizeof(tx_in_t));
+		tx_in = bcArenaAlloc(arena, sizeof(tx_in_t));
 		if (!tx_in)
 		{
 			fprintf(stderr, "readInputs: calloc failure\n");
 			return (1);
 		}
 
-		if (read(fd, tx_in, sizeof(tx_in_t)) == -1)
+		if (bcReaderTake(reader, tx_in, sizeof(tx_in_t)) != 0)
 		{
-			perror("readInputs: read");
+			fprintf(stderr, "readInputs: bcReaderTake failure\n");
+			bcArenaFree(arena, tx_in);
 			return (1);
 		}
 
@@ -375,6 +516,7 @@ int readInputs(int fd, llist_t *inputs, uint32_t nb_inputs)
 			fprintf(stderr,
 				"readInputs: llist_add_node: %s\n",
 				strE_LLIST(llist_errno));
+			bcArenaFree(arena, tx_in);
 			return (1);
 		}
 	}
@@ -386,24 +528,27 @@ int readInputs(int fd, llist_t *inputs, uint32_t nb_inputs)
  * readOutputs - reads serialized transaction outputs from a storage file into
  *   a blockchain data structure
  *
- * @fd: file descriptor already open for reading
+ * @reader: pointer to reader over the mapped file
  * @outputs: pointer to an empty transaction outputs list to contain the
  *   deserialized outputs
  * @nb_outputs: number of outputs to expect to read
  * @local_endianness: 1 for little endian, 2 for big endian
  * @hblk_endian: 1 for little endian, 2 for big endian
+ * @arena: pointer to the arena of the block being read, or NULL to allocate
+ *   each output on the heap
  *
  * Return: 0 on success, or 1 upon failure
  */
-int readOutputs(int fd, llist_t *outputs, uint32_t nb_outputs,
-		uint8_t local_endianness, uint8_t hblk_endian)
+int readOutputs(bc_reader_t *reader, llist_t *outputs, uint32_t nb_outputs,
+		uint8_t local_endianness, uint8_t hblk_endian,
+		bc_arena_t *arena)
 {
 	uint32_t i;
 	tx_out_t *tx_out;
 
-	if (!outputs)
+	if (!reader || !outputs)
 	{
-		fprintf(stderr, "readOutputs: NULL parameter\n");
+		fprintf(stderr, "readOutputs: NULL parameter(s)\n");
 		return (1);
 	}
 	if (!llist_is_empty(outputs))
@@ -414,7 +559,7 @@ int readOutputs(int fd, llist_t *outputs, uint32_t nb_outputs,
 	}
 	for (i = 0; i < nb_outputs; i++)
 	{
-		tx_out = calloc(1, sizeof(tx_out_t));
+		tx_out = bcArenaAlloc(arena, sizeof(tx_out_t));
 		if (!tx_out)
 		{
 			fprintf(stderr, "readOutputs: calloc failure\n");
@@ -422,11 +567,14 @@ int readOutputs(int fd, llist_t *outputs, uint32_t nb_outputs,
 		}
 
 		/* serialized one member at a time, see blockchain_serialize */
-		if (read(fd, &(tx_out->amount), sizeof(uint32_t)) == -1 ||
-		    read(fd, &(tx_out->pub), EC_PUB_LEN) == -1 ||
-		    read(fd, &(tx_out->hash), SHA256_DIGEST_LENGTH) == -1)
+		if (bcReaderTake(reader, &(tx_out->amount),
+				 sizeof(uint32_t)) != 0 ||
+		    bcReaderTake(reader, &(tx_out->pub), EC_PUB_LEN) != 0 ||
+		    bcReaderTake(reader, &(tx_out->hash),
+				 SHA256_DIGEST_LENGTH) != 0)
 		{
-			perror("readOutputs: read");
+			fprintf(stderr, "readOutputs: bcReaderTake failure\n");
+			bcArenaFree(arena, tx_out);
 			return (1);
 		}
 
@@ -443,6 +591,7 @@ int readOutputs(int fd, llist_t *outputs, uint32_t nb_outputs,
 			fprintf(stderr,
 				"readOutputs: llist_add_node: %s\n",
 				strE_LLIST(llist_errno));
+			bcArenaFree(arena, tx_out);
 			return (1);
 		}
 	}
@@ -450,25 +599,85 @@ int readOutputs(int fd, llist_t *outputs, uint32_t nb_outputs,
 }
 
 
+/**
+ * readUnspentTxOut - reads a serialized unspent output
+ *
+ * @reader: pointer to reader over the serialized unspent output
+ * @local_endianness: 1 for little endian, 2 for big endian
+ * @hblk_endian: 1 for little endian, 2 for big endian
+ *
+ * Return: pointer to the deserialized unspent output, or NULL upon failure
+ */
+unspent_tx_out_t *readUnspentTxOut(bc_reader_t *reader,
+				   uint8_t local_endianness,
+				   uint8_t hblk_endian)
+{
+	unspent_tx_out_t *unspent_tx_out;
+
+	if (!reader)
+	{
+		fprintf(stderr, "readUnspentTxOut: NULL parameter\n");
+		return (NULL);
+	}
+
+	unspent_tx_out = calloc(1, sizeof(unspent_tx_out_t));
+	if (!unspent_tx_out)
+	{
+		fprintf(stderr, "readUnspent: calloc failure\n");
+		return (NULL);
+	}
+
+	/* serialized one member at a time, see blockchain_serialize */
+	if (bcReaderTake(reader, &(unspent_tx_out->block_hash),
+			 SHA256_DIGEST_LENGTH) != 0 ||
+	    bcReaderTake(reader, &(unspent_tx_out->tx_id),
+			 SHA256_DIGEST_LENGTH) != 0 ||
+	    bcReaderTake(reader, &(unspent_tx_out->out.amount),
+			 sizeof(uint32_t)) != 0 ||
+	    bcReaderTake(reader, &(unspent_tx_out->out.pub),
+			 EC_PUB_LEN) != 0 ||
+	    bcReaderTake(reader, &(unspent_tx_out->out.hash),
+			 SHA256_DIGEST_LENGTH) != 0)
+	{
+		fprintf(stderr, "readUnspent: bcReaderTake failure\n");
+		free(unspent_tx_out);
+		return (NULL);
+	}
+
+	if (local_endianness != hblk_endian)
+	{
+#ifdef __GNUC__ /* compiled with gcc, can use gcc builtins for fast assembly */
+		unspent_tx_out->out.amount =
+			__builtin_bswap32(unspent_tx_out->out.amount);
+#else /* use function to manually byte swap */
+		_swap_endian(&(unspent_tx_out->out.amount), 4);
+#endif
+	}
+
+	return (unspent_tx_out);
+}
+
+
 /**
  * readUnspent - reads serialized unspent outputs from a storage file into a
  *   blockchain data structure
  *
- * @fd: file descriptor already open for reading
+ * @reader: pointer to reader over the mapped file
  * @unspent: pointer to an empty unspent output list to contain the
  *   deserialized unspent outputs
+ * @index: index of `unspent`, or NULL
  * @local_endianness: 1 for little endian, 2 for big endian
  * @header: stores values read from file header
  *
  * Return: 0 on success, or 1 upon failure
  */
-int readUnspent(int fd, llist_t *unspent,
+int readUnspent(bc_reader_t *reader, llist_t *unspent, utxo_index_t *index,
 		uint8_t local_endianness, bc_file_hdr_t *header)
 {
 	uint32_t i;
 	unspent_tx_out_t *unspent_tx_out;
 
-	if (!unspent || !header)
+	if (!reader || !unspent || !header)
 	{
 		fprintf(stderr, "readUnspent: NULL parameter(s)\n");
 		return (1);
@@ -481,45 +690,15 @@ int readUnspent(int fd, llist_t *unspent,
 	}
 	for (i = 0; i < header->hblk_unspent; i++)
 	{
-		unspent_tx_out = calloc(1, sizeof(unspent_tx_out_t));
+		unspent_tx_out = readUnspentTxOut(reader, local_endianness,
+						  header->hblk_endian);
 		if (!unspent_tx_out)
-		{
-			fprintf(stderr, "readUnspent: calloc failure\n");
 			return (1);
-		}
 
-		/* serialized one member at a time, see blockchain_serialize */
-		if (read(fd, &(unspent_tx_out->block_hash),
-			 SHA256_DIGEST_LENGTH) == -1 ||
-		    read(fd, &(unspent_tx_out->tx_id),
-			 SHA256_DIGEST_LENGTH) == -1 ||
-		    read(fd, &(unspent_tx_out->out.amount),
-			  sizeof(uint32_t)) == -1 ||
-		    read(fd, &(unspent_tx_out->out.pub),
-			 EC_PUB_LEN) == -1 ||
-		    read(fd, &(unspent_tx_out->out.hash),
-			 SHA256_DIGEST_LENGTH) == -1)
+		if (unspentAdd(unspent, index, unspent_tx_out) != 0)
 		{
-			perror("readUnspent: read");
-			return (1);
-		}
-
-		if (local_endianness != header->hblk_endian)
-		{
-#ifdef __GNUC__ /* compiled with gcc, can use gcc builtins for fast assembly */
-			unspent_tx_out->out.amount =
-				__builtin_bswap32(unspent_tx_out->out.amount);
-#else /* use function to manually byte swap */
-			_swap_endian(&(unspent_tx_out->out.amount), 4);
-#endif
-		}
-
-		if (llist_add_node(unspent, (llist_node_t)unspent_tx_out,
-				   ADD_NODE_REAR) != 0)
-		{
-			fprintf(stderr,
-				"readUnspent: llist_add_node: %s\n",
-				strE_LLIST(llist_errno));
+			fprintf(stderr, "readUnspent: unspentAdd failure\n");
+			free(unspent_tx_out);
 			return (1);
 		}
 	}
@@ -528,54 +707,91 @@ int readUnspent(int fd, llist_t *unspent,
 
 
 /**
- * blockchain_deserialize - deserializes a blockchain from a file; see
- *   blockchain_serialize for serialization format
+ * blockchain_deserialize_mt - deserializes a blockchain from a file, see
+ *   blockchain_serialize for serialization format; the blocks of large
+ *   mapped files are decoded by several threads, see readBlocksMT
  *
  * @path: full path to file containing serialized blockchain
+ * @thread_ct: amount of threads to use, or 0 for one per online processor;
+ *   bound to BLOCK_MINE_THREADS_MAX, and only used for files of at least
+ *   BC_LOAD_MT_MIN_BLOCKS blocks
  *
  * Return: pointer to deserialized blockchain, or NULL on failure
  */
-blockchain_t *blockchain_deserialize(char const *path)
+blockchain_t *blockchain_deserialize_mt(char const *path,
+				       unsigned int thread_ct)
 {
 	int fd;
 	uint8_t local_endianness;
 	bc_file_hdr_t header;
-	blockchain_t *blockchain;
-	block_t *genesis;
+	bc_reader_t reader;
+	blockchain_t *blockchain = NULL;
+	int ret;
 
 	if (!path)
 	{
-		fprintf(stderr, "blockchain_deserialize: NULL parameter\n");
+		fprintf(stderr, "blockchain_deserialize_mt: NULL parameter\n");
 		return (NULL);
 	}
 
 	fd = pathToReadFD(path);
 	if (fd == -1)
 		return (NULL);
+	/* the mapping outlives the file descriptor */
+	ret = bcReaderMap(&reader, fd);
+	if (ret == 2)
+		blockchain = blockchainFromStream(fd);
+	close(fd);
+	if (ret != 0)
+		return (ret == 2 ? blockchain : NULL);
 	blockchain = blockchain_create();
 	if (!blockchain)
 	{
-		fprintf(stderr,
-			"blockchain_deserialize: blockchain_create failure\n");
-		close(fd);
+		fprintf(stderr, "blockchain_deserialize_mt: %s\n",
+			"blockchain_create failure");
+		bcReaderUnmap(&reader);
 		return (NULL);
 	}
-	/* remove preloaded Genesis Block at head of list */
-	genesis = (block_t *)llist_pop(blockchain->chain);
-	if (genesis)
-		free(genesis);
+	chainPopGenesis(blockchain);
 	local_endianness = _get_endianness();
-
-	if (readBlkchnFileHdr(fd, local_endianness, &header) != 0 ||
-	    readBlocks(fd, blockchain->chain, local_endianness, &header) != 0 ||
-	    readUnspent(fd, blockchain->unspent,
-			local_endianness, &header) != 0)
+	if (thread_ct == 0)
+		thread_ct = minerThreadCt();
+
+	if (readBlkchnFileHdr(&reader, local_endianness, &header) != 0 ||
+	    (thread_ct > 1 && header.hblk_blocks >= BC_LOAD_MT_MIN_BLOCKS ?
+	     readBlocksMT(&reader, blockchain, local_endianness,
+			  &header, thread_ct) :
+	     readBlocks(&reader, blockchain,
+			local_endianness, &header)) != 0 ||
+	    readUnspent(&reader, blockchain->unspent,
+			blockchain->unspent_index, local_endianness,
+			&header) != 0)
 	{
-		close(fd);
+		bcReaderUnmap(&reader);
 		blockchain_destroy(blockchain);
 		return (NULL);
 	}
 
-	close(fd);
+	bcReaderUnmap(&reader);
 	return (blockchain);
 }
+
+
+/**
+ * blockchain_deserialize - deserializes a blockchain from a file; see
+ *   blockchain_serialize for serialization format
+ *
+ * @path: full path to file containing serialized blockchain
+ *
+ * Return: pointer to deserialized blockchain, or NULL on failure
+ */
+blockchain_t *blockchain_deserialize(char const *path)
+{
+	if (!path)
+	{
+		fprintf(stderr, "blockchain_deserialize: NULL parameter\n");
+		return (NULL);
+	}
+
+	return (blockchain_deserialize_mt(path, BC_LOAD_THREADS_DFLT));
+}
@@ -22,7 +22,10 @@ void blockchain_destroy(blockchain_t *blockchain)
 		return;
 	}
 
+	unspentIndexUnbind(blockchain);
+	chainIndexDestroy(blockchain->chain_index);
 	llist_destroy(blockchain->chain, 1, (node_dtor_t)block_destroy);
+	unspentIndexDestroy(blockchain->unspent_index);
 	llist_destroy(blockchain->unspent, 1, NULL);
 
 	free(blockchain);
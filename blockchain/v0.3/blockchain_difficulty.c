@@ -1,12 +1,39 @@
-/* blockchain_t sreE_LLIST BLOCK_GENERATION_INTERVAL */
+/* blockchain_t sreE_LLIST chainBlockAt BLOCK_GENERATION_INTERVAL */
 /* DIFFICULTY_ADJUSTMENT_INTERVAL */
 #include "blockchain.h"
 /* fprintf */
 #include <stdio.h>
-/* llist_size llist_errno llist_get_node_at llist_get_tail */
+/* llist_size llist_errno llist_get_tail */
 #include <llist.h>
 
 
+/**
+ * retargetDifficulty - adjusts a difficulty rating to the rate at which the
+ *   blocks since the last adjustment were mined
+ *
+ * @latest_blk: most recently added block
+ * @last_adj_blk: block DIFFICULTY_ADJUSTMENT_INTERVAL blocks before the one
+ *   to follow `latest_blk`
+ * @difficulty: difficulty setting, default value is difficulty of
+ *   `latest_blk`, modified by reference
+ */
+void retargetDifficulty(const block_t *latest_blk,
+			const block_t *last_adj_blk, uint32_t *difficulty)
+{
+	uint64_t expected_dt, actual_dt;
+
+	expected_dt = (latest_blk->info.index -
+		       last_adj_blk->info.index) * BLOCK_GENERATION_INTERVAL;
+	actual_dt = latest_blk->info.timestamp - last_adj_blk->info.timestamp;
+
+	if (actual_dt < (expected_dt / 2))
+		(*difficulty)++;
+
+	if (*difficulty && actual_dt > (expected_dt * 2))
+		(*difficulty)--;
+}
+
+
 /**
  * adjustDifficulty - sets a difficulty rating based on rate of block mining
  *
@@ -22,7 +49,6 @@ uint8_t adjustDifficulty(const blockchain_t *blockchain,
 {
 	block_t *last_adj_blk;
 	int block_ct;
-	uint64_t expected_dt, actual_dt;
 
 	if (!blockchain || !latest_blk || !difficulty)
 	{
@@ -38,25 +64,16 @@ uint8_t adjustDifficulty(const blockchain_t *blockchain,
 		return (1);
 	}
 
-	last_adj_blk = llist_get_node_at(blockchain->chain,
-					 block_ct -
-					 DIFFICULTY_ADJUSTMENT_INTERVAL);
+	/* constant time with the chain index, rather than a list walk */
+	last_adj_blk = chainBlockAt(blockchain,
+				    block_ct - DIFFICULTY_ADJUSTMENT_INTERVAL);
 	if (!last_adj_blk)
 	{
-		fprintf(stderr, "adjustDifficulty: llist_get_node_at: %s\n",
-			strE_LLIST(llist_errno));
+		fprintf(stderr, "adjustDifficulty: chainBlockAt failure\n");
 		return (1);
 	}
 
-	expected_dt = (latest_blk->info.index -
-		       last_adj_blk->info.index) * BLOCK_GENERATION_INTERVAL;
-	actual_dt = latest_blk->info.timestamp - last_adj_blk->info.timestamp;
-
-	if (actual_dt < (expected_dt / 2))
-		(*difficulty)++;
-
-	if (*difficulty && actual_dt > (expected_dt * 2))
-		(*difficulty)--;
+	retargetDifficulty(latest_blk, last_adj_blk, difficulty);
 
 	return (0);
 }
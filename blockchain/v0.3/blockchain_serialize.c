@@ -1,13 +1,16 @@
-/* block_t blockchain_t strE_LLIST bc_file_hdr_t HBLK_MAG HBLK_VER */
+/* block_t blockchain_t strE_LLIST bc_file_hdr_t bc_index_t HBLK_MAG HBLK_VER */
 #include "blockchain.h"
 /* lstat `struct stat` S_ISDIR */
 #include <sys/types.h>
 #include <sys/stat.h>
+/* close */
 #include <unistd.h>
 /* errno ENOENT */
 #include <errno.h>
-/* fprintf perror write remove */
+/* fprintf perror remove */
 #include <stdio.h>
+/* memset */
+#include <string.h>
 /* open O_* S_* close */
 #include <fcntl.h>
 /* _get_endianness */
@@ -65,7 +68,7 @@ int pathToWriteFD(char const *path)
  * writeBlkchnFileHdr - writes a serialized file header to a file for storage
  *   of a blockchain
  *
- * @fd: file descriptor open for writing
+ * @writer: pointer to buffered output of a file open for writing
  * @blockchain: pointer to the blockchain to be serialized
  *
  * File Header format:
@@ -84,18 +87,20 @@ int pathToWriteFD(char const *path)
  *  0x10   ?       blocks       List of Blocks, see writeBlock
  *  0x10  165      unspent      List of unspent transaction outputs,
  *   + ?   * hblk_unspent         see writeUnspent
+ *   ...   ?       index        Block and transaction tables, then footer,
+ *                                since version 0.4; see bcIndexWrite
  *
  * Return: 0 on success, or 1 upon failure
  */
-int writeBlkchnFileHdr(int fd, const blockchain_t *blockchain)
+int writeBlkchnFileHdr(bc_writer_t *writer, const blockchain_t *blockchain)
 {
 	bc_file_hdr_t header = { HBLK_MAG, HBLK_VER, 0, 0, 0 };
 	int block_ct, unspent_ct;
 
 
-	if (!blockchain)
+	if (!writer || !blockchain)
 	{
-		fprintf(stderr, "writeBlkchnFileHdr: NULL parameter\n");
+		fprintf(stderr, "writeBlkchnFileHdr: NULL parameter(s)\n");
 		return (1);
 	}
 
@@ -125,9 +130,9 @@ int writeBlkchnFileHdr(int fd, const blockchain_t *blockchain)
 	}
 	header.hblk_unspent = (uint32_t)unspent_ct;
 
-	if (write(fd, &header, sizeof(bc_file_hdr_t)) == -1)
+	if (bcWriterPut(writer, &header, sizeof(bc_file_hdr_t)) != 0)
 	{
-		perror("writeBlkchnFileHdr: write");
+		fprintf(stderr, "writeBlkchnFileHdr: bcWriterPut failure\n");
 		return (1);
 	}
 
@@ -141,7 +146,7 @@ int writeBlkchnFileHdr(int fd, const blockchain_t *blockchain)
  *
  * @block: current block in blockchain->chain
  * @idx: index of block in blockchain->chain list
- * @fd: pointer to file descriptor open for writing
+ * @writer: pointer to buffered output of a file open for writing
  *
  * Blocks are serialized contiguously, the first starting at file offset
  *   0x10, and adhere to the following format:
@@ -168,11 +173,11 @@ int writeBlkchnFileHdr(int fd, const blockchain_t *blockchain)
  * Return: 0 on incremental success (llist_for_each can continue,)
  *   and -2 on failure (-1 reserved for llist_for_each errors)
  */
-int writeBlock(block_t *block, unsigned int idx, int *fd)
+int writeBlock(block_t *block, unsigned int idx, bc_writer_t *writer)
 {
 	int32_t nb_transactions;
 
-	if (!block || !fd)
+	if (!block || !writer)
 	{
 		fprintf(stderr, "writeBlock: NULL parameter(s)\n");
 		return (-2);
@@ -188,19 +193,23 @@ int writeBlock(block_t *block, unsigned int idx, int *fd)
 		return (-2);
 	}
 
-	if (write(*fd, &(block->info), sizeof(block_info_t)) == -1 ||
-	    write(*fd, &(block->data.len), sizeof(uint32_t)) == -1 ||
-	    write(*fd, &(block->data.buffer), block->data.len) == -1 ||
-	    write(*fd, &(block->hash), SHA256_DIGEST_LENGTH) == -1 ||
-	    write(*fd, &nb_transactions, sizeof(uint32_t)) == -1)
+	if (writer->index &&
+	    bcIndexBlock(writer->index, block, writer->pos) != 0)
+		return (-2);
+
+	if (bcWriterPut(writer, &(block->info), sizeof(block_info_t)) != 0 ||
+	    bcWriterPut(writer, &(block->data.len), sizeof(uint32_t)) != 0 ||
+	    bcWriterPut(writer, &(block->data.buffer), block->data.len) != 0 ||
+	    bcWriterPut(writer, &(block->hash), SHA256_DIGEST_LENGTH) != 0 ||
+	    bcWriterPut(writer, &nb_transactions, sizeof(uint32_t)) != 0)
 	{
-		perror("writeBlock: write");
+		fprintf(stderr, "writeBlock: bcWriterPut failure\n");
 		return (-2);
 	}
 
 	if (idx > 0 && block->info.index > 0 &&
 	    llist_for_each(block->transactions,
-			   (node_func_t)writeTransaction, fd) < 0)
+			   (node_func_t)writeTransaction, writer) < 0)
 	{
 		fprintf(stderr,
 			"writeBlock: llist_for_each failure\n");
@@ -217,7 +226,7 @@ int writeBlock(block_t *block, unsigned int idx, int *fd)
  *
  * @tx: current transaction in block->transactions
  * @idx: index of transaction in a block->transactions list
- * @fd: pointer to file descriptor open for writing
+ * @writer: pointer to buffered output of a file open for writing
  *
  * Transaction serialized contiguously, the first starting at offset
  *    0x60 + data_len from the start of a serialized block:
@@ -236,57 +245,29 @@ int writeBlock(block_t *block, unsigned int idx, int *fd)
  * Return: 0 on incremental success (llist_for_each can continue,)
  *   and -2 on failure (-1 reserved for llist_for_each errors)
  */
-int writeTransaction(transaction_t *tx, unsigned int idx, int *fd)
+int writeTransaction(transaction_t *tx, unsigned int idx,
+		     bc_writer_t *writer)
 {
-	int nb_inputs, nb_outputs;
+	tx_flat_t flat;
+	int ret;
 
 	(void)idx;
-	if (!tx || !fd)
+	if (!tx || !writer)
 	{
 		fprintf(stderr, "writeTransaction: NULL parameter(s)\n");
 		return (-2);
 	}
 
-	nb_inputs = llist_size(tx->inputs);
-	if (nb_inputs == -1)
-	{
-		fprintf(stderr, "writeTransaction: llist_size: %s\n",
-			strE_LLIST(llist_errno));
-		return (-2);
-	}
-	nb_outputs = llist_size(tx->outputs);
-	if (nb_outputs == -1)
+	/* written from the array form, walking no list node per field */
+	if (txFlatten(tx, &flat) != 0)
 	{
-		fprintf(stderr, "writeTransaction: llist_size: %s\n",
-			strE_LLIST(llist_errno));
+		fprintf(stderr, "writeTransaction: txFlatten failure\n");
 		return (-2);
 	}
+	ret = writeTxFlat(&flat, writer);
+	txFlatFree(&flat);
 
-	if (write(*fd, &(tx->id), SHA256_DIGEST_LENGTH) == -1 ||
-	    write(*fd, &nb_inputs, sizeof(uint32_t)) == -1 ||
-	    write(*fd, &nb_outputs, sizeof(uint32_t)) == -1)
-	{
-		perror("writeTransaction: write");
-		return (-2);
-	}
-
-	if (llist_for_each(tx->inputs,
-			   (node_func_t)writeInput, fd) < 0)
-	{
-		fprintf(stderr,
-			"writeTransaction: llist_for_each failure\n");
-		return (-2);
-	}
-
-	if (llist_for_each(tx->outputs,
-			   (node_func_t)writeOutput, fd) < 0)
-	{
-		fprintf(stderr,
-			"writeTransaction: llist_for_each failure\n");
-		return (-2);
-	}
-
-	return (0);
+	return (ret ? -2 : 0);
 }
 
 
@@ -296,7 +277,7 @@ int writeTransaction(transaction_t *tx, unsigned int idx, int *fd)
  *
  * @tx_in: current input in transaction->inputs
  * @idx: index of input in a transaction->inputs list
- * @fd: pointer to file descriptor open for writing
+ * @writer: pointer to buffered output of a file open for writing
  *
  * Transaction inputs serialized contiguously, the first starting at offset
  *    0x28 from start of transaction, each stored in exactly 169 bytes:
@@ -312,10 +293,10 @@ int writeTransaction(transaction_t *tx, unsigned int idx, int *fd)
  * Return: 0 on incremental success (llist_for_each can continue,)
  *   and -2 on failure (-1 reserved for llist_for_each errors)
  */
-int writeInput(tx_in_t *tx_in, unsigned int idx, int *fd)
+int writeInput(tx_in_t *tx_in, unsigned int idx, bc_writer_t *writer)
 {
 	(void)idx;
-	if (!tx_in || !fd)
+	if (!tx_in || !writer)
 	{
 		fprintf(stderr, "writeInput: NULL parameter(s)\n");
 		return (-2);
@@ -326,9 +307,9 @@ int writeInput(tx_in_t *tx_in, unsigned int idx, int *fd)
 	 *   sig:sizeof(sig_t):73 sig72 len:1
 	 * no padding observed, size of struct matches total of members
 	 */
-	if (write(*fd, tx_in, sizeof(tx_in_t)) == -1)
+	if (bcWriterPut(writer, tx_in, sizeof(tx_in_t)) != 0)
 	{
-		perror("writeInput: write");
+		fprintf(stderr, "writeInput: bcWriterPut failure\n");
 		return (-2);
 	}
 
@@ -342,7 +323,7 @@ int writeInput(tx_in_t *tx_in, unsigned int idx, int *fd)
  *
  * @tx_out: current output in transaction->outputs
  * @idx: index of output in a transaction->outputs list
- * @fd: pointer to file descriptor open for writing
+ * @writer: pointer to buffered output of a file open for writing
  *
  * Transaction outputs serialized contiguously, the first starting after the
  *    last transaction input, each stored in exactly 101 bytes:
@@ -354,10 +335,10 @@ int writeInput(tx_in_t *tx_in, unsigned int idx, int *fd)
  * Return: 0 on incremental success (llist_for_each can continue,)
  *   and -2 on failure (-1 reserved for llist_for_each errors)
  */
-int writeOutput(tx_out_t *tx_out, unsigned int idx, int *fd)
+int writeOutput(tx_out_t *tx_out, unsigned int idx, bc_writer_t *writer)
 {
 	(void)idx;
-	if (!tx_out || !fd)
+	if (!tx_out || !writer)
 	{
 		fprintf(stderr, "writeOutput: NULL parameter(s)\n");
 		return (-2);
@@ -367,11 +348,11 @@ int writeOutput(tx_out_t *tx_out, unsigned int idx, int *fd)
 	 * sizeof(tx_out_t):104 amount:4 pub:65 hash:32
 	 * padded with 3 bytes at end, must serialize manually to total 101
 	 */
-	if (write(*fd, &(tx_out->amount), sizeof(uint32_t)) == -1 ||
-	    write(*fd, &(tx_out->pub), EC_PUB_LEN) == -1 ||
-	    write(*fd, &(tx_out->hash), SHA256_DIGEST_LENGTH) == -1)
+	if (bcWriterPut(writer, &(tx_out->amount), sizeof(uint32_t)) != 0 ||
+	    bcWriterPut(writer, &(tx_out->pub), EC_PUB_LEN) != 0 ||
+	    bcWriterPut(writer, &(tx_out->hash), SHA256_DIGEST_LENGTH) != 0)
 	{
-		perror("writeOutput: write");
+		fprintf(stderr, "writeOutput: bcWriterPut failure\n");
 		return (-2);
 	}
 
@@ -379,13 +360,50 @@ int writeOutput(tx_out_t *tx_out, unsigned int idx, int *fd)
 }
 
 
+/**
+ * writeTxFlat - serializes and writes to file a transaction in array form,
+ *   in the format documented at writeTransaction
+ *
+ * @flat: pointer to transaction to write, see txFlatten
+ * @writer: pointer to buffered output of a file open for writing
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+int writeTxFlat(tx_flat_t const *flat, bc_writer_t *writer)
+{
+	uint32_t i;
+
+	if (!flat || !writer)
+	{
+		fprintf(stderr, "writeTxFlat: NULL parameter(s)\n");
+		return (1);
+	}
+
+	/* inputs are unpadded, see writeInput, and written in one copy */
+	if (bcWriterPut(writer, &(flat->id), SHA256_DIGEST_LENGTH) != 0 ||
+	    bcWriterPut(writer, &(flat->input_ct), sizeof(uint32_t)) != 0 ||
+	    bcWriterPut(writer, &(flat->output_ct), sizeof(uint32_t)) != 0 ||
+	    bcWriterPut(writer, flat->inputs,
+			(size_t)flat->input_ct * sizeof(tx_in_t)) != 0)
+	{
+		fprintf(stderr, "writeTxFlat: bcWriterPut failure\n");
+		return (1);
+	}
+	for (i = 0; i < flat->output_ct; i++)
+		if (writeOutput(flat->outputs + i, i, writer) != 0)
+			return (1);
+
+	return (0);
+}
+
+
 /**
  * writeUnspent - used as `action` for llist_for_each to serialize and
  *   write to file an unspent output in blockchain->unspent list
  *
  * @unspent_tx_out: current unspent output in blockchain->unspent
  * @idx: index of unspent output in a blockchain->unspent list
- * @fd: pointer to file descriptor open for writing
+ * @writer: pointer to buffered output of a file open for writing
  *
  * Unspent transaction outputs serialized contiguously, the first starting
  *   after the last serialized block, each stored in exactly 165 bytes:
@@ -403,10 +421,11 @@ int writeOutput(tx_out_t *tx_out, unsigned int idx, int *fd)
  * Return: 0 on incremental success (llist_for_each can continue,)
  *   and -2 on failure (-1 reserved for llist_for_each errors)
  */
-int writeUnspent(unspent_tx_out_t *unspent_tx_out, unsigned int idx, int *fd)
+int writeUnspent(unspent_tx_out_t *unspent_tx_out, unsigned int idx,
+		 bc_writer_t *writer)
 {
 	(void)idx;
-	if (!unspent_tx_out || !fd)
+	if (!unspent_tx_out || !writer)
 	{
 		fprintf(stderr, "writeUnspent: NULL parameter(s)\n");
 		return (-2);
@@ -418,15 +437,17 @@ int writeUnspent(unspent_tx_out_t *unspent_tx_out, unsigned int idx, int *fd)
 	 * (3 bytes of padding at end of tx_out_t requires serializing
 	 *   manually to total 165)
 	 */
-	if (write(*fd, &(unspent_tx_out->block_hash),
-		  SHA256_DIGEST_LENGTH) == -1 ||
-	    write(*fd, &(unspent_tx_out->tx_id), SHA256_DIGEST_LENGTH) == -1 ||
-	    write(*fd, &(unspent_tx_out->out.amount),
-		  sizeof(uint32_t)) == -1 ||
-	    write(*fd, &(unspent_tx_out->out.pub), EC_PUB_LEN) == -1 ||
-	    write(*fd, &(unspent_tx_out->out.hash), SHA256_DIGEST_LENGTH) == -1)
+	if (bcWriterPut(writer, &(unspent_tx_out->block_hash),
+			SHA256_DIGEST_LENGTH) != 0 ||
+	    bcWriterPut(writer, &(unspent_tx_out->tx_id),
+			SHA256_DIGEST_LENGTH) != 0 ||
+	    bcWriterPut(writer, &(unspent_tx_out->out.amount),
+			sizeof(uint32_t)) != 0 ||
+	    bcWriterPut(writer, &(unspent_tx_out->out.pub), EC_PUB_LEN) != 0 ||
+	    bcWriterPut(writer, &(unspent_tx_out->out.hash),
+			SHA256_DIGEST_LENGTH) != 0)
 	{
-		perror("writeUnspent: write");
+		fprintf(stderr, "writeUnspent: bcWriterPut failure\n");
 		return (-2);
 	}
 
@@ -451,11 +472,14 @@ int writeUnspent(unspent_tx_out_t *unspent_tx_out, unsigned int idx, int *fd)
  *          Inputs (see writeInput)
  *          Outputs (see writeOutput)
  *  Unspent outputs (see writeUnspent)
+ *  Block and transaction tables, and footer (see bcIndexWrite)
  *
  * Return: 0 upon success, or -1 upon failure
  */
 int blockchain_serialize(blockchain_t const *blockchain, char const *path)
 {
+	bc_writer_t writer;
+	bc_index_t index;
 	int fd;
 
 	if (!blockchain || !path)
@@ -467,8 +491,11 @@ int blockchain_serialize(blockchain_t const *blockchain, char const *path)
 	fd = pathToWriteFD(path);
 	if (fd == -1)
 		return (-1);
+	bcWriterInit(&writer, fd);
+	memset(&index, 0, sizeof(bc_index_t));
+	writer.index = &index;
 
-	if (writeBlkchnFileHdr(fd, blockchain) != 0)
+	if (writeBlkchnFileHdr(&writer, blockchain) != 0)
 	{
 		close(fd);
 		remove(path);
@@ -476,25 +503,51 @@ int blockchain_serialize(blockchain_t const *blockchain, char const *path)
 	}
 
 	if (llist_for_each(blockchain->chain,
-			   (node_func_t)writeBlock, &fd) < 0)
+			   (node_func_t)writeBlock, &writer) < 0)
 	{
 		fprintf(stderr,
 			"blockchain_serialize: llist_for_each failure\n");
+		bcIndexFree(&index);
 		close(fd);
 		remove(path);
 		return (-1);
 	}
 
 	if (llist_for_each(blockchain->unspent,
-			   (node_func_t)writeUnspent, &fd) < 0)
+			   (node_func_t)writeUnspent, &writer) < 0)
 	{
 		fprintf(stderr,
 			"blockchain_serialize: llist_for_each failure\n");
+		bcIndexFree(&index);
 		close(fd);
 		remove(path);
 		return (-1);
 	}
 
-	close(fd);
+	/* tables of the offsets recorded by writeBlock, then footer */
+	if (bcIndexWrite(&writer, &index) != 0)
+	{
+		bcIndexFree(&index);
+		close(fd);
+		remove(path);
+		return (-1);
+	}
+	bcIndexFree(&index);
+
+	/* fields still buffered are only on disk once flushed */
+	if (bcWriterFlush(&writer) != 0)
+	{
+		close(fd);
+		remove(path);
+		return (-1);
+	}
+
+	if (close(fd) == -1)
+	{
+		perror("blockchain_serialize: close");
+		remove(path);
+		return (-1);
+	}
+
 	return (0);
 }
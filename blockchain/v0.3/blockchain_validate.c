@@ -0,0 +1,449 @@
+/* bv_pool_t blockchain_t block_t BC_VALIDATE_BATCH BLOCK_MINE_THREADS_MAX */
+#include "blockchain.h"
+/* fprintf */
+#include <stdio.h>
+/* malloc free */
+#include <stdlib.h>
+/* memcmp memcpy */
+#include <string.h>
+/* pthread_create pthread_join */
+#include <pthread.h>
+/* llist_* */
+#include <llist.h>
+
+
+/**
+ * collectBlock - used as `action` for llist_for_each to store each block of
+ *   a chain in its slot of an array
+ *
+ * @block: pointer to block in blockchain->chain, as iterated through by
+ *   llist_for_each
+ * @idx: index of `block` in blockchain->chain, as iterated through by
+ *   llist_for_each
+ * @blocks: array of blocks to amend
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int collectBlock(block_t *block, unsigned int idx, block_t **blocks)
+{
+	if (!block || !blocks)
+	{
+		fprintf(stderr, "collectBlock: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	blocks[idx] = block;
+	return (0);
+}
+
+
+/**
+ * checkTxId - used as `action` for llist_for_each to check that the ID of
+ *   each transaction in a block is the hash of the transaction
+ *
+ * @tx: pointer to transaction in block->transactions, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx` in block->transactions, as iterated through by
+ *   llist_for_each
+ * @arg: dummy arg to conform to node_func_t typedef
+ *
+ * Return: 0 if valid (llist_for_each can continue,)
+ *   or -2 if not (-1 reserved for llist_for_each errors)
+ */
+static int checkTxId(transaction_t *tx, unsigned int idx, void *arg)
+{
+	(void)arg;
+
+	if (!txIdIsValid(tx))
+	{
+		fprintf(stderr, "checkTxId: %s %u\n",
+			"hash does not match ID of transaction", idx);
+		return (-2);
+	}
+
+	return (0);
+}
+
+
+/**
+ * checkBlock - checks everything about a block in a chain that does not
+ *   depend on the unspent outputs: index, hash, difficulty, link to the
+ *   previous block and coinbase transaction; only reads the previous block,
+ *   so that blocks can be checked in any order
+ *
+ * @blocks: array of every block in the chain
+ * @i: index of the block to check in `blocks`
+ *
+ * Return: 0 if valid, or 1 if not
+ */
+static int checkBlock(block_t * const *blocks, uint32_t i)
+{
+	block_t const *block = blocks[i], *prev;
+	uint32_t difficulty;
+
+	if (block->info.index != i)
+	{
+		fprintf(stderr, "checkBlock: block %u: %s\n", i,
+			"index out of sequence");
+		return (1);
+	}
+	if (i == 0)
+		return (block_is_valid(block, NULL, NULL));
+
+	prev = blocks[i - 1];
+	difficulty = prev->info.difficulty;
+	/* same schedule as blockchain_difficulty when `block` was mined */
+	if (prev->info.index != 0 &&
+	    prev->info.index % DIFFICULTY_ADJUSTMENT_INTERVAL == 0)
+		retargetDifficulty(prev,
+				   blocks[i - DIFFICULTY_ADJUSTMENT_INTERVAL],
+				   &difficulty);
+	if (block->info.difficulty != difficulty)
+	{
+		fprintf(stderr, "checkBlock: block %u: %s\n", i,
+			"difficulty does not follow adjustment schedule");
+		return (1);
+	}
+	/* prev->hash itself is checked along with `prev` */
+	if (block->data.len > BLOCKCHAIN_DATA_MAX || miniumumBlkTxs(block) ||
+	    !blockHashIsValid(block) ||
+	    !hash_matches_difficulty(block->hash, block->info.difficulty) ||
+	    memcmp(block->info.prev_hash, prev->hash,
+		   SHA256_DIGEST_LENGTH) != 0 ||
+	    llist_for_each(block->transactions, (node_func_t)checkTxId,
+			   NULL) != 0)
+	{
+		fprintf(stderr, "checkBlock: block %u: %s\n", i,
+			"invalid data length, hash, link or transaction");
+		return (1);
+	}
+
+	return (0);
+}
+
+
+/**
+ * validateWorker - start routine of a blockchain_validate worker thread,
+ *   claims and checks batches of consecutive blocks until none is left
+ *   before the first invalid block found so far
+ *
+ * @pool: pointer to pool shared by every worker
+ *
+ * Return: always NULL, results are reported in pool->first_bad
+ */
+static void *validateWorker(bv_pool_t *pool)
+{
+	size_t i, end;
+	uint32_t bad;
+
+	for (;;)
+	{
+		i = __atomic_fetch_add(&(pool->next), BC_VALIDATE_BATCH,
+				       __ATOMIC_RELAXED);
+		if (i >= pool->block_ct)
+			break;
+		end = pool->block_ct - i < BC_VALIDATE_BATCH ?
+			pool->block_ct : i + BC_VALIDATE_BATCH;
+		for (; i < end; i++)
+		{
+			bad = __atomic_load_n(&(pool->first_bad),
+					      __ATOMIC_RELAXED);
+			if (i >= bad)
+				return (NULL);
+			if (checkBlock(pool->blocks, (uint32_t)i) == 0)
+				continue;
+			/* keep the lowest index if several workers fail */
+			while (i < bad &&
+			       !__atomic_compare_exchange_n(&(pool->first_bad),
+							    &bad, (uint32_t)i,
+							    0, __ATOMIC_RELAXED,
+							    __ATOMIC_RELAXED))
+				;
+			return (NULL);
+		}
+	}
+
+	return (NULL);
+}
+
+
+/**
+ * validatePool - checks every block of a pool, spreading them between
+ *   `thread_ct` workers; the calling thread acts as the first worker
+ *
+ * @pool: pointer to pool of blocks to check
+ * @thread_ct: amount of workers, at least 1
+ */
+static void validatePool(bv_pool_t *pool, unsigned int thread_ct)
+{
+	pthread_t *tids;
+	unsigned int spawned = 1;
+
+	pool->next = 0;
+	pool->first_bad = pool->block_ct;
+	if (thread_ct > pool->block_ct / BC_VALIDATE_BATCH)
+		thread_ct = pool->block_ct / BC_VALIDATE_BATCH ?
+			pool->block_ct / BC_VALIDATE_BATCH : 1;
+	tids = thread_ct > 1 ? malloc(thread_ct * sizeof(pthread_t)) : NULL;
+	/* remaining blocks are checked by the calling thread on any failure */
+	for (; tids && spawned < thread_ct; spawned++)
+		if (pthread_create(tids + spawned, NULL,
+				   (void *(*)(void *))validateWorker,
+				   pool) != 0)
+			break;
+	validateWorker(pool);
+	while (tids && --spawned > 0)
+		pthread_join(tids[spawned], NULL);
+	free(tids);
+}
+
+
+/**
+ * collectTx - used as `action` for llist_for_each to list each transaction
+ *   of a block but its coinbase transaction
+ *
+ * @tx: pointer to transaction in block->transactions, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx` in block->transactions, as iterated through by
+ *   llist_for_each
+ * @txs: list of transactions to amend, not owning them
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int collectTx(transaction_t *tx, unsigned int idx, llist_t *txs)
+{
+	if (!tx || !txs)
+	{
+		fprintf(stderr, "collectTx: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	if (idx && llist_add_node(txs, tx, ADD_NODE_REAR) != 0)
+		return (-2);
+	return (0);
+}
+
+
+/**
+ * replayBlockTxs - checks the transactions of a block against the unspent
+ *   outputs left by the blocks before it, then updates those outputs with
+ *   them, as cmd_mine does when adding the block
+ *
+ * @block: pointer to the block to replay
+ * @rebuilt: pointer to struct whose unspent outputs and index are those
+ *   left by the blocks before `block`, amended on success
+ * @thread_ct: amount of threads verifying signatures, see
+ *   transactionsVerify
+ *
+ * Return: 0 on success, or 1 if the block is invalid or upon failure
+ */
+static int replayBlockTxs(block_t *block, blockchain_t *rebuilt,
+			  unsigned int thread_ct)
+{
+	llist_t *txs;
+	int8_t *valid;
+	int tx_ct, i;
+
+	/* the coinbase transaction was checked by checkBlock */
+	tx_ct = llist_size(block->transactions);
+	txs = llist_create(MT_SUPPORT_FALSE);
+	valid = tx_ct > 0 ? malloc((size_t)tx_ct * sizeof(int8_t)) : NULL;
+	if (!txs || !valid ||
+	    llist_for_each(block->transactions, (node_func_t)collectTx,
+			   txs) != 0 ||
+	    transactionsVerify(txs, rebuilt->unspent, rebuilt->unspent_index,
+			       thread_ct, valid) != 0)
+	{
+		fprintf(stderr, "replayBlockTxs: transactionsVerify failure\n");
+		llist_destroy(txs, 0, NULL);
+		free(valid);
+		return (1);
+	}
+	llist_destroy(txs, 0, NULL);
+	for (i = 0; i < tx_ct - 1 && valid[i]; i++)
+		;
+	free(valid);
+	if (i < tx_ct - 1)
+	{
+		fprintf(stderr, "replayBlockTxs: block %u: %s %i\n",
+			block->info.index, "invalid transaction", i + 1);
+		return (1);
+	}
+	if (!updateUnspent(block->transactions, block->hash, rebuilt->unspent,
+			   rebuilt->unspent_index))
+	{
+		fprintf(stderr, "replayBlockTxs: updateUnspent failure\n");
+		return (1);
+	}
+
+	return (0);
+}
+
+
+/**
+ * matchUnspent - used as `action` for llist_for_each to find each unspent
+ *   output of a blockchain among those rebuilt by replaying its blocks
+ *
+ * @utxo: pointer to unspent output in blockchain->unspent, as iterated
+ *   through by llist_for_each
+ * @idx: index of `utxo` in blockchain->unspent, as iterated through by
+ *   llist_for_each
+ * @rebuilt: pointer to struct whose unspent outputs and index were rebuilt
+ *   by replayBlockTxs
+ *
+ * Return: 0 if found (llist_for_each can continue,)
+ *   or -2 if not (-1 reserved for llist_for_each errors)
+ */
+static int matchUnspent(unspent_tx_out_t *utxo, unsigned int idx,
+			blockchain_t *rebuilt)
+{
+	unspent_tx_out_t *found;
+	tx_in_t ref;
+
+	if (!utxo || !rebuilt)
+	{
+		fprintf(stderr, "matchUnspent: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	memcpy(ref.block_hash, utxo->block_hash, SHA256_DIGEST_LENGTH);
+	memcpy(ref.tx_id, utxo->tx_id, SHA256_DIGEST_LENGTH);
+	memcpy(ref.tx_out_hash, utxo->out.hash, SHA256_DIGEST_LENGTH);
+	found = unspentFind(rebuilt->unspent, rebuilt->unspent_index, &ref);
+	if (!found || found->out.amount != utxo->out.amount)
+	{
+		fprintf(stderr, "matchUnspent: %s %u\n",
+			"no block created unspent output", idx);
+		return (-2);
+	}
+
+	return (0);
+}
+
+
+/**
+ * replayUnspent - rebuilds the unspent outputs of a chain by replaying the
+ *   transactions of its blocks in order, then compares them to those stored
+ *   in the blockchain
+ *
+ * @blockchain: pointer to the blockchain to check
+ * @pool: pointer to pool of blocks, pool->first_bad being the index of the
+ *   first block found invalid by validatePool, or pool->block_ct; lowered
+ *   to the first block whose transactions are invalid
+ * @thread_ct: amount of threads verifying signatures, see
+ *   transactionsVerify
+ *
+ * Return: 0 if the unspent outputs of every block before pool->first_bad
+ *   replayed, 1 if they did not match blockchain->unspent, or -1 upon
+ *   failure
+ */
+static int replayUnspent(blockchain_t const *blockchain, bv_pool_t *pool,
+			 unsigned int thread_ct)
+{
+	/* only the unspent outputs of `rebuilt` are used */
+	blockchain_t rebuilt = {NULL, NULL, NULL, NULL};
+	uint32_t i;
+	int ret = 0, ct;
+
+	rebuilt.unspent = llist_create(MT_SUPPORT_FALSE);
+	if (rebuilt.unspent)
+		rebuilt.unspent_index = unspentIndexCreate(rebuilt.unspent);
+	if (!rebuilt.unspent_index)
+	{
+		fprintf(stderr, "replayUnspent: failed to create list\n");
+		if (rebuilt.unspent)
+			llist_destroy(rebuilt.unspent, 0, NULL);
+		return (-1);
+	}
+
+	for (i = 1; i < pool->first_bad; i++)
+	{
+		if (replayBlockTxs(pool->blocks[i], &rebuilt, thread_ct) != 0)
+			pool->first_bad = i;
+	}
+	if (pool->first_bad == pool->block_ct)
+	{
+		ct = llist_size(blockchain->unspent);
+		if (ct != llist_size(rebuilt.unspent) ||
+		    llist_for_each(blockchain->unspent,
+				   (node_func_t)matchUnspent, &rebuilt) != 0)
+		{
+			fprintf(stderr, "replayUnspent: %s\n",
+				"unspent outputs do not match blocks");
+			ret = 1;
+		}
+	}
+
+	unspentIndexDestroy(rebuilt.unspent_index);
+	llist_destroy(rebuilt.unspent, 1, NULL);
+	return (ret);
+}
+
+
+/**
+ * blockchain_validate - checks every block of a blockchain, as block_is_valid
+ *   does while mining, plus the difficulty adjustment schedule and the
+ *   transactions spending outputs; blocks are first checked in parallel,
+ *   then their transactions are replayed in chain order to rebuild the
+ *   unspent outputs, which must match those of the blockchain
+ *
+ * @blockchain: pointer to the blockchain to check
+ * @thread_ct: amount of threads to use, or 0 for one per online processor;
+ *   bound to BLOCK_MINE_THREADS_MAX
+ * @bad_index: modified by reference to the index of the first invalid
+ *   block, or to the amount of blocks if they are all valid but
+ *   blockchain->unspent does not match them
+ *
+ * Return: 0 if valid, 1 if not, or -1 upon failure
+ */
+int blockchain_validate(blockchain_t const *blockchain,
+			unsigned int thread_ct, uint32_t *bad_index)
+{
+	bv_pool_t pool = {NULL, 0, 0, 0};
+	chain_index_t *index;
+	int block_ct, ret;
+
+	if (!blockchain || !bad_index)
+	{
+		fprintf(stderr, "blockchain_validate: NULL parameter(s)\n");
+		return (-1);
+	}
+	block_ct = llist_size(blockchain->chain);
+	if (block_ct < 1)
+	{
+		fprintf(stderr, "blockchain_validate: llist_size: %s\n",
+			strE_LLIST(llist_errno));
+		return (-1);
+	}
+	pool.block_ct = (uint32_t)block_ct;
+	/* the chain index already lists every block in order */
+	index = blockchain->chain_index;
+	pool.blocks = index ? index->blocks :
+		malloc(pool.block_ct * sizeof(block_t *));
+	if (!pool.blocks ||
+	    (!index && llist_for_each(blockchain->chain,
+				      (node_func_t)collectBlock,
+				      pool.blocks) != 0))
+	{
+		fprintf(stderr, "blockchain_validate: failed to list blocks\n");
+		if (!index)
+			free(pool.blocks);
+		return (-1);
+	}
+
+	if (thread_ct == 0)
+		thread_ct = minerThreadCt();
+	else if (thread_ct > BLOCK_MINE_THREADS_MAX)
+		thread_ct = BLOCK_MINE_THREADS_MAX;
+	validatePool(&pool, thread_ct);
+	ret = replayUnspent(blockchain, &pool, thread_ct);
+	*bad_index = pool.first_bad;
+	if (!index)
+		free(pool.blocks);
+	if (ret == 0 && pool.first_bad < pool.block_ct)
+		ret = 1;
+
+	return (ret);
+}
@@ -0,0 +1,313 @@
+/* blockchain_t chain_index_t CHAIN_INDEX_MIN_CAP */
+#include "blockchain.h"
+/* fprintf */
+#include <stdio.h>
+/* calloc realloc free */
+#include <stdlib.h>
+/* memcpy memcmp memset */
+#include <string.h>
+
+
+/**
+ * blockKey - computes the index key of a block hash; its leading bytes are
+ *   zeroed by proof of work, but its trailing bytes are uniformly distributed
+ *
+ * @hash: block hash
+ *
+ * Return: 64-bit key
+ */
+static uint64_t blockKey(uint8_t const *hash)
+{
+	uint64_t key;
+
+	memcpy(&key, hash + SHA256_DIGEST_LENGTH - sizeof(uint64_t),
+	       sizeof(uint64_t));
+
+	return (key);
+}
+
+
+/**
+ * matchBlockHash - used as `identifier` for llist_find_node to compare the
+ *   hash of a block against a given hash
+ *
+ * @block: block in a blockchain->chain list, as iterated through by
+ *   llist_find_node
+ * @hash: hash to match
+ *
+ * Return: 1 if the hash of `block` matches `hash`, 0 if not or on failure
+ */
+static int matchBlockHash(block_t const *block, uint8_t const *hash)
+{
+	if (!block || !hash)
+	{
+		fprintf(stderr, "matchBlockHash: NULL parameter(s)\n");
+		return (0);
+	}
+
+	return (memcmp(block->hash, hash, SHA256_DIGEST_LENGTH) == 0);
+}
+
+
+/**
+ * indexSlots - rehashes every block of an index into a new array of slots
+ *
+ * @index: index to amend
+ * @cap: amount of slots, power of 2 over twice index->block_ct
+ *
+ * Return: 0 on success, 1 on failure, in which case the slots are unchanged
+ */
+static int indexSlots(chain_index_t *index, uint32_t cap)
+{
+	uint32_t *slots, i, j;
+
+	slots = calloc(cap, sizeof(uint32_t));
+	if (!slots)
+	{
+		fprintf(stderr, "indexSlots: calloc failure\n");
+		return (1);
+	}
+	for (i = 0; i < index->block_ct; i++)
+	{
+		for (j = blockKey(index->blocks[i]->hash) & (cap - 1);
+		     slots[j]; j = (j + 1) & (cap - 1))
+			;
+		slots[j] = i + 1;
+	}
+	free(index->slots);
+	index->slots = slots;
+	index->slot_cap = cap;
+
+	return (0);
+}
+
+
+/**
+ * indexBlock - used as `action` for llist_for_each to add each block of a
+ *   list to its index, at the next height; also adds blocks appended by
+ *   chainAdd
+ *
+ * @block: block, as iterated through by llist_for_each
+ * @idx: index of `block` in the list, as iterated through by llist_for_each
+ * @index: index to amend
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int indexBlock(block_t *block, unsigned int idx, chain_index_t *index)
+{
+	block_t **blocks;
+	uint32_t cap, i;
+
+	(void)idx;
+	if (!block || !index)
+	{
+		fprintf(stderr, "indexBlock: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	if (index->block_ct == index->block_cap)
+	{
+		cap = index->block_cap ? index->block_cap * 2 :
+			CHAIN_INDEX_MIN_CAP;
+		blocks = realloc(index->blocks, cap * sizeof(block_t *));
+		if (!blocks)
+		{
+			fprintf(stderr, "indexBlock: realloc failure\n");
+			return (-2);
+		}
+		index->blocks = blocks;
+		index->block_cap = cap;
+	}
+	index->blocks[index->block_ct++] = block;
+
+	/* slots stay under half full, so that probes remain short */
+	if (index->block_ct * 2 > index->slot_cap)
+		return (indexSlots(index, index->slot_cap ?
+				   index->slot_cap * 2 :
+				   CHAIN_INDEX_MIN_CAP) ? -2 : 0);
+	for (i = blockKey(block->hash) & (index->slot_cap - 1);
+	     index->slots[i]; i = (i + 1) & (index->slot_cap - 1))
+		;
+	index->slots[i] = index->block_ct;
+
+	return (0);
+}
+
+
+/**
+ * chainIndexCreate - builds a height and hash index of a list of blocks, so
+ *   that chainBlockAt and chainBlockByHash run in constant time rather than
+ *   walking the list
+ *
+ * @chain: list of blocks, to be amended from now on only through chainAdd
+ *
+ * Return: pointer to the new index, or NULL on failure
+ */
+chain_index_t *chainIndexCreate(llist_t *chain)
+{
+	chain_index_t *index;
+
+	if (!chain)
+	{
+		fprintf(stderr, "chainIndexCreate: NULL parameter\n");
+		return (NULL);
+	}
+
+	index = calloc(1, sizeof(chain_index_t));
+	if (!index)
+	{
+		fprintf(stderr, "chainIndexCreate: calloc failure\n");
+		return (NULL);
+	}
+	if (llist_for_each(chain, (node_func_t)indexBlock, index) < 0)
+	{
+		fprintf(stderr, "chainIndexCreate: llist_for_each failure\n");
+		chainIndexDestroy(index);
+		return (NULL);
+	}
+
+	return (index);
+}
+
+
+/**
+ * chainIndexDestroy - frees a chain index; the blocks it lists are left
+ *   untouched
+ *
+ * @index: index to free, or NULL
+ */
+void chainIndexDestroy(chain_index_t *index)
+{
+	if (!index)
+		return;
+
+	free(index->blocks);
+	free(index->slots);
+	free(index);
+}
+
+
+/**
+ * chainPopGenesis - frees the Genesis Block preloaded by blockchain_create,
+ *   removing it from the chain and from its index, so that the chain can be
+ *   filled with the blocks of a file
+ *
+ * @blockchain: blockchain holding only its Genesis Block
+ */
+void chainPopGenesis(blockchain_t *blockchain)
+{
+	chain_index_t *index;
+
+	if (!blockchain)
+	{
+		fprintf(stderr, "chainPopGenesis: NULL parameter\n");
+		return;
+	}
+
+	free(llist_pop(blockchain->chain));
+	index = blockchain->chain_index;
+	if (!index)
+		return;
+	index->block_ct = 0;
+	if (index->slots)
+		memset(index->slots, 0, index->slot_cap * sizeof(uint32_t));
+}
+
+
+/**
+ * chainAdd - appends a block to the chain of a blockchain, and to its index
+ *   if any
+ *
+ * @blockchain: blockchain to amend
+ * @block: block to append, its hash already set
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int chainAdd(blockchain_t *blockchain, block_t *block)
+{
+	if (!blockchain || !block)
+	{
+		fprintf(stderr, "chainAdd: NULL parameter(s)\n");
+		return (1);
+	}
+
+	if (llist_add_node(blockchain->chain, (llist_node_t)block,
+			   ADD_NODE_REAR) != 0)
+	{
+		fprintf(stderr, "chainAdd: llist_add_node: %s\n",
+			strE_LLIST(llist_errno));
+		return (1);
+	}
+	/* without an index blocks are still found, only by walking the list */
+	if (blockchain->chain_index &&
+	    indexBlock(block, 0, blockchain->chain_index) != 0)
+	{
+		chainIndexDestroy(blockchain->chain_index);
+		blockchain->chain_index = NULL;
+	}
+
+	return (0);
+}
+
+
+/**
+ * chainBlockAt - finds the block at a given height of a blockchain
+ *
+ * @blockchain: blockchain to search, indexed or not
+ * @height: index of the block, 0 for the Genesis Block
+ *
+ * Return: pointer to the block, or NULL if the chain is not as high
+ */
+block_t *chainBlockAt(blockchain_t const *blockchain, uint32_t height)
+{
+	chain_index_t const *index;
+
+	if (!blockchain)
+	{
+		fprintf(stderr, "chainBlockAt: NULL parameter\n");
+		return (NULL);
+	}
+
+	index = blockchain->chain_index;
+	if (!index)
+		return (llist_get_node_at(blockchain->chain, height));
+
+	return (height < index->block_ct ? index->blocks[height] : NULL);
+}
+
+
+/**
+ * chainBlockByHash - finds the block of a given hash in a blockchain
+ *
+ * @blockchain: blockchain to search, indexed or not
+ * @hash: hash of the block to find
+ *
+ * Return: pointer to the block, or NULL if not found
+ */
+block_t *chainBlockByHash(blockchain_t const *blockchain,
+			  uint8_t const hash[SHA256_DIGEST_LENGTH])
+{
+	chain_index_t const *index;
+	uint32_t i;
+
+	if (!blockchain || !hash)
+	{
+		fprintf(stderr, "chainBlockByHash: NULL parameter(s)\n");
+		return (NULL);
+	}
+
+	index = blockchain->chain_index;
+	if (!index)
+		return (llist_find_node(blockchain->chain,
+					(node_ident_t)matchBlockHash,
+					(void *)hash));
+	if (!index->slot_cap)
+		return (NULL);
+	for (i = blockKey(hash) & (index->slot_cap - 1); index->slots[i];
+	     i = (i + 1) & (index->slot_cap - 1))
+		if (matchBlockHash(index->blocks[index->slots[i] - 1], hash))
+			return (index->blocks[index->slots[i] - 1]);
+
+	return (NULL);
+}
@@ -1,9 +1,114 @@
-/* stdint.h SHA256_DIGEST_LENGTH */
+/* stdint.h SHA256_DIGEST_LENGTH hash_target_t */
 #include "blockchain.h"
 /* fprintf */
 #include <stdio.h>
 
 
+/**
+ * loadHashWord - reads a hash 64 bits at a time, its first byte being the
+ *   most significant
+ *
+ * @hash: hash to read
+ * @i: index of the 64-bit word to read, 0-3
+ *
+ * Return: word `i` of hash, in host byte order
+ */
+static uint64_t loadHashWord(uint8_t const hash[SHA256_DIGEST_LENGTH],
+			     unsigned int i)
+{
+	uint64_t word = 0;
+	unsigned int j;
+
+	for (j = 0; j < 8; j++)
+		word = (word << 8) | hash[i * 8 + j];
+
+	return (word);
+}
+
+
+/**
+ * leadingZeroes - counts the leading zero bits of a 64-bit word
+ *
+ * @word: word to inspect
+ *
+ * Return: amount of leading zero bits, 64 if word is 0
+ */
+static unsigned int leadingZeroes(uint64_t word)
+{
+	unsigned int n = 0;
+
+	if (!word)
+		return (64);
+#ifdef __GNUC__
+	n = (unsigned int)__builtin_clzll((unsigned long long)word);
+#else
+	for (; !(word & ((uint64_t)1 << 63)); word <<= 1)
+		n++;
+#endif
+	return (n);
+}
+
+
+/**
+ * hashTarget - converts a difficulty to the mask of the hash bits it
+ *   requires to be 0, so that hashes can be checked against it by
+ *   hashMatchesTarget a 64-bit word at a time
+ *
+ * @difficulty: minimum difficulty hashes should match
+ * @target: modified by reference to the target of the difficulty
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int hashTarget(uint32_t difficulty, hash_target_t *target)
+{
+	unsigned int i, bits;
+
+	if (!target)
+	{
+		fprintf(stderr, "hashTarget: NULL parameter\n");
+		return (1);
+	}
+
+	if (difficulty > SHA256_DIGEST_LENGTH * 8)
+	{
+		fprintf(stderr, "hashTarget: %s\n",
+			"difficulty out of range for 256 bit hash");
+		return (1);
+	}
+
+	for (i = 0; i < HASH_TARGET_WORDS; i++, difficulty -= bits)
+	{
+		bits = difficulty < 64 ? difficulty : 64;
+		target->mask[i] = bits ? ~(uint64_t)0 << (64 - bits) : 0;
+	}
+
+	return (0);
+}
+
+
+/**
+ * hashMatchesTarget - checks whether a given hash matches a target built by
+ *   hashTarget; meant for hot loops, it never prints and mostly returns
+ *   after its first word
+ *
+ * @hash: hash to check
+ * @target: target to match
+ *
+ * Return: 1 if target is met by hash, 0 if not
+ */
+int hashMatchesTarget(uint8_t const hash[SHA256_DIGEST_LENGTH],
+		      hash_target_t const *target)
+{
+	unsigned int i;
+
+	for (i = 0; i < HASH_TARGET_WORDS && target->mask[i]; i++)
+		if (loadHashWord(hash, i) & target->mask[i])
+			return (0);
+
+	return (1);
+}
+
+
 /**
  * hash_matches_difficulty - checks whether a given hash matches a given
  *   difficulty, ie whether it has `difficulty` or more leading zeroes
@@ -16,8 +121,7 @@
 int hash_matches_difficulty(uint8_t const hash[SHA256_DIGEST_LENGTH],
 			    uint32_t difficulty)
 {
-	int8_t i, j;
-	uint32_t diff = difficulty;
+	unsigned int i, zeroes;
 
 	if (!hash)
 	{
@@ -25,20 +129,19 @@ int hash_matches_difficulty(uint8_t const hash[SHA256_DIGEST_LENGTH],
 		return (0);
 	}
 
-	if (difficulty > 256)
+	if (difficulty > SHA256_DIGEST_LENGTH * 8)
 	{
 		fprintf(stderr, "hash_matches_difficulty: %s\n",
 			"difficulty out of range for 256 bit hash");
 		return (0);
 	}
 
-	for (i = 0; i < SHA256_DIGEST_LENGTH; i++)
+	for (i = 0; difficulty && i < HASH_TARGET_WORDS; i++)
 	{
-		for (j = 7; diff && j >= 0; diff--, j--)
-		{
-			if (hash[i] & 1 << j)
-				return (0);
-		}
+		zeroes = leadingZeroes(loadHashWord(hash, i));
+		if (zeroes < 64)
+			return (zeroes >= difficulty);
+		difficulty -= difficulty < 64 ? difficulty : 64;
 	}
 
 	return (1);
@@ -0,0 +1,276 @@
+/* bc_file_t bcFileOpen blockchain_serialize chainBlockAt chainAdd */
+#include "blockchain.h"
+/* printf fprintf */
+#include <stdio.h>
+/* memcmp memcpy memset */
+#include <string.h>
+/* malloc free EXIT_SUCCESS EXIT_FAILURE */
+#include <stdlib.h>
+/* open O_* */
+#include <fcntl.h>
+/* fstat `struct stat` */
+#include <sys/stat.h>
+/* read write close unlink */
+#include <unistd.h>
+
+
+/* blocks in the chain saved, Genesis Block included */
+#define TEST_BLOCKS 24
+/* coinbase transactions per block after the Genesis Block, one per key */
+#define TEST_KEYS 3
+/* scratch files, the second rewritten in the HBLK 0.3 layout */
+#define TEST_PATH "bc_file-test.hblk"
+#define TEST_PATH_0_3 "bc_file-test.0.3.hblk"
+
+
+/**
+ * sameBlock - compares a block read through a file's tables with the same
+ *   block of a fully deserialized blockchain
+ *
+ * @block: block read through bc_file_t, or NULL
+ * @ref: block of the deserialized blockchain
+ *
+ * Return: 1 if both blocks hold the same info, data, hash and transaction
+ *   IDs, 0 if not
+ */
+static int sameBlock(block_t const *block, block_t const *ref)
+{
+	transaction_t *tx, *ref_tx;
+	int i, tx_ct;
+
+	if (!block || memcmp(&(block->info), &(ref->info),
+			     sizeof(block_info_t)) != 0 ||
+	    block->data.len != ref->data.len ||
+	    memcmp(block->data.buffer, ref->data.buffer, ref->data.len) != 0 ||
+	    memcmp(block->hash, ref->hash, SHA256_DIGEST_LENGTH) != 0)
+		return (0);
+
+	tx_ct = llist_size(ref->transactions);
+	if (llist_size(block->transactions) != tx_ct)
+		return (0);
+	for (i = 0; i < tx_ct; i++)
+	{
+		tx = llist_get_node_at(block->transactions, i);
+		ref_tx = llist_get_node_at(ref->transactions, i);
+		if (!tx || !ref_tx ||
+		    memcmp(tx->id, ref_tx->id, SHA256_DIGEST_LENGTH) != 0)
+			return (0);
+	}
+
+	return (1);
+}
+
+
+/**
+ * checkTxs - checks that the ID of each transaction of a block finds that
+ *   block through the transaction table of a file
+ *
+ * @file: pointer to open blockchain file
+ * @ref: block of the deserialized blockchain
+ *
+ * Return: amount of mismatches
+ */
+static int checkTxs(bc_file_t const *file, block_t const *ref)
+{
+	transaction_t *tx;
+	block_t *block;
+	int i, fails = 0;
+
+	for (i = 0; i < llist_size(ref->transactions); i++)
+	{
+		tx = llist_get_node_at(ref->transactions, i);
+		block = bcFileTxBlock(file, tx->id);
+		if (!block || memcmp(block->hash, ref->hash,
+				     SHA256_DIGEST_LENGTH) != 0)
+			fails++;
+		if (block)
+			block_destroy(block);
+	}
+
+	return (fails);
+}
+
+
+/**
+ * checkFile - compares every block read through the tables of a file with
+ *   the blocks of the same file fully deserialized
+ *
+ * @path: path of the blockchain file
+ * @loaded: blockchain deserialized from the file
+ *
+ * Return: amount of mismatches, or -1 if the file cannot be opened
+ */
+static int checkFile(char const *path, blockchain_t const *loaded)
+{
+	uint8_t unknown[SHA256_DIGEST_LENGTH];
+	bc_file_t file;
+	block_t *block, *ref;
+	uint32_t i, block_ct = (uint32_t)llist_size(loaded->chain);
+	int fails = 0;
+
+	if (bcFileOpen(&file, path) != 0)
+		return (-1);
+	if (file.header.hblk_blocks != block_ct)
+		fails++;
+
+	for (i = 0; i < block_ct; i++)
+	{
+		ref = chainBlockAt(loaded, i);
+		block = bcFileBlock(&file, i);
+		fails += !sameBlock(block, ref);
+		if (block)
+			block_destroy(block);
+		block = bcFileBlockByHash(&file, ref->hash);
+		fails += !block || block->info.index != i;
+		if (block)
+			block_destroy(block);
+		fails += checkTxs(&file, ref);
+	}
+
+	/* heights past the tip and unknown hashes or IDs find nothing */
+	memset(unknown, 0xff, SHA256_DIGEST_LENGTH);
+	block = bcFileBlock(&file, block_ct);
+	fails += block != NULL;
+	if (block)
+		block_destroy(block);
+	block = bcFileBlockByHash(&file, unknown);
+	fails += block != NULL;
+	if (block)
+		block_destroy(block);
+	block = bcFileTxBlock(&file, unknown);
+	fails += block != NULL;
+	if (block)
+		block_destroy(block);
+
+	bcFileClose(&file);
+	return (fails);
+}
+
+
+/**
+ * writeVersion0_3 - rewrites a blockchain file in the HBLK 0.3 layout, which
+ *   is the same without the tables and footer, so that opening it builds the
+ *   tables instead of mapping them
+ *
+ * @path: path of a file saved by blockchain_serialize, in local endianness
+ * @path_0_3: path of the file to write
+ *
+ * Return: 0 on success, 1 on failure
+ */
+static int writeVersion0_3(char const *path, char const *path_0_3)
+{
+	bc_file_ftr_t footer;
+	struct stat st;
+	uint8_t *buf = NULL;
+	int fd, ret = 1;
+
+	fd = open(path, O_RDONLY);
+	if (fd != -1 && fstat(fd, &st) == 0 &&
+	    (size_t)st.st_size > sizeof(bc_file_hdr_t) + sizeof(footer))
+		buf = malloc(st.st_size);
+	if (buf && read(fd, buf, st.st_size) == st.st_size)
+	{
+		memcpy(&footer, buf + st.st_size - sizeof(footer),
+		       sizeof(footer));
+		memcpy(buf + HBLK_MAG_LEN, HBLK_VER_0_3, HBLK_VER_LEN);
+		ret = footer.blocks_off > (uint64_t)st.st_size;
+	}
+	if (fd != -1)
+		close(fd);
+
+	fd = ret ? -1 : open(path_0_3, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	ret = fd == -1 || write(fd, buf, footer.blocks_off) !=
+		(ssize_t)footer.blocks_off;
+	if (fd != -1 && close(fd) == -1)
+		ret = 1;
+	free(buf);
+	if (ret)
+		fprintf(stderr, "writeVersion0_3: failed to write '%s'\n",
+			path_0_3);
+	return (ret);
+}
+
+
+/**
+ * buildChain - creates a blockchain of TEST_BLOCKS blocks, each after the
+ *   Genesis Block holding a coinbase transaction for every key
+ *
+ * @keys: keys receiving the coinbase transactions
+ *
+ * Return: pointer to the blockchain, or NULL on failure
+ */
+static blockchain_t *buildChain(EC_KEY *keys[TEST_KEYS])
+{
+	blockchain_t *blockchain = blockchain_create();
+	block_t *prev, *block;
+	int i, k;
+
+	for (i = 1; blockchain && i < TEST_BLOCKS; i++)
+	{
+		prev = llist_get_tail(blockchain->chain);
+		block = block_create(prev, (int8_t *)"test", 4);
+		for (k = 0; block && k < TEST_KEYS; k++)
+			if (llist_add_node(block->transactions,
+					   coinbase_create(keys[k], i),
+					   ADD_NODE_REAR) != 0)
+				break;
+		if (!block || k < TEST_KEYS ||
+		    !block_hash(block, block->hash) ||
+		    chainAdd(blockchain, block) != 0)
+		{
+			fprintf(stderr, "buildChain: failed to add block\n");
+			if (block)
+				block_destroy(block);
+			blockchain_destroy(blockchain);
+			return (NULL);
+		}
+	}
+
+	return (blockchain);
+}
+
+
+/**
+ * main - saves a blockchain, then checks that reading its blocks by height,
+ *   by hash and by transaction ID through the tables of the file finds the
+ *   same blocks as a full load, for a version 0.4 file and its 0.3 copy
+ *
+ * Return: EXIT_SUCCESS, or EXIT_FAILURE on failure or mismatch
+ */
+int main(void)
+{
+	EC_KEY *keys[TEST_KEYS] = {NULL};
+	blockchain_t *blockchain = NULL, *loaded = NULL;
+	int k, fails = -1, fails_0_3 = -1;
+
+	for (k = 0; k < TEST_KEYS; k++)
+		if (!(keys[k] = ec_create()))
+			break;
+	if (k == TEST_KEYS)
+		blockchain = buildChain(keys);
+	if (blockchain && blockchain_serialize(blockchain, TEST_PATH) == 0)
+		loaded = blockchain_deserialize(TEST_PATH);
+	if (loaded && llist_size(loaded->chain) == TEST_BLOCKS)
+	{
+		fails = checkFile(TEST_PATH, loaded);
+		if (writeVersion0_3(TEST_PATH, TEST_PATH_0_3) == 0)
+			fails_0_3 = checkFile(TEST_PATH_0_3, loaded);
+	}
+
+	if (fails || fails_0_3)
+		fprintf(stderr, "bc_file-test: %d %s, %d in 0.3 (%s)\n", fails,
+			"mismatches in 0.4", fails_0_3, "-1: setup failure");
+	else
+		printf("bc_file-test: %d blocks match a full load\n",
+		       TEST_BLOCKS);
+
+	unlink(TEST_PATH);
+	unlink(TEST_PATH_0_3);
+	if (loaded)
+		blockchain_destroy(loaded);
+	if (blockchain)
+		blockchain_destroy(blockchain);
+	for (k = 0; k < TEST_KEYS; k++)
+		EC_KEY_free(keys[k]);
+	return (fails || fails_0_3 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,162 @@
+/* block_hash blockPreimage block_hash_ctx_t coinbase_create */
+#include "blockchain.h"
+/* printf fprintf */
+#include <stdio.h>
+/* memcmp */
+#include <string.h>
+/* atol free EXIT_SUCCESS EXIT_FAILURE */
+#include <stdlib.h>
+/* clock_gettime */
+#include <time.h>
+
+
+/* hashes timed per transaction count and method, unless given in argv */
+#define BENCH_HASHES_DFLT 200000
+
+
+/**
+ * benchNow - reads a monotonic clock
+ *
+ * Return: seconds elapsed since an arbitrary point
+ */
+static double benchNow(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+
+/**
+ * preimageHash - hashes a block as block_hash did before streaming it:
+ *   serializes it into a newly allocated buffer, hashes it and frees it
+ *
+ * @block: block to hash
+ * @hash_buf: modified by reference to the hash of `block`
+ *
+ * Return: pointer to hash_buf, or NULL on failure
+ */
+static uint8_t *preimageHash(block_t const *block,
+			     uint8_t hash_buf[SHA256_DIGEST_LENGTH])
+{
+	uint8_t *preimage;
+	size_t sz;
+
+	preimage = blockPreimage(block, &sz);
+	if (!preimage)
+		return (NULL);
+	if (!sha256((int8_t const *)preimage, sz, hash_buf))
+		hash_buf = NULL;
+	free(preimage);
+
+	return (hash_buf);
+}
+
+
+/**
+ * benchBlock - times the hashing of a block of `tx_ct` transactions with
+ *   the allocating preimage, the streamed block_hash and a block hashing
+ *   context, after checking that all three agree
+ *
+ * @prev: block to build on
+ * @key: key receiving the coinbase transactions
+ * @tx_ct: amount of transactions in the block
+ * @hashes: amount of hashes timed per method
+ *
+ * Return: 0 on success, 1 on failure or mismatch
+ */
+static int benchBlock(block_t *prev, EC_KEY *key, int tx_ct, long hashes)
+{
+	uint8_t h_pre[SHA256_DIGEST_LENGTH], h_blk[SHA256_DIGEST_LENGTH];
+	uint8_t h_ctx[SHA256_DIGEST_LENGTH];
+	block_hash_ctx_t ctx;
+	block_t *block;
+	double t[4];
+	long i;
+	int j, ret = 1;
+
+	block = block_create(prev, (int8_t *)"bench", 5);
+	for (j = 0; block && j < tx_ct; j++)
+		if (llist_add_node(block->transactions,
+				   coinbase_create(key, j), ADD_NODE_REAR) != 0)
+			break;
+	if (!block || j < tx_ct || blockHashCtxInit(&ctx, block) != 0)
+	{
+		fprintf(stderr, "benchBlock: failed to build block\n");
+		if (block)
+			block_destroy(block);
+		return (1);
+	}
+
+	block->info.nonce = 42;
+	if (!preimageHash(block, h_pre) || !block_hash(block, h_blk) ||
+	    !blockHashCtxNonce(&ctx, 42, h_ctx) ||
+	    memcmp(h_pre, h_blk, SHA256_DIGEST_LENGTH) ||
+	    memcmp(h_pre, h_ctx, SHA256_DIGEST_LENGTH))
+		fprintf(stderr, "benchBlock: hashes do not match\n");
+	else
+	{
+		t[0] = benchNow();
+		for (i = 0; i < hashes; block->info.nonce = i++)
+			preimageHash(block, h_pre);
+		t[1] = benchNow();
+		for (i = 0; i < hashes; block->info.nonce = i++)
+			block_hash(block, h_blk);
+		t[2] = benchNow();
+		for (i = 0; i < hashes; i++)
+			blockHashCtxNonce(&ctx, (uint64_t)i, h_ctx);
+		t[3] = benchNow();
+		printf("%-6d %-18.0f %-18.0f %.0f\n", tx_ct,
+		       hashes / (t[1] - t[0]), hashes / (t[2] - t[1]),
+		       hashes / (t[3] - t[2]));
+		ret = 0;
+	}
+	blockHashCtxFree(&ctx);
+	block_destroy(block);
+
+	return (ret);
+}
+
+
+/**
+ * main - measures block hashes per second on one core, before and after
+ *   block_hash stopped allocating, for blocks of 1 to 1000 transactions
+ *
+ * @argc: argument count
+ * @argv: arguments; argv[1] optionally sets the amount of hashes timed per
+ *   transaction count and method
+ *
+ * Return: EXIT_SUCCESS, or EXIT_FAILURE on failure
+ */
+int main(int argc, char *argv[])
+{
+	int const tx_cts[] = {1, 10, 100, 1000};
+	long hashes = argc > 1 ? atol(argv[1]) : BENCH_HASHES_DFLT;
+	blockchain_t *blockchain;
+	EC_KEY *key;
+	size_t i;
+	int ret = 0;
+
+	blockchain = blockchain_create();
+	key = ec_create();
+	if (!blockchain || !key || hashes < 1)
+	{
+		fprintf(stderr, "block_hash-bench: setup failure\n");
+		return (EXIT_FAILURE);
+	}
+
+	printf("hashes per second, %ld hashes each, a tenth at 1000 txs\n",
+	       hashes);
+	printf("%-6s %-18s %-18s %s\n", "txs", "malloc+serialize",
+	       "streamed", "mining context");
+	for (i = 0; i < sizeof(tx_cts) / sizeof(tx_cts[0]) && !ret; i++)
+		ret = benchBlock(llist_get_head(blockchain->chain), key,
+				 tx_cts[i], tx_cts[i] >= 1000 ?
+				 hashes / 10 : hashes);
+
+	EC_KEY_free(key);
+	blockchain_destroy(blockchain);
+	return (ret ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,325 @@
+/* blockchain_t bc_writer_t writeBlock blockchain_serialize chainAdd */
+#include "blockchain.h"
+/* printf fprintf perror sprintf */
+#include <stdio.h>
+/* memcmp strlen */
+#include <string.h>
+/* atol free EXIT_SUCCESS EXIT_FAILURE */
+#include <stdlib.h>
+/* clock_gettime */
+#include <time.h>
+/* open O_* */
+#include <fcntl.h>
+/* read write close unlink */
+#include <unistd.h>
+
+
+/* blocks saved, Genesis Block included, unless given in argv */
+#define BENCH_BLOCKS_DFLT 100000
+/* runs per method, of which the best is kept */
+#define BENCH_RUNS 3
+/* size of the chunks compared by sameFiles */
+#define BENCH_CMP_SZ 65536
+
+
+/**
+ * benchNow - reads a monotonic clock
+ *
+ * Return: seconds elapsed since an arbitrary point
+ */
+static double benchNow(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+
+/**
+ * fieldOutput - used as `action` for llist_for_each to write an output as
+ *   writeOutput does, with one write(2) per field as before bc_writer_t
+ *
+ * @tx_out: output, as iterated through by llist_for_each
+ * @idx: index of `tx_out`, as iterated through by llist_for_each
+ * @fd: pointer to file descriptor open for writing
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int fieldOutput(tx_out_t *tx_out, unsigned int idx, int *fd)
+{
+	(void)idx;
+	if (write(*fd, &(tx_out->amount), sizeof(uint32_t)) == -1 ||
+	    write(*fd, &(tx_out->pub), EC_PUB_LEN) == -1 ||
+	    write(*fd, &(tx_out->hash), SHA256_DIGEST_LENGTH) == -1)
+		return (-2);
+
+	return (0);
+}
+
+
+/**
+ * fieldInput - used as `action` for llist_for_each to write an input as
+ *   writeInput does, with one write(2) as before bc_writer_t
+ *
+ * @tx_in: input, as iterated through by llist_for_each
+ * @idx: index of `tx_in`, as iterated through by llist_for_each
+ * @fd: pointer to file descriptor open for writing
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int fieldInput(tx_in_t *tx_in, unsigned int idx, int *fd)
+{
+	(void)idx;
+
+	return (write(*fd, tx_in, sizeof(tx_in_t)) == -1 ? -2 : 0);
+}
+
+
+/**
+ * fieldTransaction - used as `action` for llist_for_each to write a
+ *   transaction as writeTransaction does, with one write(2) per field as
+ *   before bc_writer_t
+ *
+ * @tx: transaction, as iterated through by llist_for_each
+ * @idx: index of `tx`, as iterated through by llist_for_each
+ * @fd: pointer to file descriptor open for writing
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int fieldTransaction(transaction_t *tx, unsigned int idx, int *fd)
+{
+	int nb_inputs = llist_size(tx->inputs);
+	int nb_outputs = llist_size(tx->outputs);
+
+	(void)idx;
+	if (write(*fd, &(tx->id), SHA256_DIGEST_LENGTH) == -1 ||
+	    write(*fd, &nb_inputs, sizeof(uint32_t)) == -1 ||
+	    write(*fd, &nb_outputs, sizeof(uint32_t)) == -1 ||
+	    llist_for_each(tx->inputs, (node_func_t)fieldInput, fd) < 0 ||
+	    llist_for_each(tx->outputs, (node_func_t)fieldOutput, fd) < 0)
+		return (-2);
+
+	return (0);
+}
+
+
+/**
+ * fieldBlock - used as `action` for llist_for_each to write a block as
+ *   writeBlock does, with one write(2) per field as before bc_writer_t
+ *
+ * @block: block, as iterated through by llist_for_each
+ * @idx: index of `block`, as iterated through by llist_for_each
+ * @fd: pointer to file descriptor open for writing
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int fieldBlock(block_t *block, unsigned int idx, int *fd)
+{
+	int32_t nb_transactions = llist_size(block->transactions);
+
+	if (write(*fd, &(block->info), sizeof(block_info_t)) == -1 ||
+	    write(*fd, &(block->data.len), sizeof(uint32_t)) == -1 ||
+	    write(*fd, &(block->data.buffer), block->data.len) == -1 ||
+	    write(*fd, &(block->hash), SHA256_DIGEST_LENGTH) == -1 ||
+	    write(*fd, &nb_transactions, sizeof(uint32_t)) == -1)
+		return (-2);
+	if (idx > 0 && block->info.index > 0 &&
+	    llist_for_each(block->transactions,
+			   (node_func_t)fieldTransaction, fd) < 0)
+		return (-2);
+
+	return (0);
+}
+
+
+/**
+ * saveBlocks - writes the blocks of a blockchain to a file, one write(2) per
+ *   field or through a bc_writer_t
+ *
+ * @blockchain: blockchain to save
+ * @path: path of the file, truncated
+ * @buffered: 1 for a bc_writer_t, 0 for one write(2) per field
+ *
+ * Return: seconds taken, or -1 on failure
+ */
+static double saveBlocks(blockchain_t const *blockchain, char const *path,
+			 int buffered)
+{
+	bc_writer_t *writer = NULL;
+	double t0 = benchNow();
+	int fd, ret;
+
+	fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd == -1)
+	{
+		perror("saveBlocks: open");
+		return (-1);
+	}
+	if (buffered)
+	{
+		writer = malloc(sizeof(bc_writer_t));
+		if (writer)
+			bcWriterInit(writer, fd);
+		ret = !writer || llist_for_each(blockchain->chain,
+						(node_func_t)writeBlock,
+						writer) != 0 ||
+			bcWriterFlush(writer) != 0;
+	}
+	else
+		ret = llist_for_each(blockchain->chain,
+				     (node_func_t)fieldBlock, &fd) != 0;
+	free(writer);
+	if (close(fd) == -1 || ret)
+	{
+		fprintf(stderr, "saveBlocks: failed to write '%s'\n", path);
+		return (-1);
+	}
+
+	return (benchNow() - t0);
+}
+
+
+/**
+ * sameFiles - compares the contents of two files
+ *
+ * @path_a: path of the first file
+ * @path_b: path of the second file
+ *
+ * Return: 1 if both files hold the same bytes, 0 if not or on failure
+ */
+static int sameFiles(char const *path_a, char const *path_b)
+{
+	static uint8_t buf_a[BENCH_CMP_SZ], buf_b[BENCH_CMP_SZ];
+	ssize_t got_a = 1, got_b = 1;
+	int fd_a, fd_b, same = 1;
+
+	fd_a = open(path_a, O_RDONLY);
+	fd_b = open(path_b, O_RDONLY);
+	while (fd_a != -1 && fd_b != -1 && same && got_a > 0)
+	{
+		got_a = read(fd_a, buf_a, BENCH_CMP_SZ);
+		got_b = read(fd_b, buf_b, BENCH_CMP_SZ);
+		same = got_a == got_b && got_a >= 0 &&
+			memcmp(buf_a, buf_b, (size_t)got_a) == 0;
+	}
+	if (fd_a != -1)
+		close(fd_a);
+	if (fd_b != -1)
+		close(fd_b);
+
+	return (fd_a != -1 && fd_b != -1 && same);
+}
+
+
+/**
+ * buildChain - creates a blockchain of `block_ct` blocks, each after the
+ *   Genesis Block holding a single coinbase transaction
+ *
+ * @block_ct: amount of blocks, Genesis Block included
+ * @key: key receiving the coinbase transactions
+ *
+ * Return: pointer to the blockchain, or NULL on failure
+ */
+static blockchain_t *buildChain(long block_ct, EC_KEY *key)
+{
+	blockchain_t *blockchain = blockchain_create();
+	block_t *prev, *block;
+	long i;
+
+	for (i = 1; blockchain && i < block_ct; i++)
+	{
+		prev = llist_get_tail(blockchain->chain);
+		block = block_create(prev, (int8_t *)"bench", 5);
+		if (!block || llist_add_node(block->transactions,
+					     coinbase_create(key, (uint32_t)i),
+					     ADD_NODE_REAR) != 0 ||
+		    !block_hash(block, block->hash) ||
+		    chainAdd(blockchain, block) != 0)
+		{
+			fprintf(stderr, "buildChain: failed to add block\n");
+			if (block)
+				block_destroy(block);
+			blockchain_destroy(blockchain);
+			return (NULL);
+		}
+	}
+
+	return (blockchain);
+}
+
+
+/**
+ * main - measures the time taken to save a blockchain of 100k single
+ *   coinbase blocks, writing its blocks with one write(2) per field as
+ *   before bc_writer_t, then through a bc_writer_t, then saving the whole
+ *   file with blockchain_serialize
+ *
+ * @argc: argument count
+ * @argv: arguments; argv[1] optionally sets the amount of blocks, and
+ *   argv[2] the path of the scratch file, suffixed for each method
+ *
+ * Return: EXIT_SUCCESS, or EXIT_FAILURE on failure or if both ways of
+ *   writing the blocks differ
+ */
+int main(int argc, char *argv[])
+{
+	long block_ct = argc > 1 ? atol(argv[1]) : BENCH_BLOCKS_DFLT;
+	char const *base = argc > 2 ? argv[2] : "bench.hblk";
+	char path_field[256], path_buf[256];
+	double best[3] = {-1, -1, -1}, t;
+	blockchain_t *blockchain;
+	EC_KEY *key = ec_create();
+	int run, m, ret = 0;
+
+	if (strlen(base) + sizeof(".field") > sizeof(path_field))
+		return (EXIT_FAILURE);
+	sprintf(path_field, "%s.field", base);
+	sprintf(path_buf, "%s.buf", base);
+	blockchain = key && block_ct > 0 ? buildChain(block_ct, key) : NULL;
+	if (!blockchain)
+		return (EXIT_FAILURE);
+
+	for (run = 0; run < BENCH_RUNS && !ret; run++)
+	{
+		for (m = 0; m < 3 && !ret; m++)
+		{
+			if (m < 2)
+				t = saveBlocks(blockchain, m ? path_buf :
+					       path_field, m);
+			else
+			{
+				t = benchNow();
+				t = blockchain_serialize(blockchain, base) ?
+					-1 : benchNow() - t;
+			}
+			ret = t < 0;
+			if (!ret && (best[m] < 0 || t < best[m]))
+				best[m] = t;
+		}
+	}
+	if (!ret && !sameFiles(path_field, path_buf))
+	{
+		fprintf(stderr, "blockchain_serialize-bench: %s\n",
+			"blocks written differently");
+		ret = 1;
+	}
+	if (!ret)
+		printf("save of %ld blocks, best of %d\n"
+		       "  blocks, write(2) per field  %.3fs\n"
+		       "  blocks, bc_writer_t         %.3fs\n"
+		       "  blockchain_serialize        %.3fs\n",
+		       block_ct, BENCH_RUNS, best[0], best[1], best[2]);
+
+	unlink(path_field);
+	unlink(path_buf);
+	unlink(base);
+	blockchain_destroy(blockchain);
+	EC_KEY_free(key);
+	return (ret ? EXIT_FAILURE : EXIT_SUCCESS);
+}
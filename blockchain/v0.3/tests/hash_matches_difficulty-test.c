@@ -0,0 +1,140 @@
+/* hash_matches_difficulty hashTarget hashMatchesTarget */
+#include "blockchain.h"
+/* printf fprintf */
+#include <stdio.h>
+/* memset */
+#include <string.h>
+/* EXIT_SUCCESS EXIT_FAILURE rand srand */
+#include <stdlib.h>
+
+
+/* random hashes tried for each amount of leading zero bits */
+#define TEST_HASHES_PER_ZEROES 8
+
+
+/**
+ * bitLoopMatches - reference check of a hash against a difficulty, bit by
+ *   bit, as hash_matches_difficulty did before checking 64-bit words
+ *
+ * @hash: hash to check
+ * @difficulty: minimum difficulty the hash should match, at most 256
+ *
+ * Return: 1 if difficulty is met by hash, 0 if not
+ */
+static int bitLoopMatches(uint8_t const hash[SHA256_DIGEST_LENGTH],
+			  uint32_t difficulty)
+{
+	int8_t i, j;
+	uint32_t diff = difficulty;
+
+	for (i = 0; i < SHA256_DIGEST_LENGTH; i++)
+	{
+		for (j = 7; diff && j >= 0; diff--, j--)
+		{
+			if (hash[i] & 1 << j)
+				return (0);
+		}
+	}
+
+	return (1);
+}
+
+
+/**
+ * hashWithZeroes - fills a hash with random bits behind exactly `zeroes`
+ *   leading zero bits
+ *
+ * @hash: hash to fill
+ * @zeroes: amount of leading zero bits, 256 for a null hash
+ */
+static void hashWithZeroes(uint8_t hash[SHA256_DIGEST_LENGTH],
+			   unsigned int zeroes)
+{
+	unsigned int i;
+
+	for (i = 0; i < SHA256_DIGEST_LENGTH; i++)
+		hash[i] = (uint8_t)rand();
+	memset(hash, 0, zeroes / 8);
+	if (zeroes == SHA256_DIGEST_LENGTH * 8)
+		return;
+	/* first bit set after the zeroes, random bits behind it */
+	hash[zeroes / 8] &= 0xff >> (zeroes % 8);
+	hash[zeroes / 8] |= 0x80 >> (zeroes % 8);
+}
+
+
+/**
+ * checkDifficulty - compares hash_matches_difficulty and hashMatchesTarget
+ *   with the bit loop for one difficulty, against hashes of every amount of
+ *   leading zero bits
+ *
+ * @difficulty: difficulty to check, 0-256
+ *
+ * Return: amount of mismatches
+ */
+static unsigned int checkDifficulty(uint32_t difficulty)
+{
+	uint8_t hash[SHA256_DIGEST_LENGTH];
+	hash_target_t target;
+	unsigned int zeroes, n, fails = 0;
+	int expect;
+
+	if (hashTarget(difficulty, &target) != 0)
+	{
+		fprintf(stderr, "difficulty %u: hashTarget failure\n",
+			difficulty);
+		return (1);
+	}
+	for (zeroes = 0; zeroes <= SHA256_DIGEST_LENGTH * 8; zeroes++)
+	{
+		for (n = 0; n < TEST_HASHES_PER_ZEROES; n++)
+		{
+			hashWithZeroes(hash, zeroes);
+			expect = bitLoopMatches(hash, difficulty);
+			if (hash_matches_difficulty(hash, difficulty) !=
+			    expect || hashMatchesTarget(hash, &target) !=
+			    expect)
+			{
+				fprintf(stderr, "difficulty %u, %u %s\n",
+					difficulty, zeroes,
+					"zeroes: mismatch with bit loop");
+				fails++;
+			}
+		}
+	}
+
+	return (fails);
+}
+
+
+/**
+ * main - checks hash_matches_difficulty and hashMatchesTarget against the
+ *   former bit by bit loop, for each of the 257 difficulties of a 256 bit
+ *   hash, then checks that difficulty 257 is rejected
+ *
+ * Return: EXIT_SUCCESS if all checks pass, EXIT_FAILURE if not
+ */
+int main(void)
+{
+	uint8_t hash[SHA256_DIGEST_LENGTH] = {0};
+	hash_target_t target;
+	unsigned int fails = 0;
+	uint32_t difficulty;
+
+	srand(0);
+	for (difficulty = 0; difficulty <= SHA256_DIGEST_LENGTH * 8;
+	     difficulty++)
+		fails += checkDifficulty(difficulty);
+
+	/* out of range, expected to print its own error */
+	if (hash_matches_difficulty(hash, SHA256_DIGEST_LENGTH * 8 + 1) != 0 ||
+	    hashTarget(SHA256_DIGEST_LENGTH * 8 + 1, &target) == 0)
+	{
+		fprintf(stderr, "difficulty 257: not rejected\n");
+		fails++;
+	}
+
+	printf("hash_matches_difficulty: %u difficulties, %u mismatches\n",
+	       difficulty, fails);
+	return (fails ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,148 @@
+/* tx_flat_t txFlatten txUnflatten txFlatHash transaction_hash */
+#include "blockchain.h"
+/* printf fprintf */
+#include <stdio.h>
+/* memcmp */
+#include <string.h>
+/* EXIT_SUCCESS EXIT_FAILURE */
+#include <stdlib.h>
+
+
+/* coinbase outputs spent by the transaction flattened */
+#define TEST_INPUTS 5
+/* coin sent, leaving change for a second output */
+#define TEST_SEND_AMT (COINBASE_AMOUNT * TEST_INPUTS - 1)
+
+
+/**
+ * sameTx - compares two transactions in list form field by field
+ *
+ * @tx: first transaction
+ * @ref: second transaction
+ *
+ * Return: 1 if both hold the same ID, inputs and outputs in the same order,
+ *   0 if not
+ */
+static int sameTx(transaction_t const *tx, transaction_t const *ref)
+{
+	tx_in_t *in, *ref_in;
+	tx_out_t *out, *ref_out;
+	int i;
+
+	if (memcmp(tx->id, ref->id, SHA256_DIGEST_LENGTH) != 0 ||
+	    llist_size(tx->inputs) != llist_size(ref->inputs) ||
+	    llist_size(tx->outputs) != llist_size(ref->outputs))
+		return (0);
+	for (i = 0; i < llist_size(ref->inputs); i++)
+	{
+		in = llist_get_node_at(tx->inputs, i);
+		ref_in = llist_get_node_at(ref->inputs, i);
+		if (memcmp(in, ref_in, sizeof(tx_in_t)) != 0)
+			return (0);
+	}
+	for (i = 0; i < llist_size(ref->outputs); i++)
+	{
+		out = llist_get_node_at(tx->outputs, i);
+		ref_out = llist_get_node_at(ref->outputs, i);
+		if (out->amount != ref_out->amount ||
+		    memcmp(out->pub, ref_out->pub, EC_PUB_LEN) != 0 ||
+		    memcmp(out->hash, ref_out->hash,
+			   SHA256_DIGEST_LENGTH) != 0)
+			return (0);
+	}
+
+	return (1);
+}
+
+
+/**
+ * buildUnspent - creates a list of unspent outputs from coinbase
+ *   transactions, all locked to the same key
+ *
+ * @key: key receiving the coinbase transactions
+ *
+ * Return: pointer to the list, or NULL on failure
+ */
+static llist_t *buildUnspent(EC_KEY const *key)
+{
+	uint8_t block_hash[SHA256_DIGEST_LENGTH] = {0};
+	llist_t *all_unspent = llist_create(MT_SUPPORT_FALSE);
+	transaction_t *coinbase;
+	unspent_tx_out_t *utxo;
+	int i;
+
+	for (i = 0; all_unspent && i < TEST_INPUTS; i++)
+	{
+		block_hash[0] = (uint8_t)i + 1;
+		coinbase = coinbase_create(key, i + 1);
+		utxo = !coinbase ? NULL :
+			unspent_tx_out_create(block_hash, coinbase->id,
+					      llist_get_head(coinbase->outputs));
+		if (coinbase)
+			transaction_destroy(coinbase);
+		if (!utxo || llist_add_node(all_unspent, utxo,
+					    ADD_NODE_REAR) != 0)
+		{
+			fprintf(stderr, "buildUnspent: failed to add output\n");
+			free(utxo);
+			llist_destroy(all_unspent, 1, NULL);
+			return (NULL);
+		}
+	}
+
+	return (all_unspent);
+}
+
+
+/**
+ * main - flattens a transaction of several inputs and two outputs, then
+ *   checks that its array form hashes to its ID and copies back to the same
+ *   list form
+ *
+ * Return: EXIT_SUCCESS, or EXIT_FAILURE on failure or mismatch
+ */
+int main(void)
+{
+	uint8_t hash[SHA256_DIGEST_LENGTH];
+	EC_KEY *sender = ec_create(), *receiver = ec_create();
+	/* ec_to_pub scans each byte as an unsigned int, so its last */
+	/* write runs past EC_PUB_LEN */
+	uint8_t pub[EC_PUB_LEN + sizeof(unsigned int)];
+	llist_t *all_unspent = NULL;
+	transaction_t *tx = NULL, *copy = NULL;
+	tx_flat_t flat = {{0}, NULL, 0, NULL, 0};
+	int fails = 0;
+
+	if (sender && receiver && ec_to_pub(receiver, pub))
+		all_unspent = buildUnspent(sender);
+	if (all_unspent)
+		tx = transaction_create(sender, receiver, TEST_SEND_AMT,
+					all_unspent);
+	if (!tx || txFlatten(tx, &flat) != 0)
+		fails++;
+
+	if (!fails && (flat.input_ct != TEST_INPUTS || flat.output_ct != 2 ||
+		       !txFlatHash(&flat, hash) ||
+		       memcmp(hash, tx->id, SHA256_DIGEST_LENGTH) != 0))
+		fails++;
+	if (!fails)
+	{
+		copy = txUnflatten(&flat);
+		fails += !copy || !sameTx(copy, tx) || !txIdIsValid(copy);
+	}
+
+	if (fails)
+		fprintf(stderr, "tx_flat-test: array form mismatch\n");
+	else
+		printf("tx_flat-test: %u inputs, %u outputs match\n",
+		       flat.input_ct, flat.output_ct);
+	txFlatFree(&flat);
+	if (copy)
+		transaction_destroy(copy);
+	if (tx)
+		transaction_destroy(tx);
+	llist_destroy(all_unspent, 1, NULL);
+	EC_KEY_free(sender);
+	EC_KEY_free(receiver);
+	return (fails ? EXIT_FAILURE : EXIT_SUCCESS);
+}
@@ -0,0 +1,173 @@
+/* blockchain_create update_unspent unspentFind unspentSlot chainAdd */
+#include "blockchain.h"
+/* printf fprintf */
+#include <stdio.h>
+/* EXIT_SUCCESS EXIT_FAILURE free */
+#include <stdlib.h>
+
+
+/* coin sent from the first block's coinbase output to the second key */
+#define TEST_SEND_AMT 20
+
+
+/**
+ * indexedNode - used as `action` for llist_for_each to check that an output
+ *   of a list is in the list's index
+ *
+ * @utxo: unspent output, as iterated through by llist_for_each
+ * @idx: index of `utxo` in the list, as iterated through by llist_for_each
+ * @index: index of the list
+ *
+ * Return: 0 if `utxo` is indexed (llist_for_each can continue,)
+ *   -2 if not (-1 reserved for llist_for_each errors)
+ */
+static int indexedNode(unspent_tx_out_t *utxo, unsigned int idx,
+		       utxo_index_t *index)
+{
+	(void)idx;
+
+	return (unspentSlot(index, utxo) ? 0 : -2);
+}
+
+
+/**
+ * checkIndex - checks that the unspent index of a blockchain holds exactly
+ *   the outputs of its unspent list
+ *
+ * @blockchain: blockchain to check
+ *
+ * Return: 1 if the index matches the list, 0 if not
+ */
+static int checkIndex(blockchain_t const *blockchain)
+{
+	return (blockchain->unspent_index &&
+		unspentIndexOf(blockchain->unspent) ==
+		blockchain->unspent_index &&
+		blockchain->unspent_index->count ==
+		(size_t)llist_size(blockchain->unspent) &&
+		llist_for_each(blockchain->unspent, (node_func_t)indexedNode,
+			       blockchain->unspent_index) == 0);
+}
+
+
+/**
+ * addBlock - mines nothing, but hashes a block of the given transactions on
+ *   top of a blockchain, then updates the unspent outputs through the spec
+ *   update_unspent, which is not given the index
+ *
+ * @blockchain: blockchain to extend
+ * @coinbase_key: key receiving the coinbase transaction of the block
+ * @tx: transaction added after the coinbase transaction, or NULL; freed
+ *   with the block, or upon failure
+ *
+ * Return: pointer to the block added, or NULL on failure
+ */
+static block_t *addBlock(blockchain_t *blockchain, EC_KEY const *coinbase_key,
+			 transaction_t *tx)
+{
+	transaction_t *coinbase = NULL;
+	block_t *block;
+
+	block = block_create(llist_get_tail(blockchain->chain),
+			     (int8_t *)"test", 4);
+	if (block)
+		coinbase = coinbase_create(coinbase_key, block->info.index);
+	if (!coinbase || llist_add_node(block->transactions, coinbase,
+					ADD_NODE_REAR) != 0 ||
+	    (tx && llist_add_node(block->transactions, tx,
+				  ADD_NODE_REAR) != 0))
+	{
+		fprintf(stderr, "addBlock: failed to build block\n");
+		if (coinbase && llist_size(block->transactions) == 0)
+			transaction_destroy(coinbase);
+		if (tx)
+			transaction_destroy(tx);
+		if (block)
+			block_destroy(block);
+		return (NULL);
+	}
+	if (!block_hash(block, block->hash) ||
+	    chainAdd(blockchain, block) != 0)
+	{
+		fprintf(stderr, "addBlock: failed to add block\n");
+		block_destroy(block);
+		return (NULL);
+	}
+	if (!update_unspent(block->transactions, block->hash,
+			    blockchain->unspent))
+		return (NULL);
+
+	return (block);
+}
+
+
+/**
+ * main - amends the unspent list of a blockchain_create'd blockchain with
+ *   update_unspent, then checks through indexed lookups that the outputs
+ *   created are found, that the outputs spent are gone, and that the spec
+ *   transaction_create, tx_in_sign and transaction_is_valid search the index
+ *
+ * Return: EXIT_SUCCESS, or EXIT_FAILURE on failure or mismatch
+ */
+int main(void)
+{
+	blockchain_t *blockchain = blockchain_create();
+	EC_KEY *alice = ec_create(), *bob = ec_create();
+	/* ec_to_pub scans each byte as an unsigned int, so its last */
+	/* write runs past EC_PUB_LEN */
+	uint8_t bob_pub[EC_PUB_LEN + sizeof(unsigned int)];
+	unspent_tx_out_t *coinbase_out = NULL;
+	transaction_t *tx = NULL;
+	tx_in_t *spent_in = NULL;
+	uint64_t balance = 0;
+	size_t count = 0;
+	int fails = 0;
+
+	if (!blockchain || !alice || !bob || !ec_to_pub(bob, bob_pub) ||
+	    !addBlock(blockchain, alice, NULL) || !checkIndex(blockchain))
+		fails++;
+	if (!fails)
+	{
+		coinbase_out = llist_get_head(blockchain->unspent);
+		spent_in = tx_in_create(coinbase_out);
+		fails += !spent_in ||
+			unspentFind(blockchain->unspent,
+				    blockchain->unspent_index,
+				    spent_in) != coinbase_out;
+		tx = transaction_create(alice, bob, TEST_SEND_AMT,
+					blockchain->unspent);
+		fails += !tx ||
+			!transaction_is_valid(tx, blockchain->unspent);
+	}
+	/* tx is freed with the block, or by addBlock upon failure */
+	if (!fails)
+	{
+		fails += !addBlock(blockchain, bob, tx);
+		tx = NULL;
+	}
+
+	/* the coinbase output is spent, bob holds his coinbase and the coin */
+	if (!fails && (!checkIndex(blockchain) ||
+		       unspentFind(blockchain->unspent,
+				   blockchain->unspent_index, spent_in) ||
+		       unspentBalance(blockchain->unspent,
+				      blockchain->unspent_index, bob_pub,
+				      &balance, &count) != 0 ||
+		       count != 2 ||
+		       balance != COINBASE_AMOUNT + TEST_SEND_AMT))
+		fails++;
+
+	if (fails)
+		fprintf(stderr, "update_unspent: index out of sync\n");
+	else
+		printf("update_unspent: %d outputs indexed\n",
+		       llist_size(blockchain->unspent));
+	free(spent_in);
+	if (tx)
+		transaction_destroy(tx);
+	if (blockchain)
+		blockchain_destroy(blockchain);
+	EC_KEY_free(alice);
+	EC_KEY_free(bob);
+	return (fails ? EXIT_FAILURE : EXIT_SUCCESS);
+}
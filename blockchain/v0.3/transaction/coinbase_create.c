@@ -54,6 +54,7 @@ transaction_t *newCoinbaseTx(tx_in_t *cb_input, tx_out_t *cb_output)
 
 	cb_tx->inputs = llist_create(MT_SUPPORT_FALSE);
 	cb_tx->outputs = llist_create(MT_SUPPORT_FALSE);
+	cb_tx->id_ok = 0;
 	if (!cb_tx->inputs || !cb_tx->outputs)
 	{
 		fprintf(stderr, "newCoinbaseTx: llist_create failure\n");
@@ -59,7 +59,6 @@ static int validCBInput(tx_in_t *cb_input, uint32_t block_index)
  */
 int coinbase_is_valid(transaction_t const *coinbase, uint32_t block_index)
 {
-	uint8_t cb_hash[SHA256_DIGEST_LENGTH];
 	tx_in_t *cb_input;
 	tx_out_t *cb_output;
 
@@ -69,8 +68,7 @@ int coinbase_is_valid(transaction_t const *coinbase, uint32_t block_index)
 		return (0);
 	}
 
-	transaction_hash(coinbase, cb_hash);
-	if (memcmp(coinbase->id, cb_hash, SHA256_DIGEST_LENGTH) != 0)
+	if (!txIdIsValid(coinbase))
 	{
 		fprintf(stderr, "coinbase_is_valid: %s\n",
 			"hash of transaction does not match id");
@@ -7,6 +7,17 @@
 
 
 # define COINBASE_AMOUNT 50
+/* initial slot count of an unspent output index, power of 2 */
+# define UNSPENT_INDEX_MIN_CAP 64
+/* initial slot count of the public key index of an unspent output index */
+# define UNSPENT_OWNERS_MIN_CAP 16
+/* most successful signature verifications remembered by txInVerify */
+# define SIG_CACHE_SIZE 4096
+/* hash buckets of the signature verification cache, power of 2 */
+# define SIG_CACHE_BUCKETS 8192
+/* bytes digested into a signature verification cache key, at most */
+# define SIG_CACHE_KEY_BUF_SZ \
+	(4 * SHA256_DIGEST_LENGTH + EC_PUB_LEN + 1 + SIG_MAX_LEN)
 
 
 /**
@@ -15,12 +26,16 @@
  * @id:      Transaction ID. A hash of all the inputs and outputs.
  * @inputs:  List of `tx_in_t *`. Transaction inputs
  * @outputs: List of `tx_out_t *`. Transaction outputs
+ * @id_ok:   1 once @id is found to be the hash of the inputs and outputs,
+ *           so that it is not hashed again, see txIdIsValid; reset by
+ *           txIdDirty whenever they change
  */
 typedef struct transaction_s
 {
 	uint8_t     id[SHA256_DIGEST_LENGTH];
 	llist_t     *inputs;
 	llist_t     *outputs;
+	uint8_t     id_ok;
 } transaction_t;
 
 /**
@@ -65,6 +80,106 @@ typedef struct unspent_tx_out_s
 	tx_out_t    out;
 } unspent_tx_out_t;
 
+/**
+ * struct tx_flat_s - Transaction, with its inputs and outputs in arrays
+ *
+ * Description: Array form of a transaction_t, see txFlatten. Inputs and
+ *   outputs are walked in order without following list nodes, and the
+ *   inputs are laid out as serialized, see writeTxFlat.
+ *
+ * @id:        Transaction ID, as in transaction_t
+ * @inputs:    Array of @input_ct transaction inputs, in list order
+ * @input_ct:  Amount of transaction inputs
+ * @outputs:   Array of @output_ct transaction outputs, in list order
+ * @output_ct: Amount of transaction outputs
+ */
+typedef struct tx_flat_s
+{
+	uint8_t     id[SHA256_DIGEST_LENGTH];
+	tx_in_t    *inputs;
+	uint32_t    input_ct;
+	tx_out_t   *outputs;
+	uint32_t    output_ct;
+} tx_flat_t;
+
+/**
+ * struct utxo_slot_s - unspent output index slot
+ * @key: key of @utxo, compared before its hashes when probing
+ * @utxo: indexed unspent output, NULL if the slot was never used, or a
+ *   tombstone address if its output was removed
+ * @pos: position of @utxo in the outputs of its owner, see utxo_owner_t
+ */
+typedef struct utxo_slot_s
+{
+	uint64_t          key;
+	unspent_tx_out_t *utxo;
+	size_t            pos;
+} utxo_slot_t;
+
+/**
+ * struct utxo_owner_s - unspent outputs of an unspent output index locked
+ *   to the same public key
+ * @pub: public key shared by @utxos
+ * @utxos: outputs locked to @pub, in the order they were added; removed
+ *   outputs leave a NULL hole until the array is compacted
+ * @len: amount of entries of @utxos in use, holes included
+ * @count: amount of outputs in @utxos, holes excluded
+ * @cap: amount of entries @utxos can hold before being regrown
+ * @balance: sum of the amounts of @utxos
+ */
+typedef struct utxo_owner_s
+{
+	uint8_t            pub[EC_PUB_LEN];
+	unspent_tx_out_t **utxos;
+	size_t             len;
+	size_t             count;
+	size_t             cap;
+	uint64_t           balance;
+} utxo_owner_t;
+
+/**
+ * struct utxo_index_s - open-addressing hash index of an unspent output
+ *   list, created with unspentIndexCreate by the owner of the list and
+ *   passed along with it to every function amending the list
+ * @slots: linearly probed slots, flat array of @cap
+ * @cap: amount of slots, power of 2
+ * @count: amount of unspent outputs in the index
+ * @used: amount of slots not NULL, including tombstones
+ * @owners: linearly probed public key index, flat array of @owners_cap;
+ *   owners left without outputs keep their slot
+ * @owners_cap: amount of public key slots, power of 2
+ * @owners_count: amount of public key slots in use
+ */
+typedef struct utxo_index_s
+{
+	utxo_slot_t  *slots;
+	size_t        cap;
+	size_t        count;
+	size_t        used;
+	utxo_owner_t *owners;
+	size_t        owners_cap;
+	size_t        owners_count;
+} utxo_index_t;
+
+/**
+ * struct utxo_view_s - overlay view of a list of unspent outputs
+ * @base: list of unspent outputs seen through the view, never amended by it
+ * @base_index: index of @base, or NULL to scan it
+ * @spent: copies of the outputs spent in the view, hiding them
+ * @spent_index: index of @spent, owned by the view
+ * @created: outputs created in the view, not in @base
+ * @created_index: index of @created, owned by the view
+ */
+typedef struct utxo_view_s
+{
+	llist_t            *base;
+	utxo_index_t const *base_index;
+	llist_t            *spent;
+	utxo_index_t       *spent_index;
+	llist_t            *created;
+	utxo_index_t       *created_index;
+} utxo_view_t;
+
 /**
  * struct su_info_s - spender unspent info
  * @sender_unspent: list of unspent outputs matching the sender's public key
@@ -72,13 +187,16 @@ typedef struct unspent_tx_out_s
  * @send_amt: proposed amount to send
  * @total_unspent_amt: total of all unspent outputs combined to be used as
  *   inputs
+ * @view: view through which the sender's unspent outputs are found, or NULL
+ *   to find them in the list of all unspent outputs
  */
 typedef struct su_info_s
 {
-	llist_t *sender_unspent;
-	uint8_t  sender_pub[EC_PUB_LEN];
-	uint32_t send_amt;
-	uint32_t total_unspent_amt;
+	llist_t           *sender_unspent;
+	uint8_t            sender_pub[EC_PUB_LEN];
+	uint32_t           send_amt;
+	uint32_t           total_unspent_amt;
+	utxo_view_t const *view;
 } su_info_t;
 
 /**
@@ -86,25 +204,71 @@ typedef struct su_info_s
  * @tx_id: hash of new transaction
  * @sender: sender's key pair
  * @all_unspent: list of all unspent outputs
+ * @view: view whose created outputs may also be spent, or NULL
  */
 typedef struct sign_info_s
 {
-	uint8_t       tx_id[SHA256_DIGEST_LENGTH];
-	const EC_KEY *sender;
-	llist_t      *all_unspent;
+	uint8_t            tx_id[SHA256_DIGEST_LENGTH];
+	const EC_KEY      *sender;
+	llist_t           *all_unspent;
+	utxo_view_t const *view;
 } sign_info_t;
 
+/**
+ * struct sv_job_s - signature verification job
+ * @tx_in: input whose signature is verified
+ * @tx_id: ID of the transaction containing @tx_in, which is the signed
+ *   message
+ * @utxo: unspent output referenced by @tx_in, NULL if missing
+ * @verdict: 1 if the signature matches the public key of @utxo, 0 if not,
+ *   -1 if @utxo is missing, or -2 on failure to verify
+ */
+typedef struct sv_job_s
+{
+	tx_in_t const          *tx_in;
+	uint8_t const          *tx_id;
+	unspent_tx_out_t const *utxo;
+	int                     verdict;
+} sv_job_t;
+
+/**
+ * struct sv_pool_s - signature verification pool, shared by its workers
+ * @jobs: flat array of @job_ct jobs, grouped by transaction and in input order
+ * @job_ct: amount of jobs in @jobs
+ * @next: index of the next job to be claimed by a worker, or of the first
+ *   job of the next transaction to be validated
+ * @all_unspent: list of all unspent outputs in the blockchain
+ * @index: index of @all_unspent, or NULL to scan it
+ * @tx_id: ID of the transaction whose inputs are being queued
+ * @valid: array of transaction validities to be filled
+ */
+typedef struct sv_pool_s
+{
+	sv_job_t           *jobs;
+	size_t              job_ct;
+	size_t              next;
+	llist_t            *all_unspent;
+	utxo_index_t const *index;
+	uint8_t const      *tx_id;
+	int8_t             *valid;
+} sv_pool_t;
+
 /**
  * struct iv_info_s - input validation info
  * @tx_id: id of transaction to be validated
  * @tl_input_amt: total of every unspent output amount referenced by an input
  * @all_unspent: list of all unspent outputs in the blockchain
+ * @index: index of @all_unspent, or NULL to scan it
+ * @jobs: signature verification jobs of the transaction inputs already run
+ *   by transactionsVerify, or NULL to verify each signature in turn
  */
 typedef struct iv_info_s
 {
-	uint8_t  tx_id[SHA256_DIGEST_LENGTH];
-	uint32_t tl_input_amt;
-	llist_t *all_unspent;
+	uint8_t             tx_id[SHA256_DIGEST_LENGTH];
+	uint32_t            tl_input_amt;
+	llist_t            *all_unspent;
+	utxo_index_t const *index;
+	sv_job_t const     *jobs;
 } iv_info_t;
 
 /**
@@ -112,14 +276,61 @@ typedef struct iv_info_s
  * @block_hash: hash of block containing transactions to update unpsent list
  * @tx_id: id of current transaction to scan when updating
  * @all_unspent: list of all unspent outputs in the blockchain
+ * @index: index of @all_unspent, or NULL to scan it
  */
 typedef struct uo_info_s
 {
-	uint8_t  block_hash[SHA256_DIGEST_LENGTH];
-	uint8_t  tx_id[SHA256_DIGEST_LENGTH];
-	llist_t *all_unspent;
+	uint8_t       block_hash[SHA256_DIGEST_LENGTH];
+	uint8_t       tx_id[SHA256_DIGEST_LENGTH];
+	llist_t      *all_unspent;
+	utxo_index_t *index;
 } uo_info_t;
 
+/**
+ * struct va_info_s - view application info
+ * @view: view to which a transaction is applied
+ * @ct: amount of inputs of the transaction spent in @view so far
+ * @block_hash: hash of the block containing the transaction
+ * @tx_id: ID of the transaction
+ */
+typedef struct va_info_s
+{
+	utxo_view_t  *view;
+	unsigned int  ct;
+	uint8_t       block_hash[SHA256_DIGEST_LENGTH];
+	uint8_t       tx_id[SHA256_DIGEST_LENGTH];
+} va_info_t;
+
+/**
+ * struct vf_info_s - view filter info
+ * @view: view whose outputs are visited
+ * @action: function called for each output not spent in @view
+ * @arg: parameter passed to @action
+ * @idx: amount of outputs visited so far
+ */
+typedef struct vf_info_s
+{
+	utxo_view_t const *view;
+	node_func_t        action;
+	void              *arg;
+	unsigned int       idx;
+} vf_info_t;
+
+/**
+ * struct pf_info_s - public key filter info
+ * @pub: public key of the outputs to visit
+ * @action: function called for each output locked to @pub
+ * @arg: parameter passed to @action
+ * @idx: amount of outputs locked to @pub visited so far
+ */
+typedef struct pf_info_s
+{
+	uint8_t const *pub;
+	node_func_t    action;
+	void          *arg;
+	unsigned int   idx;
+} pf_info_t;
+
 tx_out_t *tx_out_create(uint32_t amount, uint8_t const pub[EC_PUB_LEN]);
 
 unspent_tx_out_t *unspent_tx_out_create(
@@ -136,20 +347,43 @@ int populateTxDataBuff(const transaction_t *transaction,
 		       uint8_t *tx_IO_buf);
 uint8_t *transaction_hash(transaction_t const *transaction,
 			  uint8_t hash_buf[SHA256_DIGEST_LENGTH]);
+uint8_t *txFlatHash(tx_flat_t const *flat,
+		    uint8_t hash_buf[SHA256_DIGEST_LENGTH]);
+int txIdIsValid(transaction_t const *transaction);
+void txIdDirty(transaction_t *transaction);
+
+int txFlatten(transaction_t const *transaction, tx_flat_t *flat);
+transaction_t *txUnflatten(tx_flat_t const *flat);
+void txFlatFree(tx_flat_t *flat);
 
 sig_t *tx_in_sign(tx_in_t *in, uint8_t const tx_id[SHA256_DIGEST_LENGTH],
 		  EC_KEY const *sender, llist_t *all_unspent);
+sig_t *txInSignUtxo(tx_in_t *in, uint8_t const tx_id[SHA256_DIGEST_LENGTH],
+		    EC_KEY const *sender, unspent_tx_out_t const *utxo);
 
 llist_t *setTxInputs(llist_t *all_unspent, su_info_t *su_info);
 llist_t *setTxOutputs(const uint8_t sender_pub[EC_PUB_LEN],
 		      const uint8_t recv_pub[EC_PUB_LEN], su_info_t *su_info);
 transaction_t *newTransaction(llist_t *tx_inputs, llist_t *tx_outputs,
-			      const EC_KEY *sender, llist_t *all_unspent);
+			      const EC_KEY *sender, llist_t *all_unspent,
+			      utxo_view_t const *view);
 transaction_t *transaction_create(EC_KEY const *sender, EC_KEY const *receiver,
 				  uint32_t amount, llist_t *all_unspent);
+transaction_t *txCreateFromView(EC_KEY const *sender, EC_KEY const *receiver,
+				uint32_t amount, utxo_view_t const *view);
 
 int transaction_is_valid(transaction_t const *transaction,
 			 llist_t *all_unspent);
+int txIsValidVerified(transaction_t const *transaction, llist_t *all_unspent,
+		      utxo_index_t const *index, sv_job_t const *jobs);
+int transactionsVerify(llist_t *transactions, llist_t *all_unspent,
+		       utxo_index_t const *index, unsigned int thread_ct,
+		       int8_t *valid);
+
+int txInVerify(tx_in_t const *tx_in, uint8_t const *tx_id,
+	       uint8_t const pub[EC_PUB_LEN]);
+void sigCacheStats(lru_stats_t *stats);
+void sigCacheClear(void);
 
 transaction_t *coinbase_create(EC_KEY const *receiver, uint32_t block_index);
 
@@ -158,11 +392,55 @@ int coinbase_is_valid(transaction_t const *coinbase, uint32_t block_index);
 void transaction_destroy(transaction_t *transaction);
 
 int delRfrncdOutput(tx_in_t *tx_in, unsigned int idx,
-		    llist_t *unspent);
+		    uo_info_t *uo_info);
 
 llist_t *update_unspent(llist_t *transactions,
 			uint8_t block_hash[SHA256_DIGEST_LENGTH],
 			llist_t *all_unspent);
+llist_t *updateUnspent(llist_t *transactions,
+		       uint8_t block_hash[SHA256_DIGEST_LENGTH],
+		       llist_t *all_unspent, utxo_index_t *index);
+utxo_index_t *unspentIndexCreate(llist_t *all_unspent);
+void unspentIndexDestroy(utxo_index_t *index);
+/* blockchain_t, defined in blockchain.h once this header is included */
+struct blockchain_s;
+int unspentIndexBind(struct blockchain_s const *blockchain);
+void unspentIndexUnbind(struct blockchain_s const *blockchain);
+utxo_index_t *unspentIndexOf(llist_t const *all_unspent);
+utxo_slot_t *unspentSlot(utxo_index_t const *index,
+			 unspent_tx_out_t const *utxo);
+unspent_tx_out_t *unspentFind(llist_t *all_unspent, utxo_index_t const *index,
+			      tx_in_t const *tx_in);
+int unspentAdd(llist_t *all_unspent, utxo_index_t *index,
+	       unspent_tx_out_t *utxo);
+int unspentRemove(llist_t *all_unspent, utxo_index_t *index,
+		  tx_in_t const *tx_in);
+
+int unspentForPub(llist_t *all_unspent, utxo_index_t const *index,
+		  uint8_t const pub[EC_PUB_LEN], node_func_t action, void *arg);
+int unspentBalance(llist_t *all_unspent, utxo_index_t const *index,
+		   uint8_t const pub[EC_PUB_LEN], uint64_t *balance,
+		   size_t *count);
+int ownerAdd(utxo_index_t *index, utxo_slot_t *slot);
+void ownerRemove(utxo_index_t *index, utxo_slot_t const *slot);
+void ownerMove(utxo_index_t *index, utxo_slot_t const *slot);
+void ownersFree(utxo_index_t *index);
+
+int unspentViewInit(utxo_view_t *view, llist_t *base,
+		    utxo_index_t const *base_index);
+unspent_tx_out_t *unspentViewFind(utxo_view_t const *view,
+				  tx_in_t const *tx_in);
+int unspentViewApply(utxo_view_t *view, transaction_t const *tx,
+		     uint8_t const block_hash[SHA256_DIGEST_LENGTH]);
+int unspentViewUnspend(utxo_view_t *view, tx_in_t const *tx_in);
+int unspentViewForPub(utxo_view_t const *view, uint8_t const pub[EC_PUB_LEN],
+		      node_func_t action, void *arg);
+int unspentViewForEach(utxo_view_t const *view, node_func_t action,
+		       void *arg);
+int unspentViewBalance(utxo_view_t const *view, uint8_t const pub[EC_PUB_LEN],
+		       uint64_t *balance, size_t *count);
+int unspentViewSize(utxo_view_t const *view);
+void unspentViewFree(utxo_view_t *view);
 
 #include "../blockchain.h"
 
@@ -5,16 +5,16 @@
 
 
 /**
- * findSenderUnspent - visit each unspent output in the blockchain
- * @unspent_tx_out: pointer to unspent output in blockchain->unspent list,
- *   as iterated through by llist_for_each
- * @idx: index of `unspent_tx_out` in blockchain->unspent list, as
- *   iterated through by llist_for_each
+ * findSenderUnspent - visit each unspent output of the sender
+ * @unspent_tx_out: pointer to unspent output in blockchain->unspent list
+ *   locked to the sender's public key, as iterated through by unspentForPub
+ * @idx: position of `unspent_tx_out` among the sender's unspent outputs, as
+ *   iterated through by unspentForPub
  * @su_info: pointer to struct containing all parameters necessary to build a
  *   second list of unspent transactions for a particular public key
- * Return: 0 on incremental success (llist_for_each can continue,)
- *   1 on total success (llist_for_each can end,)
- *   and -2 on failure (-1 reserved for llist_for_each errors)
+ * Return: 0 on incremental success (unspentForPub can continue,)
+ *   1 on total success (unspentForPub can end,)
+ *   and -2 on failure (-1 reserved for unspentForPub errors)
  */
 static int findSenderUnspent(unspent_tx_out_t *unspent_tx_out,
 			     unsigned int idx, su_info_t *su_info)
@@ -27,22 +27,18 @@ static int findSenderUnspent(unspent_tx_out_t *unspent_tx_out,
 		return (-2);
 	}
 
-	if (memcmp(unspent_tx_out->out.pub, su_info->sender_pub,
-		   EC_PUB_LEN) == 0)
+	if (llist_add_node(su_info->sender_unspent,
+			   unspent_tx_out, ADD_NODE_REAR) != 0)
 	{
-		if (llist_add_node(su_info->sender_unspent,
-				   unspent_tx_out, ADD_NODE_REAR) != 0)
-		{
-			fprintf(stderr, "findSenderUnspent: %s\n",
-				"llist_add_node failure");
-			return (-2);
-		}
+		fprintf(stderr, "findSenderUnspent: %s\n",
+			"llist_add_node failure");
+		return (-2);
+	}
 
-		su_info->total_unspent_amt += unspent_tx_out->out.amount;
+	su_info->total_unspent_amt += unspent_tx_out->out.amount;
 
-		if (su_info->total_unspent_amt >= su_info->send_amt)
-			return (1); /* sufficient to cover spending */
-	}
+	if (su_info->total_unspent_amt >= su_info->send_amt)
+		return (1); /* sufficient to cover spending */
 
 	return (0);
 }
@@ -110,8 +106,12 @@ static int signTxIn(tx_in_t *tx_in, unsigned int idx,
 		return (1);
 	}
 
-	if (!tx_in_sign(tx_in, sign_info->tx_id, sign_info->sender,
-			sign_info->all_unspent))
+	/* outputs created in a view are only found in it */
+	if (!(sign_info->view ?
+	      txInSignUtxo(tx_in, sign_info->tx_id, sign_info->sender,
+			   unspentViewFind(sign_info->view, tx_in)) :
+	      tx_in_sign(tx_in, sign_info->tx_id, sign_info->sender,
+			 sign_info->all_unspent)))
 	{
 		fprintf(stderr, "signTxIn: tx_in_sign failure\n");
 		return (1);
@@ -124,7 +124,8 @@ static int signTxIn(tx_in_t *tx_in, unsigned int idx,
 /**
  * setTxInputs - populates list of valid transaction inputs
  * @all_unspent: list of all the unspent outputs to date
- * @su_info:  pointer to "sender unspent" info struct
+ * @su_info:  pointer to "sender unspent" info struct; the sender's outputs
+ *   are found through su_info->view instead of `all_unspent` if set
  * Return: 0 on success, 1 on failure
  */
 llist_t *setTxInputs(llist_t *all_unspent, su_info_t *su_info)
@@ -137,10 +138,15 @@ llist_t *setTxInputs(llist_t *all_unspent, su_info_t *su_info)
 		return (NULL);
 	}
 
-	if (llist_for_each(all_unspent,
-			   (node_func_t)findSenderUnspent, su_info) < 0)
+	/* only visits the sender's outputs when the list or view is indexed */
+	if ((su_info->view ?
+	     unspentViewForPub(su_info->view, su_info->sender_pub,
+			       (node_func_t)findSenderUnspent, su_info) :
+	     unspentForPub(all_unspent, unspentIndexOf(all_unspent),
+			   su_info->sender_pub,
+			   (node_func_t)findSenderUnspent, su_info)) < 0)
 	{
-		fprintf(stderr, "setTxInputs: llist_for_each failure\n");
+		fprintf(stderr, "setTxInputs: unspentForPub failure\n");
 		return (NULL);
 	}
 
@@ -244,10 +250,12 @@ llist_t *setTxOutputs(const uint8_t sender_pub[EC_PUB_LEN],
  * @tx_outputs: list of transaction outputs
  * @sender: contains the private key of the transaction sender
  * @all_unspent: list of all the unspent outputs to date
+ * @view: view of `all_unspent` whose created outputs may be spent, or NULL
  * Return: pointer
  */
 transaction_t *newTransaction(llist_t *tx_inputs, llist_t *tx_outputs,
-			      const EC_KEY *sender, llist_t *all_unspent)
+			      const EC_KEY *sender, llist_t *all_unspent,
+			      utxo_view_t const *view)
 {
 	transaction_t *tx;
 	sign_info_t sign_info;
@@ -266,6 +274,7 @@ transaction_t *newTransaction(llist_t *tx_inputs, llist_t *tx_outputs,
 	}
 	tx->inputs = tx_inputs;
 	tx->outputs = tx_outputs;
+	tx->id_ok = 0;
 
 	if (transaction_hash(tx, tx->id) == NULL)
 	{
@@ -277,6 +286,7 @@ transaction_t *newTransaction(llist_t *tx_inputs, llist_t *tx_outputs,
 	memcpy(sign_info.tx_id, tx->id, SHA256_DIGEST_LENGTH);
 	sign_info.sender = sender;
 	sign_info.all_unspent = all_unspent;
+	sign_info.view = view;
 	if (llist_for_each(tx->inputs, (node_func_t)signTxIn, &sign_info) != 0)
 	{
 		fprintf(stderr, "newTransaction: llist_for_each failure\n");
@@ -289,15 +299,19 @@ transaction_t *newTransaction(llist_t *tx_inputs, llist_t *tx_outputs,
 
 
 /**
- * transaction_create - creates a transaction
+ * createTx - creates a transaction spending outputs of a list, or of a view
+ *   of that list
  * @sender: contains the private key of the transaction sender
  * @receiver: contains the public key of the transaction recipient
  * @amount: amount to send
  * @all_unspent: list of all the unspent outputs to date
+ * @view: view of `all_unspent` through which the outputs to spend are found,
+ *   or NULL
  * Return: pointer
  */
-transaction_t *transaction_create(EC_KEY const *sender, EC_KEY const *receiver,
-				  uint32_t amount, llist_t *all_unspent)
+static transaction_t *createTx(EC_KEY const *sender, EC_KEY const *receiver,
+			       uint32_t amount, llist_t *all_unspent,
+			       utxo_view_t const *view)
 {
 	su_info_t su_info;
 	transaction_t *tx;
@@ -306,24 +320,25 @@ transaction_t *transaction_create(EC_KEY const *sender, EC_KEY const *receiver,
 
 	if (!sender || !receiver || !all_unspent)
 	{
-		fprintf(stderr, "transaction_create: NULL parameter(s)\n");
+		fprintf(stderr, "createTx: NULL parameter(s)\n");
 		return (NULL);
 	}
 
 	if (!ec_to_pub(sender, su_info.sender_pub) ||
 	    !ec_to_pub(receiver, recv_pub))
 	{
-		fprintf(stderr, "transaction_create: ec_to_pub failure\n");
+		fprintf(stderr, "createTx: ec_to_pub failure\n");
 		return (NULL);
 	}
 	su_info.sender_unspent = llist_create(MT_SUPPORT_FALSE);
 	if (!(su_info.sender_unspent))
 	{
-		fprintf(stderr, "transaction_create: llist_create failure\n");
+		fprintf(stderr, "createTx: llist_create failure\n");
 		return (NULL);
 	}
 	su_info.send_amt = amount;
 	su_info.total_unspent_amt = 0;
+	su_info.view = view;
 
 	tx_inputs = setTxInputs(all_unspent, &su_info);
 	llist_destroy(su_info.sender_unspent, 0, NULL);
@@ -337,7 +352,7 @@ transaction_t *transaction_create(EC_KEY const *sender, EC_KEY const *receiver,
 		return (NULL);
 	}
 
-	tx = newTransaction(tx_inputs, tx_outputs, sender, all_unspent);
+	tx = newTransaction(tx_inputs, tx_outputs, sender, all_unspent, view);
 	if (!tx)
 	{
 		llist_destroy(tx_inputs, 1, NULL);
@@ -347,3 +362,40 @@ transaction_t *transaction_create(EC_KEY const *sender, EC_KEY const *receiver,
 
 	return (tx);
 }
+
+
+/**
+ * transaction_create - creates a transaction
+ * @sender: contains the private key of the transaction sender
+ * @receiver: contains the public key of the transaction recipient
+ * @amount: amount to send
+ * @all_unspent: list of all the unspent outputs to date
+ * Return: pointer
+ */
+transaction_t *transaction_create(EC_KEY const *sender, EC_KEY const *receiver,
+				  uint32_t amount, llist_t *all_unspent)
+{
+	return (createTx(sender, receiver, amount, all_unspent, NULL));
+}
+
+
+/**
+ * txCreateFromView - creates a transaction, as transaction_create does, but
+ *   spending only outputs neither spent nor created in an overlay view
+ * @sender: contains the private key of the transaction sender
+ * @receiver: contains the public key of the transaction recipient
+ * @amount: amount to send
+ * @view: view of the unspent outputs to date
+ * Return: pointer
+ */
+transaction_t *txCreateFromView(EC_KEY const *sender, EC_KEY const *receiver,
+				uint32_t amount, utxo_view_t const *view)
+{
+	if (!view)
+	{
+		fprintf(stderr, "txCreateFromView: NULL parameter\n");
+		return (NULL);
+	}
+
+	return (createTx(sender, receiver, amount, view->base, view));
+}
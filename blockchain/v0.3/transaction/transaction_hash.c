@@ -53,7 +53,61 @@ uint8_t *createTxDataBuff(const transaction_t *transaction,
 
 
 /**
- * populateTxDataBuff - fills a buffer allocated by createTxDataBuff
+ * copyInputHashes - used as `action` for llist_for_each to copy the hashes
+ *   of each input of a transaction->inputs list to its slot in a buffer
+ * @tx_in: pointer to input in transaction->inputs list, as iterated through
+ *   by llist_for_each
+ * @idx: index of `tx_in` in transaction->inputs list, as iterated through by
+ *   llist_for_each
+ * @buf: first byte of the input hashes in the buffer
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int copyInputHashes(tx_in_t const *tx_in, unsigned int idx,
+			   uint8_t *buf)
+{
+	if (!tx_in || !buf)
+	{
+		fprintf(stderr, "copyInputHashes: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	/* block_hash, tx_id and tx_out_hash are the leading members */
+	memcpy(buf + (size_t)idx * (SHA256_DIGEST_LENGTH * 3), tx_in,
+	       (SHA256_DIGEST_LENGTH * 3));
+	return (0);
+}
+
+
+/**
+ * copyOutputHash - used as `action` for llist_for_each to copy the hash of
+ *   each output of a transaction->outputs list to its slot in a buffer
+ * @tx_out: pointer to output in transaction->outputs list, as iterated
+ *   through by llist_for_each
+ * @idx: index of `tx_out` in transaction->outputs list, as iterated through
+ *   by llist_for_each
+ * @buf: first byte of the output hashes in the buffer
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int copyOutputHash(tx_out_t const *tx_out, unsigned int idx,
+			  uint8_t *buf)
+{
+	if (!tx_out || !buf)
+	{
+		fprintf(stderr, "copyOutputHash: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	memcpy(buf + (size_t)idx * SHA256_DIGEST_LENGTH, tx_out->hash,
+	       SHA256_DIGEST_LENGTH);
+	return (0);
+}
+
+
+/**
+ * populateTxDataBuff - fills a buffer allocated by createTxDataBuff, in a
+ *   single pass over each list
  * @transaction: points to the transaction of which to to compute the hash
  * @input_ct: count of transaction inputs
  * @output_ct: count of transaction outputs
@@ -64,42 +118,27 @@ int populateTxDataBuff(const transaction_t *transaction,
 		       int input_ct, int output_ct,
 		       uint8_t *tx_IO_buf)
 {
-	int i;
-	uint8_t *temp;
-	tx_in_t *tx_in;
-	tx_out_t *tx_out;
-
 	if (!transaction || !tx_IO_buf)
 	{
 		fprintf(stderr, "populateTxDataBuff: NULL parameter(s)\n");
 		return (1);
 	}
-
-	for (i = 0, temp = tx_IO_buf; i < input_ct; i++)
+	if (llist_size(transaction->inputs) != input_ct ||
+	    llist_size(transaction->outputs) != output_ct)
 	{
-		tx_in = (tx_in_t *)llist_get_node_at(transaction->inputs,
-						     (unsigned int)i);
-		if (!tx_in)
-		{
-			fprintf(stderr, "populateTxDataBuff: %s\n",
-				"llist_get_node_at failure");
-			return (1);
-		}
-		memcpy(temp, tx_in, (SHA256_DIGEST_LENGTH * 3));
-		temp += (SHA256_DIGEST_LENGTH * 3);
+		fprintf(stderr, "populateTxDataBuff: %s\n",
+			"input or output count does not match buffer");
+		return (1);
 	}
-	for (i = 0; i < output_ct; i++)
+
+	if (llist_for_each(transaction->inputs,
+			   (node_func_t)copyInputHashes, tx_IO_buf) < 0 ||
+	    llist_for_each(transaction->outputs, (node_func_t)copyOutputHash,
+			   tx_IO_buf + (size_t)input_ct *
+			   (SHA256_DIGEST_LENGTH * 3)) < 0)
 	{
-		tx_out = (tx_out_t *)llist_get_node_at(transaction->outputs,
-						       (unsigned int)i);
-		if (!tx_out)
-		{
-			fprintf(stderr, "populateTxDataBuff: %s\n",
-				"llist_get_node_at failure");
-			return (1);
-		}
-		memcpy(temp, tx_out->hash, SHA256_DIGEST_LENGTH);
-		temp += SHA256_DIGEST_LENGTH;
+		fprintf(stderr, "populateTxDataBuff: llist_for_each failure\n");
+		return (1);
 	}
 
 	return (0);
@@ -148,3 +187,91 @@ uint8_t *transaction_hash(transaction_t const *transaction,
 	free(tx_IO_buf);
 	return (hash_buf);
 }
+
+
+/**
+ * txFlatHash - computes the ID (hash) of a transaction in array form, as
+ *   transaction_hash does for its list form
+ * @flat: points to the transaction of which to compute the hash
+ * @hash_buf: buffer in which to store the computed hash
+ * Return: pointer to hash_buf, or NULL on failure
+ */
+uint8_t *txFlatHash(tx_flat_t const *flat,
+		    uint8_t hash_buf[SHA256_DIGEST_LENGTH])
+{
+	uint8_t *tx_IO_buf;
+	size_t tx_IO_buf_sz;
+	uint32_t i;
+
+	if (!flat || !hash_buf)
+	{
+		fprintf(stderr, "txFlatHash: NULL parameter(s)\n");
+		return (NULL);
+	}
+
+	tx_IO_buf_sz = ((SHA256_DIGEST_LENGTH * 3) * (size_t)flat->input_ct) +
+		(SHA256_DIGEST_LENGTH * (size_t)flat->output_ct);
+	tx_IO_buf = malloc(tx_IO_buf_sz ? tx_IO_buf_sz : 1);
+	if (!tx_IO_buf)
+	{
+		fprintf(stderr, "txFlatHash: malloc failure\n");
+		return (NULL);
+	}
+	for (i = 0; i < flat->input_ct; i++)
+		copyInputHashes(flat->inputs + i, i, tx_IO_buf);
+	for (i = 0; i < flat->output_ct; i++)
+		copyOutputHash(flat->outputs + i, i, tx_IO_buf +
+			       (size_t)flat->input_ct *
+			       (SHA256_DIGEST_LENGTH * 3));
+
+	if (!sha256((const int8_t *)tx_IO_buf, tx_IO_buf_sz, hash_buf))
+	{
+		fprintf(stderr, "txFlatHash: sha256 failure\n");
+		free(tx_IO_buf);
+		return (NULL);
+	}
+
+	free(tx_IO_buf);
+	return (hash_buf);
+}
+
+
+/**
+ * txIdIsValid - checks whether the ID of a transaction is the hash of its
+ *   inputs and outputs; a transaction found valid is not hashed again until
+ *   marked dirty
+ * @transaction: points to the transaction to check
+ * Return: 1 if valid, 0 if not or on failure
+ */
+int txIdIsValid(transaction_t const *transaction)
+{
+	uint8_t hash_buf[SHA256_DIGEST_LENGTH];
+
+	if (!transaction)
+	{
+		fprintf(stderr, "txIdIsValid: NULL parameter\n");
+		return (0);
+	}
+	if (transaction->id_ok)
+		return (1);
+
+	if (!transaction_hash(transaction, hash_buf) ||
+	    memcmp(transaction->id, hash_buf, SHA256_DIGEST_LENGTH) != 0)
+		return (0);
+	/* a cache of the check rather than part of the transaction value */
+	((transaction_t *)transaction)->id_ok = 1;
+	return (1);
+}
+
+
+/**
+ * txIdDirty - marks the ID of a transaction to be checked again by
+ *   txIdIsValid, to be called after changing its ID, or any of its inputs or
+ *   outputs
+ * @transaction: points to the changed transaction
+ */
+void txIdDirty(transaction_t *transaction)
+{
+	if (transaction)
+		transaction->id_ok = 0;
+}
@@ -4,34 +4,6 @@
 #include <stdlib.h>
 
 
-/**
- * matchUnspentOut - compare block transaction and output hashes
- * @unspent_tx_out: unspent output in a blockchain->unspent list, as
- *   iterated through by llist_find_node
- * @tx_in: pointer to input containing references to match
- * Return: 1 if transaction hash matches `tx_in`, 0 if not or on failure
- */
-static int matchUnspentOut(unspent_tx_out_t *unspent_tx_out, tx_in_t *tx_in)
-{
-	int match;
-
-	if (!unspent_tx_out || !tx_in)
-	{
-		fprintf(stderr, "matchUnspentOut: NULL parameter(s)\n");
-		return (0);
-	}
-
-	match = !(memcmp(unspent_tx_out->block_hash, tx_in->block_hash,
-			 SHA256_DIGEST_LENGTH) ||
-		  memcmp(unspent_tx_out->tx_id, tx_in->tx_id,
-			 SHA256_DIGEST_LENGTH) ||
-		  memcmp(unspent_tx_out->out.hash, tx_in->tx_out_hash,
-			 SHA256_DIGEST_LENGTH));
-
-	return (match);
-}
-
-
 /**
  * totalOutputAmt - used as `action` for llist_for_each to visit each
  *   output in a transaction->outputs list, and find the total coin
@@ -45,7 +17,7 @@ static int matchUnspentOut(unspent_tx_out_t *unspent_tx_out, tx_in_t *tx_in)
  * Return: 0 on incremental success (llist_for_each can continue,)
  *   or -2 on failure (-1 reserved for llist_for_each errors)
  */
-static int totalOutputAmt(tx_out_t *tx_out, unsigned int idx,
+static int totalOutputAmt(tx_out_t const *tx_out, unsigned int idx,
 			  uint32_t *tl_output_amt)
 {
 	(void)idx;
@@ -73,60 +45,58 @@ static int totalOutputAmt(tx_out_t *tx_out, unsigned int idx,
  *   -2 on failure (-1 reserved for llist_for_each errors,)
  *   and -3 when invalid transaction input found
  */
-static int validateTxInput(tx_in_t *tx_in, unsigned int idx,
+static int validateTxInput(tx_in_t const *tx_in, unsigned int idx,
 			   iv_info_t *iv_info)
 {
 	unspent_tx_out_t *unspent_tx_out;
-	EC_KEY *owner;
+	int verdict;
 
-	(void)idx;
 	if (!tx_in || !iv_info)
 	{
 		fprintf(stderr, "validateTxInput: NULL parameter(s)\n");
 		return (-2);
 	}
-	unspent_tx_out = llist_find_node(iv_info->all_unspent,
-					 (node_ident_t)matchUnspentOut,
-					 tx_in);
+	unspent_tx_out = unspentFind(iv_info->all_unspent, iv_info->index,
+				     tx_in);
 	if (!unspent_tx_out)
 	{
-		if (llist_errno == LLIST_NODE_NOT_FOUND)
-		{
-			fprintf(stderr, "validateTxInput: input found %s\n",
-				"with missing referenced unspent output");
-			return (-3);
-		}
-		fprintf(stderr, "validateTxInput: llist_find_node failure\n");
-		return (-2);
+		fprintf(stderr, "validateTxInput: input found %s\n",
+			"with missing referenced unspent output");
+		return (-3);
 	}
-	owner = ec_from_pub(unspent_tx_out->out.pub);
-	if (!owner)
+	if (iv_info->jobs)
+		verdict = iv_info->jobs[idx].verdict;
+	else
+		verdict = txInVerify(tx_in, iv_info->tx_id,
+				     unspent_tx_out->out.pub);
+	if (verdict < 0)
 	{
 		fprintf(stderr, "validateTxInput: ec_from_pub failure\n");
 		return (-2);
 	}
-	if (!ec_verify(owner, iv_info->tx_id,
-		       SHA256_DIGEST_LENGTH, &(tx_in->sig)))
+	if (!verdict)
 	{
 		fprintf(stderr, "validateTxInput: input signature does %s\n",
 			"not match referenced unspent output public key");
-		EC_KEY_free(owner);
 		return (-3);
 	}
 	iv_info->tl_input_amt += unspent_tx_out->out.amount;
-	EC_KEY_free(owner);
 	return (0);
 }
 
 
 /**
- * transaction_is_valid - checks whether a transaction is valid
+ * txIsValidVerified - checks whether a transaction is valid, possibly using
+ *   the verdicts of signature verifications already run for its inputs
  * @transaction: points to the transaction to verify
  * @all_unspent: list of all unspent transaction outputs to date
+ * @index: index of `all_unspent`, or NULL to scan it
+ * @jobs: signature verification jobs of each input of `transaction`, in
+ *   input order, or NULL to verify the signatures here
  * Return: 1 if the transaction is valid, 0 otherwise
  */
-int transaction_is_valid(transaction_t const *transaction,
-			 llist_t *all_unspent)
+int txIsValidVerified(transaction_t const *transaction, llist_t *all_unspent,
+		      utxo_index_t const *index, sv_job_t const *jobs)
 {
 	iv_info_t iv_info;
 	uint32_t tl_output_amt = 0;
@@ -144,16 +114,18 @@ int transaction_is_valid(transaction_t const *transaction,
 		return (0);
 	}
 
-	transaction_hash(transaction, iv_info.tx_id);
-	if (memcmp(transaction->id, iv_info.tx_id, SHA256_DIGEST_LENGTH) != 0)
+	if (!txIdIsValid(transaction))
 	{
 		fprintf(stderr, "transaction_is_valid: %s\n",
 			"transaction ID does not match hash of transaction");
 		return (0);
 	}
 
+	memcpy(iv_info.tx_id, transaction->id, SHA256_DIGEST_LENGTH);
 	iv_info.tl_input_amt = 0;
 	iv_info.all_unspent = all_unspent;
+	iv_info.index = index;
+	iv_info.jobs = jobs;
 	if (llist_for_each(transaction->inputs, (node_func_t)validateTxInput,
 			   &iv_info) < 0)
 	{
@@ -169,3 +141,17 @@ int transaction_is_valid(transaction_t const *transaction,
 	}
 	return (1);
 }
+
+
+/**
+ * transaction_is_valid - checks whether a transaction is valid
+ * @transaction: points to the transaction to verify
+ * @all_unspent: list of all unspent transaction outputs to date
+ * Return: 1 if the transaction is valid, 0 otherwise
+ */
+int transaction_is_valid(transaction_t const *transaction,
+			 llist_t *all_unspent)
+{
+	return (txIsValidVerified(transaction, all_unspent,
+				  unspentIndexOf(all_unspent), NULL));
+}
@@ -0,0 +1,279 @@
+#include "transaction.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+
+/**
+ * countInputs - used as `action` for llist_for_each to total the inputs of
+ *   every transaction in a list
+ *
+ * @tx: pointer to transaction in the list, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx` in the list, as iterated through by llist_for_each
+ * @input_ct: running total of inputs, modified by reference
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int countInputs(transaction_t *tx, unsigned int idx, size_t *input_ct)
+{
+	int size;
+
+	(void)idx;
+
+	if (!tx || !input_ct)
+	{
+		fprintf(stderr, "countInputs: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	size = llist_size(tx->inputs);
+	if (size < 0)
+		return (-2);
+	*input_ct += (size_t)size;
+
+	return (0);
+}
+
+
+/**
+ * addInputJob - used as `action` for llist_for_each to queue the signature
+ *   verification of each input of a transaction
+ *
+ * @tx_in: pointer to input in transaction->inputs list, as iterated through
+ *   by llist_for_each
+ * @idx: index of `tx_in` in transaction->inputs list, as iterated through by
+ *   llist_for_each
+ * @pool: pointer to pool to amend, pool->tx_id being the ID of the
+ *   transaction containing `tx_in`
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int addInputJob(tx_in_t *tx_in, unsigned int idx, sv_pool_t *pool)
+{
+	sv_job_t *job;
+
+	(void)idx;
+
+	if (!tx_in || !pool)
+	{
+		fprintf(stderr, "addInputJob: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	job = pool->jobs + pool->job_ct++;
+	job->tx_in = tx_in;
+	job->tx_id = pool->tx_id;
+	job->utxo = unspentFind(pool->all_unspent, pool->index, tx_in);
+	job->verdict = -1;
+
+	return (0);
+}
+
+
+/**
+ * addTxJobs - used as `action` for llist_for_each to queue the signature
+ *   verification of every input of every transaction in a list; the inputs
+ *   of a transaction failing cheaper checks are not verified, as
+ *   transaction_is_valid would reject it before or without verifying all of
+ *   them
+ *
+ * @tx: pointer to transaction in the list, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx` in the list, as iterated through by llist_for_each
+ * @pool: pointer to pool to amend; pool->valid[idx] is set to -1 if the
+ *   inputs of `tx` are not to be verified, 0 otherwise
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int addTxJobs(transaction_t *tx, unsigned int idx, sv_pool_t *pool)
+{
+	size_t i, first = pool ? pool->job_ct : 0;
+
+	if (!tx || !pool)
+	{
+		fprintf(stderr, "addTxJobs: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	pool->tx_id = tx->id;
+	if (llist_for_each(tx->inputs, (node_func_t)addInputJob, pool) < 0)
+		return (-2);
+	pool->valid[idx] = txIdIsValid(tx) ? 0 : -1;
+	for (i = first; i < pool->job_ct && !pool->valid[idx]; i++)
+		if (!pool->jobs[i].utxo)
+			pool->valid[idx] = -1;
+	for (i = first; i < pool->job_ct && pool->valid[idx]; i++)
+		pool->jobs[i].utxo = NULL;
+
+	return (0);
+}
+
+
+/**
+ * verifyWorker - start routine of a transactionsVerify worker thread, claims
+ *   and runs signature verification jobs until none is left
+ *
+ * @pool: pointer to pool shared by every worker
+ *
+ * Return: always NULL, results are reported in each job verdict
+ */
+static void *verifyWorker(sv_pool_t *pool)
+{
+	sv_job_t *job;
+	size_t i;
+
+	for (;;)
+	{
+		i = __atomic_fetch_add(&(pool->next), 1, __ATOMIC_RELAXED);
+		if (i >= pool->job_ct)
+			break;
+		job = pool->jobs + i;
+		if (!job->utxo)
+			continue;
+		job->verdict = txInVerify(job->tx_in, job->tx_id,
+					  job->utxo->out.pub);
+	}
+
+	return (NULL);
+}
+
+
+/**
+ * verifyPool - runs every job of a signature verification pool, spreading
+ *   them between `thread_ct` workers; the calling thread acts as the first
+ *   worker
+ *
+ * @pool: pointer to pool of jobs to run
+ * @thread_ct: amount of workers, at least 1
+ */
+static void verifyPool(sv_pool_t *pool, unsigned int thread_ct)
+{
+	pthread_t *tids;
+	unsigned int spawned = 1;
+
+	pool->next = 0;
+	if (thread_ct > pool->job_ct)
+		thread_ct = pool->job_ct ? (unsigned int)pool->job_ct : 1;
+	tids = thread_ct > 1 ? malloc(thread_ct * sizeof(pthread_t)) : NULL;
+	/* remaining jobs are run by the calling thread on any failure */
+	for (; tids && spawned < thread_ct; spawned++)
+		if (pthread_create(tids + spawned, NULL,
+				   (void *(*)(void *))verifyWorker, pool) != 0)
+			break;
+	verifyWorker(pool);
+	while (tids && --spawned > 0)
+		pthread_join(tids[spawned], NULL);
+	free(tids);
+}
+
+
+/**
+ * validateBatchTx - used as `action` for llist_for_each to decide on the
+ *   validity of each transaction of a verified batch, in list order
+ *
+ * @tx: pointer to transaction in the list, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx` in the list, as iterated through by llist_for_each
+ * @pool: pointer to pool of verified jobs, pool->next being the index of the
+ *   first job of `tx`; `tx` is checked without them if pool->valid[idx] is -1
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int validateBatchTx(transaction_t *tx, unsigned int idx,
+			   sv_pool_t *pool)
+{
+	int input_ct;
+
+	if (!tx || !pool)
+	{
+		fprintf(stderr, "validateBatchTx: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	input_ct = llist_size(tx->inputs);
+	if (input_ct < 0)
+		return (-2);
+	pool->valid[idx] = (int8_t)txIsValidVerified(
+		tx, pool->all_unspent, pool->index,
+		pool->valid[idx] == -1 ? NULL : pool->jobs + pool->next);
+	pool->next += (size_t)input_ct;
+
+	return (0);
+}
+
+
+/**
+ * transactionsVerify - checks the validity of every transaction in a list,
+ *   as transaction_is_valid would one after the other; the signatures of
+ *   all their inputs are first verified by a pool of threads, then the
+ *   remaining checks and the input and output amounts accounting are run
+ *   in list order
+ *
+ * @transactions: list of transactions to check
+ * @all_unspent: list of all unspent transaction outputs to date, not amended
+ *   until this returns
+ * @index: index of `all_unspent`, or NULL to scan it
+ * @thread_ct: amount of threads to use, or 0 for one per online processor;
+ *   bound to BLOCK_MINE_THREADS_MAX
+ * @valid: array of at least as many members as `transactions`, each set to
+ *   1 if the transaction at the same index is valid, 0 otherwise
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int transactionsVerify(llist_t *transactions, llist_t *all_unspent,
+		       utxo_index_t const *index, unsigned int thread_ct,
+		       int8_t *valid)
+{
+	sv_pool_t pool = {NULL, 0, 0, NULL, NULL, NULL, NULL};
+	size_t input_ct = 0;
+
+	if (!transactions || !all_unspent || !valid)
+	{
+		fprintf(stderr, "transactionsVerify: NULL parameter(s)\n");
+		return (1);
+	}
+	if (llist_for_each(transactions, (node_func_t)countInputs,
+			   &input_ct) < 0)
+	{
+		fprintf(stderr, "transactionsVerify: llist_for_each failure\n");
+		return (1);
+	}
+	pool.jobs = malloc((input_ct ? input_ct : 1) * sizeof(sv_job_t));
+	if (!pool.jobs)
+	{
+		fprintf(stderr, "transactionsVerify: malloc failure\n");
+		return (1);
+	}
+	pool.all_unspent = all_unspent;
+	pool.index = index;
+	pool.valid = valid;
+	/* referenced outputs are looked up serially, workers only verify */
+	if (llist_for_each(transactions, (node_func_t)addTxJobs, &pool) < 0)
+	{
+		fprintf(stderr, "transactionsVerify: llist_for_each failure\n");
+		free(pool.jobs);
+		return (1);
+	}
+	if (thread_ct == 0)
+		thread_ct = minerThreadCt();
+	else if (thread_ct > BLOCK_MINE_THREADS_MAX)
+		thread_ct = BLOCK_MINE_THREADS_MAX;
+	verifyPool(&pool, thread_ct);
+	pool.next = 0;
+	if (llist_for_each(transactions, (node_func_t)validateBatchTx,
+			   &pool) < 0)
+	{
+		fprintf(stderr, "transactionsVerify: llist_for_each failure\n");
+		free(pool.jobs);
+		return (1);
+	}
+	free(pool.jobs);
+
+	return (0);
+}
@@ -0,0 +1,198 @@
+/* -> blockchain.h -> */
+/* llist.h stdint.h hblk_crypto.h */
+#include "transaction.h"
+/* fprintf */
+#include <stdio.h>
+/* malloc free */
+#include <stdlib.h>
+/* memcpy memset */
+#include <string.h>
+
+
+/**
+ * flattenInput - used as `action` for llist_for_each to copy each input of
+ *   a transaction->inputs list to its slot in an array
+ *
+ * @tx_in: pointer to input in transaction->inputs list, as iterated through
+ *   by llist_for_each
+ * @idx: index of `tx_in` in transaction->inputs list, as iterated through by
+ *   llist_for_each
+ * @inputs: array of inputs to amend
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int flattenInput(tx_in_t *tx_in, unsigned int idx, tx_in_t *inputs)
+{
+	if (!tx_in || !inputs)
+	{
+		fprintf(stderr, "flattenInput: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	memcpy(inputs + idx, tx_in, sizeof(tx_in_t));
+	return (0);
+}
+
+
+/**
+ * flattenOutput - used as `action` for llist_for_each to copy each output
+ *   of a transaction->outputs list to its slot in an array
+ *
+ * @tx_out: pointer to output in transaction->outputs list, as iterated
+ *   through by llist_for_each
+ * @idx: index of `tx_out` in transaction->outputs list, as iterated through
+ *   by llist_for_each
+ * @outputs: array of outputs to amend
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int flattenOutput(tx_out_t *tx_out, unsigned int idx,
+			 tx_out_t *outputs)
+{
+	if (!tx_out || !outputs)
+	{
+		fprintf(stderr, "flattenOutput: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	memcpy(outputs + idx, tx_out, sizeof(tx_out_t));
+	return (0);
+}
+
+
+/**
+ * txFlatten - copies a transaction to array form
+ *
+ * @transaction: points to the transaction to copy
+ * @flat: pointer to the struct to fill, released by txFlatFree
+ *
+ * Return: 0 on success, or 1 upon failure
+ */
+int txFlatten(transaction_t const *transaction, tx_flat_t *flat)
+{
+	int input_ct, output_ct;
+
+	if (!transaction || !flat)
+	{
+		fprintf(stderr, "txFlatten: NULL parameter(s)\n");
+		return (1);
+	}
+	memset(flat, 0, sizeof(tx_flat_t));
+
+	input_ct = llist_size(transaction->inputs);
+	output_ct = llist_size(transaction->outputs);
+	if (input_ct == -1 || output_ct == -1)
+	{
+		fprintf(stderr, "txFlatten: llist_size failure\n");
+		return (1);
+	}
+	memcpy(flat->id, transaction->id, SHA256_DIGEST_LENGTH);
+	flat->input_ct = (uint32_t)input_ct;
+	flat->output_ct = (uint32_t)output_ct;
+	flat->inputs = malloc((input_ct ? input_ct : 1) * sizeof(tx_in_t));
+	flat->outputs = malloc((output_ct ? output_ct : 1) * sizeof(tx_out_t));
+	if (!flat->inputs || !flat->outputs)
+	{
+		fprintf(stderr, "txFlatten: malloc failure\n");
+		txFlatFree(flat);
+		return (1);
+	}
+
+	if (llist_for_each(transaction->inputs, (node_func_t)flattenInput,
+			   flat->inputs) < 0 ||
+	    llist_for_each(transaction->outputs, (node_func_t)flattenOutput,
+			   flat->outputs) < 0)
+	{
+		fprintf(stderr, "txFlatten: llist_for_each failure\n");
+		txFlatFree(flat);
+		return (1);
+	}
+
+	return (0);
+}
+
+
+/**
+ * txUnflatten - copies a transaction in array form back to list form
+ *
+ * @flat: pointer to the transaction to copy, see txFlatten
+ *
+ * Return: pointer to the created transaction, to be freed with
+ *   transaction_destroy, or NULL upon failure
+ */
+transaction_t *txUnflatten(tx_flat_t const *flat)
+{
+	transaction_t *transaction;
+	tx_in_t *tx_in;
+	tx_out_t *tx_out;
+	uint32_t i;
+
+	if (!flat)
+	{
+		fprintf(stderr, "txUnflatten: NULL parameter\n");
+		return (NULL);
+	}
+
+	transaction = calloc(1, sizeof(transaction_t));
+	if (!transaction)
+	{
+		fprintf(stderr, "txUnflatten: calloc failure\n");
+		return (NULL);
+	}
+	memcpy(transaction->id, flat->id, SHA256_DIGEST_LENGTH);
+	transaction->inputs = llist_create(MT_SUPPORT_FALSE);
+	transaction->outputs = llist_create(MT_SUPPORT_FALSE);
+	if (!transaction->inputs || !transaction->outputs)
+	{
+		fprintf(stderr, "txUnflatten: llist_create failure\n");
+		transaction_destroy(transaction);
+		return (NULL);
+	}
+
+	for (i = 0; i < flat->input_ct; i++)
+	{
+		tx_in = malloc(sizeof(tx_in_t));
+		if (!tx_in || llist_add_node(transaction->inputs, tx_in,
+					     ADD_NODE_REAR) != 0)
+		{
+			fprintf(stderr, "txUnflatten: failed to add input\n");
+			free(tx_in);
+			transaction_destroy(transaction);
+			return (NULL);
+		}
+		memcpy(tx_in, flat->inputs + i, sizeof(tx_in_t));
+	}
+	for (i = 0; i < flat->output_ct; i++)
+	{
+		tx_out = malloc(sizeof(tx_out_t));
+		if (!tx_out || llist_add_node(transaction->outputs, tx_out,
+					      ADD_NODE_REAR) != 0)
+		{
+			fprintf(stderr, "txUnflatten: failed to add output\n");
+			free(tx_out);
+			transaction_destroy(transaction);
+			return (NULL);
+		}
+		memcpy(tx_out, flat->outputs + i, sizeof(tx_out_t));
+	}
+
+	return (transaction);
+}
+
+
+/**
+ * txFlatFree - frees the arrays of a transaction in array form
+ *
+ * @flat: pointer to the transaction to release, left empty
+ */
+void txFlatFree(tx_flat_t *flat)
+{
+	if (!flat)
+		return;
+
+	free(flat->inputs);
+	free(flat->outputs);
+	memset(flat, 0, sizeof(tx_flat_t));
+}
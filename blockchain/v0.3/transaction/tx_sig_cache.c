@@ -0,0 +1,108 @@
+#include "transaction.h"
+#include <stdio.h>
+#include <string.h>
+
+
+/* keys are digests, see sigCacheKey, and values unused */
+static lru_entry_t sig_cache_entries[SIG_CACHE_SIZE];
+static uint32_t sig_cache_buckets[SIG_CACHE_BUCKETS];
+static lru_cache_t sig_cache = LRU_CACHE_INIT(sig_cache_entries,
+					      sig_cache_buckets,
+					      SHA256_DIGEST_LENGTH, 0,
+					      NULL, NULL);
+
+
+/**
+ * sigCacheKey - digests everything a signature verification depends on: the
+ *   signed transaction ID, the output referenced by the input, the public
+ *   key of that output and the signature itself
+ * @tx_in: input whose signature is verified
+ * @tx_id: ID of the transaction containing `tx_in`
+ * @pub: public key of the output referenced by `tx_in`
+ * @key: buffer to fill with the digest
+ * Return: 0 on success, or 1 on failure
+ */
+static int sigCacheKey(tx_in_t const *tx_in, uint8_t const *tx_id,
+		       uint8_t const *pub, uint8_t key[SHA256_DIGEST_LENGTH])
+{
+	uint8_t buf[SIG_CACHE_KEY_BUF_SZ], *pos = buf;
+
+	if (tx_in->sig.len > SIG_MAX_LEN)
+		return (1);
+	memcpy(pos, tx_id, SHA256_DIGEST_LENGTH);
+	pos += SHA256_DIGEST_LENGTH;
+	memcpy(pos, tx_in->block_hash, SHA256_DIGEST_LENGTH);
+	pos += SHA256_DIGEST_LENGTH;
+	memcpy(pos, tx_in->tx_id, SHA256_DIGEST_LENGTH);
+	pos += SHA256_DIGEST_LENGTH;
+	memcpy(pos, tx_in->tx_out_hash, SHA256_DIGEST_LENGTH);
+	pos += SHA256_DIGEST_LENGTH;
+	memcpy(pos, pub, EC_PUB_LEN);
+	pos += EC_PUB_LEN;
+	*(pos++) = tx_in->sig.len;
+	memcpy(pos, tx_in->sig.sig, tx_in->sig.len);
+	pos += tx_in->sig.len;
+
+	return (!sha256((int8_t const *)buf, (size_t)(pos - buf), key));
+}
+
+
+/**
+ * txInVerify - verifies the signature of a transaction input against the
+ *   public key of the output it references, skipping the verification if
+ *   the same signature of the same input was verified successfully among
+ *   the SIG_CACHE_SIZE most recent ones; failed verifications are not
+ *   cached; thread safe
+ * @tx_in: input whose signature is verified
+ * @tx_id: ID of the transaction containing `tx_in`, which is the signed
+ *   message
+ * @pub: public key of the output referenced by `tx_in`
+ * Return: 1 if the signature matches, 0 if not, or -2 on failure to verify
+ */
+int txInVerify(tx_in_t const *tx_in, uint8_t const *tx_id,
+	       uint8_t const pub[EC_PUB_LEN])
+{
+	uint8_t key[SHA256_DIGEST_LENGTH];
+	ec_verify_ctx_t owner;
+	int keyed, verdict;
+
+	if (!tx_in || !tx_id || !pub)
+	{
+		fprintf(stderr, "txInVerify: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	keyed = sigCacheKey(tx_in, tx_id, pub, key) == 0;
+	if (keyed && lruGet(&sig_cache, key, NULL))
+		return (1);
+
+	/* verified without the lock, other lookups can proceed meanwhile */
+	verdict = !ec_verify_ctx_pub(&owner, pub) ? -2 :
+		ec_verify_prepared(&owner, tx_id, SHA256_DIGEST_LENGTH,
+				   &(tx_in->sig));
+	ec_verify_ctx_free(&owner);
+	if (keyed && verdict == 1)
+		lruPut(&sig_cache, key, NULL);
+
+	return (verdict);
+}
+
+
+/**
+ * sigCacheStats - reads the counters of the signature verification cache
+ * @stats: pointer to struct to fill
+ */
+void sigCacheStats(lru_stats_t *stats)
+{
+	lruStats(&sig_cache, stats);
+}
+
+
+/**
+ * sigCacheClear - forgets every verified signature, and resets the counters
+ *   of the signature verification cache
+ */
+void sigCacheClear(void)
+{
+	lruClear(&sig_cache);
+}
@@ -0,0 +1,411 @@
+#include "transaction.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/* address marking slots of removed outputs, so that probing goes past them */
+static unspent_tx_out_t utxo_tombstone;
+
+
+/**
+ * utxoKey - computes the index key of an unspent output reference; its three
+ *   hashes are already uniformly distributed, so a few of their bytes suffice
+ *
+ * @block_hash: hash of the block containing the output
+ * @tx_id: ID of the transaction containing the output
+ * @out_hash: hash of the output
+ *
+ * Return: 64-bit key
+ */
+static uint64_t utxoKey(uint8_t const *block_hash, uint8_t const *tx_id,
+			uint8_t const *out_hash)
+{
+	uint64_t a, b, c;
+
+	memcpy(&a, block_hash, sizeof(uint64_t));
+	memcpy(&b, tx_id, sizeof(uint64_t));
+	memcpy(&c, out_hash, sizeof(uint64_t));
+
+	return (a ^ ((b << 21) | (b >> 43)) ^ ((c << 42) | (c >> 22)));
+}
+
+
+/**
+ * matchUnspentOut - used as `identifier` for llist_find_node to compare
+ *   block, transaction and output hashes of unspent output against those
+ *   recorded in an input
+ *
+ * @unspent_tx_out: unspent output in a blockchain->unspent list, as
+ *   iterated through by llist_find_node
+ * @tx_in: pointer to input containing references to match
+ *
+ * Return: 1 if transaction hash matches `tx_in`, 0 if not or on failure
+ */
+static int matchUnspentOut(unspent_tx_out_t const *unspent_tx_out,
+			   tx_in_t const *tx_in)
+{
+	if (!unspent_tx_out || !tx_in)
+	{
+		fprintf(stderr, "matchUnspentOut: NULL parameter(s)\n");
+		return (0);
+	}
+
+	return (!(memcmp(unspent_tx_out->block_hash, tx_in->block_hash,
+			 SHA256_DIGEST_LENGTH) ||
+		  memcmp(unspent_tx_out->tx_id, tx_in->tx_id,
+			 SHA256_DIGEST_LENGTH) ||
+		  memcmp(unspent_tx_out->out.hash, tx_in->tx_out_hash,
+			 SHA256_DIGEST_LENGTH)));
+}
+
+
+/**
+ * indexSlot - finds the slot of an unspent output in an index
+ *
+ * @index: index to search
+ * @key: key of the output, see utxoKey
+ * @tx_in: input referencing the output to find
+ * @utxo: address of the output to find, or NULL to find any output matching
+ *   `tx_in`
+ *
+ * Return: pointer to the slot, or NULL if not found
+ */
+static utxo_slot_t *indexSlot(utxo_index_t const *index, uint64_t key,
+			      tx_in_t const *tx_in,
+			      unspent_tx_out_t const *utxo)
+{
+	utxo_slot_t *slot;
+	size_t i;
+
+	if (!index->cap)
+		return (NULL);
+	for (i = key & (index->cap - 1); index->slots[i].utxo;
+	     i = (i + 1) & (index->cap - 1))
+	{
+		slot = index->slots + i;
+		if (slot->key != key || slot->utxo == &utxo_tombstone)
+			continue;
+		if (utxo ? slot->utxo == utxo :
+		    matchUnspentOut(slot->utxo, tx_in))
+			return (slot);
+	}
+
+	return (NULL);
+}
+
+
+/**
+ * unspentSlot - finds the slot of an unspent output in an index by address
+ *
+ * @index: index to search
+ * @utxo: address of the output to find
+ *
+ * Return: pointer to the slot, or NULL if not found
+ */
+utxo_slot_t *unspentSlot(utxo_index_t const *index,
+			 unspent_tx_out_t const *utxo)
+{
+	if (!index || !utxo)
+	{
+		fprintf(stderr, "unspentSlot: NULL parameter(s)\n");
+		return (NULL);
+	}
+
+	return (indexSlot(index, utxoKey(utxo->block_hash, utxo->tx_id,
+					 utxo->out.hash), NULL, utxo));
+}
+
+
+/**
+ * indexGrow - moves the slots of an index in use to a new array of slots,
+ *   large enough for one more output at a load factor under 1/2; tombstones
+ *   are left behind
+ *
+ * @index: index to amend
+ *
+ * Return: 0 on success, 1 on failure, in which case the index is unchanged
+ */
+static int indexGrow(utxo_index_t *index)
+{
+	utxo_slot_t *slots;
+	size_t i, j, cap = UNSPENT_INDEX_MIN_CAP;
+
+	while (cap < (index->count + 1) * 2)
+		cap *= 2;
+	slots = calloc(cap, sizeof(utxo_slot_t));
+	if (!slots)
+	{
+		fprintf(stderr, "indexGrow: calloc failure\n");
+		return (1);
+	}
+	for (i = 0; i < index->cap; i++)
+	{
+		if (!index->slots[i].utxo ||
+		    index->slots[i].utxo == &utxo_tombstone)
+			continue;
+		for (j = index->slots[i].key & (cap - 1); slots[j].utxo;
+		     j = (j + 1) & (cap - 1))
+			;
+		slots[j] = index->slots[i];
+	}
+	free(index->slots);
+	index->slots = slots;
+	index->cap = cap;
+	index->used = index->count;
+
+	return (0);
+}
+
+
+/**
+ * indexAdd - adds an unspent output to an index and to the public key index
+ *   of its owner, regrowing the index as needed to keep its load factor
+ *   under 3/4
+ *
+ * @index: index to amend
+ * @utxo: unspent output to add
+ *
+ * Return: 0 on success, 1 on failure, in which case the index is unchanged
+ */
+static int indexAdd(utxo_index_t *index, unspent_tx_out_t *utxo)
+{
+	utxo_slot_t *slot;
+	uint64_t key;
+	size_t i;
+
+	if ((index->used + 1) * 4 > index->cap * 3 && indexGrow(index) != 0)
+		return (1);
+
+	key = utxoKey(utxo->block_hash, utxo->tx_id, utxo->out.hash);
+	for (i = key & (index->cap - 1);
+	     index->slots[i].utxo && index->slots[i].utxo != &utxo_tombstone;
+	     i = (i + 1) & (index->cap - 1))
+		;
+	slot = index->slots + i;
+	if (!slot->utxo)
+		index->used++;
+	slot->key = key;
+	slot->utxo = utxo;
+	if (ownerAdd(index, slot) != 0)
+	{
+		slot->utxo = &utxo_tombstone;
+		return (1);
+	}
+	index->count++;
+
+	return (0);
+}
+
+
+/**
+ * indexDrop - removes the output of a slot from an index and from the
+ *   public key index of its owner
+ *
+ * @index: index to amend
+ * @slot: slot of the output to remove
+ */
+static void indexDrop(utxo_index_t *index, utxo_slot_t *slot)
+{
+	ownerRemove(index, slot);
+	slot->utxo = &utxo_tombstone;
+	index->count--;
+}
+
+
+/**
+ * indexNode - used as `action` for llist_for_each to add each node of a list
+ *   of unspent outputs to its index
+ *
+ * @utxo: unspent output, as iterated through by llist_for_each
+ * @idx: index of `utxo` in the list, as iterated through by llist_for_each
+ * @index: index being built
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int indexNode(unspent_tx_out_t *utxo, unsigned int idx,
+		     utxo_index_t *index)
+{
+	(void)idx;
+
+	if (!utxo || !index)
+	{
+		fprintf(stderr, "indexNode: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	return (indexAdd(index, utxo) ? -2 : 0);
+}
+
+
+/**
+ * unspentIndexCreate - builds a hash index of a list of unspent outputs, so
+ *   that unspentFind and unspentRemove run in constant time on that list
+ *   rather than scanning it
+ *
+ * @all_unspent: list of unspent outputs, to be amended from now on only
+ *   through unspentAdd and unspentRemove, passing them the index
+ *
+ * Return: pointer to the index, to be freed with unspentIndexDestroy, or
+ *   NULL on failure
+ */
+utxo_index_t *unspentIndexCreate(llist_t *all_unspent)
+{
+	utxo_index_t *index;
+
+	if (!all_unspent)
+	{
+		fprintf(stderr, "unspentIndexCreate: NULL parameter\n");
+		return (NULL);
+	}
+
+	index = calloc(1, sizeof(utxo_index_t));
+	if (!index)
+	{
+		fprintf(stderr, "unspentIndexCreate: calloc failure\n");
+		return (NULL);
+	}
+	if (llist_for_each(all_unspent, (node_func_t)indexNode, index) < 0)
+	{
+		fprintf(stderr, "unspentIndexCreate: llist_for_each failure\n");
+		unspentIndexDestroy(index);
+		return (NULL);
+	}
+
+	return (index);
+}
+
+
+/**
+ * unspentIndexDestroy - frees an index and its public key index; the
+ *   indexed list itself is left untouched
+ *
+ * @index: index to free, may be NULL
+ */
+void unspentIndexDestroy(utxo_index_t *index)
+{
+	if (!index)
+		return;
+
+	ownersFree(index);
+	free(index->slots);
+	free(index);
+}
+
+
+/**
+ * unspentFind - finds the unspent output referenced by a transaction input
+ *
+ * @all_unspent: list of unspent outputs
+ * @index: index of `all_unspent`, or NULL to scan it
+ * @tx_in: input referencing the output to find
+ *
+ * Return: pointer to the unspent output, or NULL if not found
+ */
+unspent_tx_out_t *unspentFind(llist_t *all_unspent, utxo_index_t const *index,
+			      tx_in_t const *tx_in)
+{
+	utxo_slot_t *slot;
+
+	if (!all_unspent || !tx_in)
+	{
+		fprintf(stderr, "unspentFind: NULL parameter(s)\n");
+		return (NULL);
+	}
+
+	if (!index)
+		return (llist_find_node(all_unspent,
+					(node_ident_t)matchUnspentOut,
+					(void *)tx_in));
+	slot = indexSlot(index, utxoKey(tx_in->block_hash, tx_in->tx_id,
+					tx_in->tx_out_hash), tx_in, NULL);
+
+	return (slot ? slot->utxo : NULL);
+}
+
+
+/**
+ * unspentAdd - appends an unspent output to a list of unspent outputs, and
+ *   to its index if any
+ *
+ * @all_unspent: list of unspent outputs
+ * @index: index of `all_unspent`, or NULL
+ * @utxo: unspent output to add
+ *
+ * Return: 0 on success, 1 on failure, in which case neither the list nor
+ *   the index is changed
+ */
+int unspentAdd(llist_t *all_unspent, utxo_index_t *index,
+	       unspent_tx_out_t *utxo)
+{
+	if (!all_unspent || !utxo)
+	{
+		fprintf(stderr, "unspentAdd: NULL parameter(s)\n");
+		return (1);
+	}
+
+	if (index && indexAdd(index, utxo) != 0)
+		return (1);
+	if (llist_add_node(all_unspent, utxo, ADD_NODE_REAR) < 0)
+	{
+		fprintf(stderr, "unspentAdd: llist_add_node: %s\n",
+			strE_LLIST(llist_errno));
+		if (index)
+			indexDrop(index, unspentSlot(index, utxo));
+		return (1);
+	}
+
+	return (0);
+}
+
+
+/**
+ * unspentRemove - removes the unspent output referenced by a transaction
+ *   input from a list of unspent outputs, and from its index if any; with an
+ *   index, the list head is moved into the node of the removed output and
+ *   popped, so that the list is never scanned, at the cost of its order
+ *
+ * @all_unspent: list of unspent outputs
+ * @index: index of `all_unspent`, or NULL to scan it
+ * @tx_in: input referencing the output to remove
+ *
+ * Return: 0 on success, 1 if not found or on failure, in which case neither
+ *   the list nor the index is changed
+ */
+int unspentRemove(llist_t *all_unspent, utxo_index_t *index,
+		  tx_in_t const *tx_in)
+{
+	utxo_slot_t *slot, *head_slot = NULL;
+	unspent_tx_out_t *head, *utxo;
+
+	if (!all_unspent || !tx_in)
+	{
+		fprintf(stderr, "unspentRemove: NULL parameter(s)\n");
+		return (1);
+	}
+	if (!index)
+		return (llist_remove_node(all_unspent,
+					  (node_ident_t)matchUnspentOut,
+					  (void *)tx_in, 1, NULL) < 0);
+
+	slot = indexSlot(index, utxoKey(tx_in->block_hash, tx_in->tx_id,
+					tx_in->tx_out_hash), tx_in, NULL);
+	head = llist_get_head(all_unspent);
+	if (slot && head && head != slot->utxo)
+		head_slot = unspentSlot(index, head);
+	if (!slot || !head || (head != slot->utxo && !head_slot))
+		return (1);
+	utxo = slot->utxo;
+	indexDrop(index, slot);
+	/* the head takes the place of the removed output, then is popped */
+	if (head_slot)
+	{
+		memcpy(utxo, head, sizeof(unspent_tx_out_t));
+		head_slot->utxo = utxo;
+		ownerMove(index, head_slot);
+	}
+	free(llist_pop(all_unspent));
+
+	return (0);
+}
@@ -0,0 +1,413 @@
+#include "transaction.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * ownerKey - computes the public key index key of a public key; the leading
+ *   byte of an uncompressed point is always 0x04, so it is skipped
+ *
+ * @pub: public key
+ *
+ * Return: 64-bit key
+ */
+static uint64_t ownerKey(uint8_t const *pub)
+{
+	uint64_t key;
+
+	memcpy(&key, pub + 1, sizeof(uint64_t));
+
+	return (key);
+}
+
+
+/**
+ * ownerSlot - finds the slot of a public key in the public key index of an
+ *   unspent output index
+ *
+ * @owners: public key slots
+ * @cap: amount of public key slots, power of 2
+ * @pub: public key to find
+ *
+ * Return: pointer to the slot holding `pub`, or to the empty slot where it
+ *   belongs if not found
+ */
+static utxo_owner_t *ownerSlot(utxo_owner_t *owners, size_t cap,
+			       uint8_t const *pub)
+{
+	size_t i;
+
+	for (i = ownerKey(pub) & (cap - 1); owners[i].utxos;
+	     i = (i + 1) & (cap - 1))
+		if (memcmp(owners[i].pub, pub, EC_PUB_LEN) == 0)
+			break;
+
+	return (owners + i);
+}
+
+
+/**
+ * ownerFind - finds the outputs of an unspent output index locked to a
+ *   public key
+ *
+ * @index: index to search
+ * @pub: public key to find
+ *
+ * Return: pointer to the owner, or NULL if no output ever was locked to `pub`
+ */
+static utxo_owner_t *ownerFind(utxo_index_t const *index, uint8_t const *pub)
+{
+	utxo_owner_t *owner;
+
+	if (!index->owners_cap)
+		return (NULL);
+	owner = ownerSlot(index->owners, index->owners_cap, pub);
+
+	return (owner->utxos ? owner : NULL);
+}
+
+
+/**
+ * ownersGrow - doubles the amount of public key slots of an unspent output
+ *   index, to keep its load factor under 3/4
+ *
+ * @index: index to amend
+ *
+ * Return: 0 on success, 1 on failure
+ */
+static int ownersGrow(utxo_index_t *index)
+{
+	utxo_owner_t *owners;
+	size_t i, cap = UNSPENT_OWNERS_MIN_CAP;
+
+	if (index->owners_cap)
+		cap = index->owners_cap * 2;
+	owners = calloc(cap, sizeof(utxo_owner_t));
+	if (!owners)
+	{
+		fprintf(stderr, "ownersGrow: calloc failure\n");
+		return (1);
+	}
+	for (i = 0; i < index->owners_cap; i++)
+		if (index->owners[i].utxos)
+			*ownerSlot(owners, cap, index->owners[i].pub) =
+				index->owners[i];
+	free(index->owners);
+	index->owners = owners;
+	index->owners_cap = cap;
+
+	return (0);
+}
+
+
+/**
+ * ownerAdd - appends an unspent output to the outputs of an unspent output
+ *   index locked to its public key, recording its position in its slot
+ *
+ * @index: index to amend
+ * @slot: slot of the output, already added to the index
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int ownerAdd(utxo_index_t *index, utxo_slot_t *slot)
+{
+	utxo_owner_t *owner;
+	unspent_tx_out_t **utxos, *utxo;
+	size_t cap;
+
+	if (!index || !slot)
+	{
+		fprintf(stderr, "ownerAdd: NULL parameter(s)\n");
+		return (1);
+	}
+
+	utxo = slot->utxo;
+	owner = ownerFind(index, utxo->out.pub);
+	if (!owner)
+	{
+		if ((index->owners_count + 1) * 4 > index->owners_cap * 3 &&
+		    ownersGrow(index) != 0)
+			return (1);
+		owner = ownerSlot(index->owners, index->owners_cap,
+				  utxo->out.pub);
+		owner->utxos = malloc(sizeof(unspent_tx_out_t *));
+		if (!owner->utxos)
+		{
+			fprintf(stderr, "ownerAdd: malloc failure\n");
+			return (1);
+		}
+		memcpy(owner->pub, utxo->out.pub, EC_PUB_LEN);
+		owner->cap = 1;
+		index->owners_count++;
+	}
+	if (owner->len == owner->cap)
+	{
+		cap = owner->cap * 2;
+		utxos = realloc(owner->utxos, cap * sizeof(unspent_tx_out_t *));
+		if (!utxos)
+		{
+			fprintf(stderr, "ownerAdd: realloc failure\n");
+			return (1);
+		}
+		owner->utxos = utxos;
+		owner->cap = cap;
+	}
+	slot->pos = owner->len;
+	owner->utxos[owner->len++] = utxo;
+	owner->count++;
+	owner->balance += utxo->out.amount;
+
+	return (0);
+}
+
+
+/**
+ * ownerCompact - moves the outputs of an owner over the holes left by the
+ *   removed ones, keeping them in order, and updates their positions
+ *
+ * @index: index containing `owner`
+ * @owner: owner to amend
+ */
+static void ownerCompact(utxo_index_t *index, utxo_owner_t *owner)
+{
+	utxo_slot_t *slot;
+	size_t i, len;
+
+	for (i = 0, len = 0; i < owner->len; i++)
+	{
+		if (!owner->utxos[i])
+			continue;
+		slot = unspentSlot(index, owner->utxos[i]);
+		if (slot)
+			slot->pos = len;
+		owner->utxos[len++] = owner->utxos[i];
+	}
+	owner->len = len;
+}
+
+
+/**
+ * ownerRemove - removes an unspent output from the outputs of an unspent
+ *   output index locked to its public key, leaving a hole in its place; the
+ *   outputs are compacted once holes outnumber them, so that removal takes
+ *   constant amortized time
+ *
+ * @index: index to amend
+ * @slot: slot of the output, still in the index
+ */
+void ownerRemove(utxo_index_t *index, utxo_slot_t const *slot)
+{
+	utxo_owner_t *owner;
+
+	if (!index || !slot)
+	{
+		fprintf(stderr, "ownerRemove: NULL parameter(s)\n");
+		return;
+	}
+
+	owner = ownerFind(index, slot->utxo->out.pub);
+	if (!owner || slot->pos >= owner->len ||
+	    owner->utxos[slot->pos] != slot->utxo)
+		return;
+	owner->utxos[slot->pos] = NULL;
+	owner->count--;
+	owner->balance -= slot->utxo->out.amount;
+	if (!owner->count)
+		owner->len = 0;
+	else if (owner->len > owner->count * 2)
+		ownerCompact(index, owner);
+}
+
+
+/**
+ * ownerMove - points the entry of an unspent output among the outputs of
+ *   its owner to the new address of the output, set in its slot
+ *
+ * @index: index to amend
+ * @slot: slot of the output, whose `utxo` member was moved
+ */
+void ownerMove(utxo_index_t *index, utxo_slot_t const *slot)
+{
+	utxo_owner_t *owner;
+
+	if (!index || !slot)
+	{
+		fprintf(stderr, "ownerMove: NULL parameter(s)\n");
+		return;
+	}
+
+	owner = ownerFind(index, slot->utxo->out.pub);
+	if (owner && slot->pos < owner->len)
+		owner->utxos[slot->pos] = slot->utxo;
+}
+
+
+/**
+ * ownersFree - frees the public key index of an unspent output index
+ *
+ * @index: index to amend
+ */
+void ownersFree(utxo_index_t *index)
+{
+	size_t i;
+
+	if (!index)
+		return;
+
+	for (i = 0; i < index->owners_cap; i++)
+		free(index->owners[i].utxos);
+	free(index->owners);
+	index->owners = NULL;
+	index->owners_cap = index->owners_count = 0;
+}
+
+
+/**
+ * filterPub - used as `action` for llist_for_each to call another action
+ *   only for the unspent outputs locked to a given public key
+ *
+ * @utxo: unspent output, as iterated through by llist_for_each
+ * @idx: index of `utxo` in the list, as iterated through by llist_for_each
+ * @pf_info: pointer to struct containing the public key, the action and its
+ *   parameter
+ *
+ * Return: return value of the filtered action, 0 if `utxo` is not locked to
+ *   the public key, or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int filterPub(unspent_tx_out_t *utxo, unsigned int idx,
+		     pf_info_t *pf_info)
+{
+	(void)idx;
+
+	if (!utxo || !pf_info)
+	{
+		fprintf(stderr, "filterPub: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	if (memcmp(utxo->out.pub, pf_info->pub, EC_PUB_LEN) != 0)
+		return (0);
+
+	return (pf_info->action(utxo, pf_info->idx++, pf_info->arg));
+}
+
+
+/**
+ * unspentForPub - calls a function for each unspent output of a list locked
+ *   to a given public key, in the order they were added, as llist_for_each
+ *   would for the whole list; only the outputs of that key are visited when
+ *   the list is indexed
+ *
+ * @all_unspent: list of unspent outputs, not to be amended by `action`
+ * @index: index of `all_unspent`, or NULL to scan it
+ * @pub: public key of the outputs to visit
+ * @action: function called for each output, with the position of the output
+ *   among those locked to `pub`
+ * @arg: parameter passed to `action`
+ *
+ * Return: 0 if `action` returned 0 for every output, else the first nonzero
+ *   value it returned, or -1 on failure
+ */
+int unspentForPub(llist_t *all_unspent, utxo_index_t const *index,
+		  uint8_t const pub[EC_PUB_LEN], node_func_t action, void *arg)
+{
+	pf_info_t pf_info;
+	utxo_owner_t *owner;
+	size_t i;
+	unsigned int visited;
+	int ret;
+
+	if (!all_unspent || !pub || !action)
+	{
+		fprintf(stderr, "unspentForPub: NULL parameter(s)\n");
+		return (-1);
+	}
+
+	if (!index)
+	{
+		pf_info.pub = pub;
+		pf_info.action = action;
+		pf_info.arg = arg;
+		pf_info.idx = 0;
+		return (llist_for_each(all_unspent, (node_func_t)filterPub,
+				       &pf_info));
+	}
+	owner = ownerFind(index, pub);
+	for (i = 0, visited = 0; owner && i < owner->len; i++)
+	{
+		if (!owner->utxos[i])
+			continue;
+		ret = action(owner->utxos[i], visited++, arg);
+		if (ret)
+			return (ret);
+	}
+
+	return (0);
+}
+
+
+/**
+ * sumBalance - used as `action` for unspentForPub to total the unspent
+ *   outputs locked to a public key
+ *
+ * @utxo: unspent output, as iterated through by unspentForPub
+ * @idx: position of `utxo` among the outputs visited
+ * @owner: running count and balance of the outputs visited
+ *
+ * Return: 0 on incremental success, or -2 on failure
+ */
+static int sumBalance(unspent_tx_out_t *utxo, unsigned int idx,
+		      utxo_owner_t *owner)
+{
+	(void)idx;
+
+	if (!utxo || !owner)
+	{
+		fprintf(stderr, "sumBalance: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	owner->balance += utxo->out.amount;
+	owner->count++;
+
+	return (0);
+}
+
+
+/**
+ * unspentBalance - totals the unspent outputs of a list locked to a given
+ *   public key; takes constant time when the list is indexed
+ *
+ * @all_unspent: list of unspent outputs
+ * @index: index of `all_unspent`, or NULL to scan it
+ * @pub: public key of the outputs to total
+ * @balance: modified by reference to the sum of the output amounts
+ * @count: modified by reference to the amount of outputs, may be NULL
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int unspentBalance(llist_t *all_unspent, utxo_index_t const *index,
+		   uint8_t const pub[EC_PUB_LEN], uint64_t *balance,
+		   size_t *count)
+{
+	utxo_owner_t sum = { {0}, NULL, 0, 0, 0, 0 }, *owner;
+
+	if (!all_unspent || !pub || !balance)
+	{
+		fprintf(stderr, "unspentBalance: NULL parameter(s)\n");
+		return (1);
+	}
+
+	owner = index ? ownerFind(index, pub) : NULL;
+	if (owner)
+		sum = *owner;
+	else if (!index && unspentForPub(all_unspent, NULL, pub,
+					 (node_func_t)sumBalance, &sum) != 0)
+		return (1);
+	*balance = sum.balance;
+	if (count)
+		*count = sum.count;
+
+	return (0);
+}
@@ -0,0 +1,123 @@
+#include "transaction.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+
+/* blockchains whose unspent list the spec API may be handed bare */
+static struct
+{
+	blockchain_t const **blockchains;
+	size_t               count;
+	size_t               cap;
+	pthread_mutex_t      lock;
+} registry = {NULL, 0, 0, PTHREAD_MUTEX_INITIALIZER};
+
+
+/**
+ * unspentIndexBind - records a blockchain, so that its unspent index is
+ *   found by unspentIndexOf from its unspent list alone; the index stays
+ *   owned by the blockchain, and is looked up through it, so that replacing
+ *   blockchain->unspent along with blockchain->unspent_index needs no rebind
+ *
+ * @blockchain: blockchain to record, to be released with unspentIndexUnbind
+ *   before it is freed
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int unspentIndexBind(blockchain_t const *blockchain)
+{
+	blockchain_t const **blockchains;
+	size_t cap;
+	int ret = 0;
+
+	if (!blockchain)
+	{
+		fprintf(stderr, "unspentIndexBind: NULL parameter\n");
+		return (1);
+	}
+
+	pthread_mutex_lock(&(registry.lock));
+	if (registry.count == registry.cap)
+	{
+		cap = registry.cap ? registry.cap * 2 : 4;
+		blockchains = realloc(registry.blockchains,
+				      cap * sizeof(blockchain_t const *));
+		if (blockchains)
+		{
+			registry.blockchains = blockchains;
+			registry.cap = cap;
+		}
+		else
+		{
+			fprintf(stderr, "unspentIndexBind: realloc failure\n");
+			ret = 1;
+		}
+	}
+	if (!ret)
+		registry.blockchains[registry.count++] = blockchain;
+	pthread_mutex_unlock(&(registry.lock));
+
+	return (ret);
+}
+
+
+/**
+ * unspentIndexUnbind - forgets a blockchain recorded by unspentIndexBind;
+ *   the last one forgotten frees the registry
+ *
+ * @blockchain: blockchain to forget, may not have been recorded
+ */
+void unspentIndexUnbind(blockchain_t const *blockchain)
+{
+	size_t i;
+
+	pthread_mutex_lock(&(registry.lock));
+	for (i = 0; i < registry.count; i++)
+	{
+		if (registry.blockchains[i] != blockchain)
+			continue;
+		registry.blockchains[i] =
+			registry.blockchains[--registry.count];
+		break;
+	}
+	if (!registry.count)
+	{
+		free(registry.blockchains);
+		registry.blockchains = NULL;
+		registry.cap = 0;
+	}
+	pthread_mutex_unlock(&(registry.lock));
+}
+
+
+/**
+ * unspentIndexOf - finds the index of a list of unspent outputs handed to
+ *   the spec API without it, so that update_unspent keeps that index in sync
+ *   and transaction_is_valid and tx_in_sign search through it
+ *
+ * @all_unspent: list of unspent outputs
+ *
+ * Return: index of the blockchain whose unspent list is `all_unspent`, or
+ *   NULL if there is none, in which case the list is not indexed
+ */
+utxo_index_t *unspentIndexOf(llist_t const *all_unspent)
+{
+	utxo_index_t *index = NULL;
+	size_t i;
+
+	if (!all_unspent)
+		return (NULL);
+
+	pthread_mutex_lock(&(registry.lock));
+	for (i = 0; i < registry.count; i++)
+	{
+		if (registry.blockchains[i]->unspent != all_unspent)
+			continue;
+		index = registry.blockchains[i]->unspent_index;
+		break;
+	}
+	pthread_mutex_unlock(&(registry.lock));
+
+	return (index);
+}
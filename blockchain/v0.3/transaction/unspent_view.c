@@ -0,0 +1,451 @@
+#include "transaction.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+/**
+ * unspentViewInit - starts an overlay view of a list of unspent outputs, to
+ *   which transactions can be applied without amending the list
+ *
+ * @view: pointer to view to fill, released by unspentViewFree
+ * @base: list of unspent outputs seen through the view, not to be amended
+ *   while the view is in use
+ * @base_index: index of `base`, or NULL to scan it
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int unspentViewInit(utxo_view_t *view, llist_t *base,
+		    utxo_index_t const *base_index)
+{
+	if (!view || !base)
+	{
+		fprintf(stderr, "unspentViewInit: NULL parameter(s)\n");
+		return (1);
+	}
+
+	memset(view, 0, sizeof(utxo_view_t));
+	view->base = base;
+	view->base_index = base_index;
+	view->spent = llist_create(MT_SUPPORT_FALSE);
+	view->created = llist_create(MT_SUPPORT_FALSE);
+	if (view->spent && view->created)
+	{
+		view->spent_index = unspentIndexCreate(view->spent);
+		view->created_index = unspentIndexCreate(view->created);
+	}
+	if (!view->spent_index || !view->created_index)
+	{
+		fprintf(stderr, "unspentViewInit: failed to create sets\n");
+		unspentViewFree(view);
+		return (1);
+	}
+
+	return (0);
+}
+
+
+/**
+ * unspentViewFind - finds an unspent output through an overlay view: outputs
+ *   spent in the view are hidden, outputs created in the view are added
+ *
+ * @view: pointer to view
+ * @tx_in: input referencing the output to find
+ *
+ * Return: pointer to the unspent output, or NULL if not found or spent
+ */
+unspent_tx_out_t *unspentViewFind(utxo_view_t const *view,
+				  tx_in_t const *tx_in)
+{
+	unspent_tx_out_t *utxo;
+
+	if (!view || !tx_in)
+	{
+		fprintf(stderr, "unspentViewFind: NULL parameter(s)\n");
+		return (NULL);
+	}
+
+	if (unspentFind(view->spent, view->spent_index, tx_in))
+		return (NULL);
+	utxo = unspentFind(view->created, view->created_index, tx_in);
+
+	return (utxo ? utxo :
+		unspentFind(view->base, view->base_index, tx_in));
+}
+
+
+/**
+ * viewSpend - used as `action` for llist_for_each to mark the output
+ *   referenced by each input of a transaction as spent in a view
+ *
+ * @tx_in: pointer to input in transaction->inputs, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx_in` in transaction->inputs, as iterated through by
+ *   llist_for_each
+ * @va_info: pointer to struct containing the view, va_info->ct being
+ *   incremented for each output spent
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   -2 on failure (-1 reserved for llist_for_each errors,)
+ *   and -3 when the output is missing or already spent
+ */
+static int viewSpend(tx_in_t *tx_in, unsigned int idx, va_info_t *va_info)
+{
+	unspent_tx_out_t *utxo, *spent;
+
+	(void)idx;
+	if (!tx_in || !va_info)
+	{
+		fprintf(stderr, "viewSpend: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	utxo = unspentViewFind(va_info->view, tx_in);
+	if (!utxo)
+		return (-3);
+	spent = malloc(sizeof(unspent_tx_out_t));
+	if (!spent)
+	{
+		fprintf(stderr, "viewSpend: malloc failure\n");
+		return (-2);
+	}
+	memcpy(spent, utxo, sizeof(unspent_tx_out_t));
+	if (unspentAdd(va_info->view->spent, va_info->view->spent_index,
+		       spent) != 0)
+	{
+		free(spent);
+		return (-2);
+	}
+	va_info->ct++;
+
+	return (0);
+}
+
+
+/**
+ * viewUnspend - used as `action` for llist_for_each to undo viewSpend for
+ *   the first va_info->ct inputs of a transaction
+ *
+ * @tx_in: pointer to input in transaction->inputs, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx_in` in transaction->inputs, as iterated through by
+ *   llist_for_each
+ * @va_info: pointer to struct containing the view and the amount of inputs
+ *   to undo
+ *
+ * Return: 0 while inputs are left to undo (llist_for_each can continue,)
+ *   or 1 once done
+ */
+static int viewUnspend(tx_in_t *tx_in, unsigned int idx, va_info_t *va_info)
+{
+	if (idx >= va_info->ct)
+		return (1);
+
+	unspentViewUnspend(va_info->view, tx_in);
+	return (0);
+}
+
+
+/**
+ * unspentViewUnspend - undoes the spending of an output in a view, so that
+ *   the output is seen again if the base list or the view still holds it
+ *
+ * @view: pointer to view to amend
+ * @tx_in: input referencing the output to release
+ *
+ * Return: 0 on success, 1 if the output is not spent in the view
+ */
+int unspentViewUnspend(utxo_view_t *view, tx_in_t const *tx_in)
+{
+	if (!view || !tx_in)
+	{
+		fprintf(stderr, "unspentViewUnspend: NULL parameter(s)\n");
+		return (1);
+	}
+
+	return (unspentRemove(view->spent, view->spent_index, tx_in));
+}
+
+
+/**
+ * viewCreate - used as `action` for llist_for_each to add each output of a
+ *   transaction to the outputs created in a view
+ *
+ * @tx_out: pointer to output in transaction->outputs, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx_out` in transaction->outputs, as iterated through by
+ *   llist_for_each
+ * @va_info: pointer to struct containing the view, and the block hash and
+ *   transaction ID of `tx_out`
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int viewCreate(tx_out_t *tx_out, unsigned int idx, va_info_t *va_info)
+{
+	unspent_tx_out_t *utxo;
+
+	(void)idx;
+	if (!tx_out || !va_info)
+	{
+		fprintf(stderr, "viewCreate: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	utxo = unspent_tx_out_create(va_info->block_hash, va_info->tx_id,
+				     tx_out);
+	if (!utxo || unspentAdd(va_info->view->created,
+				va_info->view->created_index, utxo) != 0)
+	{
+		free(utxo);
+		return (-2);
+	}
+
+	return (0);
+}
+
+
+/**
+ * unspentViewApply - spends in an overlay view the outputs referenced by the
+ *   inputs of a transaction, then creates its outputs in the view; each
+ *   input costs one lookup, the base list is never copied nor amended
+ *
+ * @view: pointer to view to amend
+ * @tx: transaction to apply, already found valid against the base list
+ * @block_hash: hash of the block containing `tx`, or NULL if not known yet,
+ *   as while a block is being assembled, in which case the outputs of `tx`
+ *   cannot be referenced and are not created
+ *
+ * Return: 0 on success, 1 if an input references an output missing from the
+ *   view, spent by an earlier transaction or by another input of `tx`, in
+ *   which case the view is left unchanged, or -1 on failure, in which case
+ *   the view is to be released
+ */
+int unspentViewApply(utxo_view_t *view, transaction_t const *tx,
+		     uint8_t const block_hash[SHA256_DIGEST_LENGTH])
+{
+	va_info_t va_info;
+	int ret;
+
+	if (!view || !tx)
+	{
+		fprintf(stderr, "unspentViewApply: NULL parameter(s)\n");
+		return (-1);
+	}
+
+	va_info.view = view;
+	va_info.ct = 0;
+	ret = llist_for_each(tx->inputs, (node_func_t)viewSpend, &va_info);
+	if (ret == -3)
+	{
+		llist_for_each(tx->inputs, (node_func_t)viewUnspend, &va_info);
+		return (1);
+	}
+	if (ret < 0)
+		return (-1);
+	if (!block_hash)
+		return (0);
+
+	memcpy(va_info.block_hash, block_hash, SHA256_DIGEST_LENGTH);
+	memcpy(va_info.tx_id, tx->id, SHA256_DIGEST_LENGTH);
+	if (llist_for_each(tx->outputs, (node_func_t)viewCreate, &va_info) < 0)
+		return (-1);
+
+	return (0);
+}
+
+
+/**
+ * viewVisit - used as `action` for llist_for_each or unspentForPub to call
+ *   a function for each output of a view not spent in it
+ *
+ * @utxo: unspent output of the base list or of the outputs created in the
+ *   view, as iterated through by llist_for_each or unspentForPub
+ * @idx: position of `utxo` among the outputs iterated through
+ * @vf_info: pointer to struct containing the view, the function to call and
+ *   the position of the next output visited
+ *
+ * Return: 0 on incremental success, else the nonzero value returned by
+ *   vf_info->action
+ */
+static int viewVisit(unspent_tx_out_t *utxo, unsigned int idx,
+		     vf_info_t *vf_info)
+{
+	tx_in_t outpoint;
+
+	(void)idx;
+	memcpy(outpoint.block_hash, utxo->block_hash, SHA256_DIGEST_LENGTH);
+	memcpy(outpoint.tx_id, utxo->tx_id, SHA256_DIGEST_LENGTH);
+	memcpy(outpoint.tx_out_hash, utxo->out.hash, SHA256_DIGEST_LENGTH);
+	if (unspentFind(vf_info->view->spent, vf_info->view->spent_index,
+			&outpoint))
+		return (0);
+
+	return (vf_info->action(utxo, vf_info->idx++, vf_info->arg));
+}
+
+
+/**
+ * unspentViewForPub - calls a function for each output of an overlay view
+ *   locked to a given public key, those of the base list first, as
+ *   unspentForPub does for a list
+ *
+ * @view: pointer to view, not to be amended by `action`
+ * @pub: public key of the outputs to visit
+ * @action: function called for each output, with the position of the output
+ *   among those visited
+ * @arg: parameter passed to `action`
+ *
+ * Return: 0 if `action` returned 0 for every output, else the first nonzero
+ *   value it returned, or -1 on failure
+ */
+int unspentViewForPub(utxo_view_t const *view, uint8_t const pub[EC_PUB_LEN],
+		      node_func_t action, void *arg)
+{
+	vf_info_t vf_info;
+	int ret;
+
+	if (!view || !pub || !action)
+	{
+		fprintf(stderr, "unspentViewForPub: NULL parameter(s)\n");
+		return (-1);
+	}
+
+	vf_info.view = view;
+	vf_info.action = action;
+	vf_info.arg = arg;
+	vf_info.idx = 0;
+	ret = unspentForPub(view->base, view->base_index, pub,
+			    (node_func_t)viewVisit, &vf_info);
+	if (!ret)
+		ret = unspentForPub(view->created, view->created_index, pub,
+				    (node_func_t)viewVisit, &vf_info);
+
+	return (ret);
+}
+
+
+/**
+ * unspentViewForEach - calls a function for each output of an overlay view,
+ *   those of the base list first, as llist_for_each does for a list
+ *
+ * @view: pointer to view, not to be amended by `action`
+ * @action: function called for each output, with the position of the output
+ *   among those visited
+ * @arg: parameter passed to `action`
+ *
+ * Return: 0 if `action` returned 0 for every output, else the first nonzero
+ *   value it returned, or -1 on failure
+ */
+int unspentViewForEach(utxo_view_t const *view, node_func_t action,
+		       void *arg)
+{
+	vf_info_t vf_info;
+	int ret;
+
+	if (!view || !action)
+	{
+		fprintf(stderr, "unspentViewForEach: NULL parameter(s)\n");
+		return (-1);
+	}
+
+	vf_info.view = view;
+	vf_info.action = action;
+	vf_info.arg = arg;
+	vf_info.idx = 0;
+	ret = llist_for_each(view->base, (node_func_t)viewVisit, &vf_info);
+	if (!ret)
+		ret = llist_for_each(view->created, (node_func_t)viewVisit,
+				     &vf_info);
+
+	return (ret);
+}
+
+
+/**
+ * unspentViewBalance - totals the outputs of an overlay view locked to a
+ *   given public key: those of the base list, less those spent in the view,
+ *   plus those created in it; takes constant time when the base list is
+ *   indexed
+ *
+ * @view: pointer to view
+ * @pub: public key of the outputs to total
+ * @balance: modified by reference to the sum of the output amounts
+ * @count: modified by reference to the amount of outputs, may be NULL
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int unspentViewBalance(utxo_view_t const *view, uint8_t const pub[EC_PUB_LEN],
+		       uint64_t *balance, size_t *count)
+{
+	uint64_t base_amt, spent_amt, created_amt;
+	size_t base_ct, spent_ct, created_ct;
+
+	if (!view || !pub || !balance)
+	{
+		fprintf(stderr, "unspentViewBalance: NULL parameter(s)\n");
+		return (1);
+	}
+
+	/* every output spent in the view is in one of the other two lists */
+	if (unspentBalance(view->base, view->base_index, pub, &base_amt,
+			   &base_ct) != 0 ||
+	    unspentBalance(view->spent, view->spent_index, pub, &spent_amt,
+			   &spent_ct) != 0 ||
+	    unspentBalance(view->created, view->created_index, pub,
+			   &created_amt, &created_ct) != 0)
+		return (1);
+	*balance = base_amt + created_amt - spent_amt;
+	if (count)
+		*count = base_ct + created_ct - spent_ct;
+
+	return (0);
+}
+
+
+/**
+ * unspentViewSize - counts the outputs of an overlay view
+ *
+ * @view: pointer to view
+ *
+ * Return: amount of outputs, or -1 on failure
+ */
+int unspentViewSize(utxo_view_t const *view)
+{
+	int base_ct, spent_ct, created_ct;
+
+	if (!view)
+	{
+		fprintf(stderr, "unspentViewSize: NULL parameter\n");
+		return (-1);
+	}
+
+	base_ct = llist_size(view->base);
+	spent_ct = llist_size(view->spent);
+	created_ct = llist_size(view->created);
+	if (base_ct < 0 || spent_ct < 0 || created_ct < 0)
+		return (-1);
+
+	return (base_ct + created_ct - spent_ct);
+}
+
+
+/**
+ * unspentViewFree - releases the outputs spent and created in an overlay
+ *   view, leaving its base list as it was
+ *
+ * @view: pointer to view to release
+ */
+void unspentViewFree(utxo_view_t *view)
+{
+	if (!view)
+		return;
+
+	unspentIndexDestroy(view->spent_index);
+	unspentIndexDestroy(view->created_index);
+	if (view->spent)
+		llist_destroy(view->spent, 1, NULL);
+	if (view->created)
+		llist_destroy(view->created, 1, NULL);
+	memset(view, 0, sizeof(utxo_view_t));
+}
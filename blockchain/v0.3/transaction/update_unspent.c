@@ -4,38 +4,6 @@
 #include <string.h>
 
 
-/**
- * matchUnspentOut - used as `identifier` for llist_find_node or
- *   llist_remove_node to compare block, transaction and output hashes of
- *   unspent output against those recorded in an input
- *
- * @unspent_tx_out: unspent output in a blockchain->unspent list, as
- *   iterated through by llist_find_node
- * @tx_in: pointer to input containing references to match
- *
- * Return: 1 if transaction hash matches `tx_in`, 0 if not or on failure
- */
-static int matchUnspentOut(unspent_tx_out_t *unspent_tx_out, tx_in_t *tx_in)
-{
-	int match;
-
-	if (!unspent_tx_out || !tx_in)
-	{
-		fprintf(stderr, "matchUnspentOut: NULL parameter(s)\n");
-		return (0);
-	}
-
-	match = !(memcmp(unspent_tx_out->block_hash, tx_in->block_hash,
-			 SHA256_DIGEST_LENGTH) ||
-		  memcmp(unspent_tx_out->tx_id, tx_in->tx_id,
-			 SHA256_DIGEST_LENGTH) ||
-		  memcmp(unspent_tx_out->out.hash, tx_in->tx_out_hash,
-			 SHA256_DIGEST_LENGTH));
-
-	return (match);
-}
-
-
 /**
  * addUnspentOutput - used as `action` for llist_for_each to add a transaction
  *   output to the list of unspent outputs
@@ -71,10 +39,11 @@ static int addUnspentOutput(tx_out_t *tx_out, unsigned int idx,
 		return (-2);
 	}
 
-	if (llist_add_node(uo_info->all_unspent, unspent_tx_out,
-			   ADD_NODE_REAR) < 0)
+	if (unspentAdd(uo_info->all_unspent, uo_info->index,
+		       unspent_tx_out) != 0)
 	{
-		fprintf(stderr, "addUnspentOutput: llist_add_node failure\n");
+		fprintf(stderr, "addUnspentOutput: unspentAdd failure\n");
+		free(unspent_tx_out);
 		return (-2);
 	}
 
@@ -82,47 +51,60 @@ static int addUnspentOutput(tx_out_t *tx_out, unsigned int idx,
 }
 
 
+/**
+ * isCoinbaseInput - checks whether a transaction input is that of a coinbase
+ *   transaction, which by definition references no output
+ *
+ * @tx_in: pointer to input to check
+ *
+ * Return: 1 if `tx_in` block hash and transaction ID are zeroed, 0 if not
+ */
+static int isCoinbaseInput(tx_in_t const *tx_in)
+{
+	uint8_t const *hash;
+	int i, end, hashes_zeroed;
+
+	/* tx_in->block_hash and tx_in->tx_id */
+	hash = tx_in->block_hash;
+	end = SHA256_DIGEST_LENGTH * 2;
+	for (i = 0, hashes_zeroed = 1; i < end; i++)
+		hashes_zeroed &= (hash[i] == 0);
+
+	return (hashes_zeroed);
+}
+
+
 /**
  * delRfrncdOutput - used as `action` for llist_for_each to delete the unspent
  *   output referenced by a given transaction input
  *
  * @tx_in: pointer to input containing references to match
  * @idx: index of tx_in in a transaction->inputs list
- * @unspent: list of all unspent outputs to be amended
+ * @uo_info: pointer to struct containing the list of all unspent outputs to
+ *   be amended and its index
  *
  * Return: 0 in incremental success (llist_for_each can continue,)
  *   and -2 on failure (-1 reserved for llist_for_each errors)
  */
 int delRfrncdOutput(tx_in_t *tx_in, unsigned int idx,
-		    llist_t *unspent)
+		    uo_info_t *uo_info)
 {
-	uint8_t *hash;
-	int i, end, hashes_zeroed;
-
 	(void)idx;
 
-	if (!tx_in || !unspent)
+	if (!tx_in || !uo_info)
 	{
 		fprintf(stderr,
 			"delRfrncdOutput: NULL parameter(s)\n");
 		return (-2);
 	}
 
-	/* tx_in->block_hash and tx_in->tx_id */
-	hash = tx_in->block_hash;
-	end = SHA256_DIGEST_LENGTH * 2;
-	for (i = 0, hashes_zeroed = 1; i < end; i++)
-		hashes_zeroed &= (hash[i] == 0);
-
 	/* coinbase tx inputs by definition have no referenced outputs */
-	if (hashes_zeroed)
+	if (isCoinbaseInput(tx_in))
 		return (0);
 
-	if (llist_remove_node(unspent, (node_ident_t)matchUnspentOut,
-			      tx_in, 1, NULL) < 0)
+	if (unspentRemove(uo_info->all_unspent, uo_info->index, tx_in) != 0)
 	{
-		fprintf(stderr, "delRfrncdOutput: llist_remove_node: %s\n",
-			strE_LLIST(llist_errno));
+		fprintf(stderr, "delRfrncdOutput: unspentRemove failure\n");
 		return (-2);
 	}
 
@@ -159,7 +141,7 @@ static int updateRfrncdOutputs(transaction_t *tx, unsigned int idx,
 	memcpy(&(uo_info->tx_id), &(tx->id), SHA256_DIGEST_LENGTH);
 
 	if (llist_for_each(tx->inputs, (node_func_t)delRfrncdOutput,
-			   uo_info->all_unspent) < 0 ||
+			   uo_info) < 0 ||
 	    llist_for_each(tx->outputs, (node_func_t)addUnspentOutput,
 			   uo_info) < 0)
 	{
@@ -173,37 +155,59 @@ static int updateRfrncdOutputs(transaction_t *tx, unsigned int idx,
 
 
 /**
- * update_unspent - updates the list of all unspent transaction outputs, given
- *   a list of processed transactions
+ * updateUnspent - updates a list of unspent transaction outputs and its
+ *   index, given a list of processed transactions
  *
  * @transactions: list of validated transactions
  * @block_hash: hash of the validated block that contains `transactions`
  * @all_unspent: current list of unspent transaction outputs
+ * @index: index of `all_unspent`, or NULL to scan it for each input
  *
  * Return: pointer to new list of unspent transaction outputs upon success,
  *   or NULL upon failure
  */
-llist_t *update_unspent(llist_t *transactions,
-			uint8_t block_hash[SHA256_DIGEST_LENGTH],
-			llist_t *all_unspent)
+llist_t *updateUnspent(llist_t *transactions,
+		       uint8_t block_hash[SHA256_DIGEST_LENGTH],
+		       llist_t *all_unspent, utxo_index_t *index)
 {
 	uo_info_t uo_info;
 
 	if (!transactions || !block_hash || !all_unspent)
 	{
-		fprintf(stderr, "update_unspent: NULL parameter(s)\n");
+		fprintf(stderr, "updateUnspent: NULL parameter(s)\n");
 		return (NULL);
 	}
 
 	memcpy(&(uo_info.block_hash), block_hash, SHA256_DIGEST_LENGTH);
 	uo_info.all_unspent = all_unspent;
+	uo_info.index = index;
 
 	if (llist_for_each(transactions, (node_func_t)updateRfrncdOutputs,
 			   &uo_info) < 0)
 	{
-		fprintf(stderr, "update_unspent: llist_for_each failure\n");
+		fprintf(stderr, "updateUnspent: llist_for_each failure\n");
 		return (NULL);
 	}
 
 	return (all_unspent);
 }
+
+
+/**
+ * update_unspent - updates the list of all unspent transaction outputs, given
+ *   a list of processed transactions
+ *
+ * @transactions: list of validated transactions
+ * @block_hash: hash of the validated block that contains `transactions`
+ * @all_unspent: current list of unspent transaction outputs
+ *
+ * Return: pointer to new list of unspent transaction outputs upon success,
+ *   or NULL upon failure
+ */
+llist_t *update_unspent(llist_t *transactions,
+			uint8_t block_hash[SHA256_DIGEST_LENGTH],
+			llist_t *all_unspent)
+{
+	return (updateUnspent(transactions, block_hash, all_unspent,
+			      unspentIndexOf(all_unspent)));
+}
@@ -0,0 +1,95 @@
+/* BLKCHN_PATH_DFLT parseBlockId */
+#include "hblk_cli.h"
+#include "info_formats.h"
+/* printf fprintf */
+#include <stdio.h>
+
+
+/**
+ * fileBlock - reads a block of a blockchain file by height or by hash,
+ *   through the block and transaction tables of the file
+ *
+ * @id: height of the block in decimal, or in hex the hash of the block or
+ *   the ID of one of its transactions
+ * @file: pointer to open blockchain file
+ *
+ * Return: pointer to the block, to be freed with block_destroy, or NULL if
+ *   not found or `id` is malformed
+ */
+static block_t *fileBlock(char *id, bc_file_t const *file)
+{
+	uint8_t hash[SHA256_DIGEST_LENGTH];
+	uint32_t height;
+	block_t *block;
+
+	switch (parseBlockId(id, &height, hash))
+	{
+	case 0:
+		return (height < file->header.hblk_blocks ?
+			bcFileBlock(file, height) : NULL);
+	case 1:
+		block = bcFileBlockByHash(file, hash);
+		return (block ? block : bcFileTxBlock(file, hash));
+	default:
+		return (NULL);
+	}
+}
+
+
+/**
+ * cmd_block_info - prints a single block of a saved blockchain, reading only
+ *   that block from the file instead of loading the whole blockchain
+ *
+ * @id: user provided height of the block in decimal, or in hex its hash or
+ *   the ID of one of its transactions
+ * @path: user provided path to the blockchain file, or NULL for the default
+ * @cli_state: pointer to struct containing information about the cli and
+ *   blockchain in use
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int cmd_block_info(char *id, char *path, cli_state_t *cli_state)
+{
+	bc_file_t file;
+	block_t *block;
+
+	if (!cli_state)
+	{
+		fprintf(stderr, "cmd_block_info: NULL cli_state parameter\n");
+		return (1);
+	}
+
+	if (!id)
+	{
+		printf(TAB4 "Usage: block_info <height / hash> [<path>]\n");
+		return (1);
+	}
+
+	if (!path || !path[0])
+	{
+		printf(TAB4 "No blockchain file path provided, %s\n",
+		       "using default");
+		path = BLKCHN_PATH_DFLT;
+	}
+
+	if (bcFileOpen(&file, path) != 0)
+	{
+		printf(TAB4 "Failed to read blockchain from '%s'\n", path);
+		return (1);
+	}
+
+	block = fileBlock(id, &file);
+	bcFileClose(&file);
+	if (!block)
+	{
+		printf(TAB4 "No block at height or of hash '%s' in '%s'\n",
+		       id, path);
+		return (1);
+	}
+
+	printf(INFO_FILE_BLOCK_FMT_HDR, block->info.index, path);
+	_block_print_single(block);
+	printf(INFO_FMT_FTR);
+	block_destroy(block);
+	return (0);
+}
@@ -3,25 +3,29 @@
 #include "info_formats.h"
 /* printf fprintf */
 #include <stdio.h>
-/* memcmp */
+/* strncmp strlen */
 #include <string.h>
+/* isdigit isxdigit */
+#include <ctype.h>
+/* strtoul */
+#include <stdlib.h>
 
 
 /**
- * findAllSenderUnspent - used as `action` for llist_for_each to visit each
- *   unspent output in the blockchain, and add unspent outputs
- *   with a matching public key to a collated list of potential inputs
+ * findAllSenderUnspent - used as `action` for unspentViewForPub to visit
+ *   each unspent output in the cache locked to the wallet public key, and
+ *   add it to a collated list of potential inputs; also used with
+ *   unspentViewForEach to collate every output in the cache
  *
  * @unspent_tx_out: pointer to unspent output in blockchain->unspent list,
- *   as iterated through by llist_for_each
- * @idx: index of `unspent_tx_out` in blockchain->unspent list, as
- *   iterated through by llist_for_each
+ *   as iterated through by unspentViewForPub
+ * @idx: position of `unspent_tx_out` among the wallet's unspent outputs, as
+ *   iterated through by unspentViewForPub
  * @su_info: pointer to struct containing all parameters necessary to build a
  *   second list of unspent transactions for a particular public key
  *
- * Return: 0 on incremental success (llist_for_each can continue,)
- *   1 on total success (llist_for_each can end,)
- *   and -2 on failure (-1 reserved for llist_for_each errors)
+ * Return: 0 on incremental success (unspentViewForPub can continue,)
+ *   and -2 on failure (-1 reserved for unspentViewForPub errors)
  */
 static int findAllSenderUnspent(unspent_tx_out_t *unspent_tx_out,
 				unsigned int idx, su_info_t *su_info)
@@ -34,19 +38,73 @@ static int findAllSenderUnspent(unspent_tx_out_t *unspent_tx_out,
 		return (-2);
 	}
 
-	if (memcmp(unspent_tx_out->out.pub, su_info->sender_pub,
-		   EC_PUB_LEN) == 0)
+	if (llist_add_node(su_info->sender_unspent,
+			   unspent_tx_out, ADD_NODE_REAR) != 0)
 	{
-		if (llist_add_node(su_info->sender_unspent,
-				   unspent_tx_out, ADD_NODE_REAR) != 0)
+		fprintf(stderr, "findSenderUnspent: %s\n",
+			"llist_add_node failure");
+		return (-2);
+	}
+
+	su_info->total_unspent_amt += unspent_tx_out->out.amount;
+
+	return (0);
+}
+
+
+/**
+ * walletUnspent - totals the unspent outputs of the session wallet, and
+ *   collates them in a list if requested
+ *
+ * @full: non-zero to collate the wallet's UTXOs in su_info->sender_unspent,
+ *   otherwise they are only counted, in constant time when the unspent cache
+ *   is indexed
+ * @cli_state: pointer to struct containing information about the cli and
+ *   blockchain in use
+ * @su_info: pointer to struct to fill with the wallet public key, the
+ *   list of its UTXOs if `full` or NULL, and their total amount
+ * @count: modified by reference to the amount of wallet UTXOs
+ *
+ * Return: 0 on success, 1 on failure
+ */
+static int walletUnspent(int full, cli_state_t *cli_state,
+			 su_info_t *su_info, size_t *count)
+{
+	uint64_t balance;
+
+	su_info->total_unspent_amt = 0;
+	su_info->sender_unspent = NULL;
+	if (!ec_to_pub(cli_state->wallet, su_info->sender_pub))
+		return (1);
+	if (!full)
+	{
+		if (unspentViewBalance(&(cli_state->unspent_cache),
+				       su_info->sender_pub, &balance,
+				       count) != 0)
 		{
-			fprintf(stderr, "findSenderUnspent: %s\n",
-				"llist_add_node failure");
-			return (-2);
+			fprintf(stderr, "walletUnspent: %s\n",
+				"unspentViewBalance failure");
+			return (1);
 		}
+		su_info->total_unspent_amt = (uint32_t)balance;
+		return (0);
+	}
 
-		su_info->total_unspent_amt += unspent_tx_out->out.amount;
+	su_info->sender_unspent = llist_create(MT_SUPPORT_FALSE);
+	if (!su_info->sender_unspent)
+	{
+		fprintf(stderr, "walletUnspent: llist_create failure\n");
+		return (1);
+	}
+	if (unspentViewForPub(&(cli_state->unspent_cache),
+			      su_info->sender_pub,
+			      (node_func_t)findAllSenderUnspent, su_info) != 0)
+	{
+		fprintf(stderr, "walletUnspent: unspentViewForPub failure\n");
+		llist_destroy(su_info->sender_unspent, 0, NULL);
+		return (1);
 	}
+	*count = (size_t)llist_size(su_info->sender_unspent);
 
 	return (0);
 }
@@ -69,7 +127,7 @@ int print_info_wallet(int full, llist_t **wallet_unspent,
 {
 	char *pub_buf;
 	su_info_t su_info;
-	size_t i, j;
+	size_t i, j, count;
 
 	if (!cli_state || (full && !wallet_unspent))
 	{
@@ -77,33 +135,22 @@ int print_info_wallet(int full, llist_t **wallet_unspent,
 		return (1);
 	}
 
-	if (!ec_to_pub(cli_state->wallet, su_info.sender_pub))
+	if (walletUnspent(full, cli_state, &su_info, &count) != 0)
 		return (1);
-	su_info.total_unspent_amt = 0;
-	su_info.sender_unspent = llist_create(MT_SUPPORT_FALSE);
-	if (!su_info.sender_unspent)
-	{
-		fprintf(stderr, "print_info_wallet: llist_create failure\n");
-		return (1);
-	}
-	if (llist_for_each(cli_state->unspent_cache,
-			   (node_func_t)findAllSenderUnspent, &su_info) != 0)
-	{
-		fprintf(stderr, "print_info_wallet: llist_for_each failure\n");
-		return (1);
-	}
 
-	pub_buf = malloc((EC_PUB_LEN * 2) * sizeof(char));
+	pub_buf = malloc((EC_PUB_LEN * 2 + 1) * sizeof(char));
 	if (!pub_buf)
 	{
 		fprintf(stderr, "print_info_wallet: malloc failure\n");
+		if (full)
+			llist_destroy(su_info.sender_unspent, 0, NULL);
 		return (1);
 	}
-	for (i = 0, j = 0; su_info.sender_pub && i < EC_PUB_LEN; i++, j += 2)
+	for (i = 0, j = 0; i < EC_PUB_LEN; i++, j += 2)
 		sprintf(pub_buf + j, "%02x", (su_info.sender_pub)[i]);
 
 	printf(INFO_WALLET_FMT_HDR);
-	printf(INFO_WALLET_FMT, pub_buf, llist_size(su_info.sender_unspent),
+	printf(INFO_WALLET_FMT, pub_buf, (int)count,
 	       su_info.total_unspent_amt);
 
 	free(pub_buf);
@@ -111,8 +158,6 @@ int print_info_wallet(int full, llist_t **wallet_unspent,
 		printf(INFO_FMT_FTR);
 	if (full)
 		*wallet_unspent = su_info.sender_unspent;
-	else
-		llist_destroy(su_info.sender_unspent, 0, NULL);
 	return (0);
 }
 
@@ -128,6 +173,8 @@ int print_info_wallet(int full, llist_t **wallet_unspent,
  */
 int print_info_mempool(int component, cli_state_t *cli_state)
 {
+	lru_stats_t sig_stats, key_stats;
+
 	if (!cli_state)
 	{
 		fprintf(stderr, "print_info_mempool: NULL parameter\n");
@@ -136,6 +183,14 @@ int print_info_mempool(int component, cli_state_t *cli_state)
 
 	printf(INFO_MEMPOOL_FMT_HDR);
 	printf(INFO_MEMPOOL_FMT, llist_size(cli_state->mempool));
+	/* shared by send, mine and validate, see txInVerify */
+	sigCacheStats(&sig_stats);
+	printf(INFO_SIG_CACHE_FMT, (unsigned long)sig_stats.hits,
+	       (unsigned long)sig_stats.misses);
+	/* keys decoded for the verifications run, see ec_from_pub_cached */
+	ec_key_cache_stats(&key_stats);
+	printf(INFO_KEY_CACHE_FMT, (unsigned long)key_stats.hits,
+	       (unsigned long)key_stats.misses);
 	if (!component)
 		printf(INFO_FMT_FTR);
 	return (0);
@@ -163,7 +218,7 @@ int print_info_blockchain(int component, cli_state_t *cli_state)
 	printf(INFO_BLKCHN_FMT_HDR);
 	printf(INFO_BLKCHN_FMT,
 	       llist_size(cli_state->blockchain->unspent),
-	       llist_size(cli_state->unspent_cache),
+	       unspentViewSize(&(cli_state->unspent_cache)),
 	       llist_size(cli_state->blockchain->chain));
 	if (!component)
 		printf(INFO_FMT_FTR);
@@ -276,6 +331,8 @@ int print_info_mempool_full(int component, cli_state_t *cli_state)
  */
 int print_info_blockchain_full(int component, cli_state_t *cli_state)
 {
+	su_info_t su_info;
+
 	if (!cli_state)
 	{
 		fprintf(stderr, "print_info_blockchain_full: NULL parameter\n");
@@ -286,7 +343,21 @@ int print_info_blockchain_full(int component, cli_state_t *cli_state)
 		return (1);
 	_print_all_unspent(cli_state->blockchain->unspent,
 			   "UTXOs before mempool");
-	_print_all_unspent(cli_state->unspent_cache, "UTXOs after mempool:");
+	/* the cache is a view, its outputs are collated to be printed */
+	su_info.total_unspent_amt = 0;
+	su_info.sender_unspent = llist_create(MT_SUPPORT_FALSE);
+	if (!su_info.sender_unspent ||
+	    unspentViewForEach(&(cli_state->unspent_cache),
+			       (node_func_t)findAllSenderUnspent,
+			       &su_info) != 0)
+	{
+		fprintf(stderr, "print_info_blockchain_full: %s\n",
+			"unspentViewForEach failure");
+		llist_destroy(su_info.sender_unspent, 0, NULL);
+		return (1);
+	}
+	_print_all_unspent(su_info.sender_unspent, "UTXOs after mempool:");
+	llist_destroy(su_info.sender_unspent, 0, NULL);
 	_blockchain_print(cli_state->blockchain);
 	if (!component)
 		printf(INFO_FMT_FTR);
@@ -294,6 +365,117 @@ int print_info_blockchain_full(int component, cli_state_t *cli_state)
 }
 
 
+/**
+ * parseBlockId - parses the id of a block given by the user, shared by
+ *   `info block` and `block_info`
+ *
+ * @id: height of the block in decimal, or its hash in hex
+ * @height: modified by reference to the height parsed, if any
+ * @hash: modified by reference to the hash parsed, if any
+ *
+ * Return: 0 if `id` is a height, 1 if it is a hash, or -1 if malformed
+ */
+int parseBlockId(char const *id, uint32_t *height,
+		 uint8_t hash[SHA256_DIGEST_LENGTH])
+{
+	unsigned long h;
+	unsigned int byte;
+	size_t i, len = strlen(id), digits;
+
+	for (i = 0, digits = 0; i < len; i++)
+		digits += isdigit(id[i]) != 0;
+	/* heights fit in 10 digits, hashes take 64 */
+	if (len && digits == len && len <= 10)
+	{
+		h = strtoul(id, NULL, 10);
+		if (h > UINT32_MAX)
+			return (-1);
+		*height = (uint32_t)h;
+		return (0);
+	}
+
+	if (len != SHA256_DIGEST_LENGTH * 2)
+		return (-1);
+	for (i = 0; i < len; i++)
+		if (!isxdigit(id[i]))
+			return (-1);
+	for (i = 0; i < SHA256_DIGEST_LENGTH; i++)
+	{
+		if (sscanf(id + i * 2, "%2x", &byte) != 1)
+			return (-1);
+		hash[i] = (uint8_t)byte;
+	}
+
+	return (1);
+}
+
+
+/**
+ * findBlock - finds a block of the session blockchain by height or by hash,
+ *   in constant time when the chain is indexed
+ *
+ * @id: height of the block in decimal, or its hash in hex
+ * @blockchain: blockchain to search
+ *
+ * Return: pointer to the block, or NULL if not found or `id` is malformed
+ */
+static block_t *findBlock(char *id, blockchain_t *blockchain)
+{
+	uint8_t hash[SHA256_DIGEST_LENGTH];
+	uint32_t height;
+
+	switch (parseBlockId(id, &height, hash))
+	{
+	case 0:
+		return (chainBlockAt(blockchain, height));
+	case 1:
+		return (chainBlockByHash(blockchain, hash));
+	default:
+		return (NULL);
+	}
+}
+
+
+/**
+ * print_info_block - prints a single block of the current session
+ *   blockchain
+ *
+ * @id: user provided height of the block in decimal, or its hash in hex
+ * @cli_state: pointer to struct containing information about the cli and
+ *   blockchain in use
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int print_info_block(char *id, cli_state_t *cli_state)
+{
+	block_t *block;
+
+	if (!cli_state)
+	{
+		fprintf(stderr, "print_info_block: NULL parameter\n");
+		return (1);
+	}
+
+	if (!id)
+	{
+		printf(TAB4 "Usage: info block <height / hash>\n");
+		return (1);
+	}
+
+	block = findBlock(id, cli_state->blockchain);
+	if (!block)
+	{
+		printf(TAB4 "No block at height or of hash '%s'\n", id);
+		return (1);
+	}
+
+	printf(INFO_BLOCK_FMT_HDR, block->info.index);
+	_block_print_single(block);
+	printf(INFO_FMT_FTR);
+	return (0);
+}
+
+
 /**
  * print_info_full - prints information about the current session wallet,
  *   mempool, and blockchain, listing out the contents of each
@@ -325,9 +507,10 @@ int print_info_full(cli_state_t *cli_state)
  * cmd_info - displays information about the current wallet, blockchain and
  *   mempool
  *
- * @arg1: "wallet", "mempool", "blockchain", "full", or NULL, determines what
- *   aspect of the state to display
- * @arg2: "full" or NULL, determines what amount of info to display
+ * @arg1: "wallet", "mempool", "blockchain", "block", "full", or NULL,
+ *   determines what aspect of the state to display
+ * @arg2: "full" or NULL, determines what amount of info to display; height
+ *   or hash of the block to display for "block"
  * @cli_state: pointer to struct containing information about the cli and
  *   blockchain in use
  *
@@ -336,7 +519,8 @@ int print_info_full(cli_state_t *cli_state)
 int cmd_info(char *arg1, char *arg2, cli_state_t *cli_state)
 {
 	char *usage =
-		"Usage: info [full]/info [wallet/mempool/blockchain] [full]\n";
+		"Usage: info [full]/info [wallet/mempool/blockchain] [full]"
+		"/info block <height / hash>\n";
 
 	if (!cli_state)
 	{
@@ -379,6 +563,8 @@ int cmd_info(char *arg1, char *arg2, cli_state_t *cli_state)
 		printf(TAB4 "%s", usage);
 		return (1);
 	}
+	if (strncmp("block", arg1, strlen("block") + 1) == 0)
+		return (print_info_block(arg2, cli_state));
 	if (strncmp("full", arg1, strlen("full") + 1) == 0)
 		return (print_info_full(cli_state));
 
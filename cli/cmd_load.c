@@ -18,6 +18,9 @@
  * @path: user provided path to the file from which to load the blockchain,
  *   or NULL for the default
  * @arg2: dummy arg to conform to cmd_fp_t typedef
+ *
+ * Note: blocks journaled since the file was saved (see cmd_save) are
+ *   replayed, and later mined blocks are appended to the same journal
  * @cli_state: pointer to struct containing information about the cli and
  *   blockchain in use
  *
@@ -27,6 +30,7 @@ int cmd_load(char *path, char *arg2, cli_state_t *cli_state)
 {
 	struct stat st;
 	blockchain_t *prev_blockchain;
+	bc_journal_t *journal;
 
 	(void)arg2;
 	if (!cli_state)
@@ -47,23 +51,38 @@ int cmd_load(char *path, char *arg2, cli_state_t *cli_state)
 		       path, strerror(errno));
 		return (1);
 	}
-	else if (!S_ISREG(st.st_mode))
+	else if (!S_ISREG(st.st_mode) && !S_ISFIFO(st.st_mode))
 	{
 		printf(TAB4 "Failed to load blockchain from '%s': %s\n",
-		       path, "Not a regular file");
+		       path, "Not a regular file or pipe");
 		return (1);
 	}
 
 	prev_blockchain = cli_state->blockchain;
 	cli_state->blockchain = blockchain_deserialize(path);
-	if (!cli_state->blockchain)
+	if (!cli_state->blockchain ||
+	    bcJournalReplay(path, cli_state->blockchain, &journal) != 0)
 	{
 		printf(TAB4 "Failed to load blockchain from '%s'\n", path);
+		if (cli_state->blockchain)
+			blockchain_destroy(cli_state->blockchain);
+		cli_state->blockchain = prev_blockchain;
 		return (1);
 	}
 
 	printf(TAB4 "Loaded blockchain from '%s'\n", path);
+	bcJournalClose(cli_state->journal);
+	cli_state->journal = journal;
+	if (journal)
+		printf(TAB4 "Journaling mined blocks to '%s" HJNL_EXT "'\n",
+		       path);
 	if (prev_blockchain)
 		blockchain_destroy(prev_blockchain);
+	cli_state->mempool_valid = 0;
+
+	/* the cache is a view of the previous blockchain->unspent */
+	if (refreshUnspentCache(cli_state) != 0)
+		return (1);
+
 	return (0);
 }
@@ -19,18 +19,18 @@
  * readMplFileHdr - reads and validates a serialized file header from a
  *   file storing a blockchain
  *
- * @fd: file descriptor already open for reading
+ * @reader: pointer to reader over the mapped file
  * @local_endianness: 1 for little endian, 2 for big endian
  * @header: stores values read from file header
  *
  * Return: 0 on success, or 1 upon failure
  */
-int readMplFileHdr(int fd, uint8_t local_endianness,
+int readMplFileHdr(bc_reader_t *reader, uint8_t local_endianness,
 		   mpl_file_hdr_t *header)
 {
-	if (!header)
+	if (!reader || !header)
 	{
-		fprintf(stderr, "readMplFileHdr: NULL parameter\n");
+		fprintf(stderr, "readMplFileHdr: NULL parameter(s)\n");
 		return (1);
 	}
 	if (local_endianness != 1 && local_endianness != 2)
@@ -39,9 +39,9 @@ int readMplFileHdr(int fd, uint8_t local_endianness,
 			"readMplFileHdr: invalid local_endianness\n");
 		return (1);
 	}
-	if (read(fd, header, sizeof(mpl_file_hdr_t)) == -1)
+	if (bcReaderTake(reader, header, sizeof(mpl_file_hdr_t)) != 0)
 	{
-		perror("readMplFileHdr: read");
+		fprintf(stderr, "readMplFileHdr: bcReaderTake failure\n");
 		return (1);
 	}
 	if (memcmp(&(header->hmpl_magic), HMPL_MAG, HMPL_MAG_LEN) != 0)
@@ -50,7 +50,7 @@ int readMplFileHdr(int fd, uint8_t local_endianness,
 			"readMplFileHdr: invalid magic number\n");
 		return (1);
 	}
-	if (memcmp(&(header->hblk_version), HBLK_VER, HBLK_VER_LEN) != 0)
+	if (!hblkVerCompat(header->hblk_version))
 	{
 		fprintf(stderr, "readMplFileHdr: %s\n",
 			"serialized with incompatible version number");
@@ -83,6 +83,7 @@ llist_t *mempool_deserialize(char const *path)
 	struct stat st;
 	uint8_t local_endianness;
 	mpl_file_hdr_t header;
+	bc_reader_t reader;
 	llist_t *mempool;
 
 	if (!path)
@@ -112,12 +113,20 @@ llist_t *mempool_deserialize(char const *path)
 	{
 		fprintf(stderr, "mempool_deserialize: open '%s': %s\n", path,
 			strerror(errno));
+		return (NULL);
 	}
+	/* the mapping outlives the file descriptor */
+	if (bcReaderMap(&reader, fd) != 0)
+	{
+		close(fd);
+		return (NULL);
+	}
+	close(fd);
 
 	local_endianness = _get_endianness();
-	if (readMplFileHdr(fd, local_endianness, &header) != 0)
+	if (readMplFileHdr(&reader, local_endianness, &header) != 0)
 	{
-		close(fd);
+		bcReaderUnmap(&reader);
 		return (NULL);
 	}
 
@@ -127,19 +136,19 @@ llist_t *mempool_deserialize(char const *path)
 		fprintf(stderr,
 			"mempool_deserialize: llist_create: %s\n",
 			strE_LLIST(llist_errno));
-		close(fd);
+		bcReaderUnmap(&reader);
 		return (NULL);
 	}
 
-	if (readTransactions(fd, mempool, header.hmpl_txs, local_endianness,
-			     header.hmpl_endian) != 0)
+	if (readTransactions(&reader, mempool, header.hmpl_txs,
+			     local_endianness, header.hmpl_endian, NULL) != 0)
 	{
-		close(fd);
+		bcReaderUnmap(&reader);
 		llist_destroy(mempool, 1, (node_dtor_t)transaction_destroy);
 		return (NULL);
 	}
 
-	close(fd);
+	bcReaderUnmap(&reader);
 	return (mempool);
 }
 
@@ -198,5 +207,10 @@ int cmd_mempool_load(char *path, char *arg2, cli_state_t *cli_state)
 	llist_destroy(cli_state->mempool, 1,
 		      (node_dtor_t)transaction_destroy);
 	cli_state->mempool = new_mempool;
+	cli_state->mempool_valid = 0;
+
+	if (refreshUnspentCache(cli_state) != 0)
+		return (1);
+
 	return (0);
 }
@@ -1,6 +1,6 @@
-/* mpl_file_hdr_t HMPL_MAG MEMPOOL_PATH_DFLT */
+/* mpl_file_hdr_t HMPL_MAG HMPL_VER MEMPOOL_PATH_DFLT */
 #include "hblk_cli.h"
-/* printf fprintf perror write remove */
+/* printf fprintf perror remove */
 #include <stdio.h>
 /* lstat `struct stat` */
 #include <sys/types.h>
@@ -19,7 +19,7 @@
  * writeMplFileHdr - writes a serialized file header to a file for storage
  *   of a blockchain mempool
  *
- * @fd: file descriptor open for writing
+ * @writer: pointer to buffered output of a file open for writing
  * @mempool: pointer to the blockchain mempool to be serialized
  *
  * File Header format:
@@ -37,14 +37,14 @@
  *
  * Return: 0 on success, or 1 upon failure
  */
-int writeMplFileHdr(int fd, const llist_t *mempool)
+int writeMplFileHdr(bc_writer_t *writer, const llist_t *mempool)
 {
-	mpl_file_hdr_t header = { HMPL_MAG, HBLK_VER, 0, 0 };
+	mpl_file_hdr_t header = { HMPL_MAG, HMPL_VER, 0, 0 };
 	int tx_ct;
 
-	if (!mempool)
+	if (!writer || !mempool)
 	{
-		fprintf(stderr, "writeMplFileHdr: NULL parameter\n");
+		fprintf(stderr, "writeMplFileHdr: NULL parameter(s)\n");
 		return (1);
 	}
 
@@ -65,9 +65,9 @@ int writeMplFileHdr(int fd, const llist_t *mempool)
 	}
 	header.hmpl_txs = (uint32_t)tx_ct;
 
-	if (write(fd, &header, sizeof(mpl_file_hdr_t)) == -1)
+	if (bcWriterPut(writer, &header, sizeof(mpl_file_hdr_t)) != 0)
 	{
-		perror("writeMplFileHdr: write");
+		fprintf(stderr, "writeMplFileHdr: bcWriterPut failure\n");
 		return (1);
 	}
 
@@ -94,6 +94,7 @@ int writeMplFileHdr(int fd, const llist_t *mempool)
  */
 int mempool_serialize(const llist_t *mempool, const char *path)
 {
+	bc_writer_t writer;
 	int fd;
 
 	if (!mempool || !path)
@@ -105,8 +106,9 @@ int mempool_serialize(const llist_t *mempool, const char *path)
 	fd = pathToWriteFD(path);
 	if (fd == -1)
 		return (-1);
+	bcWriterInit(&writer, fd);
 
-	if (writeMplFileHdr(fd, mempool) != 0)
+	if (writeMplFileHdr(&writer, mempool) != 0)
 	{
 		close(fd);
 		remove(path);
@@ -114,7 +116,7 @@ int mempool_serialize(const llist_t *mempool, const char *path)
 	}
 
 	if (llist_for_each((llist_t *)mempool,
-			   (node_func_t)writeTransaction, &fd) < 0)
+			   (node_func_t)writeTransaction, &writer) < 0)
 	{
 		fprintf(stderr,
 			"blockchain_serialize: llist_for_each failure\n");
@@ -123,7 +125,20 @@ int mempool_serialize(const llist_t *mempool, const char *path)
 		return (-1);
 	}
 
-	close(fd);
+	if (bcWriterFlush(&writer) != 0)
+	{
+		close(fd);
+		remove(path);
+		return (-1);
+	}
+
+	if (close(fd) == -1)
+	{
+		perror("mempool_serialize: close");
+		remove(path);
+		return (-1);
+	}
+
 	return (0);
 }
 
@@ -2,22 +2,29 @@
 #include "hblk_cli.h"
 /* printf fprintf */
 #include <stdio.h>
-/* strerror memcmp */
+/* strerror memcmp memset strlen */
 #include <string.h>
 /* time */
 #include <time.h>
+/* isdigit */
+#include <ctype.h>
+/* atoi calloc free */
+#include <stdlib.h>
 
 
 /**
  * mempoolTxToBlock - used as `action` for llist_for_each to visit each
  *   pending transaction in a mempool, and add the verified ones to a
- *   new block to be mined
+ *   new block to be mined, in mempool order, up to MINE_TXS_MAX and leaving
+ *   out those spending an output already spent by the block, as found
+ *   through mtb_info->view
  *
  * @tx: pointer to a transaction in the mempool, as iterated through by
  *   llist_for_each
  * @idx: index of `tx` in the mempool, as iterated through by llist_for_each
- * @mtb_info: pointer to struct containing the new block and the list of
- *   unspent transaction outputs
+ * @mtb_info: pointer to struct containing the new block, the view of the
+ *   unspent transaction outputs left by the block and the verdict on each
+ *   transaction, set to MP_TX_MINED for those added
  *
  * Return: 0 on incremental success (llist_for_each can continue,)
  *   or -2 on failure (-1 reserved for llist_for_each errors)
@@ -25,7 +32,7 @@
 static int mempoolTxToBlock(transaction_t *tx, unsigned int idx,
 			    mtb_info_t *mtb_info)
 {
-	(void)idx;
+	int ret;
 
 	if (!tx || !mtb_info)
 	{
@@ -33,7 +40,14 @@ static int mempoolTxToBlock(transaction_t *tx, unsigned int idx,
 		return (-2);
 	}
 
-	if (transaction_is_valid(tx, mtb_info->unspent))
+	if (mtb_info->valid[idx] != MP_TX_VALID ||
+	    mtb_info->mined_ct >= MINE_TXS_MAX)
+		return (0);
+	/* outputs of `tx` are not spendable until the block hash is known */
+	ret = unspentViewApply(&(mtb_info->view), tx, NULL);
+	if (ret < 0)
+		return (-2);
+	if (ret == 0)
 	{
 		if (llist_add_node(mtb_info->new_block->transactions,
 				   tx, ADD_NODE_REAR) != 0)
@@ -42,6 +56,8 @@ static int mempoolTxToBlock(transaction_t *tx, unsigned int idx,
 				strE_LLIST(llist_errno));
 			return (-2);
 		}
+		mtb_info->valid[idx] = MP_TX_MINED;
+		mtb_info->mined_ct++;
 	}
 
 	return (0);
@@ -49,24 +65,145 @@ static int mempoolTxToBlock(transaction_t *tx, unsigned int idx,
 
 
 /**
- * cmd_mine - mines a new block in the blockchain: includes all valid
- *   transactions currently in the mempool plus a coinbase transaction, sets
- *   block difficulty, finds a matching hash and adds the block to the chain
+ * verifyNew - checks the validity of the mempool transactions not found
+ *   valid yet, verifying their signatures in parallel
+ *
+ * @mtb_info: pointer to struct containing the mempool index, the unspent
+ *   outputs and the verdict on each mempool transaction, amended from
+ *   `known` onwards
+ * @known: amount of leading mempool transactions already found valid
+ * @thread_ct: amount of verifying threads, see transactionsVerify
+ *
+ * Return: 0 on success, 1 on failure
+ */
+static int verifyNew(mtb_info_t *mtb_info, unsigned int known,
+		     unsigned int thread_ct)
+{
+	llist_t *txs;
+	unsigned int i;
+	int ret = 0;
+
+	for (i = 0; i < known; i++)
+		mtb_info->valid[i] = MP_TX_VALID;
+	if (known == mtb_info->index.tx_ct)
+		return (0);
+	txs = llist_create(MT_SUPPORT_FALSE);
+	if (!txs)
+	{
+		fprintf(stderr, "verifyNew: llist_create: %s\n",
+			strE_LLIST(llist_errno));
+		return (1);
+	}
+	for (i = known; i < mtb_info->index.tx_ct && !ret; i++)
+		ret = llist_add_node(txs, mtb_info->index.txs[i],
+				     ADD_NODE_REAR) != 0;
+	if (ret || transactionsVerify(txs, mtb_info->blockchain->unspent,
+				      mtb_info->blockchain->unspent_index,
+				      thread_ct, mtb_info->valid + known) != 0)
+	{
+		fprintf(stderr, "verifyNew: failed to verify mempool\n");
+		ret = 1;
+	}
+	for (i = known; i < mtb_info->index.tx_ct && !ret; i++)
+		mtb_info->valid[i] = mtb_info->valid[i] > 0 ?
+			MP_TX_VALID : MP_TX_INVALID;
+	llist_destroy(txs, 0, NULL);
+
+	return (ret);
+}
+
+
+/**
+ * mempoolVerify - indexes the mempool, starts a view of the blockchain
+ *   unspent outputs for the new block, and checks the validity of the
+ *   mempool transactions against those outputs; only those added since the
+ *   mempool was last rebuilt are verified, see verifyNew
+ *
+ * @cli_state: pointer to struct containing information about the cli and
+ *   blockchain in use
+ * @thread_ct: amount of verifying threads, or 0 for one per online processor
+ * @mtb_info: pointer to struct whose `index` and `view` members are filled,
+ *   and whose `valid` member is set to a newly allocated array of the
+ *   MP_TX_* verdict on each mempool transaction
+ *
+ * Return: 0 on success, 1 on failure
+ */
+static int mempoolVerify(cli_state_t *cli_state, unsigned int thread_ct,
+			 mtb_info_t *mtb_info)
+{
+	int tx_ct = llist_size(cli_state->mempool), known;
+
+	mtb_info->valid = NULL;
+	mtb_info->mined_ct = 0;
+	memset(&(mtb_info->index), 0, sizeof(mp_index_t));
+	memset(&(mtb_info->view), 0, sizeof(utxo_view_t));
+	if (tx_ct < 0 || mempoolIndexBuild(cli_state->mempool,
+					   &(mtb_info->index)) != 0 ||
+	    unspentViewInit(&(mtb_info->view), mtb_info->blockchain->unspent,
+			    mtb_info->blockchain->unspent_index) != 0)
+		return (1);
+	mtb_info->valid = calloc(tx_ct ? tx_ct : 1, sizeof(int8_t));
+	if (!mtb_info->valid)
+	{
+		fprintf(stderr, "mempoolVerify: calloc failure\n");
+		return (1);
+	}
+	known = cli_state->mempool_valid < tx_ct ?
+		cli_state->mempool_valid : tx_ct;
+
+	return (verifyNew(mtb_info, (unsigned int)known, thread_ct));
+}
+
+
+/**
+ * mineAbort - deletes a block whose mining failed before it was added to
+ *   the blockchain, leaving the mempool transactions it contains to the
+ *   mempool
  *
- * @arg1: dummy arg to conform to cmd_fp_t typedef
+ * @new_block: block to delete
+ * @coinbase: coinbase transaction of `new_block`, or NULL if not created yet
+ * @mtb_info: pointer to struct containing the mempool index, view and
+ *   verdicts
+ */
+static void mineAbort(block_t *new_block, transaction_t *coinbase,
+		      mtb_info_t *mtb_info)
+{
+	if (coinbase)
+		transaction_destroy(coinbase);
+	/* the other transactions are still owned by the mempool */
+	llist_destroy(new_block->transactions, 0, NULL);
+	new_block->transactions = NULL;
+	free(new_block);
+	unspentViewFree(&(mtb_info->view));
+	mempoolIndexFree(&(mtb_info->index));
+	free(mtb_info->valid);
+}
+
+
+/**
+ * cmd_mine - mines a new block in the blockchain: includes up to
+ *   MINE_TXS_MAX valid transactions currently in the mempool plus a coinbase
+ *   transaction, sets block difficulty, finds a matching hash and adds the
+ *   block to the chain; the mempool then keeps the transactions left out
+ *   which are still valid, see mempoolRetain
+ *
+ * @threads: user provided amount of mining threads; expecting string
+ *   representing positive integer, or NULL for one per online processor
  * @arg2: dummy arg to conform to cmd_fp_t typedef
  * @cli_state: pointer to struct containing information about the cli and
  *   blockchain in use
  *
  * Return: 0 on success, 1 on failure
  */
-int cmd_mine(char *arg1, char *arg2, cli_state_t *cli_state)
+int cmd_mine(char *threads, char *arg2, cli_state_t *cli_state)
 {
 	block_t *prev_block, *new_block;
 	transaction_t *coinbase;
 	mtb_info_t mtb_info;
+	unsigned int thread_ct = BLOCK_MINE_THREADS_DFLT;
+	size_t i;
+	int journaled;
 
-	(void)arg1;
 	(void)arg2;
 	if (!cli_state)
 	{
@@ -74,6 +211,19 @@ int cmd_mine(char *arg1, char *arg2, cli_state_t *cli_state)
 		return (1);
 	}
 
+	if (threads)
+	{
+		for (i = 0; i < strlen(threads); i++)
+		{
+			if (!isdigit(threads[i]))
+			{
+				printf(TAB4 "Usage: mine [<threads>]\n");
+				return (1);
+			}
+		}
+		thread_ct = (unsigned int)atoi(threads);
+	}
+
 	prev_block = (block_t *)llist_get_tail(cli_state->blockchain->chain);
 	if (!prev_block)
 	{
@@ -88,64 +238,64 @@ int cmd_mine(char *arg1, char *arg2, cli_state_t *cli_state)
 		return (1);
 	}
 
-	/* add valid mempool txs to block */
+	/* add valid mempool txs to block, the others stay in the mempool */
 	mtb_info.new_block = new_block;
-	mtb_info.unspent = cli_state->blockchain->unspent;
-	if (llist_for_each(cli_state->mempool,
+	mtb_info.blockchain = cli_state->blockchain;
+	if (mempoolVerify(cli_state, thread_ct, &mtb_info) != 0 ||
+	    llist_for_each(cli_state->mempool,
 			   (node_func_t)mempoolTxToBlock, &mtb_info) != 0)
 	{
-		block_destroy(new_block);
+		mineAbort(new_block, NULL, &mtb_info);
 		fprintf(stderr, "cmd_mine: llist_for_each failure\n");
 		return (1);
 	}
-	/* delete all remaining unvalidated mempool transactions */
-	llist_destroy(cli_state->mempool, 1, (node_dtor_t)transaction_destroy);
-	cli_state->mempool = llist_create(MT_SUPPORT_FALSE);
+	unspentViewFree(&(mtb_info.view));
 
 	new_block->info.difficulty =
 		blockchain_difficulty(cli_state->blockchain);
 	new_block->info.timestamp = (uint64_t)time(NULL);
 
 	coinbase = coinbase_create(cli_state->wallet, new_block->info.index);
-	if (!coinbase)
+	if (!coinbase || llist_add_node(new_block->transactions, coinbase,
+					ADD_NODE_FRONT) != 0)
 	{
-		fprintf(stderr, "cmd_mine: coinbase_create failure\n");
+		fprintf(stderr, "cmd_mine: failed to add coinbase\n");
+		mineAbort(new_block, coinbase, &mtb_info);
 		return (1);
 	}
-	llist_add_node(new_block->transactions, coinbase, ADD_NODE_FRONT);
 
-	block_mine(new_block);
+	block_mine_mt(new_block, thread_ct);
 	if (block_is_valid(new_block, prev_block,
 			   cli_state->blockchain->unspent) != 0)
 	{
 		printf(TAB4 "Failed to mine block at index: %u\n",
 		       new_block->info.index);
-		block_destroy(new_block);
+		mineAbort(new_block, coinbase, &mtb_info);
 		return (1);
 	}
 
-	cli_state->blockchain->unspent =
-		update_unspent(new_block->transactions,
-			       new_block->hash,
-			       cli_state->blockchain->unspent);
-	if (!cli_state->blockchain->unspent)
+	if (!updateUnspent(new_block->transactions, new_block->hash,
+			   cli_state->blockchain->unspent,
+			   cli_state->blockchain->unspent_index))
 	{
-		fprintf(stderr, "cmd_mine: update_unspent failure\n");
-		block_destroy(new_block);
+		fprintf(stderr, "cmd_mine: updateUnspent failure\n");
+		mineAbort(new_block, coinbase, &mtb_info);
 		return (1);
 	}
 
-	if (refreshUnspentCache(cli_state) != 0)
-	{
-		fprintf(stderr, "cmd_mine: refreshUnspentCache failure\n");
-		block_destroy(new_block);
-		return (1);
-	}
+	/* the block now owns its txs, the rest are rechecked if it spent */
+	/* or created an output they reference, and the cache amended */
+	if (mempoolRetain(cli_state, new_block, &(mtb_info.index),
+			  mtb_info.valid, thread_ct) != 0)
+		fprintf(stderr, "cmd_mine: mempoolRetain failure\n");
+	/* every transaction kept was found valid against the new outputs */
+	cli_state->mempool_valid = llist_size(cli_state->mempool);
+	mempoolIndexFree(&(mtb_info.index));
+	free(mtb_info.valid);
 
-	if (llist_add_node(cli_state->blockchain->chain,
-			   new_block, ADD_NODE_REAR) != 0)
+	if (chainAdd(cli_state->blockchain, new_block) != 0)
 	{
-		fprintf(stderr, "cmd_mine: llist_add_node failure\n");
+		fprintf(stderr, "cmd_mine: chainAdd failure\n");
 		block_destroy(new_block);
 		return (1);
 	}
@@ -153,5 +303,20 @@ int cmd_mine(char *arg1, char *arg2, cli_state_t *cli_state)
 	printf(TAB4 "Block mined: [%u] ", new_block->info.difficulty);
 	_print_hex_buffer(new_block->hash, SHA256_DIGEST_LENGTH);
 	printf("\n");
+
+	if (!cli_state->journal)
+		return (0);
+	journaled = bcJournalAppend(cli_state->journal, new_block,
+				    cli_state->blockchain->unspent);
+	if (journaled == 2)
+		printf(TAB4 "Failed to checkpoint journal, %s\n",
+		       "retrying with next block");
+	else if (journaled != 0)
+	{
+		printf(TAB4 "Failed to journal block, journaling stopped\n");
+		bcJournalClose(cli_state->journal);
+		cli_state->journal = NULL;
+		return (1);
+	}
 	return (0);
 }
@@ -71,6 +71,10 @@ int cmd_new_blockchain(cli_state_t *cli_state)
 	if (cli_state->blockchain)
 		blockchain_destroy(cli_state->blockchain);
 	cli_state->blockchain = new_blockchain;
+	cli_state->mempool_valid = 0;
+	/* the journal extends the previous blockchain file */
+	bcJournalClose(cli_state->journal);
+	cli_state->journal = NULL;
 	printf(TAB4 "Created new blockchain for session\n");
 
 	if (refreshUnspentCache(cli_state) != 0)
@@ -111,6 +115,7 @@ int cmd_new_mempool(cli_state_t *cli_state)
 			      (node_dtor_t)transaction_destroy);
 	}
 	cli_state->mempool = new_mempool;
+	cli_state->mempool_valid = 0;
 	printf(TAB4 "Created new empty mempool for session\n");
 
 	if (refreshUnspentCache(cli_state) != 0)
@@ -7,36 +7,70 @@
 #include <sys/stat.h>
 /* lstat */
 #include <unistd.h>
-/* strlen strerror */
+/* strlen strerror strcmp */
 #include <string.h>
 /* PATH_MAX */
 #include <linux/limits.h>
 
 
+/**
+ * parseSync - parses the journal sync policy argument of `save`
+ *
+ * @sync: user provided policy: "always", "checkpoint" or "never"
+ * @policy: modified by reference to the matching bc_sync_t
+ *
+ * Return: 0 on success, 1 if `sync` is not a policy
+ */
+static int parseSync(char const *sync, bc_sync_t *policy)
+{
+	if (strcmp(sync, "always") == 0)
+		*policy = BC_SYNC_ALWAYS;
+	else if (strcmp(sync, "checkpoint") == 0)
+		*policy = BC_SYNC_CHECKPOINT;
+	else if (strcmp(sync, "never") == 0)
+		*policy = BC_SYNC_NEVER;
+	else
+		return (1);
+
+	return (0);
+}
+
+
 /**
  * cmd_save - saves a blockchain from the current CLI session to a given path
  *
  * @path: user provided path to the file from which to load the blockchain,
  *   or NULL for the default
- * @arg2: dummy arg to conform to cmd_fp_t typedef
+ * @sync: user provided journal sync policy, or NULL to save without
+ *   journaling the blocks mined afterwards
  * @cli_state: pointer to struct containing information about the cli and
  *   blockchain in use
  *
+ * Note: the whole blockchain is written either way; with a sync policy, later
+ *   mined blocks are then only appended to a journal next to the file, see
+ *   bcJournalCreate
+ *
  * Return: 0 on success, 1 on failure
  */
-int cmd_save(char *path, char *arg2, cli_state_t *cli_state)
+int cmd_save(char *path, char *sync, cli_state_t *cli_state)
 {
 	struct stat st;
 	char dir_path[PATH_MAX];
 	int64_t i;
+	bc_sync_t policy = BC_SYNC_NEVER;
 
-	(void)arg2;
 	if (!cli_state)
 	{
 		fprintf(stderr, "cmd_save: NULL cli_state parameter\n");
 		return (1);
 	}
 
+	if (sync && parseSync(sync, &policy) != 0)
+	{
+		printf(TAB4 "Usage: save [<path> [always|checkpoint|never]]\n");
+		return (1);
+	}
+
 	if (!path || !path[0])
 	{
 		printf(TAB4 "No blockchain file path provided, using default\n");
@@ -78,5 +112,18 @@ int cmd_save(char *path, char *arg2, cli_state_t *cli_state)
 	}
 
 	printf(TAB4 "Saved blockchain to '%s'\n", path);
+	/* any journal extended the previous contents of a file */
+	bcJournalClose(cli_state->journal);
+	cli_state->journal = NULL;
+	if (!sync)
+		return (bcJournalRemove(path));
+	cli_state->journal = bcJournalCreate(path, cli_state->blockchain,
+					     policy);
+	if (!cli_state->journal)
+	{
+		printf(TAB4 "Failed to start journal '%s" HJNL_EXT "'\n", path);
+		return (1);
+	}
+	printf(TAB4 "Journaling mined blocks to '%s" HJNL_EXT "'\n", path);
 	return (0);
 }
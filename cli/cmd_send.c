@@ -2,7 +2,7 @@
 #include "hblk_cli.h"
 /* printf fprintf */
 #include <stdio.h>
-/* strerror memcmp */
+/* strerror strlen */
 #include <string.h>
 /* isdigit */
 #include <ctype.h>
@@ -10,54 +10,6 @@
 #include <stdlib.h>
 
 
-/**
- * findSenderUnspent - used as `action` for llist_for_each to visit each
- *   unspent output in the blockchain, and add unspent outputs
- *   with a matching public key to a collated list of potential inputs
- *
- * @unspent_tx_out: pointer to unspent output in blockchain->unspent list,
- *   as iterated through by llist_for_each
- * @idx: index of `unspent_tx_out` in blockchain->unspent list, as
- *   iterated through by llist_for_each
- * @su_info: pointer to struct containing all parameters necessary to build a
- *   second list of unspent transactions for a particular public key
- *
- * Return: 0 on incremental success (llist_for_each can continue,)
- *   1 on total success (llist_for_each can end,)
- *   and -2 on failure (-1 reserved for llist_for_each errors)
- */
-static int findSenderUnspent(unspent_tx_out_t *unspent_tx_out,
-			     unsigned int idx, su_info_t *su_info)
-{
-	(void)idx;
-
-	if (!unspent_tx_out || !su_info)
-	{
-		fprintf(stderr, "findSenderUnspent: NULL parameter(s)\n");
-		return (-2);
-	}
-
-	if (memcmp(unspent_tx_out->out.pub, su_info->sender_pub,
-		   EC_PUB_LEN) == 0)
-	{
-		if (llist_add_node(su_info->sender_unspent,
-				   unspent_tx_out, ADD_NODE_REAR) != 0)
-		{
-			fprintf(stderr, "findSenderUnspent: %s\n",
-				"llist_add_node failure");
-			return (-2);
-		}
-
-		su_info->total_unspent_amt += unspent_tx_out->out.amount;
-
-		if (su_info->total_unspent_amt >= su_info->send_amt)
-			return (1); /* sufficient to cover spending */
-	}
-
-	return (0);
-}
-
-
 /**
  * pubKeyHexToByteArray - converts a EC_KEY public key in a lowercase or
  *   uppercase hex string to a byte array
@@ -161,9 +113,9 @@ int cmd_send(char *amount, char *address, cli_state_t *cli_state)
 {
 	EC_KEY *receiver;
 	transaction_t *tx;
-	uint8_t *pub;
-	su_info_t su_info;
-	int amt;
+	uint8_t *pub, sender_pub[EC_PUB_LEN];
+	uint64_t balance;
+	int amt, ret = 0;
 	size_t i;
 
 	if (!cli_state)
@@ -188,31 +140,22 @@ int cmd_send(char *amount, char *address, cli_state_t *cli_state)
 	}
 	amt = atoi(amount);
 
-	su_info.sender_unspent = llist_create(MT_SUPPORT_FALSE);
-	if (!su_info.sender_unspent)
-	{
-		fprintf(stderr, "cmd_send: llist_create failure\n");
-		return (1);
-	}
-	if (!ec_to_pub(cli_state->wallet, su_info.sender_pub))
+	if (!ec_to_pub(cli_state->wallet, sender_pub))
 	{
 		fprintf(stderr, "cmd_send: ec_to_pub failure\n");
 		return (1);
 	}
-	su_info.send_amt = (uint32_t)amt;
-	su_info.total_unspent_amt = 0;
-	if (llist_for_each(cli_state->unspent_cache,
-			   (node_func_t)findSenderUnspent, &su_info) < 0)
+	if (unspentViewBalance(&(cli_state->unspent_cache), sender_pub,
+			       &balance, NULL) != 0)
 	{
-		fprintf(stderr, "cmd_send: llist_for_each failure\n");
+		fprintf(stderr, "cmd_send: unspentViewBalance failure\n");
 		return (1);
 	}
-	llist_destroy(su_info.sender_unspent, 0, NULL);
-	if (su_info.total_unspent_amt < (uint32_t)amt)
+	if (balance < (uint64_t)amt)
 	{
-		printf(TAB4 TAB4 "%s total %u insufficient to send %i\n",
+		printf(TAB4 TAB4 "%s total %lu insufficient to send %i\n",
 		       "Wallet confirmed unspent output",
-		       su_info.total_unspent_amt, amt);
+		       (unsigned long)balance, amt);
 		return (1);
 	}
 
@@ -232,15 +175,20 @@ int cmd_send(char *amount, char *address, cli_state_t *cli_state)
 		return (1);
 	}
 
-	tx = transaction_create(cli_state->wallet, receiver, amt,
-				cli_state->unspent_cache);
+	tx = txCreateFromView(cli_state->wallet, receiver, amt,
+			      &(cli_state->unspent_cache));
 	EC_KEY_free(receiver);
-	if (!tx || !transaction_is_valid(tx, cli_state->unspent_cache) ||
-	    llist_for_each(tx->inputs, (node_func_t)delRfrncdOutput,
-			   cli_state->unspent_cache) < 0)
+	/* outputs spent by tx are hidden in the cache once it is valid */
+	if (!tx || !txIsValidVerified(tx, cli_state->blockchain->unspent,
+				      cli_state->blockchain->unspent_index,
+				      NULL) ||
+	    (ret = unspentViewApply(&(cli_state->unspent_cache), tx, NULL)))
 	{
 		if (tx)
 			transaction_destroy(tx);
+		/* a failed application leaves the view to be released */
+		if (ret < 0)
+			refreshUnspentCache(cli_state);
 		printf(TAB4 "Failed to create transaction\n");
 		return (1);
 	}
@@ -251,6 +199,9 @@ int cmd_send(char *amount, char *address, cli_state_t *cli_state)
 		printf(TAB4 "Failed to add transaction to mempool\n");
 		return (1);
 	}
+	/* tx was just found valid, see mempool_valid */
+	if (cli_state->mempool_valid == llist_size(cli_state->mempool) - 1)
+		cli_state->mempool_valid++;
 
 	printf(TAB4 "%s, sending %s to provided public key\n",
 	       "Verified transaction added to mempool", amount);
@@ -0,0 +1,65 @@
+/* TAB4 BC_VALIDATE_THREADS_DFLT */
+#include "hblk_cli.h"
+/* printf fprintf */
+#include <stdio.h>
+/* strlen */
+#include <string.h>
+/* isdigit */
+#include <ctype.h>
+/* atoi */
+#include <stdlib.h>
+
+
+/**
+ * cmd_validate - checks every block in the session blockchain and the
+ *   unspent outputs they add up to, reporting the first invalid block
+ *
+ * @threads: user provided amount of validating threads; expecting string
+ *   representing positive integer, or NULL for one per online processor
+ * @arg2: dummy arg to conform to cmd_fp_t typedef
+ * @cli_state: pointer to struct containing information about the cli and
+ *   blockchain in use
+ *
+ * Return: 0 if the blockchain is valid, 1 if not or on failure
+ */
+int cmd_validate(char *threads, char *arg2, cli_state_t *cli_state)
+{
+	unsigned int thread_ct = BC_VALIDATE_THREADS_DFLT;
+	uint32_t bad_index;
+	int block_ct, ret;
+	size_t i;
+
+	(void)arg2;
+	if (!cli_state)
+	{
+		fprintf(stderr, "cmd_validate: NULL cli_state parameter\n");
+		return (1);
+	}
+
+	if (threads)
+	{
+		for (i = 0; i < strlen(threads); i++)
+		{
+			if (!isdigit(threads[i]))
+			{
+				printf(TAB4 "Usage: validate [<threads>]\n");
+				return (1);
+			}
+		}
+		thread_ct = (unsigned int)atoi(threads);
+	}
+
+	block_ct = llist_size(cli_state->blockchain->chain);
+	ret = blockchain_validate(cli_state->blockchain, thread_ct,
+				  &bad_index);
+	if (ret == -1)
+		printf(TAB4 "Failed to validate blockchain\n");
+	else if (ret == 1 && bad_index < (uint32_t)block_ct)
+		printf(TAB4 "Invalid block at index: %u\n", bad_index);
+	else if (ret == 1)
+		printf(TAB4 "Blocks valid, but unspent outputs do not match\n");
+	else
+		printf(TAB4 "Blockchain valid: %i blocks\n", block_ct);
+
+	return (ret != 0);
+}
@@ -137,57 +137,12 @@ void parseArgs(int argc, char *argv[], cli_state_t *cli_state)
 }
 
 
-/**
- * copyUnspent - used as `action` for llist_for_each to visit each
- *   unspent output in the blockchain, and copy its nodes into the unspent
- *   output cache
- *
- * @utxo: pointer to unspent output in blockchain->unspent list,
- *   as iterated through by llist_for_each
- * @idx: index of `unspent_tx_out` in blockchain->unspent list, as
- *   iterated through by llist_for_each
- * @unspent_cache: pointer to list of unspent output cache
- *
- * Return: 0 on incremental success (llist_for_each can continue,)
- *   1 on total success (llist_for_each can end,)
- *   and -2 on failure (-1 reserved for llist_for_each errors)
- */
-static int copyUnspent(unspent_tx_out_t *utxo,
-		       unsigned int idx, llist_t *unspent_cache)
-{
-	unspent_tx_out_t *utxo_copy;
-
-	(void)idx;
-
-	if (!utxo || !unspent_cache)
-	{
-		fprintf(stderr, "copyUnspent: NULL parameter(s)\n");
-		return (-2);
-	}
-
-	utxo_copy = unspent_tx_out_create(utxo->block_hash,
-					  utxo->tx_id, &(utxo->out));
-	if (!utxo_copy)
-	{
-		fprintf(stderr, "copyUnspent: unspent_tx_out_create failure\n");
-		return (-2);
-	}
-
-	if (llist_add_node(unspent_cache, utxo_copy, ADD_NODE_REAR) != 0)
-	{
-		free(utxo_copy);
-		fprintf(stderr, "copyUnspent: %s\n",
-			"llist_add_node failure");
-		return (-2);
-	}
-
-	return (0);
-}
-
-
 /**
  * refreshUnspentCache - sets new unspent transaction output cache to track
- *   pending transactions in the mempool
+ *   pending transactions in the mempool: a view of the blockchain unspent
+ *   outputs, hiding the ones spent by the mempool; blockchain->unspent is
+ *   not copied, so the refresh costs one lookup per mempool input; `mine`
+ *   amends the cache instead, see mempoolRetain
  *
  * @cli_state: pointer to struct containing information about the cli and
  *   blockchain in use
@@ -202,23 +157,22 @@ int refreshUnspentCache(cli_state_t *cli_state)
 		return (1);
 	}
 
-	if (cli_state->unspent_cache)
-		llist_destroy(cli_state->unspent_cache, 1, NULL);
-
-	cli_state->unspent_cache = llist_create(MT_SUPPORT_FALSE);
-	if (!cli_state->unspent_cache)
+	unspentViewFree(&(cli_state->unspent_cache));
+	if (unspentViewInit(&(cli_state->unspent_cache),
+			    cli_state->blockchain->unspent,
+			    cli_state->blockchain->unspent_index) != 0)
 	{
-		fprintf(stderr, "refreshUnspentCache: llist_create failure\n");
+		fprintf(stderr, "refreshUnspentCache: %s\n",
+			"unspentViewInit failure");
 		return (1);
 	}
-
-	/* copy blockchain->unspent */
-	if (llist_for_each(cli_state->blockchain->unspent,
-			   (node_func_t)copyUnspent,
-			   cli_state->unspent_cache) != 0)
+	/* outputs spent by pending transactions cannot be sent again */
+	if (cli_state->mempool &&
+	    mempoolHoldInputs(cli_state->mempool,
+			      &(cli_state->unspent_cache)) != 0)
 	{
-		llist_destroy(cli_state->unspent_cache, 1, NULL);
-		fprintf(stderr, "refreshUnspentCache: llist_for_each failure\n");
+		fprintf(stderr, "refreshUnspentCache: %s\n",
+			"mempoolHoldInputs failure");
 		return (1);
 	}
 
@@ -305,9 +259,11 @@ void freeCLIState(cli_state_t *cli_state)
 	if (cli_state->blockchain)
 		blockchain_destroy(cli_state->blockchain);
 
+	bcJournalClose(cli_state->journal);
+
 	llist_destroy(cli_state->mempool, 1, (node_dtor_t)transaction_destroy);
 
-	llist_destroy(cli_state->unspent_cache, 1, NULL);
+	unspentViewFree(&(cli_state->unspent_cache));
 
 	free(cli_state);
 }
@@ -18,29 +18,33 @@
 
 /* add new <aspect> to refresh wallet/mempool/blockchain from CLI? */
 /* exit differs from cmd_fp_t typedef and is handled separately */
-#define CMD_FP_CT 11 /* not counting exit */
+#define CMD_FP_CT 13 /* not counting exit */
 #define CMD_FP_ARRAY { \
 	cmd_wallet_load, \
 	cmd_wallet_save, \
 	cmd_send, \
 	cmd_mine, \
 	cmd_info, \
+	cmd_block_info, \
 	cmd_load, \
 	cmd_save, \
+	cmd_validate, \
 	cmd_mempool_load, \
 	cmd_mempool_save, \
 	cmd_new, \
 	cmd_help \
 }
-#define CMD_CT 12 /* counting exit */
+#define CMD_CT 14 /* counting exit */
 #define CMD_NAME_ARRAY { \
 	"wallet_load", \
 	"wallet_save", \
 	"send", \
 	"mine", \
 	"info", \
+	"block_info", \
 	"load", \
 	"save", \
+	"validate", \
 	"mempool_load", \
 	"mempool_save", \
 	"new", \
@@ -53,8 +57,10 @@
 	SEND_HELP, \
 	MINE_HELP, \
 	INFO_HELP, \
+	BLOCK_INFO_HELP, \
 	LOAD_HELP, \
 	SAVE_HELP, \
+	VALIDATE_HELP, \
 	MEMPOOL_LOAD_HELP, \
 	MEMPOOL_SAVE_HELP, \
 	NEW_HELP, \
@@ -67,8 +73,10 @@
 	SEND_HELP_SUMMARY \
 	MINE_HELP_SUMMARY \
 	INFO_HELP_SUMMARY \
+	BLOCK_INFO_HELP_SUMMARY \
 	LOAD_HELP_SUMMARY \
 	SAVE_HELP_SUMMARY \
+	VALIDATE_HELP_SUMMARY \
 	MEMPOOL_LOAD_HELP_SUMMARY \
 	MEMPOOL_SAVE_HELP_SUMMARY \
 	NEW_HELP_SUMMARY \
@@ -77,6 +85,8 @@
 
 #define HMPL_MAG "HMPL"
 #define HMPL_MAG_LEN 4
+/* mempool files kept the HBLK 0.3 layout, see HBLK_VER_0_3 */
+#define HMPL_VER HBLK_VER_0_3
 
 #define SAVE_DIR_DFLT "hblk_save/"
 #define WALLET_DIR_DFLT SAVE_DIR_DFLT "wallet/"
@@ -85,6 +95,14 @@
 #define MEMPOOL_PATH_DFLT SAVE_DIR_DFLT "save.hmpl"
 #define BLKCHN_PATH_DFLT SAVE_DIR_DFLT "save.hblk"
 
+/* most mempool transactions included in a block, the rest wait for the next */
+#define MINE_TXS_MAX 1024
+
+/* verdicts on mempool transactions while mining, see mempoolRetain */
+#define MP_TX_INVALID 0
+#define MP_TX_VALID   1
+#define MP_TX_MINED   2
+
 
 /**
  * struct st_list_s - singly linked list node to contain a CLI syntax token
@@ -117,9 +135,15 @@ typedef struct st_list_s
  * @blockchain: blockchain created in session or loaded from file
  * @mempool: list of transactions that have been verified but not
  *   confirmed(mined)
- * @unspent_cache: temproary list of unspent outputs used to track pending
- *   transactions in the mempool, refreshed every time a block is mined and
- *   canonical utxo list blockchain->unspent is updated
+ * @unspent_cache: view of canonical utxo list blockchain->unspent in which
+ *   the outputs spent by pending transactions in the mempool are hidden,
+ *   refreshed every time a block is mined or the blockchain or mempool is
+ *   replaced
+ * @journal: journal to which mined blocks are appended, started by `save`
+ *   with a sync policy or reopened by `load`, or NULL
+ * @mempool_valid: amount of leading @mempool transactions already found
+ *   valid against blockchain->unspent, which `mine` does not verify again;
+ *   reset whenever the blockchain or mempool is replaced
  *
  * Description: used to hold anything that needs to be gqlobally visible to
  * various functions to ensure consistent error messages, storage access,
@@ -139,7 +163,9 @@ typedef struct cli_state_s
 	EC_KEY *wallet;
 	blockchain_t *blockchain;
 	llist_t *mempool;
-	llist_t *unspent_cache;
+	utxo_view_t unspent_cache;
+	bc_journal_t *journal;
+	int mempool_valid;
 } cli_state_t;
 
 /**
@@ -162,6 +188,40 @@ typedef struct mpl_file_hdr_s
 	uint32_t hmpl_txs;
 } mpl_file_hdr_t;
 
+/**
+ * struct mp_ref_s - mempool index entry
+ *
+ * @tx_in: mempool transaction input, referencing an output
+ * @tx_idx: index in the mempool of the transaction containing @tx_in
+ */
+typedef struct mp_ref_s
+{
+	tx_in_t const *tx_in;
+	unsigned int  tx_idx;
+} mp_ref_t;
+
+/**
+ * struct mp_index_s - mempool index
+ *
+ * Description: Indexes the inputs of every mempool transaction by the output
+ *   they reference, so that the transactions spending an output are found
+ *   without visiting the whole mempool.
+ *
+ * @refs: entries sorted by referenced output, see mempoolIndexFind
+ * @ref_ct: amount of entries in @refs
+ * @ref_cap: amount of entries allocated in @refs
+ * @txs: mempool transactions, in mempool order
+ * @tx_ct: amount of transactions in @txs
+ */
+typedef struct mp_index_s
+{
+	mp_ref_t      *refs;
+	size_t        ref_ct;
+	size_t        ref_cap;
+	transaction_t **txs;
+	unsigned int  tx_ct;
+} mp_index_t;
+
 /**
  * struct mtb_info_s - mempool-to-block info
  *
@@ -171,14 +231,55 @@ typedef struct mpl_file_hdr_s
  *   outside parameter to its `action` function.
  *
  * @new_block: newly created block to contain the mempool transactions
- * @unspent: list of all unspent outputs in the blockchain
+ * @blockchain: blockchain whose unspent outputs the mempool spends
+ * @valid: MP_TX_* verdict on each mempool transaction, see transactionsVerify
+ * @index: index of the mempool
+ * @view: view of the unspent outputs of @blockchain less the outputs spent
+ *   by @new_block so far
+ * @mined_ct: amount of mempool transactions added to @new_block
  */
 typedef struct mtb_info_s
 {
-	block_t *new_block;
-	llist_t *unspent;
+	block_t      *new_block;
+	blockchain_t *blockchain;
+	int8_t       *valid;
+	mp_index_t   index;
+	utxo_view_t  view;
+	unsigned int mined_ct;
 } mtb_info_t;
 
+/**
+ * struct mr_info_s - mempool retention info
+ *
+ * Description: Used to contain all the parameters necessary for finding the
+ *   mempool transactions affected by a new block. Necessary for
+ *   llist_for_each, as it only takes one void pointer as an outside
+ *   parameter to its `action` function.
+ *
+ * @block: block just added to the blockchain
+ * @tx: transaction of @block being visited
+ * @index: index of the mempool
+ * @touched: flag of each mempool transaction whose inputs @block affects
+ * @cache: view of the unspent outputs less those held by the mempool, see
+ *   mempoolHoldInputs
+ * @released: flag of each mempool transaction whose inputs are released
+ *   from @cache
+ * @queue: mempool indices of the transactions flagged in @released, in the
+ *   order they were flagged
+ * @queue_ct: amount of entries in @queue
+ */
+typedef struct mr_info_s
+{
+	block_t const       *block;
+	transaction_t const *tx;
+	mp_index_t const    *index;
+	uint8_t             *touched;
+	utxo_view_t         *cache;
+	uint8_t             *released;
+	unsigned int        *queue;
+	unsigned int        queue_ct;
+} mr_info_t;
+
 /* function pointer type for all builtin commands other than `exit` */
 typedef int (*cmd_fp_t)(char *arg1, char *arg2, cli_state_t *cli_state);
 
@@ -186,10 +287,6 @@ typedef int (*cmd_fp_t)(char *arg1, char *arg2, cli_state_t *cli_state);
 /* hblk_cli.c */
 cli_state_t *initCLIState(void);
 void parseArgs(int argc, char *argv[], cli_state_t *cli_state);
-/*
- * static int copyUnspent(unspent_tx_out_t *utxo,
- *		          unsigned int idx, llist_t *unspent_cache)
- */
 int refreshUnspentCache(cli_state_t *cli_state);
 void initSession(cli_state_t *cli_state);
 void freeCLIState(cli_state_t *cli_state);
@@ -229,7 +326,10 @@ int cmd_wallet_save(char *path, char *arg2, cli_state_t *cli_state);
 int cmd_load(char *path, char *arg2, cli_state_t *cli_state);
 
 /* cmd_save.c */
-int cmd_save(char *path, char *arg2, cli_state_t *cli_state);
+/* static int parseSync(char const *sync, bc_sync_t *policy); */
+int cmd_save(char *path, char *sync, cli_state_t *cli_state);
+/* cmd_validate.c */
+int cmd_validate(char *threads, char *arg2, cli_state_t *cli_state);
 
 /* cmd_mempool_load.c */
 int cmd_mempool_load(char *path, char *arg2, cli_state_t *cli_state);
@@ -241,7 +341,10 @@ int cmd_mempool_save(char *path, char *arg2, cli_state_t *cli_state);
 /*
  * static int findAllSenderUnspent(unspent_tx_out_t *unspent_tx_out,
  *				unsigned int idx, su_info_t *su_info);
+ * static block_t *findBlock(char *id, blockchain_t *blockchain);
  */
+int parseBlockId(char const *id, uint32_t *height,
+		 uint8_t hash[SHA256_DIGEST_LENGTH]);
 int print_info_wallet(int full, llist_t **wallet_unspent,
 		      int component, cli_state_t *cli_state);
 int print_info_mempool(int component, cli_state_t *cli_state);
@@ -250,9 +353,13 @@ int print_info(cli_state_t *cli_state);
 int print_info_wallet_full(int component, cli_state_t *cli_state);
 int print_info_mempool_full(int component, cli_state_t *cli_state);
 int print_info_blockchain_full(int component, cli_state_t *cli_state);
+int print_info_block(char *id, cli_state_t *cli_state);
 int print_info_full(cli_state_t *cli_state);
 int cmd_info(char *arg1, char *arg2, cli_state_t *cli_state);
 
+/* cmd_block_info.c */
+int cmd_block_info(char *id, char *path, cli_state_t *cli_state);
+
 /* cmd_send.c */
 /*
  * static int findSenderUnspent(unspent_tx_out_t *unspent_tx_out,
@@ -262,7 +369,42 @@ uint8_t *pubKeyHexToByteArray(char *address);
 int cmd_send(char *amount, char *address, cli_state_t *cli_state);
 
 /* cmd_mine.c */
-int cmd_mine(char *arg1, char *arg2, cli_state_t *cli_state);
+/*
+ * static int mempoolTxToBlock(transaction_t *tx, unsigned int idx,
+ *			       mtb_info_t *mtb_info);
+ * static int mempoolVerify(cli_state_t *cli_state, unsigned int thread_ct,
+ *			    mtb_info_t *mtb_info);
+ */
+int cmd_mine(char *threads, char *arg2, cli_state_t *cli_state);
+
+/* mempool.c */
+/*
+ * static int refCmp(void const *a, void const *b);
+ * static int indexInput(tx_in_t *tx_in, unsigned int idx, mp_index_t *index);
+ * static int indexTx(transaction_t *tx, unsigned int idx, mp_index_t *index);
+ * static void markSpenders(mp_index_t const *index, tx_in_t const *outpoint,
+ *			    uint8_t *touched);
+ * static int markInput(tx_in_t *tx_in, unsigned int idx, mr_info_t *mr_info);
+ * static int markOutput(tx_out_t *tx_out, unsigned int idx,
+ *			 mr_info_t *mr_info);
+ * static int markBlockTx(transaction_t *tx, unsigned int idx,
+ *			  mr_info_t *mr_info);
+ * static int recheckTouched(mr_info_t *mr_info, int8_t *verdict,
+ *			     blockchain_t const *blockchain,
+ *			     unsigned int thread_ct);
+ * static int releaseInput(tx_in_t *tx_in, unsigned int idx,
+ *			   mr_info_t *mr_info);
+ * static int updateCache(mr_info_t *mr_info, int8_t const *verdict);
+ * static int holdTxInputs(transaction_t *tx, unsigned int idx,
+ *			   utxo_view_t *unspent_cache);
+ */
+int mempoolIndexBuild(llist_t *mempool, mp_index_t *index);
+mp_ref_t const *mempoolIndexFind(mp_index_t const *index,
+				 tx_in_t const *outpoint, size_t *ct);
+void mempoolIndexFree(mp_index_t *index);
+int mempoolRetain(cli_state_t *cli_state, block_t const *block,
+		  mp_index_t *index, int8_t *verdict, unsigned int thread_ct);
+int mempoolHoldInputs(llist_t *mempool, utxo_view_t *unspent_cache);
 
 /* cmd_new.c */
 int cmd_new_wallet(cli_state_t *cli_state);
@@ -278,6 +420,7 @@ int cmd_new(char *aspect, char *arg2, cli_state_t *cli_state);
  *			   char const *indent);
  */
 void _blockchain_print(blockchain_t const *blockchain);
+void _block_print_single(block_t const *block);
 void _blockchain_print_brief(blockchain_t const *blockchain);
 
 /* printing/_print_all_unspent.c */
@@ -43,15 +43,22 @@
 	" mining.\n" \
 	"\n"
 
-#define MINE_HELP_SUMMARY TAB4 "mine - hashes current mempool into a new " \
-	"block\n"
+#define MINE_HELP_SUMMARY TAB4 "mine [<threads>] - hashes current " \
+	"mempool into a new block\n"
 #define MINE_HELP "\n" \
 	MINE_HELP_SUMMARY \
 	"\n" \
 	TAB4 TAB4 "Creates a new block, reverifies all mempool "	\
-	"transactions, adds the valid\nones to the block, adds a coinbase " \
-	"transaction, sets the block difficulty,\nhashes the block, and adds " \
-	"it to the blockchain.\n" \
+	"transactions, adds the valid\nones to the block, up to its limit of " \
+	"transactions and in mempool order,\nadds a coinbase transaction, " \
+	"sets the block difficulty, hashes the block,\nand adds it to the " \
+	"blockchain.\n" \
+	TAB4 TAB4 "Valid transactions left out stay in the mempool; those " \
+	"spending an\noutput the block spent are checked again, and dropped " \
+	"if no longer valid.\n" \
+	TAB4 TAB4 "The nonce search is split between <threads> threads, or " \
+	"one per online\nprocessor if <threads> is not given or 0. The block " \
+	"mined is the same for any\namount of threads.\n" \
 	"\n"
 
 #define INFO_HELP_SUMMARY TAB4 "info [<aspect> / full] [full] - displays " \
@@ -63,17 +70,33 @@
 	TAB4 TAB4 "info wallet full: `info wallet` plus a full list of " \
 	"wallet's unspent UTXOs\n" \
 	TAB4 TAB4 "info mempool: number of pending transactions in the local" \
-	" memory pool\n" \
+	" memory pool,\nsignature verifications skipped or run, and public " \
+	"keys reused or decoded\n" \
 	TAB4 TAB4 "info mempool full: `info mempool` plus a full list of " \
 	"transactions in the\nlocal memory pool\n" \
 	TAB4 TAB4 "info blockchain: number of UTXOs and blockchain height\n" \
 	TAB4 TAB4 "info blockchain full: `info blockchain` plus a full list " \
 	"of all UTXOs and\nblocks in the chain\n" \
+	TAB4 TAB4 "info block <height / hash>: the block at <height> in the " \
+	"chain, or the\nblock of <hash> in hex\n" \
 	TAB4 TAB4 "info: `info wallet`, `info mempool`, `info blockchain`\n" \
 	TAB4 TAB4 "info full: `info wallet full`, `info mempool full`,\n" \
 	"`info blockchain full`\n" \
 	"\n"
 
+#define BLOCK_INFO_HELP_SUMMARY TAB4 "block_info <height / hash> [<path>]" \
+	" - displays a block of a blockchain file\n"
+#define BLOCK_INFO_HELP "\n" \
+	BLOCK_INFO_HELP_SUMMARY \
+	"\n" \
+	TAB4 TAB4 "Reads the block at <height>, or the block of <hash> in " \
+	"hex, from the\nblockchain file at <path>, or the default path if " \
+	"none is given, without\nloading the file into the CLI session. A " \
+	"transaction ID as <hash> finds the\nblock holding that " \
+	"transaction. Blocks journaled since the file was saved,\nsee " \
+	"`save`, are not read.\n" \
+	"\n"
+
 #define LOAD_HELP_SUMMARY TAB4 "load [<path>] - loads a new blockchain into " \
 	"the CLI session\n"
 #define LOAD_HELP "\n" \
@@ -81,16 +104,38 @@
 	"\n" \
 	TAB4 TAB4 "Attempts to load a blockchain from the default path " \
 	"if <path> is not\ngiven. Not run automatically at startup, instead " \
-	"each session begins with an\nempty blockchain.\n" \
+	"each session begins with an\nempty blockchain. Blocks journaled " \
+	"since the file was saved, see `save`,\nare replayed, and mined " \
+	"blocks keep being journaled.\n" \
 	"\n"
 
-#define SAVE_HELP_SUMMARY TAB4 "save [<path>] - saves the current CLI " \
-	"session blockchain to file\n"
+#define SAVE_HELP_SUMMARY TAB4 "save [<path> [<sync>]] - saves the " \
+	"current CLI session blockchain to file\n"
 #define SAVE_HELP "\n" \
 	SAVE_HELP_SUMMARY \
 	"\n" \
 	TAB4 TAB4 "Saves current session blockchain to the default path" \
-	" if <path> is not\ngiven.\n" \
+	" if <path> is not\ngiven. With <sync>, blocks mined afterwards are " \
+	"appended to the journal\n<path>" HJNL_EXT ", along with the unspent " \
+	"outputs every few blocks, instead of\nrewriting the file. <sync> " \
+	"is when the journal is flushed to disk:\n" \
+	TAB4 TAB4 "* always: after each block\n" \
+	TAB4 TAB4 "* checkpoint: after each unspent outputs checkpoint\n" \
+	TAB4 TAB4 "* never: left to the system\n" \
+	"\n"
+
+#define VALIDATE_HELP_SUMMARY TAB4 "validate [<threads>] - checks every " \
+	"block in the current CLI session\nblockchain\n"
+#define VALIDATE_HELP "\n" \
+	VALIDATE_HELP_SUMMARY \
+	"\n" \
+	TAB4 TAB4 "Checks the index, hash, difficulty, link to the previous " \
+	"block and\ncoinbase transaction of every block, split between " \
+	"<threads> threads, or one\nper online processor if <threads> is " \
+	"not given or 0. Then replays the\ntransactions of each block in " \
+	"order, checking that they only spend unspent\noutputs, and that " \
+	"the outputs left unspent are those of the blockchain.\nReports the " \
+	"first invalid block, if any.\n" \
 	"\n"
 
 #define MEMPOOL_LOAD_HELP_SUMMARY TAB4 "mempool_load [<path>] - loads a new " \
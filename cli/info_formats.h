@@ -35,6 +35,19 @@
 #define INFO_MEMPOOL_FMT \
 	TAB4 TAB4 "* total transactions in mempool awaiting confirmation: %i\n"
 
+#define INFO_SIG_CACHE_FMT \
+	TAB4 TAB4 "* signature verifications skipped (cache hits): %lu\n" \
+	TAB4 TAB4 "* signature verifications run (cache misses): %lu\n"
+#define INFO_KEY_CACHE_FMT \
+	TAB4 TAB4 "* public keys reused (cache hits): %lu\n" \
+	TAB4 TAB4 "* public keys decoded (cache misses): %lu\n"
+
+#define INFO_BLOCK_FMT_HDR "\n" \
+	TAB4 "Block %u of session blockchain:\n"
+
+#define INFO_FILE_BLOCK_FMT_HDR "\n" \
+	TAB4 "Block %u of blockchain file '%s':\n"
+
 #define INFO_BLKCHN_FMT \
 	TAB4 TAB4 "* total unspent outputs:\n" \
 	TAB4 TAB4 TAB4 "* (before mempool transactions are confirmed): %i\n" \
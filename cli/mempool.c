@@ -0,0 +1,584 @@
+/* mp_index_t MP_TX_* */
+#include "hblk_cli.h"
+/* fprintf */
+#include <stdio.h>
+/* malloc calloc realloc free qsort */
+#include <stdlib.h>
+/* memcmp memcpy memset */
+#include <string.h>
+
+
+/**
+ * refCmp - compares two mempool index entries by the output their inputs
+ *   reference, for qsort
+ *
+ * @a: pointer to first entry
+ * @b: pointer to second entry
+ *
+ * Return: negative, 0 or positive as `a` sorts before, with or after `b`
+ */
+static int refCmp(void const *a, void const *b)
+{
+	tx_in_t const *in_a = ((mp_ref_t const *)a)->tx_in,
+		*in_b = ((mp_ref_t const *)b)->tx_in;
+	int cmp;
+
+	cmp = memcmp(in_a->block_hash, in_b->block_hash, SHA256_DIGEST_LENGTH);
+	if (!cmp)
+		cmp = memcmp(in_a->tx_id, in_b->tx_id, SHA256_DIGEST_LENGTH);
+	if (!cmp)
+		cmp = memcmp(in_a->tx_out_hash, in_b->tx_out_hash,
+			     SHA256_DIGEST_LENGTH);
+
+	return (cmp);
+}
+
+
+/**
+ * indexInput - used as `action` for llist_for_each to add each input of a
+ *   mempool transaction to the index
+ *
+ * @tx_in: pointer to input in transaction->inputs, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx_in` in transaction->inputs, as iterated through by
+ *   llist_for_each
+ * @index: pointer to index to amend, index->tx_ct being the mempool index
+ *   of the transaction containing `tx_in`
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int indexInput(tx_in_t *tx_in, unsigned int idx, mp_index_t *index)
+{
+	mp_ref_t *refs;
+
+	(void)idx;
+	if (!tx_in || !index)
+	{
+		fprintf(stderr, "indexInput: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	if (index->ref_ct == index->ref_cap)
+	{
+		index->ref_cap = index->ref_cap ? index->ref_cap * 2 : 64;
+		refs = realloc(index->refs, index->ref_cap * sizeof(mp_ref_t));
+		if (!refs)
+		{
+			fprintf(stderr, "indexInput: realloc failure\n");
+			return (-2);
+		}
+		index->refs = refs;
+	}
+	index->refs[index->ref_ct].tx_in = tx_in;
+	index->refs[index->ref_ct].tx_idx = index->tx_ct;
+	index->ref_ct++;
+
+	return (0);
+}
+
+
+/**
+ * indexTx - used as `action` for llist_for_each to add each mempool
+ *   transaction and its inputs to the index
+ *
+ * @tx: pointer to transaction in the mempool, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx` in the mempool, as iterated through by llist_for_each
+ * @index: pointer to index to amend
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int indexTx(transaction_t *tx, unsigned int idx, mp_index_t *index)
+{
+	if (!tx || !index)
+	{
+		fprintf(stderr, "indexTx: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	index->txs[idx] = tx;
+	index->tx_ct = idx;
+	if (llist_for_each(tx->inputs, (node_func_t)indexInput, index) < 0)
+		return (-2);
+	index->tx_ct = idx + 1;
+
+	return (0);
+}
+
+
+/**
+ * mempoolIndexBuild - indexes every mempool transaction by the outputs its
+ *   inputs reference
+ *
+ * @mempool: list of transactions to index, not to be amended while the
+ *   index is in use
+ * @index: pointer to index to fill, released by mempoolIndexFree
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int mempoolIndexBuild(llist_t *mempool, mp_index_t *index)
+{
+	int tx_ct;
+
+	if (!mempool || !index)
+	{
+		fprintf(stderr, "mempoolIndexBuild: NULL parameter(s)\n");
+		return (1);
+	}
+	memset(index, 0, sizeof(mp_index_t));
+
+	tx_ct = llist_size(mempool);
+	if (tx_ct < 0)
+		return (1);
+	index->txs = malloc((tx_ct ? tx_ct : 1) * sizeof(transaction_t *));
+	if (!index->txs ||
+	    llist_for_each(mempool, (node_func_t)indexTx, index) < 0)
+	{
+		fprintf(stderr, "mempoolIndexBuild: failed to index mempool\n");
+		mempoolIndexFree(index);
+		return (1);
+	}
+	qsort(index->refs, index->ref_ct, sizeof(mp_ref_t), refCmp);
+
+	return (0);
+}
+
+
+/**
+ * mempoolIndexFind - finds the index entries of every mempool input
+ *   referencing an output
+ *
+ * @index: pointer to mempool index
+ * @outpoint: input whose block hash, transaction ID and output hash identify
+ *   the referenced output
+ * @ct: modified by reference to the amount of entries found
+ *
+ * Return: pointer to the first of `*ct` consecutive entries, or NULL if none
+ */
+mp_ref_t const *mempoolIndexFind(mp_index_t const *index,
+				 tx_in_t const *outpoint, size_t *ct)
+{
+	mp_ref_t key;
+	size_t lo = 0, hi, end;
+
+	*ct = 0;
+	if (!index || !outpoint)
+		return (NULL);
+
+	key.tx_in = outpoint;
+	hi = index->ref_ct;
+	while (lo < hi)
+	{
+		if (refCmp(index->refs + (lo + hi) / 2, &key) < 0)
+			lo = (lo + hi) / 2 + 1;
+		else
+			hi = (lo + hi) / 2;
+	}
+	for (end = lo; end < index->ref_ct &&
+		     refCmp(index->refs + end, &key) == 0; end++)
+		;
+	*ct = end - lo;
+
+	return (*ct ? index->refs + lo : NULL);
+}
+
+
+/**
+ * mempoolIndexFree - releases the arrays of a mempool index, but none of the
+ *   transactions indexed
+ *
+ * @index: pointer to index to release, left empty
+ */
+void mempoolIndexFree(mp_index_t *index)
+{
+	if (!index)
+		return;
+
+	free(index->refs);
+	free(index->txs);
+	memset(index, 0, sizeof(mp_index_t));
+}
+
+
+/**
+ * markSpenders - marks every mempool transaction spending an output
+ *
+ * @index: pointer to index of the mempool
+ * @outpoint: input identifying the output, see mempoolIndexFind
+ * @touched: array of flags of each mempool transaction, amended
+ */
+static void markSpenders(mp_index_t const *index, tx_in_t const *outpoint,
+			 uint8_t *touched)
+{
+	mp_ref_t const *refs;
+	size_t i, ct;
+
+	refs = mempoolIndexFind(index, outpoint, &ct);
+	for (i = 0; i < ct; i++)
+		touched[refs[i].tx_idx] = 1;
+}
+
+
+/**
+ * markInput - used as `action` for llist_for_each to mark every mempool
+ *   transaction spending the output referenced by each input of a block
+ *   transaction
+ *
+ * @tx_in: pointer to input in transaction->inputs, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx_in` in transaction->inputs, as iterated through by
+ *   llist_for_each
+ * @mr_info: pointer to struct containing the mempool index and the flags to
+ *   amend
+ *
+ * Return: always 0 (llist_for_each can continue)
+ */
+static int markInput(tx_in_t *tx_in, unsigned int idx, mr_info_t *mr_info)
+{
+	(void)idx;
+
+	markSpenders(mr_info->index, tx_in, mr_info->touched);
+	return (0);
+}
+
+
+/**
+ * markOutput - used as `action` for llist_for_each to mark every mempool
+ *   transaction spending each output of a block transaction
+ *
+ * @tx_out: pointer to output in transaction->outputs, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx_out` in transaction->outputs, as iterated through by
+ *   llist_for_each
+ * @mr_info: pointer to struct containing the block, the transaction
+ *   containing `tx_out`, the mempool index and the flags to amend
+ *
+ * Return: always 0 (llist_for_each can continue)
+ */
+static int markOutput(tx_out_t *tx_out, unsigned int idx, mr_info_t *mr_info)
+{
+	tx_in_t outpoint;
+
+	(void)idx;
+	memcpy(outpoint.block_hash, mr_info->block->hash,
+	       SHA256_DIGEST_LENGTH);
+	memcpy(outpoint.tx_id, mr_info->tx->id, SHA256_DIGEST_LENGTH);
+	memcpy(outpoint.tx_out_hash, tx_out->hash, SHA256_DIGEST_LENGTH);
+	markSpenders(mr_info->index, &outpoint, mr_info->touched);
+
+	return (0);
+}
+
+
+/**
+ * markBlockTx - used as `action` for llist_for_each to mark every mempool
+ *   transaction whose inputs reference an output spent or created by a
+ *   transaction of a block
+ *
+ * @tx: pointer to transaction in block->transactions, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx` in block->transactions, as iterated through by
+ *   llist_for_each
+ * @mr_info: pointer to struct containing the block, the mempool index and
+ *   the flags to amend
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int markBlockTx(transaction_t *tx, unsigned int idx,
+		       mr_info_t *mr_info)
+{
+	(void)idx;
+	if (!tx || !mr_info)
+	{
+		fprintf(stderr, "markBlockTx: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	mr_info->tx = tx;
+	if (llist_for_each(tx->inputs, (node_func_t)markInput, mr_info) < 0 ||
+	    llist_for_each(tx->outputs, (node_func_t)markOutput, mr_info) < 0)
+		return (-2);
+
+	return (0);
+}
+
+
+/**
+ * recheckTouched - checks again the mempool transactions left out of a new
+ *   block whose inputs reference an output the block spent or created,
+ *   against the unspent outputs the block left; the verdicts of the others
+ *   still hold
+ *
+ * @mr_info: pointer to struct containing the mempool index and the flags of
+ *   the transactions touched by the block
+ * @verdict: array of the MP_TX_* verdict of each mempool transaction, those
+ *   rechecked being amended
+ * @blockchain: blockchain whose unspent outputs are those after the block
+ * @thread_ct: amount of verifying threads, see transactionsVerify
+ *
+ * Return: 0 on success, 1 on failure
+ */
+static int recheckTouched(mr_info_t *mr_info, int8_t *verdict,
+			  blockchain_t const *blockchain,
+			  unsigned int thread_ct)
+{
+	llist_t *recheck;
+	int8_t *valid;
+	unsigned int i, j;
+	int ret = 0;
+
+	recheck = llist_create(MT_SUPPORT_FALSE);
+	valid = malloc((mr_info->index->tx_ct ? mr_info->index->tx_ct : 1) *
+		       sizeof(int8_t));
+	if (!recheck || !valid)
+	{
+		fprintf(stderr, "recheckTouched: allocation failure\n");
+		llist_destroy(recheck, 0, NULL);
+		free(valid);
+		return (1);
+	}
+	for (i = 0; i < mr_info->index->tx_ct; i++)
+		if (mr_info->touched[i] && verdict[i] != MP_TX_MINED &&
+		    llist_add_node(recheck, mr_info->index->txs[i],
+				   ADD_NODE_REAR) != 0)
+			ret = 1;
+	if (!ret && transactionsVerify(recheck, blockchain->unspent,
+				       blockchain->unspent_index, thread_ct,
+				       valid) != 0)
+		ret = 1;
+	for (i = 0, j = 0; !ret && i < mr_info->index->tx_ct; i++)
+		if (mr_info->touched[i] && verdict[i] != MP_TX_MINED)
+			verdict[i] = valid[j++] ? MP_TX_VALID : MP_TX_INVALID;
+	llist_destroy(recheck, 0, NULL);
+	free(valid);
+
+	return (ret);
+}
+
+
+/**
+ * releaseInput - used as `action` for llist_for_each to release from the
+ *   unspent output cache the output referenced by each input of a mempool
+ *   transaction, queueing every other mempool transaction spending it, as
+ *   any of them may be the one holding it
+ *
+ * @tx_in: pointer to input in transaction->inputs, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx_in` in transaction->inputs, as iterated through by
+ *   llist_for_each
+ * @mr_info: pointer to struct containing the mempool index, the cache, and
+ *   the flags and queue to amend
+ *
+ * Return: always 0 (llist_for_each can continue)
+ */
+static int releaseInput(tx_in_t *tx_in, unsigned int idx, mr_info_t *mr_info)
+{
+	mp_ref_t const *refs;
+	size_t i, ct;
+
+	(void)idx;
+	/* not held if its transaction conflicted with an earlier one */
+	unspentViewUnspend(mr_info->cache, tx_in);
+	refs = mempoolIndexFind(mr_info->index, tx_in, &ct);
+	for (i = 0; i < ct; i++)
+	{
+		if (mr_info->released[refs[i].tx_idx])
+			continue;
+		mr_info->released[refs[i].tx_idx] = 1;
+		mr_info->queue[mr_info->queue_ct++] = refs[i].tx_idx;
+	}
+
+	return (0);
+}
+
+
+/**
+ * updateCache - amends the unspent output cache for a new block instead of
+ *   rebuilding it: the inputs of the transactions mined or dropped, and of
+ *   those the block touched, are released along with the inputs of every
+ *   transaction sharing an output with them; the transactions kept among
+ *   those then hold their inputs again in mempool order, as
+ *   mempoolHoldInputs would, and the holds of the others are left alone
+ *
+ * @mr_info: pointer to struct containing the mempool index, the cache, and
+ *   the flags of the transactions touched by the block, if any
+ * @verdict: array of the MP_TX_* verdict of each mempool transaction after
+ *   the block, MP_TX_VALID for those kept
+ *
+ * Return: 0 on success, 1 on failure, in which case the cache is to be
+ *   rebuilt with refreshUnspentCache
+ */
+static int updateCache(mr_info_t *mr_info, int8_t const *verdict)
+{
+	unsigned int i, tx_ct = mr_info->index->tx_ct;
+	transaction_t const *tx;
+	int ret = 0;
+
+	mr_info->released = calloc(tx_ct ? tx_ct : 1, sizeof(uint8_t));
+	mr_info->queue = malloc((tx_ct ? tx_ct : 1) * sizeof(unsigned int));
+	if (!mr_info->released || !mr_info->queue)
+	{
+		fprintf(stderr, "updateCache: allocation failure\n");
+		ret = 1;
+	}
+	for (i = 0; !ret && i < tx_ct; i++)
+	{
+		if (verdict[i] == MP_TX_VALID &&
+		    !(mr_info->touched && mr_info->touched[i]))
+			continue;
+		mr_info->released[i] = 1;
+		mr_info->queue[mr_info->queue_ct++] = i;
+	}
+	/* the queue grows as releaseInput finds other spenders */
+	for (i = 0; !ret && i < mr_info->queue_ct; i++)
+	{
+		tx = mr_info->index->txs[mr_info->queue[i]];
+		if (llist_for_each(tx->inputs, (node_func_t)releaseInput,
+				   mr_info) < 0)
+			ret = 1;
+	}
+	for (i = 0; !ret && i < tx_ct; i++)
+		if (mr_info->released[i] && verdict[i] == MP_TX_VALID &&
+		    unspentViewApply(mr_info->cache, mr_info->index->txs[i],
+				     NULL) < 0)
+			ret = 1;
+	free(mr_info->released);
+	free(mr_info->queue);
+	mr_info->released = NULL;
+	mr_info->queue = NULL;
+
+	return (ret);
+}
+
+
+/**
+ * mempoolRetain - rebuilds the mempool once a block is added to the
+ *   blockchain: transactions mined in the block are dropped, as they now
+ *   belong to it, and so are transactions no longer valid; only those whose
+ *   inputs the block touched are checked again, see recheckTouched; the
+ *   unspent output cache is then amended from the same flags and verdicts,
+ *   see updateCache
+ *
+ * @cli_state: pointer to struct containing information about the cli and
+ *   blockchain in use; cli_state->mempool being the list indexed, and
+ *   cli_state->unspent_cache the view of blockchain->unspent, already
+ *   amended by the block, holding its inputs
+ * @block: block just added to the blockchain
+ * @index: pointer to index of the mempool
+ * @verdict: array of the MP_TX_* verdict of each mempool transaction before
+ *   the block, amended to MP_TX_INVALID for each transaction dropped
+ * @thread_ct: amount of verifying threads, see transactionsVerify
+ *
+ * Return: 0 on success, 1 on failure to recheck, in which case transactions
+ *   which would have been rechecked are dropped, or on failure to amend the
+ *   cache and then to rebuild it
+ */
+int mempoolRetain(cli_state_t *cli_state, block_t const *block,
+		  mp_index_t *index, int8_t *verdict, unsigned int thread_ct)
+{
+	mr_info_t mr_info;
+	unsigned int i;
+	int ret = 0;
+
+	memset(&mr_info, 0, sizeof(mr_info_t));
+	mr_info.block = block;
+	mr_info.index = index;
+	mr_info.cache = &(cli_state->unspent_cache);
+	mr_info.touched = calloc(index->tx_ct ? index->tx_ct : 1,
+				 sizeof(uint8_t));
+	if (!mr_info.touched ||
+	    llist_for_each(block->transactions, (node_func_t)markBlockTx,
+			   &mr_info) < 0 ||
+	    recheckTouched(&mr_info, verdict, cli_state->blockchain,
+			   thread_ct) != 0)
+	{
+		fprintf(stderr, "mempoolRetain: failed to recheck mempool\n");
+		ret = 1;
+	}
+
+	/* every indexed tx is popped, and the ones kept added back in order */
+	for (i = 0; i < index->tx_ct; i++)
+	{
+		llist_pop(cli_state->mempool);
+		if (verdict[i] == MP_TX_MINED)
+			continue;
+		if (verdict[i] == MP_TX_INVALID ||
+		    (ret && (!mr_info.touched || mr_info.touched[i])) ||
+		    llist_add_node(cli_state->mempool, index->txs[i],
+				   ADD_NODE_REAR) != 0)
+			verdict[i] = MP_TX_INVALID;
+	}
+	/* the inputs of dropped txs are released before they are freed */
+	if (updateCache(&mr_info, verdict) != 0 &&
+	    refreshUnspentCache(cli_state) != 0)
+	{
+		fprintf(stderr, "mempoolRetain: failed to update cache\n");
+		ret = 1;
+	}
+	for (i = 0; i < index->tx_ct; i++)
+		if (verdict[i] == MP_TX_INVALID)
+			transaction_destroy(index->txs[i]);
+	free(mr_info.touched);
+
+	return (ret);
+}
+
+
+/**
+ * holdTxInputs - used as `action` for llist_for_each to spend the outputs
+ *   referenced by each mempool transaction in the unspent output cache
+ *
+ * @tx: pointer to transaction in the mempool, as iterated through by
+ *   llist_for_each
+ * @idx: index of `tx` in the mempool, as iterated through by llist_for_each
+ * @unspent_cache: view of the unspent outputs to amend
+ *
+ * Return: 0 on incremental success (llist_for_each can continue,)
+ *   or -2 on failure (-1 reserved for llist_for_each errors)
+ */
+static int holdTxInputs(transaction_t *tx, unsigned int idx,
+			utxo_view_t *unspent_cache)
+{
+	(void)idx;
+
+	if (!tx || !unspent_cache)
+	{
+		fprintf(stderr, "holdTxInputs: NULL parameter(s)\n");
+		return (-2);
+	}
+
+	/* conflicting transactions hold nothing, `mine` drops them anyway */
+	return (unspentViewApply(unspent_cache, tx, NULL) < 0 ? -2 : 0);
+}
+
+
+/**
+ * mempoolHoldInputs - spends the outputs referenced by pending mempool
+ *   transactions in a view of the unspent outputs, so that they are not
+ *   spent again by the next `send`; costs one lookup per input
+ *
+ * @mempool: list of pending transactions
+ * @unspent_cache: view of the unspent outputs to amend
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int mempoolHoldInputs(llist_t *mempool, utxo_view_t *unspent_cache)
+{
+	if (!mempool || !unspent_cache)
+	{
+		fprintf(stderr, "mempoolHoldInputs: NULL parameter(s)\n");
+		return (1);
+	}
+
+	if (llist_for_each(mempool, (node_func_t)holdTxInputs,
+			   unspent_cache) < 0)
+	{
+		fprintf(stderr, "mempoolHoldInputs: llist_for_each failure\n");
+		return (1);
+	}
+
+	return (0);
+}
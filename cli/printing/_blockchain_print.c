@@ -141,6 +141,18 @@ void _blockchain_print(blockchain_t const *blockchain)
 }
 
 
+/**
+ * _block_print_single - Prints a single block
+ *
+ * @block: Pointer to the block to be printed
+ */
+void _block_print_single(block_t const *block)
+{
+	_block_print(block, 0, "");
+	fflush(NULL);
+}
+
+
 /**
  * _blockchain_print_brief - Prints an entire blockchain (brief mode)
  *
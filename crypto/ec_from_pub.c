@@ -7,7 +7,9 @@
 
 
 /**
- * bAToEC_POINT - byte array of a public key to EC_POINT
+ * bAToEC_POINT - byte array of a public key to EC_POINT; the point is
+ *   decoded from its octet string directly, which also checks that it lies
+ *   on the curve
  * @ec_group: pointer
  * @bn_ctx: pointer to structure
  * @pub: uncompressed representation of the public key/point
@@ -17,10 +19,8 @@ EC_POINT *bAToEC_POINT(const EC_GROUP *ec_group, BN_CTX *bn_ctx,
 			      const uint8_t pub[EC_PUB_LEN])
 {
 	EC_POINT *ec_point;
-	char *pub_hex_str;
-	int i, j, buf_len;
 
-	if (!ec_group || !bn_ctx || !pub)
+	if (!ec_group || !pub)
 	{
 		fprintf(stderr, "bAToEC_POINT: NULL parameter(s)\n");
 		return (NULL);
@@ -33,26 +33,13 @@ EC_POINT *bAToEC_POINT(const EC_GROUP *ec_group, BN_CTX *bn_ctx,
 		return (NULL);
 	}
 
-	buf_len = EC_PUB_LEN * 2;
-	pub_hex_str = OPENSSL_malloc(sizeof(char) * buf_len);
-	if (!pub_hex_str)
+	if (!EC_POINT_oct2point(ec_group, ec_point, pub, EC_PUB_LEN, bn_ctx))
 	{
-		fprintf(stderr, "bAToEC_POINT: OPENSSL_malloc failure\n");
+		fprintf(stderr, "bAToEC_POINT: EC_POINT_oct2point failure\n");
+		EC_POINT_free(ec_point);
 		return (NULL);
 	}
 
-	memset(pub_hex_str, 0, buf_len);
-	for (i = 0, j = 0; i < EC_PUB_LEN; i++, j += 2)
-		sprintf(pub_hex_str + j, "%02X", (unsigned int)(pub[i]));
-
-	ec_point = EC_POINT_hex2point(ec_group, pub_hex_str, ec_point, bn_ctx);
-	if (!ec_point)
-	{
-		fprintf(stderr, "bAToEC_POINT: EC_KEY_get0_group failure\n");
-		return (NULL);
-	}
-
-	OPENSSL_free(pub_hex_str);
 	return (ec_point);
 }
 
@@ -66,7 +53,6 @@ EC_KEY *ec_from_pub(uint8_t const pub[EC_PUB_LEN])
 {
 	EC_KEY *ec_key;
 	const EC_GROUP *ec_group;
-	BN_CTX *bn_ctx;
 	EC_POINT *ec_point;
 
 	if (!pub)
@@ -85,22 +71,19 @@ EC_KEY *ec_from_pub(uint8_t const pub[EC_PUB_LEN])
 	if (!ec_group)
 	{
 		fprintf(stderr, "ec_from_pub: EC_KEY_get0_group failure\n");
+		EC_KEY_free(ec_key);
 		return (NULL);
 	}
 
-	bn_ctx = BN_CTX_new();
-	if (!bn_ctx)
-	{
-		fprintf(stderr, "ec_from_pub: BN_CTX_new failure\n");
-		return (NULL);
-	}
-	ec_point = bAToEC_POINT(ec_group, bn_ctx, pub);
-	if (EC_KEY_set_public_key(ec_key, ec_point) == 0)
+	/* affine coordinates need no BN_CTX to be decoded */
+	ec_point = bAToEC_POINT(ec_group, NULL, pub);
+	if (!ec_point || EC_KEY_set_public_key(ec_key, ec_point) == 0)
 	{
 		fprintf(stderr, "ec_from_pub: EC_KEY_set_public_key failure\n");
+		EC_POINT_free(ec_point);
+		EC_KEY_free(ec_key);
 		return (NULL);
 	}
-	BN_CTX_free(bn_ctx);
 	EC_POINT_free(ec_point);
 
 	return (ec_key);
@@ -0,0 +1,97 @@
+#include "hblk_crypto.h"
+#include <openssl/ec.h>
+#include <stdio.h>
+
+
+/**
+ * keyAcquire - used as `acquire` for the decoded public key cache to take a
+ *   reference to a key
+ *
+ * @key: pointer to EC_KEY structure
+ *
+ * Return: 1 on success, 0 on failure
+ */
+static int keyAcquire(void *key)
+{
+	return (EC_KEY_up_ref((EC_KEY *)key));
+}
+
+
+/**
+ * keyRelease - used as `release` for the decoded public key cache to drop
+ *   its reference to a key
+ *
+ * @key: pointer to EC_KEY structure
+ */
+static void keyRelease(void *key)
+{
+	EC_KEY_free((EC_KEY *)key);
+}
+
+
+/* keys are uncompressed points, whose leading byte is always 0x04 */
+static lru_entry_t ec_cache_entries[EC_KEY_CACHE_SIZE];
+static uint32_t ec_cache_buckets[EC_KEY_CACHE_BUCKETS];
+static lru_cache_t ec_cache = LRU_CACHE_INIT(ec_cache_entries,
+					     ec_cache_buckets, EC_PUB_LEN, 1,
+					     keyAcquire, keyRelease);
+
+
+/**
+ * ec_from_pub_cached - creates an EC_KEY structure, as ec_from_pub does,
+ *   reusing the key decoded for the same public key by a previous call as
+ *   long as it is among the EC_KEY_CACHE_SIZE most recently used ones;
+ *   keys are checked by EC_KEY_check_key once, when decoded; thread safe
+ * @pub: public key
+ * Return: pointer to a reference of the key, to be released by EC_KEY_free
+ *   and not to be modified, or NULL if invalid or on failure
+ */
+EC_KEY *ec_from_pub_cached(uint8_t const pub[EC_PUB_LEN])
+{
+	EC_KEY *key;
+	void *cached;
+
+	if (!pub)
+	{
+		fprintf(stderr, "ec_from_pub_cached: NULL parameter\n");
+		return (NULL);
+	}
+
+	if (lruGet(&ec_cache, pub, &cached))
+		return ((EC_KEY *)cached);
+
+	/* decoded without the lock, other lookups can proceed meanwhile */
+	key = ec_from_pub(pub);
+	if (!key)
+		return (NULL);
+	if (!EC_KEY_check_key(key))
+	{
+		fprintf(stderr,
+			"ec_from_pub_cached: EC_KEY_check_key failure\n");
+		EC_KEY_free(key);
+		return (NULL);
+	}
+	lruPut(&ec_cache, pub, key);
+
+	return (key);
+}
+
+
+/**
+ * ec_key_cache_stats - reads the counters of the decoded public key cache
+ * @stats: pointer to struct to fill
+ */
+void ec_key_cache_stats(lru_stats_t *stats)
+{
+	lruStats(&ec_cache, stats);
+}
+
+
+/**
+ * ec_key_cache_clear - releases every key of the decoded public key cache,
+ *   and resets its counters; keys still referenced by callers stay valid
+ */
+void ec_key_cache_clear(void)
+{
+	lruClear(&ec_cache);
+}
@@ -0,0 +1,123 @@
+#include "hblk_crypto.h"
+#include <stdio.h>
+#include <openssl/ec.h>
+#include <openssl/ecdsa.h>
+
+
+/**
+ * ec_verify_ctx_init - prepares a key for signature verification, checking
+ *   it once so that ec_verify_prepared does not have to
+ * @ctx: pointer to context to initialize
+ * @key: pointer to EC_KEY structure, of which the context takes a reference
+ * Return: 1 if ok, 0 if the key is not a valid secp256k1 key or on failure
+ */
+int ec_verify_ctx_init(ec_verify_ctx_t *ctx, EC_KEY const *key)
+{
+	const EC_GROUP *ec_group;
+
+	if (!ctx || !key)
+	{
+		fprintf(stderr, "ec_verify_ctx_init: NULL parameter(s)\n");
+		return (0);
+	}
+	ctx->key = NULL;
+
+	if (!EC_KEY_check_key(key))
+	{
+		fprintf(stderr, "ec_verify: EC_KEY_check_key failure\n");
+		return (0);
+	}
+
+	ec_group = EC_KEY_get0_group(key);
+	if (!ec_group || EC_GROUP_get_curve_name(ec_group) != EC_CURVE ||
+	    ECDSA_size(key) != SIG_MAX_LEN)
+	{
+		fprintf(stderr,
+			"ec_verify: expecting key with secp256k1 curve\n");
+		return (0);
+	}
+
+	if (!EC_KEY_up_ref((EC_KEY *)key))
+	{
+		fprintf(stderr, "ec_verify_ctx_init: EC_KEY_up_ref failure\n");
+		return (0);
+	}
+	ctx->key = (EC_KEY *)key;
+
+	return (1);
+}
+
+
+/**
+ * ec_verify_ctx_pub - prepares the key decoded from a public key for
+ *   signature verification; keys are taken from the cache of
+ *   ec_from_pub_cached, which only holds checked keys, so that a public key
+ *   is decoded and checked once for all its signatures
+ * @ctx: pointer to context to initialize
+ * @pub: public key
+ * Return: 1 if ok, 0 if the public key is invalid or on failure
+ */
+int ec_verify_ctx_pub(ec_verify_ctx_t *ctx, uint8_t const pub[EC_PUB_LEN])
+{
+	if (!ctx || !pub)
+	{
+		fprintf(stderr, "ec_verify_ctx_pub: NULL parameter(s)\n");
+		return (0);
+	}
+
+	ctx->key = ec_from_pub_cached(pub);
+
+	return (ctx->key != NULL);
+}
+
+
+/**
+ * ec_verify_ctx_free - releases the key of a signature verification context
+ * @ctx: pointer to context
+ */
+void ec_verify_ctx_free(ec_verify_ctx_t *ctx)
+{
+	if (!ctx)
+		return;
+
+	EC_KEY_free(ctx->key);
+	ctx->key = NULL;
+}
+
+
+/**
+ * ec_verify_prepared - verifies signature with a prepared key, skipping the
+ *   key checks of ec_verify
+ * @ctx: pointer to context initialized by ec_verify_ctx_init or
+ *   ec_verify_ctx_pub
+ * @msg: pointer
+ * @msglen: size
+ * @sig: pointer to signature
+ * Return: 1 if ok
+ */
+int ec_verify_prepared(ec_verify_ctx_t const *ctx, uint8_t const *msg,
+		       size_t msglen, sig_t const *sig)
+{
+	if (!ctx || !ctx->key || !msg || !sig)
+	{
+		fprintf(stderr, "ec_verify_prepared: NULL parameter(s)\n");
+		return (0);
+	}
+
+	if (sig->len > SIG_MAX_LEN || sig->len == 0)
+	{
+		fprintf(stderr, sig->len ?
+			"ec_verify: signature over max length\n" :
+			"ec_verify: signature length of 0\n");
+		return (0);
+	}
+
+	if (ECDSA_verify(0, msg, (int)msglen, sig->sig,
+			 (int)sig->len, ctx->key) != 1)
+	{
+		fprintf(stderr, "ec_verify: ECDSA_verify failure\n");
+		return (0);
+	}
+
+	return (1);
+}
@@ -12,12 +12,29 @@
 /* NID_secp256k1 */
 #include <openssl/obj_mac.h>
 #include <openssl/ecdsa.h>
+/* pthread_mutex_t PTHREAD_MUTEX_INITIALIZER */
+#include <pthread.h>
 
 #define EC_CURVE NID_secp256k1
 #define EC_PUB_LEN 65
 #define PUB_FILENAME "key_pub.pem"
 #define PRI_FILENAME "key.pem"
 #define SIG_MAX_LEN 72
+/* most messages hashed at once by sha256_mb_resume */
+#define SHA256_MB_LANES_MAX 8
+/* most public keys kept decoded by ec_from_pub_cached */
+#define EC_KEY_CACHE_SIZE 256
+/* hash buckets of the decoded public key cache, power of 2 */
+#define EC_KEY_CACHE_BUCKETS 512
+/* longest key of an lru_cache_t, that of the decoded public key cache */
+#define LRU_KEY_MAX EC_PUB_LEN
+
+/* static initializer of an lru_cache_t over arrays of entries and buckets */
+#define LRU_CACHE_INIT(ents, bkts, key_len, hash_off, acquire, release) \
+	{ ents, sizeof(ents) / sizeof(*(ents)), \
+	  bkts, sizeof(bkts) / sizeof(*(bkts)), \
+	  key_len, hash_off, acquire, release, 0, 0, { 0, 0, 0, 0 }, \
+	  PTHREAD_MUTEX_INITIALIZER }
 
 
 /**
@@ -31,10 +48,105 @@ typedef struct sig_s
 	uint8_t len;
 } sig_t;
 
+/**
+ * struct ec_verify_ctx_s - signature verification context
+ * @key: reference to a public key already checked by EC_KEY_check_key and
+ *   known to be on the secp256k1 curve
+ */
+typedef struct ec_verify_ctx_s
+{
+	EC_KEY *key;
+} ec_verify_ctx_t;
+
+/**
+ * struct lru_entry_s - bounded cache entry
+ * @key: key of the entry, lru_cache_t.key_len bytes long
+ * @value: value of the entry, or NULL in caches of keys alone
+ * @next: index + 1 of the next entry in the same hash bucket, or 0
+ * @newer: index + 1 of the entry used after this one, or 0 if newest
+ * @older: index + 1 of the entry used before this one, or 0 if oldest
+ */
+typedef struct lru_entry_s
+{
+	uint8_t   key[LRU_KEY_MAX];
+	void     *value;
+	uint32_t  next;
+	uint32_t  newer;
+	uint32_t  older;
+} lru_entry_t;
+
+/**
+ * struct lru_stats_s - bounded cache counters
+ * @hits: lookups answered by the cache
+ * @misses: lookups not answered by the cache
+ * @evictions: entries dropped to make room for another key
+ * @size: amount of entries in use
+ */
+typedef struct lru_stats_s
+{
+	uint64_t hits;
+	uint64_t misses;
+	uint64_t evictions;
+	size_t   size;
+} lru_stats_t;
+
+/**
+ * struct lru_cache_s - bounded cache, evicting its least recently used
+ *   entry in constant time once full; thread safe
+ *
+ * Description: Entries are chained by key in hash buckets, and by recency
+ *   in a list from the newest to the oldest. Links are indexes + 1, so that
+ *   zeroed buckets and entries are empty, and a cache declared with
+ *   LRU_CACHE_INIT needs no setup. Entries fill up in array order, and once
+ *   all are in use the oldest is the one replaced.
+ *
+ * @entries: flat array of @cap entries, the first @stats.size in use
+ * @cap: amount of entries
+ * @buckets: flat array of @bucket_ct hash buckets, each the index + 1 of its
+ *   first entry, or 0 if empty
+ * @bucket_ct: amount of hash buckets, power of 2
+ * @key_len: length of every key, at most LRU_KEY_MAX
+ * @hash_off: offset in the keys of 8 uniformly distributed bytes, from which
+ *   their bucket is found
+ * @acquire: called with @lock held to take a reference to a value, returns
+ *   1 on success; NULL if values are not referenced
+ * @release: called with @lock held to drop the reference of the cache to a
+ *   value no longer cached; NULL if values are not referenced
+ * @newest: index + 1 of the most recently used entry, or 0 if empty
+ * @oldest: index + 1 of the least recently used entry, or 0 if empty
+ * @stats: counters
+ * @lock: guards every other member
+ */
+typedef struct lru_cache_s
+{
+	lru_entry_t     *entries;
+	size_t           cap;
+	uint32_t        *buckets;
+	size_t           bucket_ct;
+	size_t           key_len;
+	size_t           hash_off;
+	int            (*acquire)(void *value);
+	void           (*release)(void *value);
+	uint32_t         newest;
+	uint32_t         oldest;
+	lru_stats_t      stats;
+	pthread_mutex_t  lock;
+} lru_cache_t;
+
 
 uint8_t *sha256(int8_t const *s, size_t len,
 		uint8_t digest[SHA256_DIGEST_LENGTH]);
 
+size_t sha256_midstate(int8_t const *s, size_t len, SHA256_CTX *mid);
+uint8_t *sha256_resume(SHA256_CTX const *mid, int8_t const *s, size_t len,
+		       uint8_t digest[SHA256_DIGEST_LENGTH]);
+
+unsigned int sha256_mb_lanes(void);
+int sha256_mb_preferred(void);
+int sha256_mb_resume(SHA256_CTX const *mid, int8_t const * const *msgs,
+		     size_t len, unsigned int n_msgs,
+		     uint8_t digests[][SHA256_DIGEST_LENGTH]);
+
 EC_KEY *ec_create(void);
 uint8_t *ec_to_pub(EC_KEY const *key, uint8_t pub[EC_PUB_LEN]);
 uint8_t *bAxEC_POINT(const EC_POINT *ec_point, const EC_GROUP *ec_group,
@@ -43,6 +155,14 @@ uint8_t *bAxEC_POINT(const EC_POINT *ec_point, const EC_GROUP *ec_group,
 EC_POINT *bAToEC_POINT(const EC_GROUP *ec_group, BN_CTX *bn_ctx,
 			      const uint8_t pub[EC_PUB_LEN]);
 EC_KEY *ec_from_pub(uint8_t const pub[EC_PUB_LEN]);
+EC_KEY *ec_from_pub_cached(uint8_t const pub[EC_PUB_LEN]);
+void ec_key_cache_stats(lru_stats_t *stats);
+void ec_key_cache_clear(void);
+
+int lruGet(lru_cache_t *cache, uint8_t const *key, void **value);
+int lruPut(lru_cache_t *cache, uint8_t const *key, void *value);
+void lruStats(lru_cache_t *cache, lru_stats_t *stats);
+void lruClear(lru_cache_t *cache);
 
 int ec_save(EC_KEY *key, char const *folder);
 FILE *ptnfile_w(char const *folder, const char *filename);
@@ -55,6 +175,11 @@ uint8_t *ec_sign(EC_KEY const *key, uint8_t const *msg, size_t msglen,
 
 int ec_verify(EC_KEY const *key, uint8_t const *msg, size_t msglen,
 	      sig_t const *sig);
+int ec_verify_ctx_init(ec_verify_ctx_t *ctx, EC_KEY const *key);
+int ec_verify_ctx_pub(ec_verify_ctx_t *ctx, uint8_t const pub[EC_PUB_LEN]);
+void ec_verify_ctx_free(ec_verify_ctx_t *ctx);
+int ec_verify_prepared(ec_verify_ctx_t const *ctx, uint8_t const *msg,
+		       size_t msglen, sig_t const *sig);
 
 
 #endif /* HBLK_CRYPTO_H */
@@ -0,0 +1,249 @@
+#include "hblk_crypto.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/**
+ * lruBucket - finds the hash bucket of a key
+ *
+ * @cache: pointer to cache
+ * @key: key, of which cache->hash_off is the offset of uniformly
+ *   distributed bytes
+ *
+ * Return: pointer to the bucket
+ */
+static uint32_t *lruBucket(lru_cache_t *cache, uint8_t const *key)
+{
+	uint64_t word;
+
+	memcpy(&word, key + cache->hash_off, sizeof(uint64_t));
+
+	return (cache->buckets + (word & (cache->bucket_ct - 1)));
+}
+
+
+/**
+ * lruFind - finds the entry of a key; to be called with cache->lock held
+ *
+ * @cache: pointer to cache
+ * @key: key to find
+ *
+ * Return: index + 1 of the entry, or 0 if not cached
+ */
+static uint32_t lruFind(lru_cache_t *cache, uint8_t const *key)
+{
+	uint32_t i;
+
+	for (i = *lruBucket(cache, key); i; i = cache->entries[i - 1].next)
+		if (memcmp(cache->entries[i - 1].key, key,
+			   cache->key_len) == 0)
+			break;
+
+	return (i);
+}
+
+
+/**
+ * lruUnlink - removes an entry from the recency list; to be called with
+ *   cache->lock held
+ *
+ * @cache: pointer to cache
+ * @i: index + 1 of an entry in the list
+ */
+static void lruUnlink(lru_cache_t *cache, uint32_t i)
+{
+	lru_entry_t *entry = cache->entries + i - 1;
+
+	if (entry->newer)
+		cache->entries[entry->newer - 1].older = entry->older;
+	else
+		cache->newest = entry->older;
+	if (entry->older)
+		cache->entries[entry->older - 1].newer = entry->newer;
+	else
+		cache->oldest = entry->newer;
+	entry->newer = entry->older = 0;
+}
+
+
+/**
+ * lruPushNewest - adds an entry at the head of the recency list; to be
+ *   called with cache->lock held
+ *
+ * @cache: pointer to cache
+ * @i: index + 1 of an entry not in the list
+ */
+static void lruPushNewest(lru_cache_t *cache, uint32_t i)
+{
+	lru_entry_t *entry = cache->entries + i - 1;
+
+	entry->older = cache->newest;
+	entry->newer = 0;
+	if (cache->newest)
+		cache->entries[cache->newest - 1].newer = i;
+	else
+		cache->oldest = i;
+	cache->newest = i;
+}
+
+
+/**
+ * lruDrop - removes an entry from its hash bucket and from the recency list,
+ *   and releases its value; to be called with cache->lock held
+ *
+ * @cache: pointer to cache
+ * @i: index + 1 of an entry in use
+ */
+static void lruDrop(lru_cache_t *cache, uint32_t i)
+{
+	lru_entry_t *entry = cache->entries + i - 1;
+	uint32_t *link = lruBucket(cache, entry->key);
+
+	while (*link && *link != i)
+		link = &(cache->entries[*link - 1].next);
+	if (*link)
+		*link = entry->next;
+	entry->next = 0;
+	lruUnlink(cache, i);
+	if (cache->release && entry->value)
+		cache->release(entry->value);
+	entry->value = NULL;
+}
+
+
+/**
+ * lruGet - looks up a key in a cache, making its entry the most recently
+ *   used one if found; thread safe
+ *
+ * @cache: pointer to cache
+ * @key: key to look up, cache->key_len bytes long
+ * @value: if not NULL, modified by reference to the value of the entry,
+ *   of which a reference is taken with cache->acquire
+ *
+ * Return: 1 if cached, 0 if not
+ */
+int lruGet(lru_cache_t *cache, uint8_t const *key, void **value)
+{
+	lru_entry_t *entry;
+	uint32_t i;
+
+	if (!cache || !key)
+	{
+		fprintf(stderr, "lruGet: NULL parameter(s)\n");
+		return (0);
+	}
+
+	pthread_mutex_lock(&(cache->lock));
+	i = lruFind(cache, key);
+	entry = i ? cache->entries + i - 1 : NULL;
+	if (entry && value && cache->acquire &&
+	    !cache->acquire(entry->value))
+		entry = NULL;
+	if (entry)
+	{
+		lruUnlink(cache, i);
+		lruPushNewest(cache, i);
+		cache->stats.hits++;
+		if (value)
+			*value = entry->value;
+	}
+	else
+		cache->stats.misses++;
+	pthread_mutex_unlock(&(cache->lock));
+
+	return (entry != NULL);
+}
+
+
+/**
+ * lruPut - caches a key in an unused entry, or in place of the least
+ *   recently used one once all are in use; thread safe
+ *
+ * @cache: pointer to cache
+ * @key: key to cache, cache->key_len bytes long
+ * @value: value of the key, of which the cache takes its own reference with
+ *   cache->acquire, or NULL
+ *
+ * Return: 1 if cached, 0 if the key already was, or on failure
+ */
+int lruPut(lru_cache_t *cache, uint8_t const *key, void *value)
+{
+	lru_entry_t *entry;
+	uint32_t i, *bucket;
+
+	if (!cache || !key)
+	{
+		fprintf(stderr, "lruPut: NULL parameter(s)\n");
+		return (0);
+	}
+
+	pthread_mutex_lock(&(cache->lock));
+	/* another thread may have cached the same key in the meantime */
+	if (lruFind(cache, key) ||
+	    (value && cache->acquire && !cache->acquire(value)))
+	{
+		pthread_mutex_unlock(&(cache->lock));
+		return (0);
+	}
+	if (cache->stats.size < cache->cap)
+		i = (uint32_t)++cache->stats.size;
+	else
+	{
+		i = cache->oldest;
+		lruDrop(cache, i);
+		cache->stats.evictions++;
+	}
+	entry = cache->entries + i - 1;
+	memcpy(entry->key, key, cache->key_len);
+	entry->value = value;
+	bucket = lruBucket(cache, key);
+	entry->next = *bucket;
+	*bucket = i;
+	lruPushNewest(cache, i);
+	pthread_mutex_unlock(&(cache->lock));
+
+	return (1);
+}
+
+
+/**
+ * lruStats - reads the counters of a cache; thread safe
+ *
+ * @cache: pointer to cache
+ * @stats: pointer to struct to fill
+ */
+void lruStats(lru_cache_t *cache, lru_stats_t *stats)
+{
+	if (!cache || !stats)
+	{
+		fprintf(stderr, "lruStats: NULL parameter(s)\n");
+		return;
+	}
+
+	pthread_mutex_lock(&(cache->lock));
+	*stats = cache->stats;
+	pthread_mutex_unlock(&(cache->lock));
+}
+
+
+/**
+ * lruClear - drops every entry of a cache, releasing their values, and
+ *   resets its counters; thread safe
+ *
+ * @cache: pointer to cache
+ */
+void lruClear(lru_cache_t *cache)
+{
+	if (!cache)
+	{
+		fprintf(stderr, "lruClear: NULL parameter\n");
+		return;
+	}
+
+	pthread_mutex_lock(&(cache->lock));
+	while (cache->newest)
+		lruDrop(cache, cache->newest);
+	memset(&(cache->stats), 0, sizeof(lru_stats_t));
+	pthread_mutex_unlock(&(cache->lock));
+}
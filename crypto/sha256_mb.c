@@ -0,0 +1,556 @@
+#include "hblk_crypto.h"
+#include <openssl/sha.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SHA256_MB_X86
+/* SSE4.1 and AVX2 intrinsics, enabled per function with target attributes */
+#include <immintrin.h>
+#endif
+
+/* word `i` of the lanes in a transposed multi-buffer state */
+#define MB_ROW(st, i) ((st) + (i) * SHA256_MB_LANES_MAX)
+
+
+static const uint32_t sha256K[64] = {
+	0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5,
+	0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+	0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+	0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+	0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+	0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+	0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7,
+	0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+	0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+	0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+	0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3,
+	0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+	0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5,
+	0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+	0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+	0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+
+/**
+ * loadBE32 - reads a big-endian 32-bit word, as SHA-256 message words are
+ *
+ * @p: pointer to the first byte of the word
+ *
+ * Return: word in host byte order
+ */
+static uint32_t loadBE32(uint8_t const *p)
+{
+	return (((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+		((uint32_t)p[2] << 8) | (uint32_t)p[3]);
+}
+
+
+/**
+ * ror32 - rotates a 32-bit word right
+ *
+ * @x: word to rotate
+ * @n: amount of bits to rotate by, 1-31
+ *
+ * Return: rotated word
+ */
+static uint32_t ror32(uint32_t x, unsigned int n)
+{
+	return ((x >> n) | (x << (32 - n)));
+}
+
+
+/**
+ * wordX1 - message schedule of one lane: loads the 16 first words of a chunk,
+ *   then expands them in place
+ *
+ * @w: the last 16 words of the schedule
+ * @i: index of the word to compute, 0-63
+ * @chunk: pointer to the 64-byte chunk being compressed
+ *
+ * Return: word `i` of the message schedule
+ */
+__attribute__((always_inline))
+static inline uint32_t wordX1(uint32_t *w, unsigned int i,
+			      uint8_t const * const *chunk)
+{
+	uint32_t s0, s1;
+
+	if (i < 16)
+		return (w[i] = loadBE32(chunk[0] + i * 4));
+	s0 = w[(i + 1) & 15];
+	s0 = ror32(s0, 7) ^ ror32(s0, 18) ^ (s0 >> 3);
+	s1 = w[(i + 14) & 15];
+	s1 = ror32(s1, 17) ^ ror32(s1, 19) ^ (s1 >> 10);
+	return (w[i & 15] += s0 + w[(i + 9) & 15] + s1);
+}
+
+
+/**
+ * roundX1 - SHA-256 round on one lane; rather than shifting the working
+ *   variables a-h, round `r` of every 8 reads them rotated by `r` places
+ *
+ * @v: working variables, a at v[(8 - r) & 7] up to h at v[(15 - r) & 7]
+ * @r: index of the round modulo 8
+ * @kw: round constant plus message schedule word
+ */
+__attribute__((always_inline))
+static inline void roundX1(uint32_t *v, unsigned int r, uint32_t kw)
+{
+	uint32_t a = v[(8 - r) & 7], e = v[(12 - r) & 7], t1, t2;
+
+	t1 = v[(15 - r) & 7] + (ror32(e, 6) ^ ror32(e, 11) ^ ror32(e, 25)) +
+		((e & v[(13 - r) & 7]) ^ (~e & v[(14 - r) & 7])) + kw;
+	t2 = (ror32(a, 2) ^ ror32(a, 13) ^ ror32(a, 22)) +
+		((a & v[(9 - r) & 7]) |
+		 (v[(10 - r) & 7] & (a | v[(9 - r) & 7])));
+	v[(11 - r) & 7] += t1;
+	v[(15 - r) & 7] = t1 + t2;
+}
+
+
+/**
+ * compressX1 - SHA-256 compression function, portable version, one lane
+ *
+ * @st: state of the lane, word `i` at st[i * SHA256_MB_LANES_MAX]
+ * @chunk: pointer to the 64-byte chunk to compress into the state
+ */
+static void compressX1(uint32_t *st, uint8_t const * const *chunk)
+{
+	uint32_t w[16], v[8];
+	unsigned int i;
+
+	for (i = 0; i < 8; i++)
+		v[i] = *MB_ROW(st, i);
+	for (i = 0; i < 64; i += 8)
+	{
+		roundX1(v, 0, sha256K[i] + wordX1(w, i, chunk));
+		roundX1(v, 1, sha256K[i + 1] + wordX1(w, i + 1, chunk));
+		roundX1(v, 2, sha256K[i + 2] + wordX1(w, i + 2, chunk));
+		roundX1(v, 3, sha256K[i + 3] + wordX1(w, i + 3, chunk));
+		roundX1(v, 4, sha256K[i + 4] + wordX1(w, i + 4, chunk));
+		roundX1(v, 5, sha256K[i + 5] + wordX1(w, i + 5, chunk));
+		roundX1(v, 6, sha256K[i + 6] + wordX1(w, i + 6, chunk));
+		roundX1(v, 7, sha256K[i + 7] + wordX1(w, i + 7, chunk));
+	}
+	for (i = 0; i < 8; i++)
+		*MB_ROW(st, i) += v[i];
+}
+
+
+#ifdef SHA256_MB_X86
+
+/**
+ * sigmaX4 - SHA-256 sigma function on four lanes: rotations of `x` right by
+ *   `r1`, `r2` and `r3` bits XORed together, the last one being a plain
+ *   shift for the message schedule functions
+ *
+ * @x: word of each lane
+ * @r1: first rotation
+ * @r2: second rotation
+ * @r3: third rotation, or shift if `shr` is set
+ * @shr: whether the third term is a shift
+ *
+ * Return: result for each lane
+ */
+__attribute__((target("sse4.1"), always_inline))
+static inline __m128i sigmaX4(__m128i x, int r1, int r2, int r3, int shr)
+{
+	__m128i r;
+
+	r = _mm_or_si128(_mm_srli_epi32(x, r1), _mm_slli_epi32(x, 32 - r1));
+	r = _mm_xor_si128(r, _mm_or_si128(_mm_srli_epi32(x, r2),
+					  _mm_slli_epi32(x, 32 - r2)));
+	if (shr)
+		return (_mm_xor_si128(r, _mm_srli_epi32(x, r3)));
+	return (_mm_xor_si128(r, _mm_or_si128(_mm_srli_epi32(x, r3),
+					      _mm_slli_epi32(x, 32 - r3))));
+}
+
+
+/**
+ * wordX4 - message schedule of four lanes plus round constant, see wordX1
+ *
+ * @w: the last 16 words of the schedule of each lane
+ * @i: index of the word to compute, 0-63
+ * @chunk: pointers to the 64-byte chunk being compressed in each lane
+ *
+ * Return: word `i` of the message schedule plus round constant `i`
+ */
+__attribute__((target("sse4.1"), always_inline))
+static inline __m128i wordX4(__m128i *w, unsigned int i,
+			     uint8_t const * const *chunk)
+{
+	__m128i s0, s1;
+
+	if (i < 16)
+		w[i] = _mm_set_epi32((int)loadBE32(chunk[3] + i * 4),
+				     (int)loadBE32(chunk[2] + i * 4),
+				     (int)loadBE32(chunk[1] + i * 4),
+				     (int)loadBE32(chunk[0] + i * 4));
+	else
+	{
+		s0 = sigmaX4(w[(i + 1) & 15], 7, 18, 3, 1);
+		s1 = sigmaX4(w[(i + 14) & 15], 17, 19, 10, 1);
+		w[i & 15] = _mm_add_epi32(_mm_add_epi32(w[i & 15], s0),
+					  _mm_add_epi32(w[(i + 9) & 15], s1));
+	}
+	return (_mm_add_epi32(w[i & 15], _mm_set1_epi32((int)sha256K[i])));
+}
+
+
+/**
+ * roundX4 - SHA-256 round on four lanes, see roundX1
+ *
+ * @v: working variables, a at v[(8 - r) & 7] up to h at v[(15 - r) & 7]
+ * @r: index of the round modulo 8
+ * @kw: round constant plus message schedule word
+ */
+__attribute__((target("sse4.1"), always_inline))
+static inline void roundX4(__m128i *v, unsigned int r, __m128i kw)
+{
+	__m128i a = v[(8 - r) & 7], e = v[(12 - r) & 7], t1, t2;
+
+	/* ch(e, f, g) = (e & f) ^ (~e & g) */
+	t1 = _mm_xor_si128(_mm_and_si128(e, v[(13 - r) & 7]),
+			   _mm_andnot_si128(e, v[(14 - r) & 7]));
+	t1 = _mm_add_epi32(_mm_add_epi32(v[(15 - r) & 7], t1),
+			   _mm_add_epi32(sigmaX4(e, 6, 11, 25, 0), kw));
+	/* maj(a, b, c) = (a & b) | (c & (a | b)) */
+	t2 = _mm_and_si128(v[(10 - r) & 7], _mm_or_si128(a, v[(9 - r) & 7]));
+	t2 = _mm_or_si128(_mm_and_si128(a, v[(9 - r) & 7]), t2);
+	t2 = _mm_add_epi32(t2, sigmaX4(a, 2, 13, 22, 0));
+	v[(11 - r) & 7] = _mm_add_epi32(v[(11 - r) & 7], t1);
+	v[(15 - r) & 7] = _mm_add_epi32(t1, t2);
+}
+
+
+/**
+ * compressX4 - SHA-256 compression function, SSE4.1 version, four lanes
+ *   compressing one independent chunk each
+ *
+ * @st: state of the lanes, word `i` of lane `j` at
+ *   st[i * SHA256_MB_LANES_MAX + j]
+ * @chunk: pointers to the 64-byte chunk to compress into each lane
+ */
+__attribute__((target("sse4.1")))
+static void compressX4(uint32_t *st, uint8_t const * const *chunk)
+{
+	__m128i w[16], v[8], t;
+	unsigned int i;
+
+	for (i = 0; i < 8; i++)
+		v[i] = _mm_loadu_si128((__m128i *)MB_ROW(st, i));
+	for (i = 0; i < 64; i += 8)
+	{
+		roundX4(v, 0, wordX4(w, i, chunk));
+		roundX4(v, 1, wordX4(w, i + 1, chunk));
+		roundX4(v, 2, wordX4(w, i + 2, chunk));
+		roundX4(v, 3, wordX4(w, i + 3, chunk));
+		roundX4(v, 4, wordX4(w, i + 4, chunk));
+		roundX4(v, 5, wordX4(w, i + 5, chunk));
+		roundX4(v, 6, wordX4(w, i + 6, chunk));
+		roundX4(v, 7, wordX4(w, i + 7, chunk));
+	}
+	for (i = 0; i < 8; i++)
+	{
+		t = _mm_loadu_si128((__m128i *)MB_ROW(st, i));
+		_mm_storeu_si128((__m128i *)MB_ROW(st, i),
+				 _mm_add_epi32(t, v[i]));
+	}
+}
+
+
+/**
+ * sigmaX8 - SHA-256 sigma function on eight lanes, see sigmaX4
+ *
+ * @x: word of each lane
+ * @r1: first rotation
+ * @r2: second rotation
+ * @r3: third rotation, or shift if `shr` is set
+ * @shr: whether the third term is a shift
+ *
+ * Return: result for each lane
+ */
+__attribute__((target("avx2"), always_inline))
+static inline __m256i sigmaX8(__m256i x, int r1, int r2, int r3, int shr)
+{
+	__m256i r;
+
+	r = _mm256_or_si256(_mm256_srli_epi32(x, r1),
+			    _mm256_slli_epi32(x, 32 - r1));
+	r = _mm256_xor_si256(r, _mm256_or_si256(_mm256_srli_epi32(x, r2),
+						_mm256_slli_epi32(x, 32 - r2)));
+	if (shr)
+		return (_mm256_xor_si256(r, _mm256_srli_epi32(x, r3)));
+	return (_mm256_xor_si256(r, _mm256_or_si256(
+					 _mm256_srli_epi32(x, r3),
+					 _mm256_slli_epi32(x, 32 - r3))));
+}
+
+
+/**
+ * wordX8 - message schedule of eight lanes plus round constant, see wordX1
+ *
+ * @w: the last 16 words of the schedule of each lane
+ * @i: index of the word to compute, 0-63
+ * @chunk: pointers to the 64-byte chunk being compressed in each lane
+ *
+ * Return: word `i` of the message schedule plus round constant `i`
+ */
+__attribute__((target("avx2"), always_inline))
+static inline __m256i wordX8(__m256i *w, unsigned int i,
+			     uint8_t const * const *chunk)
+{
+	__m256i s0, s1;
+
+	if (i < 16)
+		w[i] = _mm256_set_epi32((int)loadBE32(chunk[7] + i * 4),
+					(int)loadBE32(chunk[6] + i * 4),
+					(int)loadBE32(chunk[5] + i * 4),
+					(int)loadBE32(chunk[4] + i * 4),
+					(int)loadBE32(chunk[3] + i * 4),
+					(int)loadBE32(chunk[2] + i * 4),
+					(int)loadBE32(chunk[1] + i * 4),
+					(int)loadBE32(chunk[0] + i * 4));
+	else
+	{
+		s0 = sigmaX8(w[(i + 1) & 15], 7, 18, 3, 1);
+		s1 = sigmaX8(w[(i + 14) & 15], 17, 19, 10, 1);
+		s0 = _mm256_add_epi32(w[i & 15], s0);
+		s1 = _mm256_add_epi32(w[(i + 9) & 15], s1);
+		w[i & 15] = _mm256_add_epi32(s0, s1);
+	}
+	return (_mm256_add_epi32(w[i & 15],
+				 _mm256_set1_epi32((int)sha256K[i])));
+}
+
+
+/**
+ * roundX8 - SHA-256 round on eight lanes, see roundX1
+ *
+ * @v: working variables, a at v[(8 - r) & 7] up to h at v[(15 - r) & 7]
+ * @r: index of the round modulo 8
+ * @kw: round constant plus message schedule word
+ */
+__attribute__((target("avx2"), always_inline))
+static inline void roundX8(__m256i *v, unsigned int r, __m256i kw)
+{
+	__m256i a = v[(8 - r) & 7], e = v[(12 - r) & 7], t1, t2;
+
+	/* ch(e, f, g) = (e & f) ^ (~e & g) */
+	t1 = _mm256_xor_si256(_mm256_and_si256(e, v[(13 - r) & 7]),
+			      _mm256_andnot_si256(e, v[(14 - r) & 7]));
+	t1 = _mm256_add_epi32(_mm256_add_epi32(v[(15 - r) & 7], t1),
+			      _mm256_add_epi32(sigmaX8(e, 6, 11, 25, 0), kw));
+	/* maj(a, b, c) = (a & b) | (c & (a | b)) */
+	t2 = _mm256_and_si256(v[(10 - r) & 7],
+			      _mm256_or_si256(a, v[(9 - r) & 7]));
+	t2 = _mm256_or_si256(_mm256_and_si256(a, v[(9 - r) & 7]), t2);
+	t2 = _mm256_add_epi32(t2, sigmaX8(a, 2, 13, 22, 0));
+	v[(11 - r) & 7] = _mm256_add_epi32(v[(11 - r) & 7], t1);
+	v[(15 - r) & 7] = _mm256_add_epi32(t1, t2);
+}
+
+
+/**
+ * compressX8 - SHA-256 compression function, AVX2 version, eight lanes
+ *   compressing one independent chunk each
+ *
+ * @st: state of the lanes, word `i` of lane `j` at
+ *   st[i * SHA256_MB_LANES_MAX + j]
+ * @chunk: pointers to the 64-byte chunk to compress into each lane
+ */
+__attribute__((target("avx2")))
+static void compressX8(uint32_t *st, uint8_t const * const *chunk)
+{
+	__m256i w[16], v[8], t;
+	unsigned int i;
+
+	for (i = 0; i < 8; i++)
+		v[i] = _mm256_loadu_si256((__m256i *)MB_ROW(st, i));
+	for (i = 0; i < 64; i += 8)
+	{
+		roundX8(v, 0, wordX8(w, i, chunk));
+		roundX8(v, 1, wordX8(w, i + 1, chunk));
+		roundX8(v, 2, wordX8(w, i + 2, chunk));
+		roundX8(v, 3, wordX8(w, i + 3, chunk));
+		roundX8(v, 4, wordX8(w, i + 4, chunk));
+		roundX8(v, 5, wordX8(w, i + 5, chunk));
+		roundX8(v, 6, wordX8(w, i + 6, chunk));
+		roundX8(v, 7, wordX8(w, i + 7, chunk));
+	}
+	for (i = 0; i < 8; i++)
+	{
+		t = _mm256_loadu_si256((__m256i *)MB_ROW(st, i));
+		_mm256_storeu_si256((__m256i *)MB_ROW(st, i),
+				    _mm256_add_epi32(t, v[i]));
+	}
+}
+
+#endif /* SHA256_MB_X86 */
+
+
+/* widest kernel of the running CPU, resolved once by detectLanes */
+static unsigned int cpu_lanes = 1;
+static pthread_once_t cpu_lanes_once = PTHREAD_ONCE_INIT;
+
+
+/**
+ * detectLanes - used as `init_routine` for pthread_once to set cpu_lanes to
+ *   the widest SHA-256 compression kernel supported by the running CPU
+ */
+static void detectLanes(void)
+{
+#ifdef SHA256_MB_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		cpu_lanes = 8;
+	else if (__builtin_cpu_supports("sse4.1"))
+		cpu_lanes = 4;
+#endif
+}
+
+
+/**
+ * sha256_mb_lanes - determines the widest SHA-256 compression kernel
+ *   supported by the running CPU; safe to call from concurrent threads
+ *
+ * Return: 8 with AVX2, 4 with SSE4.1, 1 otherwise; this is the amount of
+ *   messages sha256_mb_resume hashes for the cost of one
+ */
+unsigned int sha256_mb_lanes(void)
+{
+	pthread_once(&cpu_lanes_once, detectLanes);
+
+	return (cpu_lanes);
+}
+
+
+/**
+ * sha256_mb_preferred - determines whether sha256_mb_resume outperforms
+ *   hashing the same messages one at a time with OpenSSL on the running CPU,
+ *   which is not the case when OpenSSL can use the SHA extensions
+ *
+ * Return: 1 if sha256_mb_resume should be preferred, 0 otherwise
+ */
+int sha256_mb_preferred(void)
+{
+	if (sha256_mb_lanes() == 1)
+		return (0);
+#if defined(SHA256_MB_X86) && __GNUC__ >= 11
+	if (__builtin_cpu_supports("sha"))
+		return (0);
+#endif
+	return (1);
+}
+
+
+/**
+ * padTail - builds the padded final chunk(s) of a message
+ *
+ * @tail: buffer of 2 chunks receiving the padded tail
+ * @s: last, partial chunk of the message
+ * @rem: number of bytes in s, less than 64
+ * @bit_len: total length of the message in bits, including any midstate
+ *
+ * Return: number of chunks in tail, 1 or 2
+ */
+static unsigned int padTail(uint8_t tail[2 * SHA256_CBLOCK],
+			    int8_t const *s, size_t rem, uint64_t bit_len)
+{
+	unsigned int n_chunks = (rem + 9 > SHA256_CBLOCK) ? 2 : 1;
+	size_t end = n_chunks * SHA256_CBLOCK;
+	unsigned int i;
+
+	memset(tail, 0, end);
+	if (rem)
+		memcpy(tail, s, rem);
+	tail[rem] = 0x80;
+	for (i = 1; i <= 8; i++, bit_len >>= 8)
+		tail[end - i] = (uint8_t)bit_len;
+
+	return (n_chunks);
+}
+
+
+/**
+ * sha256_mb_resume - finishes the hashes of several messages of the same
+ *   length from a state computed by sha256_midstate, compressing up to
+ *   sha256_mb_lanes() of them at once with SIMD instructions
+ *
+ * @mid: pointer to the intermediate state, left unmodified
+ * @msgs: remainder of each message, following the bytes hashed into mid
+ * @len: number of bytes to hash in each of msgs
+ * @n_msgs: amount of messages, 1 to SHA256_MB_LANES_MAX
+ * @digests: hash of each message, in the order of msgs
+ *
+ * Return: 0 on success, 1 on failure
+ */
+int sha256_mb_resume(SHA256_CTX const *mid, int8_t const * const *msgs,
+		     size_t len, unsigned int n_msgs,
+		     uint8_t digests[][SHA256_DIGEST_LENGTH])
+{
+	uint8_t tail[SHA256_MB_LANES_MAX][2 * SHA256_CBLOCK];
+	uint32_t st[8 * SHA256_MB_LANES_MAX];
+	uint8_t const *chunk[SHA256_MB_LANES_MAX];
+	void (*compress)(uint32_t *st, uint8_t const * const *chunk);
+	size_t full = len / SHA256_CBLOCK, c, n_chunks = 0;
+	uint64_t bit_len;
+	uint32_t word;
+	unsigned int i, j, lane, width = 1;
+
+	if (!mid || !msgs || !digests || !n_msgs ||
+	    n_msgs > SHA256_MB_LANES_MAX || mid->num)
+	{
+		fprintf(stderr, "sha256_mb_resume: invalid parameter(s)\n");
+		return (1);
+	}
+	compress = compressX1;
+#ifdef SHA256_MB_X86
+	if (sha256_mb_lanes() == 8 && n_msgs > 4)
+	{
+		compress = compressX8;
+		width = 8;
+	}
+	else if (sha256_mb_lanes() >= 4 && n_msgs > 1)
+	{
+		compress = compressX4;
+		width = 4;
+	}
+#endif
+	bit_len = ((((uint64_t)mid->Nh << 32) | mid->Nl) + (uint64_t)len * 8);
+	for (j = 0; j < n_msgs; j++)
+		n_chunks = full + padTail(tail[j], msgs[j] + len - len % 64,
+					  len % 64, bit_len);
+	for (i = 0; i < 8 * SHA256_MB_LANES_MAX; i++)
+		st[i] = mid->h[i / SHA256_MB_LANES_MAX];
+
+	/* unused lanes of the kernel repeat the first message */
+	for (j = 0; j < n_msgs; j += width)
+		for (c = 0; c < n_chunks; c++)
+		{
+			for (i = 0; i < width; i++)
+			{
+				lane = (j + i < n_msgs) ? j + i : j;
+				chunk[i] = (c < full) ?
+					(uint8_t const *)msgs[lane] + c * 64 :
+					tail[lane] + (c - full) * 64;
+			}
+			compress(st + j, chunk);
+		}
+
+	for (j = 0; j < n_msgs; j++)
+		for (i = 0; i < 8; i++)
+		{
+			word = MB_ROW(st, i)[j];
+			digests[j][i * 4] = (uint8_t)(word >> 24);
+			digests[j][i * 4 + 1] = (uint8_t)(word >> 16);
+			digests[j][i * 4 + 2] = (uint8_t)(word >> 8);
+			digests[j][i * 4 + 3] = (uint8_t)word;
+		}
+
+	return (0);
+}
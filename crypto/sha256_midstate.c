@@ -0,0 +1,65 @@
+#include "hblk_crypto.h"
+#include <openssl/sha.h>
+#include <stdio.h>
+#include <string.h>
+
+
+/**
+ * sha256_midstate - hashes the whole 64-byte chunks at the start of a
+ *   message, so that the hash of several messages sharing that prefix can be
+ *   finished from the same state with sha256_resume
+ *
+ * @s: sequence of bytes starting the message
+ * @len: number of bytes available in s; only the first (len / 64) * 64 of
+ *   them are hashed
+ * @mid: pointer to the context to initialize with the intermediate state
+ *
+ * Return: number of bytes of s hashed into mid, or 0 on failure or if
+ *   len is shorter than one chunk
+ */
+size_t sha256_midstate(int8_t const *s, size_t len, SHA256_CTX *mid)
+{
+	size_t mid_len;
+
+	if (!mid || (!s && len))
+	{
+		fprintf(stderr, "sha256_midstate: NULL parameter(s)\n");
+		return (0);
+	}
+
+	mid_len = len - (len % SHA256_CBLOCK);
+	SHA256_Init(mid);
+	if (mid_len)
+		SHA256_Update(mid, (const void *)s, (unsigned long)mid_len);
+
+	return (mid_len);
+}
+
+
+/**
+ * sha256_resume - finishes a hash from a state computed by sha256_midstate
+ *
+ * @mid: pointer to the intermediate state, left unmodified
+ * @s: remainder of the message, following the bytes hashed into mid
+ * @len: number of bytes to hash in s
+ * @digest: hash
+ *
+ * Return: hash or NULL
+ */
+uint8_t *sha256_resume(SHA256_CTX const *mid, int8_t const *s, size_t len,
+		       uint8_t digest[SHA256_DIGEST_LENGTH])
+{
+	SHA256_CTX ctx;
+
+	if (!mid || !digest || (!s && len))
+	{
+		fprintf(stderr, "sha256_resume: NULL parameter(s)\n");
+		return (NULL);
+	}
+
+	memcpy(&ctx, mid, sizeof(SHA256_CTX));
+	SHA256_Update(&ctx, (const void *)s, (unsigned long)len);
+	SHA256_Final((unsigned char *)digest, &ctx);
+
+	return (digest);
+}
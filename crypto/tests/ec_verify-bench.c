@@ -0,0 +1,170 @@
+#include "hblk_crypto.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+
+/* distinct signing keys, each signing as many messages in turn */
+#define BENCH_KEYS 16
+/* verifications timed per method and run, unless given in argv */
+#define BENCH_VERIFIES_DFLT 3000
+/* runs per method, of which the best is kept */
+#define BENCH_RUNS 3
+
+
+/**
+ * benchNow - reads a monotonic clock
+ * Return: seconds elapsed since an arbitrary point
+ */
+static double benchNow(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return (ts.tv_sec + ts.tv_nsec / 1e9);
+}
+
+
+/**
+ * checkedVerify - verifies a signature as ec_verify did before the key
+ *   checks moved to ec_verify_ctx_init: the key is checked by
+ *   EC_KEY_check_key on every call
+ * @pub: public key of the signer
+ * @msg: pointer
+ * @msglen: size
+ * @sig: pointer to signature
+ * Return: 1 if ok, 0 if not
+ */
+static int checkedVerify(uint8_t const pub[EC_PUB_LEN], uint8_t const *msg,
+			 size_t msglen, sig_t const *sig)
+{
+	EC_KEY *key = ec_from_pub_cached(pub);
+	EC_GROUP const *ec_group;
+	int ok;
+
+	if (!key)
+		return (0);
+	ec_group = EC_KEY_get0_group(key);
+	ok = EC_KEY_check_key(key) && ec_group &&
+		EC_GROUP_get_curve_name(ec_group) == EC_CURVE &&
+		ECDSA_size(key) == SIG_MAX_LEN &&
+		ECDSA_verify(0, msg, (int)msglen, sig->sig, (int)sig->len,
+			     key) == 1;
+	EC_KEY_free(key);
+
+	return (ok);
+}
+
+
+/**
+ * benchMethod - times the verification of `verifies` signatures, each
+ *   signed by key `i % BENCH_KEYS`, with one of three methods: checking the
+ *   key on every call (0), preparing a context per call (1), or reusing a
+ *   context prepared per key (2)
+ * @method: method to time, 0-2
+ * @pubs: public keys
+ * @ctxs: contexts prepared per key, used by method 2
+ * @msg: signed message
+ * @sigs: signature by each key
+ * @verifies: amount of verifications
+ * Return: best verifications per second over BENCH_RUNS runs, or 0 if any
+ *   verification failed
+ */
+static double benchMethod(int method, uint8_t pubs[][EC_PUB_LEN],
+			  ec_verify_ctx_t const *ctxs, uint8_t const *msg,
+			  sig_t const *sigs, long verifies)
+{
+	ec_verify_ctx_t ctx;
+	double t0, dt, best = 0;
+	long i, k;
+	int run, ok = 1;
+
+	for (run = 0; run < BENCH_RUNS && ok; run++)
+	{
+		t0 = benchNow();
+		for (i = 0; i < verifies && ok; i++)
+		{
+			k = i % BENCH_KEYS;
+			if (method == 0)
+				ok = checkedVerify(pubs[k], msg,
+						   SHA256_DIGEST_LENGTH,
+						   sigs + k);
+			else if (method == 1)
+			{
+				ok = ec_verify_ctx_pub(&ctx, pubs[k]) &&
+					ec_verify_prepared(&ctx, msg,
+							   SHA256_DIGEST_LENGTH,
+							   sigs + k);
+				ec_verify_ctx_free(&ctx);
+			}
+			else
+				ok = ec_verify_prepared(ctxs + k, msg,
+							SHA256_DIGEST_LENGTH,
+							sigs + k);
+		}
+		dt = benchNow() - t0;
+		if (ok && verifies / dt > best)
+			best = verifies / dt;
+	}
+
+	return (ok ? best : 0);
+}
+
+
+/**
+ * main - measures signature verifications per second on one core, with the
+ *   key checked on every verification as ec_verify used to, and with the
+ *   ec_verify_ctx_t contexts checking it once
+ * @argc: argument count
+ * @argv: arguments; argv[1] optionally sets the amount of verifications
+ *   timed per method and run
+ * Return: EXIT_SUCCESS, or EXIT_FAILURE on failure
+ */
+int main(int argc, char *argv[])
+{
+	char const *names[] = {"ec_from_pub_cached + key checks",
+			       "ec_verify_ctx_pub + prepared",
+			       "prepared on a prepared ctx"};
+	uint8_t pubs[BENCH_KEYS][EC_PUB_LEN], msg[SHA256_DIGEST_LENGTH];
+	uint8_t pub[EC_PUB_LEN + sizeof(unsigned int)];
+	ec_verify_ctx_t ctxs[BENCH_KEYS] = {{NULL}};
+	sig_t sigs[BENCH_KEYS];
+	long verifies = argc > 1 ? atol(argv[1]) : BENCH_VERIFIES_DFLT;
+	double rate = 1;
+	EC_KEY *key;
+	int i, ok = verifies > 0;
+
+	sha256((int8_t const *)"Holberton School", 16, msg);
+	for (i = 0; i < BENCH_KEYS && ok; i++)
+	{
+		key = ec_create();
+		/* ec_to_pub scans each byte as an unsigned int, so its last */
+		/* write runs past EC_PUB_LEN */
+		ok = key && ec_to_pub(key, pub) &&
+			memcpy(pubs[i], pub, EC_PUB_LEN) &&
+			ec_sign(key, msg, SHA256_DIGEST_LENGTH, sigs + i) &&
+			ec_verify_ctx_pub(ctxs + i, pubs[i]);
+		EC_KEY_free(key);
+	}
+
+	if (ok)
+		printf("verifies per second, %d keys, %ld %s %d\n",
+		       BENCH_KEYS, verifies, "verifies, best of", BENCH_RUNS);
+	for (i = 0; i < 3 && ok && rate; i++)
+	{
+		rate = benchMethod(i, pubs, ctxs, msg, sigs, verifies);
+		if (rate)
+			printf("  %-34s %.0f\n", names[i], rate);
+	}
+
+	for (i = 0; i < BENCH_KEYS; i++)
+		ec_verify_ctx_free(ctxs + i);
+	if (!ok || !rate)
+	{
+		fprintf(stderr, "ec_verify-bench: verification failure\n");
+		return (EXIT_FAILURE);
+	}
+	return (EXIT_SUCCESS);
+}